@@ -0,0 +1,71 @@
+/*
+Allocore Example: Audio Spectrum
+
+Description:
+This example shows how to draw the spectrum of the audio output. An STFT
+appended to the audio IO analyzes the output after onSound() and publishes
+the magnitudes through a lock free triple buffer, which the graphics thread
+reads in onAnimate().
+*/
+
+#include <cmath>
+
+#include "al/app/al_App.hpp"
+#include "al/sound/al_STFT.hpp"
+
+using namespace al;
+
+class MyApp : public App {
+ public:
+  STFT stft{2048, 512, STFT::HANN};
+  Mesh spectrum;
+  double phase = 0;
+  double sweep = 0;
+
+  void onCreate() {
+    nav().pos(0, 0, 4);
+    audioIO().append(stft);
+  }
+
+  void onSound(AudioIOData& io) {
+    while (io()) {
+      // Slowly sweeping sawtooth
+      sweep += 0.05 / io.framesPerSecond();
+      if (sweep > 1) sweep -= 1;
+      phase += (110 + 330 * sweep) / io.framesPerSecond();
+      if (phase > 1) phase -= 1;
+      float out = float(phase * 2 - 1) * 0.1f;
+      io.out(0) = out;
+      io.out(1) = out;
+    }
+  }
+
+  void onAnimate(double dt) {
+    if (!stft.updateMagnitudes()) {
+      return;
+    }
+    const std::vector<float>& mags = stft.magnitudes();
+    spectrum.primitive(Mesh::LINE_STRIP);
+    spectrum.reset();
+    for (size_t k = 0; k < mags.size(); k++) {
+      // Logarithmic frequency and level
+      float x = std::log2(float(k + 1)) / std::log2(float(mags.size()));
+      float y = 20 * std::log10(mags[k] + 1e-6f) / 60 + 1;
+      spectrum.vertex(x * 2 - 1, std::max(y, -1.0f));
+      spectrum.color(HSV(x * 0.8f, 0.7f, 1));
+    }
+  }
+
+  void onDraw(Graphics& g) {
+    g.clear(0);
+    g.meshColor();
+    g.draw(spectrum);
+  }
+};
+
+int main() {
+  MyApp app;
+  app.configureAudio(44100, 512, 2, 0);
+  app.start();
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "al/sound/al_Ambisonics.hpp"
+
+using namespace al;
+
+// Compares AmbiDecode::decode() against the previous speaker-by-speaker
+// loop, which streams every Ambisonic channel once per speaker, for orders
+// 1 to 7 on a 64 speaker layout.
+
+#define BLOCK_SIZE (512)
+#define NUM_SPEAKERS (64)
+#define NUM_BLOCKS (2000)
+
+// Previous implementation: speakers, then Ambisonic channels, then frames
+void referenceDecode(AmbiDecode &dec, float *out, const float *ambi,
+                     int numFrames) {
+  for (int s = 0; s < dec.numSpeakers(); ++s) {
+    if (dec.speaker(s).gain != 0.) {
+      float *o = out + dec.speaker(s).deviceChannel * numFrames;
+      for (int c = 0; c < dec.channels(); ++c) {
+        const float *in = ambi + c * numFrames;
+        float w = dec.decodeWeight(s, c);
+        for (int i = 0; i < numFrames; ++i) {
+          o[i] += in[i] * w;
+        }
+      }
+    }
+  }
+}
+
+template <class F> double timeBlocks(F &&decodeBlock) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    decodeBlock();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         NUM_BLOCKS;
+}
+
+int main() {
+  Speakers sl;
+  for (int i = 0; i < NUM_SPEAKERS; i++) {
+    float el = std::asin(1.0f - 2.0f * (i + 0.5f) / NUM_SPEAKERS) * 57.29578f;
+    float az = std::fmod(i * 137.50776f, 360.0f);
+    sl.push_back(Speaker(i, az, el));
+  }
+
+  std::vector<float> out(NUM_SPEAKERS * BLOCK_SIZE);
+  std::cout << "Microseconds per block of " << BLOCK_SIZE << " frames, "
+            << NUM_SPEAKERS << " speakers" << std::endl;
+  std::cout << "order\tchans\treference\tblocked\t4 threads\tdual-band"
+            << std::endl;
+
+  for (int order = 1; order <= 7; order++) {
+    AmbiDecode dec(3, order, NUM_SPEAKERS, 3);
+    dec.setSpeakers(sl);
+    std::vector<float> ambi(dec.channels() * BLOCK_SIZE);
+    for (size_t i = 0; i < ambi.size(); i++) {
+      ambi[i] = std::sin(0.01f * i);
+    }
+
+    double reference = timeBlocks(
+        [&]() { referenceDecode(dec, out.data(), ambi.data(), BLOCK_SIZE); });
+    double blocked = timeBlocks(
+        [&]() { dec.decode(out.data(), ambi.data(), BLOCK_SIZE); });
+    dec.numThreads(4);
+    double threaded = timeBlocks(
+        [&]() { dec.decode(out.data(), ambi.data(), BLOCK_SIZE); });
+    dec.numThreads(1);
+    dec.dualBand(true);
+    double dualBand = timeBlocks(
+        [&]() { dec.decode(out.data(), ambi.data(), BLOCK_SIZE); });
+
+    std::cout << order << "\t" << dec.channels() << "\t" << reference << "\t\t"
+              << blocked << "\t" << threaded << "\t\t" << dualBand
+              << std::endl;
+  }
+  return 0;
+}
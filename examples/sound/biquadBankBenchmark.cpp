@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "al/sound/al_Biquad.hpp"
+
+using namespace al;
+
+// Compares one BiQuad per channel against BiQuadBank for a two section EQ
+// on 64 channels.
+
+#define BLOCK_SIZE (512)
+#define NUM_CHANNELS (64)
+#define NUM_BLOCKS (2000)
+
+template <class F> double timeBlocks(F &&processBlock) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    processBlock();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         NUM_BLOCKS;
+}
+
+int main() {
+  std::vector<std::vector<float>> buffers(NUM_CHANNELS,
+                                          std::vector<float>(BLOCK_SIZE));
+  std::vector<float *> channels;
+  for (auto &b : buffers) {
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+      b[i] = std::sin(0.01f * i);
+    }
+    channels.push_back(b.data());
+  }
+
+  std::vector<BiQuad> highShelves, peaks;
+  for (int c = 0; c < NUM_CHANNELS; c++) {
+    highShelves.push_back(BiQuad(BIQUAD_HSH, 48000));
+    highShelves.back().set(8000, 1.0, -3.0);
+    peaks.push_back(BiQuad(BIQUAD_PEQ, 48000));
+    peaks.back().set(100 + c, 1.0, 2.0);
+  }
+  double serial = timeBlocks([&]() {
+    for (int c = 0; c < NUM_CHANNELS; c++) {
+      highShelves[c].processBuffer(channels[c], BLOCK_SIZE);
+      peaks[c].processBuffer(channels[c], BLOCK_SIZE);
+    }
+  });
+
+  BiQuadBank bank(NUM_CHANNELS, 2, 48000);
+  bank.set(-1, 0, BIQUAD_HSH, 8000, 1.0, -3.0);
+  for (int c = 0; c < NUM_CHANNELS; c++) {
+    bank.set(c, 1, BIQUAD_PEQ, 100 + c, 1.0, 2.0);
+  }
+  double banked =
+      timeBlocks([&]() { bank.process(channels.data(), BLOCK_SIZE); });
+
+  std::cout << "Microseconds per block of " << BLOCK_SIZE << " frames, "
+            << NUM_CHANNELS << " channels, 2 sections" << std::endl;
+  std::cout << "BiQuad per channel: " << serial << std::endl;
+  std::cout << "BiQuadBank:         " << banked << std::endl;
+  return 0;
+}
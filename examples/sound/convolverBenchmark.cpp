@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "al/sound/al_Convolver.hpp"
+
+using namespace al;
+
+// Audio callback cost of Convolver for growing impulse responses, compared
+// to a direct form FIR filter. The tail partitions run on background
+// threads, so the uniform and direct columns grow with the response length
+// while the partitioned column stays nearly flat when spare cores are
+// available. On a single core the background work shows up in the timings.
+
+#define BLOCK_SIZE (256)
+#define NUM_CHANNELS (8)
+#define NUM_BLOCKS (200)
+
+struct DirectFIR {
+  std::vector<std::vector<float>> irs;
+  std::vector<std::vector<float>> history;
+
+  void process(float *const *channels) {
+    for (size_t c = 0; c < irs.size(); c++) {
+      const std::vector<float> &ir = irs[c];
+      std::vector<float> &h = history[c];
+      // Newest samples at the end of the history
+      h.erase(h.begin(), h.begin() + BLOCK_SIZE);
+      h.insert(h.end(), channels[c], channels[c] + BLOCK_SIZE);
+      const float *last = h.data() + h.size() - BLOCK_SIZE;
+      for (int i = 0; i < BLOCK_SIZE; i++) {
+        float sum = 0;
+        for (size_t k = 0; k < ir.size(); k++) {
+          sum += ir[k] * last[i - int(k)];
+        }
+        channels[c][i] = sum;
+      }
+    }
+  }
+};
+
+template <class F> double timeBlocks(F &&processBlock, int numBlocks) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < numBlocks; i++) {
+    processBlock();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         numBlocks;
+}
+
+int main() {
+  std::vector<std::vector<float>> buffers(NUM_CHANNELS,
+                                          std::vector<float>(BLOCK_SIZE));
+  std::vector<float *> channels;
+  for (auto &b : buffers) {
+    channels.push_back(b.data());
+  }
+  auto fill = [&]() {
+    for (auto &b : buffers) {
+      for (int i = 0; i < BLOCK_SIZE; i++) {
+        b[i] = std::sin(0.01f * i);
+      }
+    }
+  };
+
+  std::cout << "Microseconds per block of " << BLOCK_SIZE << " frames, "
+            << NUM_CHANNELS << " channels" << std::endl;
+  std::cout << "IR length\tdirect\t\tuniform\t\tpartitioned" << std::endl;
+  for (int length = 1024; length <= 131072; length *= 4) {
+    std::vector<std::vector<float>> irs(NUM_CHANNELS,
+                                        std::vector<float>(length));
+    for (auto &ir : irs) {
+      for (int i = 0; i < length; i++) {
+        ir[i] = std::exp(-5.0f * i / length) * std::sin(0.37f * i);
+      }
+    }
+
+    double direct = 0;
+    if (length <= 16384) {
+      DirectFIR fir;
+      fir.irs = irs;
+      fir.history.assign(NUM_CHANNELS,
+                         std::vector<float>(length + BLOCK_SIZE, 0.0f));
+      direct = timeBlocks(
+          [&]() {
+            fill();
+            fir.process(channels.data());
+          },
+          NUM_BLOCKS / 10);
+    }
+
+    Convolver uniform;
+    uniform.configure(irs, BLOCK_SIZE);
+    double uniformTime = timeBlocks(
+        [&]() {
+          fill();
+          uniform.process(channels.data(), channels.data(), BLOCK_SIZE);
+        },
+        NUM_BLOCKS);
+
+    Convolver partitioned;
+    partitioned.configure(irs, BLOCK_SIZE, 16384);
+    double partitionedTime = timeBlocks(
+        [&]() {
+          fill();
+          partitioned.process(channels.data(), channels.data(), BLOCK_SIZE);
+        },
+        NUM_BLOCKS);
+
+    std::cout << length << "\t\t";
+    if (direct > 0) {
+      std::cout << direct;
+    } else {
+      std::cout << "-";
+    }
+    std::cout << "\t\t" << uniformTime << "\t\t" << partitionedTime
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_DownMixer.hpp"
+#include "al/sphere/al_AlloSphereSpeakerLayout.hpp"
+
+using namespace al;
+
+// Compares the compiled DownMixer routing against the previous frame by
+// frame walk of the routing map, downmixing the AlloSphere layout to stereo.
+
+#define BLOCK_SIZE (512)
+#define NUM_BLOCKS (2000)
+
+// Previous implementation: frames, then map entries, then routes
+void referenceDownMix(const DownMixer::RoutingMap &routing, AudioIOData &io) {
+  for (unsigned i = 0; i < io.channelsBus(); i++) {
+    memset(io.busBuffer(i), 0, io.framesPerBuffer() * sizeof(float));
+  }
+  io.frame(0);
+  while (io()) {
+    for (const auto &mapEntry : routing) {
+      for (const auto &r : mapEntry.second) {
+        io.bus(r.first) += io.out(mapEntry.first) * r.second;
+      }
+    }
+  }
+}
+
+template <class F> double timeBlocks(F &&mixBlock) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    mixBlock();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         NUM_BLOCKS;
+}
+
+int main() {
+  AudioIOData io;
+  io.framesPerBuffer(BLOCK_SIZE);
+  io.channelsOut(64);
+  for (int c = 0; c < 64; c++) {
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+      io.outBuffer(c)[i] = std::sin(0.01f * (c + 1) * i);
+    }
+  }
+  DownMixer downMixer;
+  downMixer.layoutToStereo(AlloSphereSpeakerLayout(), io);
+
+  double reference =
+      timeBlocks([&]() { referenceDownMix(downMixer.routing(), io); });
+  double compiled = timeBlocks([&]() { downMixer.downMixToBus(io); });
+  downMixer.setIdentity(64, io);
+  double identity = timeBlocks([&]() { downMixer.downMixToBus(io); });
+
+  std::cout << "Microseconds per block of " << BLOCK_SIZE << " frames"
+            << std::endl;
+  std::cout << "reference\tcompiled\t64 channel identity" << std::endl;
+  std::cout << reference << "\t\t" << compiled << "\t\t" << identity
+            << std::endl;
+  return 0;
+}
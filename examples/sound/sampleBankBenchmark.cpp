@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "al/io/al_File.hpp"
+#include "al/sound/al_SampleBank.hpp"
+
+using namespace al;
+
+// Compares opening a sample library one file at a time with SoundFile::open()
+// against SampleBank::loadAll(), for 200 one second stereo 24 bit files.
+// Pass a directory to load a real library instead.
+
+#define FILES (200)
+#define SECONDS (1)
+#define CHANNELS (2)
+#define RATE (48000)
+
+static void writeLE(std::ofstream &f, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    f.put(char((value >> (8 * i)) & 0xFF));
+  }
+}
+
+template <class F> double timeMilliseconds(F &&run) {
+  auto start = std::chrono::high_resolution_clock::now();
+  run();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> paths;
+  if (argc > 1) {
+    FileList files = filterInDir(argv[1], [](const FilePath &f) {
+      return checkExtension(f, ".wav") || checkExtension(f, ".flac");
+    });
+    for (auto &file : files) {
+      paths.push_back(file.filepath());
+    }
+  } else {
+    for (int n = 0; n < FILES; n++) {
+      paths.push_back("sampleBankBenchmark" + std::to_string(n) + ".wav");
+      std::ofstream f(paths.back(), std::ios::binary);
+      uint32_t dataBytes = SECONDS * RATE * CHANNELS * 3;
+      f.write("RIFF", 4);
+      writeLE(f, 36 + dataBytes, 4);
+      f.write("WAVEfmt ", 8);
+      writeLE(f, 16, 4);
+      writeLE(f, 1, 2);
+      writeLE(f, CHANNELS, 2);
+      writeLE(f, RATE, 4);
+      writeLE(f, RATE * CHANNELS * 3, 4);
+      writeLE(f, CHANNELS * 3, 2);
+      writeLE(f, 24, 2);
+      f.write("data", 4);
+      writeLE(f, dataBytes, 4);
+      for (uint32_t i = 0; i < dataBytes / 3; i++) {
+        writeLE(f, ((i + n) * 2654435761u) >> 8, 3);
+      }
+    }
+  }
+
+  std::vector<SoundFile> files(paths.size());
+  double sequentialTime = timeMilliseconds([&]() {
+    for (size_t i = 0; i < paths.size(); i++) {
+      files[i].open(paths[i].c_str());
+    }
+  });
+  files.clear();
+
+  SampleBank bank;
+  std::shared_ptr<BatchLoad> batch;
+  double firstTime = 0;
+  double batchTime = timeMilliseconds([&]() {
+    batch = bank.loadAll(paths);
+    firstTime = timeMilliseconds([&]() { batch->sample(0).get(); });
+    batch->wait();
+  });
+
+  double readTime = 0;
+  double decodeTime = 0;
+  for (const auto &result : batch->results()) {
+    readTime += result.readSeconds;
+    decodeTime += result.decodeSeconds;
+  }
+  std::cout << paths.size() << " files, " << bank.memoryUsage() / (1 << 20)
+            << " MB decoded, " << batch->failed() << " failed" << std::endl;
+  std::cout << "SoundFile::open in turn:  " << sequentialTime << " ms"
+            << std::endl;
+  std::cout << "SampleBank::loadAll:      " << batchTime << " ms, first file "
+            << firstTime << " ms" << std::endl;
+  std::cout << "  total read " << 1000 * readTime << " ms, decode "
+            << 1000 * decodeTime << " ms" << std::endl;
+  if (argc <= 1) {
+    for (const auto &path : paths) {
+      std::remove(path.c_str());
+    }
+  }
+  return 0;
+}
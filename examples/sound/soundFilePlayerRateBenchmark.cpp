@@ -0,0 +1,72 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "al/sound/al_SoundFile.hpp"
+
+using namespace al;
+
+// Measures how many mono SoundFilePlayer voices at a rate other than 1 fit
+// in real time on one core, for each interpolation, as used by granular and
+// sampler voices.
+
+#define RATE (48000)
+#define BLOCK_SIZE (256)
+#define VOICES (64)
+
+template <class F> double timeMilliseconds(F &&run) {
+  auto start = std::chrono::high_resolution_clock::now();
+  run();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  SoundFile file;
+  file.channels = 1;
+  file.sampleRate = RATE;
+  file.frameCount = 10 * RATE;
+  file.data.resize(size_t(file.frameCount));
+  for (size_t i = 0; i < file.data.size(); i++) {
+    file.data[i] = float(std::sin(i * 0.01) * 0.5);
+  }
+
+  struct Setting {
+    const char *name;
+    SoundFilePlayer::Interpolation interpolation;
+    double rate;
+    bool bandLimit;
+  };
+  Setting settings[] = {{"native rate   ", SoundFilePlayer::LINEAR, 1.0, false},
+                        {"linear  x0.73 ", SoundFilePlayer::LINEAR, 0.73, false},
+                        {"cubic   x0.73 ", SoundFilePlayer::CUBIC, 0.73, false},
+                        {"hermite x0.73 ", SoundFilePlayer::HERMITE, 0.73, false},
+                        {"cubic   x1.7  ", SoundFilePlayer::CUBIC, 1.7, false},
+                        {"sinc    x1.7  ", SoundFilePlayer::CUBIC, 1.7, true}};
+
+  std::vector<float> buffer(BLOCK_SIZE);
+  const int blocks = RATE / BLOCK_SIZE; // one second of audio
+  for (const auto &setting : settings) {
+    std::vector<SoundFilePlayer> players(VOICES);
+    for (int v = 0; v < VOICES; v++) {
+      players[v].soundFile = &file;
+      players[v].pause = false;
+      players[v].loop = true;
+      players[v].frame = v * 997;
+      players[v].rate = setting.rate;
+      players[v].interpolation = setting.interpolation;
+      players[v].bandLimit = setting.bandLimit;
+    }
+    double ms = timeMilliseconds([&]() {
+      for (int b = 0; b < blocks; b++) {
+        for (auto &player : players) {
+          player.getFrames(BLOCK_SIZE, buffer.data(), BLOCK_SIZE);
+        }
+      }
+    });
+    std::cout << setting.name << ": " << ms / VOICES << " ms per voice second, "
+              << int(VOICES * 1000.0 / ms) << " voices per core" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "al/sound/al_SoundFile.hpp"
+
+using namespace al;
+
+// Compares decoding a whole wav file with SoundFile::open() against mapping
+// it with SoundFileView, for a 60 second 8 channel 24 bit file. Reading
+// through the view converts only what is played.
+
+#define SECONDS (60)
+#define CHANNELS (8)
+#define RATE (48000)
+#define BLOCK_SIZE (512)
+
+static void writeLE(std::ofstream &f, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    f.put(char((value >> (8 * i)) & 0xFF));
+  }
+}
+
+template <class F> double timeMilliseconds(F &&run) {
+  auto start = std::chrono::high_resolution_clock::now();
+  run();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  const char *path = "soundFileViewBenchmark.wav";
+  {
+    std::ofstream f(path, std::ios::binary);
+    uint32_t dataBytes = SECONDS * RATE * CHANNELS * 3;
+    f.write("RIFF", 4);
+    writeLE(f, 36 + dataBytes, 4);
+    f.write("WAVEfmt ", 8);
+    writeLE(f, 16, 4);
+    writeLE(f, 1, 2);
+    writeLE(f, CHANNELS, 2);
+    writeLE(f, RATE, 4);
+    writeLE(f, RATE * CHANNELS * 3, 4);
+    writeLE(f, CHANNELS * 3, 2);
+    writeLE(f, 24, 2);
+    f.write("data", 4);
+    writeLE(f, dataBytes, 4);
+    for (uint32_t i = 0; i < dataBytes / 3; i++) {
+      writeLE(f, (i * 2654435761u) >> 8, 3);
+    }
+  }
+
+  SoundFile file;
+  double decodeTime = timeMilliseconds([&]() { file.open(path); });
+  SoundFileView view;
+  double mapTime = timeMilliseconds([&]() { view.open(path); });
+
+  // Play one second from the middle
+  std::vector<float> buffer(BLOCK_SIZE * CHANNELS);
+  SoundFilePlayer player;
+  player.soundFileView = &view;
+  player.pause = false;
+  player.frame = SECONDS * RATE / 2;
+  double playTime = timeMilliseconds([&]() {
+    for (int i = 0; i < RATE / BLOCK_SIZE; i++) {
+      player.getFrames(BLOCK_SIZE, buffer.data(), int(buffer.size()));
+    }
+  });
+
+  std::cout << "SoundFile::open:      " << decodeTime << " ms, "
+            << file.data.size() * sizeof(float) / (1 << 20) << " MB decoded"
+            << std::endl;
+  std::cout << "SoundFileView::open:  " << mapTime << " ms" << std::endl;
+  std::cout << "Play 1 s from view:   " << playTime << " ms" << std::endl;
+  std::remove(path);
+  return 0;
+}
@@ -19,6 +19,7 @@ struct MyApp : App {
       std::cerr << "File not found: " << name << std::endl;
       quit();
     }
+    player.loop(loop);
     std::cout << "sampleRate: " << player.sampleRate() << std::endl;
     std::cout << "channels: " << player.numChannels() << std::endl;
     std::cout << "frameCount: " << player.totalFrames() << std::endl;
@@ -0,0 +1,54 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "al/ui/al_ParameterServer.hpp"
+
+using namespace al;
+
+// Sends a burst of parameter notifications to a local listener, one datagram
+// per notification against batched bundles sent from the notifier's thread.
+// Reports the time spent in the notifying thread and the datagrams sent.
+
+#define NOTIFICATIONS (100000)
+#define PARAMETERS (64)
+
+template <class F> double timeMilliseconds(F &&run) {
+  auto start = std::chrono::high_resolution_clock::now();
+  run();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  std::vector<std::string> addresses;
+  for (int p = 0; p < PARAMETERS; p++) {
+    addresses.push_back("/group/param" + std::to_string(p));
+  }
+
+  for (int mode = 0; mode < 2; mode++) {
+    OSCNotifier notifier;
+    notifier.addListener("localhost", 10840);
+    if (mode == 1) {
+      notifier.startBatching();
+    }
+    double ms = timeMilliseconds([&]() {
+      for (int i = 0; i < NOTIFICATIONS; i++) {
+        notifier.notifyListeners(addresses[i % PARAMETERS],
+                                 float(i) / NOTIFICATIONS, nullptr);
+      }
+    });
+    double drain = timeMilliseconds([&]() { notifier.stopBatching(); });
+    if (mode == 0) {
+      std::cout << "immediate: " << ms << " ms, " << NOTIFICATIONS
+                << " datagrams" << std::endl;
+    } else {
+      std::cout << "batched:   " << ms << " ms (+" << drain
+                << " ms to drain), " << notifier.packetsSent()
+                << " datagrams for " << notifier.messagesSent()
+                << " messages" << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "al/ui/al_Parameter.hpp"
+
+using namespace al;
+
+// Measures the cost of get() on an audio thread while GUI and OSC threads
+// keep setting the same parameters.
+
+#define READS (2000000)
+#define WRITERS (2)
+
+template <class P, class V>
+void run(const char *name, P &param, V (*make)(float)) {
+  std::atomic<bool> running(true);
+  std::atomic<uint64_t> writes(0);
+  std::vector<std::thread> writers;
+  for (int w = 0; w < WRITERS; w++) {
+    writers.emplace_back([&]() {
+      float v = 0;
+      while (running.load()) {
+        param.set(make(v));
+        v += 1.0f;
+        writes++;
+      }
+    });
+  }
+  V sink = make(0);
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < READS; i++) {
+    sink = param.get();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  running = false;
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  const double ns =
+      std::chrono::duration<double, std::nano>(end - start).count() / READS;
+  std::cout << name << ": " << ns << " ns per get(), " << writes.load()
+            << " concurrent sets" << std::endl;
+  (void)sink;
+}
+
+float makeFloat(float v) { return v; }
+Vec3f makeVec3(float v) { return Vec3f(v); }
+Color makeColor(float v) { return Color(v, v, v, 1); }
+Pose makePose(float v) { return Pose(Vec3d(v), Quatd(1, 0, 0, 0)); }
+std::string makeString(float v) { return std::to_string(v); }
+
+int main() {
+  std::cout << "AtomicValue<float> lock-free: "
+            << AtomicValue<float>::isLockFree << std::endl;
+  std::cout << "AtomicValue<Pose> lock-free: "
+            << AtomicValue<Pose>::isLockFree << std::endl;
+
+  Parameter param("float", "", 0.0f, -1e9f, 1e9f);
+  run("Parameter", param, makeFloat);
+  ParameterVec3 vec("vec3");
+  run("ParameterVec3", vec, makeVec3);
+  ParameterColor color("color");
+  run("ParameterColor", color, makeColor);
+  ParameterPose pose("pose");
+  run("ParameterPose", pose, makePose);
+  ParameterString text("string");
+  run("ParameterString (mutex)", text, makeString);
+  return 0;
+}
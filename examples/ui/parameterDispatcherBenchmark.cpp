@@ -0,0 +1,72 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "al/ui/al_Parameter.hpp"
+
+using namespace al;
+
+// Simulates a 1 kHz OSC stream on many parameters whose callbacks do some
+// work, comparing synchronous callbacks with a ParameterDispatcher processed
+// once per 60 Hz frame.
+
+#define PARAMETERS (32)
+#define UPDATE_RATE (1000)
+#define FRAME_RATE (60)
+#define SECONDS (10)
+
+template <class F> double timeMilliseconds(F &&run) {
+  auto start = std::chrono::high_resolution_clock::now();
+  run();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  volatile double sink = 0;
+  uint64_t calls = 0;
+  auto callback = [&](float value) {
+    // Stand in for an OSC send or a GUI update
+    double v = value;
+    for (int i = 0; i < 200; i++) {
+      v = std::sin(v) + 1.0;
+    }
+    sink = v;
+    calls++;
+  };
+
+  for (int mode = 0; mode < 2; mode++) {
+    ParameterDispatcher dispatcher;
+    std::vector<std::unique_ptr<Parameter>> parameters;
+    for (int p = 0; p < PARAMETERS; p++) {
+      parameters.emplace_back(
+          new Parameter("p" + std::to_string(p), "", 0.0f, 0.0f, 1.0f));
+      parameters.back()->registerChangeCallback(callback);
+      if (mode == 1) {
+        parameters.back()->setChangeDispatcher(&dispatcher);
+      }
+    }
+    calls = 0;
+    const int updates = UPDATE_RATE * SECONDS;
+    double ms = timeMilliseconds([&]() {
+      for (int u = 0; u < updates; u++) {
+        for (auto &parameter : parameters) {
+          parameter->set(float(u % 100) / 100.0f);
+        }
+        if (mode == 1 && u % (UPDATE_RATE / FRAME_RATE) == 0) {
+          dispatcher.process();
+        }
+      }
+      dispatcher.process();
+    });
+    std::cout << (mode == 0 ? "synchronous: " : "dispatcher:  ") << ms
+              << " ms, " << calls << " callbacks";
+    if (mode == 1) {
+      std::cout << ", " << dispatcher.coalesced() << " coalesced";
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
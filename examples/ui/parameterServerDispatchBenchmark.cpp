@@ -0,0 +1,68 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "al/ui/al_ParameterServer.hpp"
+
+using namespace al;
+
+// Measures ParameterServer::onMessage() with many registered parameters,
+// against scanning every parameter with setParameterValueFromMessage() as
+// the server did before it indexed addresses.
+
+#define PARAMETERS (5000)
+#define MESSAGES (20000)
+
+template <class F> double timeMilliseconds(F &&run) {
+  auto start = std::chrono::high_resolution_clock::now();
+  run();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  ParameterServer server("", 9010, false);
+  std::vector<std::unique_ptr<Parameter>> parameters;
+  for (int p = 0; p < PARAMETERS; p++) {
+    parameters.emplace_back(new Parameter("param" + std::to_string(p),
+                                          "group", 0.0f, 0.0f, 1.0f));
+    server << *parameters.back();
+  }
+
+  std::vector<std::unique_ptr<osc::Packet>> packets;
+  for (int i = 0; i < 64; i++) {
+    packets.emplace_back(new osc::Packet);
+    packets.back()->addMessage(
+        parameters[(i * 7919) % PARAMETERS]->getFullAddress(),
+        float(i) / 64.0f);
+  }
+
+  double indexed = timeMilliseconds([&]() {
+    for (int i = 0; i < MESSAGES; i++) {
+      osc::Packet &packet = *packets[i % packets.size()];
+      osc::Message m(packet.data(), int(packet.size()), 1, "127.0.0.1", 0);
+      server.onMessage(m);
+    }
+  });
+
+  double scanned = timeMilliseconds([&]() {
+    for (int i = 0; i < MESSAGES / 100; i++) {
+      osc::Packet &packet = *packets[i % packets.size()];
+      osc::Message m(packet.data(), int(packet.size()), 1, "127.0.0.1", 0);
+      for (auto &p : parameters) {
+        if (ParameterServer::setParameterValueFromMessage(
+                p.get(), m.addressPattern(), m)) {
+          m.resetStream();
+        }
+      }
+    }
+  });
+
+  std::cout << PARAMETERS << " parameters" << std::endl;
+  std::cout << "indexed onMessage(): " << 1000.0 * indexed / MESSAGES
+            << " us per message" << std::endl;
+  std::cout << "linear scan:         " << 1000.0 * scanned / (MESSAGES / 100)
+            << " us per message" << std::endl;
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "al/ui/al_ParameterSmoother.hpp"
+
+using namespace al;
+
+// Compares voices that read a gain parameter with get() for every sample
+// against voices that use a ParameterSmoother once per block.
+
+#define RATE (48000)
+#define BLOCK_SIZE (256)
+#define VOICES (64)
+#define BLOCKS (2000)
+
+template <class F> double timeMilliseconds(F &&run) {
+  auto start = std::chrono::high_resolution_clock::now();
+  run();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+  Parameter gain("gain", "", 0.5f, 0.0f, 1.0f);
+  std::vector<float> buffer(BLOCK_SIZE, 0.25f);
+  float sink = 0;
+
+  // The value changes every block to keep the smoothers ramping
+  double perSample = timeMilliseconds([&]() {
+    for (int b = 0; b < BLOCKS; b++) {
+      gain.set((b % 2) ? 0.25f : 0.75f);
+      for (int v = 0; v < VOICES; v++) {
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+          sink += buffer[i] * gain.get();
+        }
+      }
+    }
+  });
+
+  std::vector<ParameterSmoother> smoothers;
+  for (int v = 0; v < VOICES; v++) {
+    smoothers.emplace_back(gain, 0.02f, RATE);
+  }
+  std::vector<float> gains(BLOCK_SIZE);
+  double perBlock = timeMilliseconds([&]() {
+    for (int b = 0; b < BLOCKS; b++) {
+      gain.set((b % 2) ? 0.25f : 0.75f);
+      for (auto &smoother : smoothers) {
+        smoother.process(gains.data(), BLOCK_SIZE);
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+          sink += buffer[i] * gains[i];
+        }
+      }
+    }
+  });
+
+  double perRamp = timeMilliseconds([&]() {
+    for (int b = 0; b < BLOCKS; b++) {
+      gain.set((b % 2) ? 0.25f : 0.75f);
+      for (auto &smoother : smoothers) {
+        SmoothedValue::Ramp ramp = smoother.ramp(BLOCK_SIZE);
+        for (int i = 0; i < BLOCK_SIZE; i++) {
+          sink += buffer[i] * (ramp.start + i * ramp.increment);
+        }
+      }
+    }
+  });
+
+  const double audioMs = 1000.0 * BLOCKS * BLOCK_SIZE / RATE;
+  std::cout << VOICES << " voices, " << audioMs << " ms of audio" << std::endl;
+  std::cout << "get() per sample:       " << perSample << " ms (unsmoothed)"
+            << std::endl;
+  std::cout << "ParameterSmoother block: " << perBlock << " ms" << std::endl;
+  std::cout << "ParameterSmoother ramp:  " << perRamp << " ms" << std::endl;
+  std::cout << sink << std::endl;
+  return 0;
+}
@@ -0,0 +1,88 @@
+#ifndef INCLUDE_AL_MATH_FFT_HPP
+#define INCLUDE_AL_MATH_FFT_HPP
+
+#include <memory>
+#include <vector>
+
+namespace al {
+
+/**
+ * @brief Fast Fourier transform of real signals
+ *
+ * Spectra are stored in split format: separate arrays for the real and
+ * imaginary parts, with size()/2 + 1 bins from DC to Nyquist. This layout
+ * lets the compiler vectorize the butterflies and spectral products.
+ *
+ * The transform size must be even, and half of it must only have the
+ * factors 2, 3, 5 and 7. Powers of two are fastest. Forward and inverse
+ * transforms together are the identity, the inverse is scaled by
+ * 1/size().
+ *
+ * Twiddle tables are computed once per size and shared by all RFFT objects
+ * of that size. Each object has its own work buffers, so separate objects
+ * can be used from different threads.
+ *
+ * @code
+ * RFFT fft(1024);
+ * std::vector<float> re(fft.bins()), im(fft.bins());
+ * fft.forward(signal, re.data(), im.data());
+ * fft.inverse(re.data(), im.data(), signal);
+ * @endcode
+ *
+ * @ingroup Math
+ */
+class RFFT {
+ public:
+  RFFT(unsigned int size = 0);
+
+  /// Set transform size
+  void resize(unsigned int size);
+
+  /// Transform size in samples
+  unsigned int size() const { return mSize; }
+
+  /// Number of spectral bins, size()/2 + 1
+  unsigned int bins() const { return mSize / 2 + 1; }
+
+  /// Real to complex transform
+  ///
+  /// @param[in] in    size() samples
+  /// @param[out] re   bins() real parts
+  /// @param[out] im   bins() imaginary parts
+  void forward(const float *in, float *re, float *im);
+
+  /// Complex to real transform, scaled by 1/size()
+  ///
+  /// The imaginary parts of the DC and Nyquist bins are ignored.
+  void inverse(const float *re, const float *im, float *out);
+
+  /// Returns true if n is a power of two greater than 1
+  static bool isPowerOfTwo(unsigned int n) {
+    return n >= 2 && (n & (n - 1)) == 0;
+  }
+
+  /// Returns true if n is a valid transform size
+  static bool isSupportedSize(unsigned int n);
+
+  /// Smallest supported size that is not less than n
+  static unsigned int nextSupportedSize(unsigned int n);
+
+ private:
+  struct Plan;
+
+  // Complex FFT of size mSize/2 on split data, in place
+  void complexTransform(float *re, float *im, float *workRe, float *workIm);
+
+  static std::shared_ptr<const Plan> plan(unsigned int size);
+
+  unsigned int mSize{0};
+  std::shared_ptr<const Plan> mPlan;
+  std::vector<float> mRe;
+  std::vector<float> mIm;
+  std::vector<float> mWorkRe;
+  std::vector<float> mWorkIm;
+};
+
+}  // namespace al
+
+#endif  // INCLUDE_AL_MATH_FFT_HPP
@@ -45,6 +45,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 #include "al/math/al_Constants.hpp"
 
@@ -157,6 +159,15 @@ bool even(const T& v);
 template <class T>
 T erf(const T& v);
 
+/// Fast approximation to exp2() for float
+
+/// Relative error is less than 2e-7 for arguments in [-126, 128). Results
+/// outside that range are clipped to the normal float range. The function is
+/// branchless so that loops calling it can be vectorized.
+///
+/// @ingroup Math
+float exp2Fast(float v);
+
 /// Returns factorial. Argument must be less than or equal to 12.
 ///
 /// @ingroup Math
@@ -257,6 +268,14 @@ T legendreP(int l, int m, T t);
 template <class T>
 T legendreP(int l, int m, T ct, T st);
 
+/// Fast approximation to log2() for positive, normal floats
+
+/// Absolute error is less than 1e-5. The function is branchless so that loops
+/// calling it can be vectorized.
+///
+/// @ingroup Math
+float log2Fast(float v);
+
 /// Returns whether the absolute value is less than an epsilon.
 ///
 /// @ingroup Math
@@ -356,6 +375,14 @@ T pow64(const T& v);  ///< Returns value to the 64th power.
 template <class T>
 T powN(T base, unsigned power);
 
+/// Fast approximation to pow() for positive base
+
+/// Computed as exp2Fast(power * log2Fast(base)). Relative error is less than
+/// 4e-6 * |power| for results within the normal float range.
+///
+/// @ingroup Math
+float powFast(float base, float power);
+
 /// Returns (n+1)th prime number up to n=53.
 ///
 /// @ingroup Math
@@ -651,6 +678,27 @@ TEM inline T erf(const T& x) {
          std::sqrt(T(1) - std::exp(-x2 * (T(4. / M_PI) + ax2) / (T(1) + ax2)));
 }
 
+inline float exp2Fast(float v) {
+  // Split into integer and fractional part, fractional part in [0, 1)
+  int32_t i = int32_t(v);
+  i -= int32_t(v < float(i));
+  float f = v - float(i);
+  // Polynomial fit of 2^f on [0, 1)
+  float p =
+      1.f +
+      f * (0.693152745f +
+           f * (0.240153196f +
+                f * (0.0558281703f + f * (0.00898897234f + f * 0.00187663531f))));
+  // Integer part goes straight into the exponent bits. Clipping is done on the
+  // integer, as clipping the float argument prevents vectorization in gcc.
+  i = i < -126 ? -126 : i;
+  i = i > 127 ? 127 : i;
+  int32_t bits = (i + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(float));
+  return p * scale;
+}
+
 inline uint32_t factorial(uint32_t v) { return mFactorial12u[v]; }
 
 inline double factorialSqrt(int v) {
@@ -835,6 +883,23 @@ TEM T legendreP(int l, int m, T t) {
   return al::legendreP(l, m, std::cos(t), std::sin(t));
 }
 
+inline float log2Fast(float v) {
+  int32_t bits;
+  std::memcpy(&bits, &v, sizeof(float));
+  // Exponent gives integer part, mantissa in [1, 2) gives fractional part
+  float e = float(((bits >> 23) & 0xff) - 127);
+  bits = (bits & 0x007fffff) | 0x3f800000;
+  float m;
+  std::memcpy(&m, &bits, sizeof(float));
+  float t = m - 1.f;
+  // Polynomial fit of log2(1 + t) on [0, 1)
+  return e + t * (1.44251704f +
+                  t * (-0.71789852f +
+                       t * (0.456894865f +
+                            t * (-0.277366571f +
+                                 t * (0.12191566f + t * -0.0260668662f)))));
+}
+
 TEM inline bool lessAbs(const T& v, const T& eps) { return std::abs(v) < eps; }
 
 TEM inline T max(const T& v1, const T& v2, const T& v3) {
@@ -890,6 +955,10 @@ TEM inline T pow8(const T& v) { return pow4(pow2(v)); }
 TEM inline T pow16(const T& v) { return pow4(pow4(v)); }
 TEM inline T pow64(const T& v) { return pow8(pow8(v)); }
 
+inline float powFast(float base, float power) {
+  return exp2Fast(power * log2Fast(base));
+}
+
 TEM inline T powN(T base, unsigned power) {
   switch (power) {
     case 0:
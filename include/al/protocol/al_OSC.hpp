@@ -328,6 +328,9 @@ public:
   /// Send a packet
   size_t send(const Packet &p);
 
+  /// Send encoded packet data, e.g. a bundle assembled by the caller
+  size_t sendRaw(const char *data, size_t size);
+
   /// Send zero argument message immediately
   size_t send(const std::string &addr) {
     addMessage(addr);
@@ -124,6 +124,7 @@ public:
   template <class TSpatializer>
   std::shared_ptr<TSpatializer> setSpatializer(const Speakers &sl) {
     mSpatializer = std::make_shared<TSpatializer>(sl);
+    mSpatializer->maxBatchSize(mSpatializerBatchSize);
     mSpatializer->compile();
     return std::static_pointer_cast<TSpatializer>(mSpatializer);
   }
@@ -131,6 +132,7 @@ public:
   template <class TSpatializer>
   std::shared_ptr<TSpatializer> setSpatializer(const Speakers &&sl) {
     mSpatializer = std::make_shared<TSpatializer>(sl);
+    mSpatializer->maxBatchSize(mSpatializerBatchSize);
     mSpatializer->compile();
     return std::static_pointer_cast<TSpatializer>(mSpatializer);
   }
@@ -222,6 +224,9 @@ protected:
 private:
   // A speaker layout and spatializer
   std::shared_ptr<Spatializer> mSpatializer;
+  // Voice outputs are gathered and passed to the spatializer in batches
+  SpatializerBatch mSpatializerBatch;
+  unsigned int mSpatializerBatchSize{64};
 
   Pose mListenerPose;
   DistAtten<> mDistAtten;
@@ -235,6 +240,7 @@ private:
   bool mThreadedAudio{false};
   std::vector<std::thread> mAudioThreads;
   std::vector<AudioIOData> mThreadedAudioData;
+  std::vector<SpatializerBatch> mThreadedBatches;
   std::map<int, std::vector<int>>
       mThreadMap; // Defines which threads run which voices. Key is thread id,
                   // value is voice ids.
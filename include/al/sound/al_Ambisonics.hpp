@@ -51,7 +51,10 @@
 
 #include <stdio.h>
 
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include "al/math/al_Vec.hpp"
 #include "al/sound/al_Spatializer.hpp"
@@ -113,9 +116,22 @@ namespace al {
 /// @ingroup Sound
 class AmbiBase {
 public:
+  /// Channel ordering and normalization of the spherical harmonics
+  enum Convention {
+    /// Furse-Malham style: W X Y, then the horizontal (sectoral) pairs of
+    /// each order, then the remaining 3D components per order (Z, S T R,
+    /// N O L M K, ...). Weights match encodeWeightsFuMa() up to 3rd order
+    /// and are max-normalized (MaxN) above it.
+    FUMA = 0,
+    /// Ambisonic Channel Number ordering with SN3D normalization (AmbiX).
+    /// In 2D only the sectoral harmonics are used, in ACN order.
+    ACN_SN3D
+  };
+
   /// @param[in] dim		number of spatial dimensions (2 or 3)
   /// @param[in] order	highest spherical harmonic order
-  AmbiBase(int dim, int order);
+  /// @param[in] convention	channel ordering and normalization
+  AmbiBase(int dim, int order, Convention convention = FUMA);
 
   virtual ~AmbiBase();
 
@@ -137,7 +153,35 @@ public:
   /// Set the order
   void order(int order);
 
-  /// Called whenever the number of Ambisonic channels changes
+  /// Get channel ordering and normalization
+  Convention convention() const { return mConvention; }
+
+  /// Set channel ordering and normalization
+  void convention(Convention convention);
+
+  /// Returns the spherical harmonic order (degree) of an Ambisonic channel
+  int channelOrder(int channel) const { return mChannelOrders[channel]; }
+
+  /// Compute spherical harmonic weights for the current dimensions, order and
+  /// convention
+
+  /// @param[out] ws	channels() weights
+  /// @param[in] x,y,z	unit vector in the listener's coordinate frame
+  void encodeWeights(float *ws, float x, float y, float z) const;
+
+  /// Compute spherical harmonic weights for several directions
+
+  /// The harmonics are evaluated with recurrences over the Cartesian
+  /// coordinates (no trigonometric functions), vectorized across directions.
+  /// @param[out] ws		weights of direction i and channel c are written
+  ///						to ws[c * stride + i]
+  /// @param[in] stride	distance between channels in ws, at least count
+  /// @param[in] dirs		unit vectors in the listener's coordinate frame
+  /// @param[in] count		number of directions
+  void encodeWeights(float *ws, int stride, const Vec3f *dirs,
+                     int count) const;
+
+  /// Called whenever the number or layout of Ambisonic channels changes
   virtual void onChannelsChange() {}
 
   static int channelsToUniformOrder(int channels);
@@ -166,16 +210,41 @@ public:
   static int channelsToDimensions(int channels);
 
 protected:
+  // Spherical harmonic of order l and degree m >= 0. Its cosine part (or the
+  // only part for m = 0) is written to cosChannel, its sine part to sinChannel
+  struct Harmonic {
+    int l;
+    int m;
+    int cosChannel;
+    int sinChannel; // -1 when m = 0
+    float cosScale;
+    float sinScale;
+  };
+
   int mDim;        // dimensions - 2d or 3d
-  int mOrder;      // order - 0th, 1st, 2nd, or 3rd
+  int mOrder;      // highest spherical harmonic order
   int mChannels;   // cached for efficiency
   float *mWeights; // weights for each ambi channel
+  Convention mConvention;
+  std::vector<Harmonic> mHarmonics; // sorted by m, then l
+  std::vector<int> mChannelOrders;  // order of each channel
+
+  void updateHarmonics();
 
   template <typename T> static void resize(T *&a, int n);
 };
 
 /// Higher Order Ambisonic Decoding class
 ///
+/// decode() applies the decode matrix (one row per output channel, with the
+/// channel weights folded in) in tiles of frames, four outputs at a time, so
+/// each block of Ambisonic input is read from cache instead of being streamed
+/// once per speaker. Outputs can be split across worker threads, and the
+/// signal can be decoded in two bands (basic below a crossover, max-rE above).
+///
+/// The matrix is rebuilt by the setters and handed to decode() without
+/// locking, so setters can be called while another thread decodes.
+///
 /// @ingroup Sound
 class AmbiDecode : public AmbiBase {
 public:
@@ -219,6 +288,32 @@ public:
   /// Set number of speakers. Positions are zeroed upon resize.
   void numSpeakers(int num);
 
+  /// Set number of threads used by decode(), including the calling thread.
+  /// Output channels are split evenly between threads. The calling thread
+  /// never waits on a lock: rows not picked up by a worker in time are
+  /// decoded by the calling thread. Like the other setters, this can be
+  /// called while another thread decodes and applies from the next block.
+  void numThreads(int num);
+
+  /// Returns number of threads used by decode()
+  int numThreads() const;
+
+  /// Enable or disable dual-band decoding
+
+  /// Below the crossover frequency the Ambisonic signal is decoded with basic
+  /// weights (flavor 0) and above it with max-rE weights (flavor 3),
+  /// regardless of flavor(). The bands are split with a 2nd order low pass
+  /// and its complement, so they sum back to the input.
+  void dualBand(bool enable, float crossoverFrequency = 400.f,
+                float sampleRate = 44100.f);
+
+  /// Returns whether dual-band decoding is enabled
+  bool dualBand() const;
+
+  /// Allocate buffers for blocks of up to framesPerBuffer frames, so decode()
+  /// does not allocate
+  void prepare(int framesPerBuffer);
+
   void setSpeakerRadians(int index, int deviceChannel, float azimuth,
                          float elevation, float amp = 1.f);
 
@@ -246,12 +341,13 @@ protected:
   int mFlavor;          // decode flavor
   float *mDecodeMatrix; // deccoding matrix for each ambi channel & speaker
                         // cols are channels and rows are speakers
-  float mWOrder[5];     // weights for each order
+  std::vector<float> mWOrder; // weights for each order
   Speakers mSpeakers;
   // float * mPositions;		// speakers' azimuths + elevations
   // float * mFrame;			// an ambisonic channel frame used for
   // decode(int)
 
+  void updateOrderWeights();
   void updateChanWeights();
   void resizeArrays(int numChannels, int numSpeakers);
 
@@ -259,6 +355,23 @@ protected:
                int speakerNum); // is this useful?
 
   static float flavorWeights[4][5][5];
+
+  /// Weight of order n for a decoder of the given flavor and order
+  static float orderWeight(int flavor, int n, int order);
+
+private:
+  struct DecodePlan;                     // decode matrix and block buffers
+  struct DecodeEngine;                   // plan handoff and threads
+  std::unique_ptr<DecodeEngine> mEngine; // not const in const decode()
+
+  void updateMatrix();
+  bool takePlan() const;
+  void rowRange(int chunk, int numChunks, int &begin, int &end) const;
+  void decodeRows(int begin, int end) const;
+  void decodeBlock(int numFrames) const;
+  void decodeChunks(uint32_t block) const;
+  void stopThreads();
+  static void decodeThreadFunc(AmbiDecode *decoder);
 };
 
 /// Higher Order Ambisonic encoding class
@@ -268,7 +381,9 @@ class AmbiEncode : public AmbiBase {
 public:
   /// @param[in] dim			number of spatial dimensions (2 or 3)
   /// @param[in] order		highest spherical harmonic order
-  AmbiEncode(int dim, int order) : AmbiBase(dim, order) {}
+  /// @param[in] convention	channel ordering and normalization
+  AmbiEncode(int dim, int order, Convention convention = FUMA)
+      : AmbiBase(dim, order, convention) {}
 
   //	/// Encode input sample and set decoder frame.
   //	void encode   (const AmbiDecode &dec, float input);
@@ -303,6 +418,19 @@ public:
   void encode(float *ambiChans, const XYZ *dir, const float *input,
               int numFrames);
 
+  /// Encode several buffers, each with a constant direction
+
+  /// The weights of all sources are computed in one pass, then each
+  /// Ambisonic channel accumulates the sources four at a time.
+  /// @param[in] ambiChans	Ambisonic domain channels (non-interleaved)
+  /// @param[in] dirs			array of numSources unit vectors in the
+  /// listener's coordinate frame
+  /// @param[in] inputs		array of numSources time-domain buffers
+  /// @param[in] numSources	number of sources
+  /// @param[in] numFrames	number of frames in each buffer
+  void encode(float *ambiChans, const Vec3f *dirs, const float *const *inputs,
+              int numSources, int numFrames);
+
   /// Set spherical direction of source to be encoded
   void direction(float az, float el);
 
@@ -315,6 +443,9 @@ public:
   void direction(float x, float y, float z);
 
   void print(std::ostream &stream);
+
+private:
+  std::vector<float> mSourceWeights; // [channel][source] for batch encoding
 };
 
 /// Ambisonic coder
@@ -328,7 +459,8 @@ public:
 
   void zeroAmbi();
 
-  void configure(int dim, int order, int flavor);
+  void configure(int dim, int order, int flavor,
+                 AmbiBase::Convention convention = AmbiBase::FUMA);
 
   float *ambiChans(unsigned channel = 0);
 
@@ -346,6 +478,12 @@ public:
                             const float *samples,
                             const unsigned int &numFrames) override;
 
+  virtual void renderBuffers(AudioIOData &io, const Vec3f *positions,
+                             const float *const *samples,
+                             const unsigned int &numSources,
+                             const unsigned int &numFrames,
+                             const uint64_t *sourceIds = nullptr) override;
+
   virtual void renderSample(AudioIOData &io, const Vec3f &pos,
                             const float &sample,
                             const unsigned int &frameIndex) override;
@@ -372,40 +510,28 @@ inline int AmbiBase::orderToChannels(int dim, int order) {
 inline int AmbiBase::orderToChannelsH(int orderH) { return (orderH << 1) + 1; }
 inline int AmbiBase::orderToChannelsV(int orderV) { return orderV * orderV; }
 
+// Full 3D sets have (order + 1)^2 channels and 2D sets 2 * order + 1. Odd
+// squares (9, 25, 49, ...) fit both and are taken as 3D.
 inline int AmbiBase::channelsToOrder(int channels) {
-  int order = -1;
-  switch (channels) {
-  case 3:
-  case 4:
-    order = 1;
-    break;
-  case 9:
-    order = 2;
-    break;
-  case 16:
-    order = 3;
-    break;
-  default:
-    order = -1;
+  if (channels < 3) {
+    return -1;
   }
-  return order;
+  int root = int(std::sqrt(double(channels)) + 0.5);
+  if (root * root == channels) {
+    return root - 1;
+  }
+  return (channels & 1) ? (channels - 1) / 2 : -1;
 }
 
 inline int AmbiBase::channelsToDimensions(int channels) {
-  int dim = 3;
-  switch (channels) {
-  case 3:
-    dim = 2;
-    break;
-  case 4:
-  case 9:
-  case 16:
-    dim = 3;
-    break;
-  default:
-    dim = -1;
+  if (channels < 3) {
+    return -1;
+  }
+  int root = int(std::sqrt(double(channels)) + 0.5);
+  if (root * root == channels) {
+    return 3;
   }
-  return dim;
+  return (channels & 1) ? 2 : -1;
 }
 
 template <typename T> void AmbiBase::resize(T *&a, int n) {
@@ -446,36 +572,25 @@ inline float AmbiDecode::decode(float *encFrame, int encNumChannels,
 //}
 
 inline void AmbiEncode::direction(float az, float el) {
-  AmbiBase::encodeWeightsFuMa(mWeights, mDim, mOrder, az, el);
+  float cosel = std::cos(el);
+  encodeWeights(mWeights, std::cos(az) * cosel, std::sin(az) * cosel,
+                mDim >= 3 ? std::sin(el) : 0.f);
 }
 
 inline void AmbiEncode::direction(Vec3f vector) {
-  AmbiBase::encodeWeightsFuMa(mWeights, mDim, mOrder, vector.x, vector.y,
-                              vector.z);
+  encodeWeights(mWeights, vector.x, vector.y, vector.z);
 }
 
 inline void AmbiEncode::direction(float x, float y, float z) {
-  AmbiBase::encodeWeightsFuMa(mWeights, mDim, mOrder, x, y, z);
+  encodeWeights(mWeights, x, y, z);
 }
 
 inline void AmbiEncode::encode(float *ambiChans, int numFrames, int timeIndex,
                                float timeSample) const {
-// "Iterate" through spherical harmonics using Duff's device.
-// This requires only a simple jump per time sample.
-#define CS(chanindex)                                                          \
-  case chanindex:                                                              \
-    ambiChans[chanindex * numFrames + timeIndex] +=                            \
-        weights()[chanindex] * timeSample;
-  int ch = channels() - 1;
-  switch (ch) {
-    CS(15)
-    CS(14)
-    CS(13)
-    CS(12)
-    CS(11)
-    CS(10) CS(9) CS(8) CS(7) CS(6) CS(5) CS(4) CS(3) CS(2) CS(1) CS(0) default:;
+  float *ambi = ambiChans + timeIndex;
+  for (int c = 0; c < channels(); ++c) {
+    ambi[c * numFrames] += weights()[c] * timeSample;
   }
-#undef CS
 }
 
 inline void AmbiEncode::encode(float *ambiChans, const float *input,
@@ -501,7 +616,7 @@ void AmbiEncode::encode(float *ambiChans, const XYZ *dir, const float *input,
   // Ideally we only want to change the position for each time sample.
   // However, for our loops to be most efficient, we want the inner loop
   // to process over time since it will have around 64-512 iterations
-  // while the spatial loop will have at most 16 iterations.
+  // while the spatial loop has one iteration per Ambisonic channel.
 
   /* outer-space, inner-time
   for(int c=0; c<channels(); ++c){
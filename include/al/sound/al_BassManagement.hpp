@@ -0,0 +1,92 @@
+#ifndef INCLUDE_AL_BASSMANAGEMENT_HPP
+#define INCLUDE_AL_BASSMANAGEMENT_HPP
+
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_Crossover.hpp"
+#include "al/sound/al_Speaker.hpp"
+#include "al/sound/al_SpeakerAdjustment.hpp"
+
+namespace al {
+
+/**
+ * @brief Route low frequencies from the main speakers to subwoofers
+ *
+ * Each main channel is high passed at the crossover frequency, and its low
+ * band is added to the subwoofer channels, with 4th order Linkwitz-Riley
+ * filters so that the bands sum flat. Since the filters are linear, the
+ * mains are mixed down for each subwoofer first and low passed once per
+ * subwoofer instead of once per main channel. Anything already in the
+ * subwoofer channels, like an LFE signal, is kept.
+ *
+ * Each subwoofer has a gain and a delay. The default delay aligns the
+ * subwoofer with the farthest speaker, the same reference used by
+ * SpeakerDistanceTimeAdjustment.
+ *
+ * @code
+ * BassManagement bassManagement;
+ * bassManagement.configure(mainSpeakers, subwoofers, 80,
+ *                          audioIO().framesPerSecond(),
+ *                          audioIO().framesPerBuffer());
+ * audioIO().append(bassManagement);
+ * @endcode
+ *
+ * @ingroup Sound
+ */
+class BassManagement : public AudioCallback {
+ public:
+  enum Routing {
+    ALL_SUBWOOFERS,    ///< Every main feeds all subwoofers equally
+    NEAREST_SUBWOOFER  ///< Every main feeds the subwoofer closest in angle
+  };
+
+  /// @param[in] mains            full range speakers
+  /// @param[in] subwoofers       subwoofer speakers
+  /// @param[in] crossoverFreq    crossover frequency in Hz
+  /// @param[in] sampleRate       sampling rate
+  /// @param[in] framesPerBuffer  largest expected audio buffer size
+  /// @param[in] routing          how mains are distributed to subwoofers
+  void configure(const Speakers &mains, const Speakers &subwoofers,
+                 double crossoverFreq, double sampleRate,
+                 int framesPerBuffer, Routing routing = ALL_SUBWOOFERS);
+
+  /// Set crossover frequency in Hz
+  void crossoverFrequency(double freq);
+
+  /// Set level of the low band of a main speaker sent to the subwoofers
+  void sendGain(int main, float gain);
+
+  /// Set gain of a subwoofer
+  void subwooferGain(int sub, float gain);
+
+  /// Set delay of a subwoofer in samples
+  void subwooferDelay(int sub, float samples);
+
+  /// Clear filter and delay state
+  void reset();
+
+  virtual void onAudioCB(AudioIOData &io);
+
+ private:
+  void updateSends();
+
+  Speakers mMains;
+  Speakers mSubwoofers;
+  Routing mRouting{ALL_SUBWOOFERS};
+  CrossoverBank mMainFilters;  // high band only
+  CrossoverBank mSubFilters;   // low band only
+  SpeakerDistanceTimeAdjustment mSubAdjustment;
+  std::vector<float> mSendGains;  // per main
+  std::vector<float> mSends;      // per subwoofer, per main
+  std::vector<float> mSubGains;
+  std::vector<float> mMix;  // per subwoofer, framesPerBuffer samples
+  std::vector<float *> mMainChannels;
+  std::vector<float *> mMixChannels;
+  int mFramesPerBuffer{0};
+  bool mWarned{false};
+};
+
+}  // namespace al
+
+#endif  // INCLUDE_AL_BASSMANAGEMENT_HPP
@@ -5,8 +5,12 @@
 #ifndef __AL_BIQUAD__
 #define __AL_BIQUAD__
 
+#include <vector>
+
 namespace al {
 
+class AudioIOData;
+
 /* this holds the data required to update samples thru a filter */
 typedef struct {
   double a0, a1, a2, a3, a4;
@@ -24,6 +28,24 @@ enum BIQUADTYPE {
   BIQUAD_HSH    /* High shelf filter */
 };
 
+/// Biquad coefficients normalized by a0
+///
+/// @ingroup Sound
+struct BiQuadCoefficients {
+  double b0{1}, b1{0}, b2{0}, a1{0}, a2{0};
+
+  /// Coefficients as computed by BiQuad::set(), bandwidth in octaves
+  static BiQuadCoefficients design(BIQUADTYPE type, double freq,
+                                   double sampleRate, double bandwidth = 1.9,
+                                   double dbGain = 0);
+
+  /// Coefficients from quality factor q. Q = 0.7071 gives a Butterworth
+  /// low or high pass
+  static BiQuadCoefficients designQ(BIQUADTYPE type, double freq,
+                                    double sampleRate, double q,
+                                    double dbGain = 0);
+};
+
 ///
 /// \brief The BiQuad class
 ///
@@ -69,6 +91,84 @@ class BiQuadNX {
   BiQuad *mFilters;
 };
 
+/// Bank of biquad filters for many channels
+///
+/// Channels are processed in groups of kLanes in parallel, with one lane
+/// per channel. Each channel has a cascade of numSections() transposed
+/// direct form II sections with its own coefficients, in single precision.
+/// The lanes of a group are interleaved in blocks of kBlock frames, so the
+/// filter recurrence runs across channels in vectorizable loops instead of
+/// sample by sample within one channel.
+///
+/// @code
+/// BiQuadBank eq(64, 2, 48000);
+/// eq.set(-1, 0, BIQUAD_HSH, 8000, 1.0, -3.0);  // all channels
+/// eq.set(5, 1, BIQUAD_PEQ, 120, 1.0, 4.0);     // channel 5 only
+/// eq.process(io);  // channels 0 to 63 of io.out()
+/// @endcode
+///
+/// @ingroup Sound
+class BiQuadBank {
+ public:
+  static const int kLanes = 8;   ///< channels processed together
+  static const int kBlock = 64;  ///< frames interleaved at a time
+
+  BiQuadBank(int numChannels = 0, int numSections = 1,
+             double sampleRate = 44100);
+
+  /// Set number of channels and sections per channel
+  ///
+  /// Sections are reset to pass through and filter state is cleared.
+  void resize(int numChannels, int numSections = 1);
+
+  int numChannels() const { return mNumChannels; }
+  int numSections() const { return mNumSections; }
+
+  /// Set sample rate used by set() and setQ()
+  void setSampleRate(double rate) { mSampleRate = rate; }
+
+  /// Design a section like BiQuad::set(). Channel -1 sets all channels
+  void set(int channel, int section, BIQUADTYPE type, double freq,
+           double bandwidth = 1.9, double dbGain = 0);
+
+  /// Design a section from a quality factor. Channel -1 sets all channels
+  void setQ(int channel, int section, BIQUADTYPE type, double freq,
+            double q, double dbGain = 0);
+
+  /// Set section coefficients. Channel -1 sets all channels
+  void coefficients(int channel, int section, const BiQuadCoefficients &c);
+
+  /// Filter numFrames of each channel from in to out. Buffers may be the
+  /// same
+  void process(const float *const *in, float *const *out, int numFrames);
+
+  /// Filter buffers in place
+  void process(float *const *buffers, int numFrames) {
+    process(buffers, buffers, numFrames);
+  }
+
+  /// Filter io.out() channels in place, starting at firstChannel
+  void process(AudioIOData &io, int firstChannel = 0);
+
+  /// Clear filter state
+  void clear();
+
+ private:
+  float *sectionCoefs(int group, int section) {
+    return mCoefs.data() + (group * mNumSections + section) * 5 * kLanes;
+  }
+
+  int mNumChannels{0};
+  int mNumSections{0};
+  double mSampleRate;
+  // Per group and section: b0, b1, b2, a1, a2, each for kLanes lanes
+  std::vector<float> mCoefs;
+  // Per group and section: s1, s2, each for kLanes lanes
+  std::vector<float> mState;
+  std::vector<float> mScratch;
+  std::vector<float *> mChannels;
+};
+
 }  // namespace al
 
 #endif /* defined(__AL_BIQUAD__) */
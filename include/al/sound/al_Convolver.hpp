@@ -0,0 +1,118 @@
+#ifndef INCLUDE_AL_CONVOLVER_HPP
+#define INCLUDE_AL_CONVOLVER_HPP
+
+#include <memory>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+
+namespace al {
+
+/**
+ * @brief Multichannel partitioned FFT convolution
+ *
+ * Convolves audio channels with impulse responses, e.g. room correction
+ * filters for each speaker or long reverb responses. Each route filters one
+ * input channel with one impulse response into one output channel. Routes
+ * that share an output channel are summed, and the result replaces the
+ * channel contents. Channels refer to io.out() channels, so the convolver
+ * processes what the main audio callback has rendered when appended to
+ * AudioIO.
+ *
+ * The head of the impulse responses is convolved with uniform partitions of
+ * blockSize samples in the audio callback. With maxPartitionSize larger
+ * than blockSize the rest is split into progressively larger partitions
+ * that are convolved on background threads, so the audio callback cost
+ * does not grow with the impulse response length. Every partition starts at
+ * twice its size, which gives each background thread one full partition
+ * period to finish its work. Output has no added latency when the audio
+ * buffer size is a multiple of blockSize.
+ *
+ * configure() and load() allocate and must not be called while the
+ * convolver is processing.
+ *
+ * @code
+ * Convolver roomCorrection;
+ * roomCorrection.load("correction.wav", {0, 1, 2, 3}, {0, 1, 2, 3},
+ *                     audioIO().framesPerBuffer());
+ * audioIO().append(roomCorrection);
+ * @endcode
+ *
+ * @ingroup Sound
+ */
+class Convolver : public AudioCallback {
+ public:
+  Convolver();
+  ~Convolver();
+
+  /// @param[in] irs               impulse response for each route
+  /// @param[in] inputChannels     channel filtered by each route
+  /// @param[in] outputChannels    channel written by each route
+  /// @param[in] blockSize         partition size processed in the audio
+  /// callback. Must be a power of two
+  /// @param[in] maxPartitionSize  largest partition size for the late part
+  /// of the responses. 0 convolves everything with blockSize partitions
+  /// @return false if the arguments are invalid
+  bool configure(const std::vector<std::vector<float>> &irs,
+                 const std::vector<int> &inputChannels,
+                 const std::vector<int> &outputChannels, int blockSize,
+                 int maxPartitionSize = 0);
+
+  /// Filter channel i in place with irs[i]
+  bool configure(const std::vector<std::vector<float>> &irs, int blockSize,
+                 int maxPartitionSize = 0);
+
+  /// Load impulse responses from a sound file, one route per file channel
+  ///
+  /// A mono file is used for all routes.
+  bool load(const char *path, const std::vector<int> &inputChannels,
+            const std::vector<int> &outputChannels, int blockSize,
+            int maxPartitionSize = 0);
+
+  /// Convolve late partitions on background threads (default) or in the
+  /// calling thread. Output is identical in both cases
+  void backgroundThreads(bool on);
+
+  /// Clear all convolution state
+  void reset();
+
+  /// Number of routes
+  int numRoutes() const { return int(mInputChannels.size()); }
+
+  /// Partition sizes in use, from the head to the tail
+  std::vector<int> partitionSizes() const;
+
+  /// Process numFrames of each input into the outputs
+  ///
+  /// inputs and outputs are indexed by channel number like io.out(). Output
+  /// channels without routes are not touched. numFrames must be a multiple
+  /// of the block size.
+  void process(const float *const *inputs, float *const *outputs,
+               int numFrames);
+
+  virtual void onAudioCB(AudioIOData &io);
+
+ private:
+  struct Segment;
+  struct Level;
+
+  void processBlock(const float *const *inputs, float *const *outputs);
+  void clearLevels();
+
+  std::vector<int> mInputChannels;
+  std::vector<int> mOutputChannels;
+  std::vector<int> mInputs;   // distinct input channels
+  std::vector<int> mOutputs;  // distinct output channels
+  std::vector<std::unique_ptr<Level>> mLevels;
+  std::vector<std::vector<float>> mInputCopy;
+  std::vector<const float *> mBlockInputs;
+  std::vector<float *> mBlockOutputs;
+  std::vector<float *> mChannels;
+  int mBlockSize{0};
+  bool mBackground{true};
+  bool mSizeWarning{false};
+};
+
+}  // namespace al
+
+#endif  // INCLUDE_AL_CONVOLVER_HPP
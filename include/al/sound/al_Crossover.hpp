@@ -46,9 +46,13 @@
 */
 
 #include <float.h>
+#include <math.h>
 #include <stdio.h>
 
+#include <vector>
+
 #include "al/math/al_Constants.hpp"
+#include "al/sound/al_Biquad.hpp"
 
 namespace al {
 
@@ -82,11 +86,11 @@ protected:
   T mC0, mC1, mZ0, mZ1, mZ2;
 };
 
-template <> void Crossover<double>::freq(double f, double fs) {
+template <> inline void Crossover<double>::freq(double f, double fs) {
   double rad = M_PI * 2. * f / fs;
   double cosine = cos(rad);
   double sine = sin(rad);
-  if (abs(c) > 0.0001) {
+  if (fabs(cosine) > 0.0001) {
     mC0 = (sine - 1.) / cosine;
   } else {
     mC0 = cosine * 0.5;
@@ -115,7 +119,7 @@ inline void Crossover<double>::next(const double in, double *lo, double *hi) {
   *hi = x0 - x2;
 }
 
-template <> void Crossover<float>::freq(float f, float fs) {
+template <> inline void Crossover<float>::freq(float f, float fs) {
   float rad = M_PI * 2.f * f / fs;
   float cosine = cosf(rad);
   float sine = sinf(rad);
@@ -148,5 +152,56 @@ inline void Crossover<float>::next(const float in, float *lo, float *hi) {
   *hi = x0 - x2;
 }
 
+/**
+ * Multichannel Linkwitz-Riley crossover built on BiQuadBank
+ *
+ * Splits each channel into low and high bands with 4th order
+ * Linkwitz-Riley filters (two Butterworth sections per band). Like
+ * Crossover, the two bands sum to an allpass, so they can be filtered or
+ * routed separately and recombined without a notch at the crossover
+ * frequency.
+ *
+ * @ingroup Sound
+ */
+class CrossoverBank {
+public:
+  CrossoverBank(int numChannels = 0, double freq = 80,
+                double sampleRate = 44100) {
+    configure(numChannels, freq, sampleRate);
+  }
+
+  /// Set number of channels, crossover frequency and sample rate
+  void configure(int numChannels, double freq, double sampleRate);
+
+  /// Set crossover frequency, keeping filter state
+  void freq(double f);
+
+  double freq() const { return mFreq; }
+
+  int numChannels() const { return mLow.numChannels(); }
+
+  /// Split numFrames of each input channel into low and high bands
+  ///
+  /// Either output may be the input buffers, but not both. An output that
+  /// is the input must be so for every channel, in the same order: outputs
+  /// that alias only some inputs, or other channels' inputs, are not
+  /// supported (checked by assertions in debug builds). A null output array
+  /// skips that band.
+  void process(const float *const *in, float *const *lo, float *const *hi,
+               int numFrames);
+
+  /// Clear filter state
+  void clear() {
+    mLow.clear();
+    mHigh.clear();
+  }
+
+protected:
+  BiQuadBank mLow;
+  BiQuadBank mHigh;
+  double mFreq{80};
+  double mSampleRate{44100};
+};
+
 } // namespace al
 #endif
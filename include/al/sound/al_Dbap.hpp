@@ -52,10 +52,20 @@
 
 namespace al {
 
-#define DBAP_MAX_NUM_SPEAKERS 192
-
 /// Distance-based amplitude panner
 ///
+/// Speaker positions are stored as separate x, y and z arrays, so any number
+/// of speakers can be used and gains for all speakers are computed in a
+/// single vectorizable loop.
+///
+/// Sources passed to renderBuffers() with a source id keep their position and
+/// gains from block to block. If a source has moved less than the position
+/// tolerance, the previous gains are reused. Otherwise new gains are computed
+/// and ramped from the previous ones across the block. A source that is not
+/// rendered in a block is forgotten at the next prepare(), so prepare() should
+/// be called once per block, as DynamicScene does. Sources without an id are
+/// rendered with fresh gains and no ramp.
+///
 /// @ingroup Sound
 class Dbap : public Spatializer {
   // do not hide base class functions
@@ -66,12 +76,21 @@ class Dbap : public Spatializer {
   /// @param[in] focus	Amplitude focus to nearby speakers
   Dbap(const Speakers& sl, float focus = 1.f);
 
+  virtual void compile() override;
+
+  virtual void prepare(AudioIOData& io) override;
+
   virtual void renderSample(AudioIOData& io, const Vec3f &pos,
                             const float& sample,
                             const unsigned int& frameIndex) override;
   virtual void renderBuffer(AudioIOData& io, const Vec3f &pos,
                             const float* samples,
                             const unsigned int& numFrames) override;
+  virtual void renderBuffers(AudioIOData& io, const Vec3f* positions,
+                             const float* const* samples,
+                             const unsigned int& numSources,
+                             const unsigned int& numFrames,
+                             const uint64_t* sourceIds = nullptr) override;
 
   /// focus is an exponent determining the amplitude focus to nearby speakers.
 
@@ -80,14 +99,54 @@ class Dbap : public Spatializer {
   /// layout may benefit from focus < 1
   void setFocus(float focus) { mFocus = focus; }
 
+  /// Sources that have moved less than this distance reuse their gains
+  void setPositionTolerance(float tolerance) {
+    mPositionTolerance = tolerance;
+  }
+
+  /// Ramp gains across the block when a source moves. On by default
+  void setGainRamp(bool ramp) { mGainRamp = ramp; }
+
+  /// Set number of sources that keep gain state. Call compile() after
+  void setMaxCachedSources(unsigned int num) { mMaxCachedSources = num; }
+
   void print(std::ostream& stream) override;
 
  private:
-  //	Listener * mListener;
-  Vec3f mSpeakerVecs[DBAP_MAX_NUM_SPEAKERS];
-  unsigned int mDeviceChannels[DBAP_MAX_NUM_SPEAKERS];
-  size_t mNumSpeakers;
+  // Compute gains for all speakers for position in audio space
+  void computeGains(const Vec3f& relpos, float* gains);
+
+  // Fill start and end gains for source. Returns true if gains change across
+  // the block.
+  bool updateSource(const Vec3f& pos, uint64_t id, float* startGains,
+                    float* endGains);
+
+  // Render at most mMaxBatchSize sources
+  void renderBatch(AudioIOData& io, const Vec3f* positions,
+                   const float* const* samples, unsigned int numSources,
+                   unsigned int numFrames, const uint64_t* sourceIds);
+
+  std::vector<float> mSpeakerX;
+  std::vector<float> mSpeakerY;
+  std::vector<float> mSpeakerZ;
+  std::vector<unsigned int> mDeviceChannels;
+  size_t mNumSpeakers{0};
   float mFocus;
+  float mPositionTolerance{0.0001f};
+  bool mGainRamp{true};
+
+  // Per source state, in slots found by source id
+  unsigned int mMaxCachedSources{256};
+  SpatializerSourceSlots mSlots;
+  std::vector<Vec3f> mSlotPositions;
+  std::vector<float> mSlotFocus;
+  std::vector<float> mSlotGains;  // [slot][speaker]
+
+  // Scratch buffers for renderBuffers(), [source][speaker], sized for
+  // mMaxBatchSize sources
+  std::vector<float> mStartGains;
+  std::vector<float> mEndGains;
+  std::vector<char> mRamps;
 };
 
 }  // namespace al
@@ -0,0 +1,133 @@
+#ifndef INCLUDE_AL_DISKRECORDER_HPP
+#define INCLUDE_AL_DISKRECORDER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/types/al_SingleRWRingBuffer.hpp"
+
+namespace al {
+
+/**
+ * @brief Record audio channels to disk from the audio thread
+ * @ingroup Sound
+ *
+ * The audio callback only copies the selected channels into a preallocated
+ * lock-free ring buffer. A writer thread interleaves, converts and writes
+ * them to disk, so a slow disk never blocks the audio thread. When the
+ * ring is full the block is dropped and counted instead.
+ *
+ * WAV files are limited to 4 GB by their 32-bit sizes. A WAV recording that
+ * reaches the limit continues in a new file named with a suffix, e.g.
+ * take_2.wav after take.wav. W64 and raw files have no limit unless one is
+ * set with splitBytes(). Files can have any number of channels.
+ *
+ * Append the recorder after the processing to record:
+ *
+ * @code
+ * DiskRecorder recorder;
+ * recorder.addChannels(DiskRecorder::OUTPUT, 0, 64);
+ * recorder.start("take.w64", audioIO().framesPerSecond(), DiskRecorder::W64);
+ * audioIO().append(recorder);
+ * ...
+ * recorder.stop();
+ * @endcode
+ */
+class DiskRecorder : public AudioCallback {
+ public:
+  enum Format {
+    WAV,  ///< RIFF wave, split every 4 GB
+    W64,  ///< Sony Wave64
+    RAW   ///< interleaved samples without a header
+  };
+
+  enum Encoding { INT16, INT24, FLOAT32 };
+
+  enum Source { OUTPUT, BUS, INPUT };
+
+  struct Channel {
+    Source source;
+    unsigned int index;
+  };
+
+  DiskRecorder();
+  ~DiskRecorder();
+
+  /// Record a channel. Channels can only be changed while stopped.
+  /// Channels the io doesn't have are recorded as silence
+  void addChannel(Source source, unsigned int index);
+  void addChannels(Source source, unsigned int first, unsigned int count);
+  void clearChannels();
+  const std::vector<Channel> &channels() const { return mChannels; }
+
+  /// Continue in a new file after this many bytes of audio. 0 only splits
+  /// WAV files at 4 GB. Takes effect on the next start()
+  void splitBytes(uint64_t bytes) { mSplitBytes = bytes; }
+  uint64_t splitBytes() const { return mSplitBytes; }
+
+  /// Open the file and start recording
+  ///
+  /// @param[in] path           output file
+  /// @param[in] sampleRate     sample rate written to the header
+  /// @param[in] format         file format
+  /// @param[in] encoding       sample encoding
+  /// @param[in] bufferSeconds  audio the ring buffer holds while the disk
+  ///                           stalls
+  /// @return false if already recording, no channels are selected or the
+  /// file can't be opened
+  bool start(const std::string &path, double sampleRate, Format format = WAV,
+             Encoding encoding = FLOAT32, double bufferSeconds = 4.0);
+
+  /// Stop recording, write what is buffered and close the file
+  void stop();
+
+  bool isRecording() const { return mRecording.load(); }
+
+  /// Frames written to disk
+  uint64_t framesWritten() const { return mFramesWritten.load(); }
+  /// Frames dropped because the ring buffer was full
+  uint64_t droppedFrames() const { return mDroppedFrames.load(); }
+  /// Audio buffers dropped because the ring buffer was full
+  uint64_t overflows() const { return mOverflows.load(); }
+  /// Highest ring buffer use as a fraction of its size
+  float maxFill() const { return mMaxFill.load(); }
+  /// Number of files written, more than one when a WAV recording is split
+  int files() const { return mFiles.load(); }
+  /// True if writing to disk failed. Later audio is discarded
+  bool writeFailed() const { return mWriteFailed.load(); }
+
+  void onAudioCB(AudioIOData &io) override;
+
+ private:
+  struct Writer;
+
+  void writerThread();
+
+  std::vector<Channel> mChannels;
+  std::unique_ptr<SingleRWRingBuffer> mRing;
+  std::unique_ptr<Writer> mWriter;
+  size_t mRingCapacity{0};
+  std::vector<float> mZeros;
+  std::thread mThread;
+  uint64_t mSplitBytes{0};
+
+  std::atomic<bool> mRecording{false};
+  std::atomic<int> mInCallback{0};
+  std::atomic<bool> mStopWriter{false};
+
+  std::atomic<uint64_t> mFramesWritten{0};
+  std::atomic<uint64_t> mDroppedFrames{0};
+  std::atomic<uint64_t> mOverflows{0};
+  std::atomic<float> mMaxFill{0};
+  std::atomic<int> mFiles{0};
+  std::atomic<bool> mWriteFailed{false};
+};
+
+}  // namespace al
+
+#endif  // INCLUDE_AL_DISKRECORDER_HPP
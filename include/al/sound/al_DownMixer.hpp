@@ -9,6 +9,7 @@
 namespace al {
 
 class AudioIOData;
+class Parameter;
 
 /**
  *  DownMixer uses buses in AudioIOData. If you are using buses in your
@@ -18,25 +19,82 @@ on the first buffer it processes.
 
 DownMixer will downmix to buffers, and can optionally copy the buses to outputs
                                        using the setOutputs() function.
+
+The routing is compiled into a sparse gain matrix with one row of
+(input, gain) terms per output whenever it is set, so processing a block only
+walks flat arrays. Outputs fed by a single input are copied or scaled
+directly, which makes identity and one-to-one routings cheap.
+
+An optional master gain can be set directly or taken from a Parameter. Gain
+changes are ramped linearly over one buffer to avoid zipper noise.
  */
 class DownMixer {
 public:
+  typedef std::map<uint32_t, std::vector<std::pair<uint32_t, float>>>
+      RoutingMap;
+
   // Configure channel mapping
   void layoutToStereo(const Speakers &sl, AudioIOData &io);
   void set5_1toStereo(AudioIOData &io);
 
+  /// Set a custom routing
+  ///
+  /// Maps each input channel to a list of (output, gain) pairs. Outputs are
+  /// numbered from 0 and each one gets its own bus.
+  void setRouting(const RoutingMap &routing, AudioIOData &io);
+
+  /// Route input channels to outputs one to one with unity gain
+  void setIdentity(unsigned numChannels, AudioIOData &io);
+
+  const RoutingMap &routing() const { return mRoutingMap; }
+
+  /// Number of outputs (buses) of the current routing
+  unsigned numOutputs() const { return unsigned(mRowStart.size()) - 1; }
+
   void setStereoOutput();
   void setOutputs(std::vector<uint32_t> outs);
 
+  /// Set master gain. Changes are ramped over the next buffer
+  void gain(float g) { mTargetGain = g; }
+  float gain() const { return mTargetGain; }
+
+  /// Read the master gain from a parameter on every buffer. nullptr to stop
+  void gainParameter(Parameter *param) { mGainParameter = param; }
+
   // process
   void downMix(AudioIOData &io);
   void downMixToBus(AudioIOData &io);
   void copyBusToOuts(AudioIOData &io);
 
+  /// Apply the routing to raw buffers
+  ///
+  /// inputs must provide every input channel referenced by the routing and
+  /// outputs numOutputs() buffers. Outputs are overwritten. Inputs and
+  /// outputs must not overlap.
+  void process(const float *const *inputs, float *const *outputs,
+               int numFrames);
+
 private:
-  std::map<uint32_t, std::vector<std::pair<uint32_t, float>>> mRoutingMap;
+  void compile();
+  void allocateBuses(AudioIOData &io);
+
+  RoutingMap mRoutingMap;
   std::vector<uint32_t> mOuts;
   int mBusStartNumber = -1;
+  int mNumBuses = 0;
+
+  // Compiled routing, one row of terms per output
+  std::vector<uint32_t> mRowStart{0};
+  std::vector<uint32_t> mInputs;
+  std::vector<float> mGains;
+  uint32_t mNumInputs = 0;
+
+  Parameter *mGainParameter = nullptr;
+  float mTargetGain = 1.0f;
+  float mCurrentGain = 1.0f;
+  std::vector<const float *> mInputBuffers;
+  std::vector<float *> mOutputBuffers;
+  std::vector<float> mZeros;
 };
 
 } // namespace al
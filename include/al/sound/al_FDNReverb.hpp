@@ -0,0 +1,141 @@
+#ifndef INCLUDE_AL_FDNREVERB_HPP
+#define INCLUDE_AL_FDNREVERB_HPP
+
+#include <vector>
+
+namespace al {
+
+/**
+ * @brief Multichannel feedback delay network reverberator
+ *
+ * A block processing alternative to Reverb for many output channels. A
+ * mono input is diffused and fed to a set of delay lines whose outputs are
+ * mixed with an orthogonal matrix and fed back through damping filters.
+ * Each output channel taps all delay lines with its own pattern of signs.
+ * When there are more outputs than delay lines, further groups of outputs
+ * tap the lines at extra delays, which keeps the reverberation decorrelated
+ * for any number of speakers.
+ *
+ * Feedback is computed for whole blocks up to the shortest delay length,
+ * so the mixing matrix and the delay line reads and writes work on
+ * contiguous arrays.
+ *
+ * The bandwidth(), damping(), decay() and diffusion() parameters behave
+ * like the ones in Reverb.
+ *
+ * @code
+ * FDNReverb reverb;
+ * reverb.configure(numSpeakers, 16, audioIO().framesPerSecond());
+ * reverb.decayTime(2.5);
+ * reverb.process(monoIn, outputs, numFrames);
+ * @endcode
+ *
+ * @ingroup Sound
+ */
+class FDNReverb {
+ public:
+  enum Mixing {
+    HADAMARD,   ///< Fast Walsh-Hadamard transform, numLines power of two
+    HOUSEHOLDER ///< Householder reflection, any numLines
+  };
+
+  FDNReverb();
+
+  /// Allocate delay lines and clear state
+  ///
+  /// @param[in] numOutputs  number of decorrelated output channels
+  /// @param[in] numLines    number of delay lines. HADAMARD mixing needs a
+  /// power of two
+  /// @param[in] sampleRate  sampling rate in Hz
+  /// @param[in] roomSize    scales delay lengths. 1 gives 25 to 100 ms
+  void configure(int numOutputs, int numLines = 16,
+                 double sampleRate = 44100, float roomSize = 1.0f);
+
+  /// Set feedback mixing matrix
+  ///
+  /// HADAMARD falls back to HOUSEHOLDER while the number of lines is not a
+  /// power of two, and is used again once configure() sets one that is.
+  FDNReverb &mixing(Mixing m);
+
+  /// Requested feedback mixing
+  Mixing mixing() const { return mMixing; }
+
+  /// Feedback mixing in use for the current number of lines
+  Mixing effectiveMixing() const { return mEffectiveMixing; }
+
+  /// Set input signal bandwidth, in [0,1]
+  FDNReverb &bandwidth(float v);
+
+  /// Set high-frequency damping amount, in [0, 1]
+  FDNReverb &damping(float v);
+
+  /// Set decay factor, in [0, 1), per average delay line length
+  FDNReverb &decay(float v);
+
+  /// Set decay as the time in seconds to decay by 60 dB
+  FDNReverb &decayTime(float seconds);
+
+  /// Set input diffusion amount, in [0,1)
+  FDNReverb &diffusion(float v);
+
+  /// Set output gain
+  FDNReverb &gain(float v);
+
+  /// Compute wet output from dry mono input
+  ///
+  /// @param[in] in        numFrames input samples
+  /// @param[out] outputs  numOutputs buffers of numFrames samples to write
+  /// @param[in] numFrames number of samples to process
+  void process(const float *in, float *const *outputs, int numFrames);
+
+  /// Clear all delay lines and filters
+  void zero();
+
+  int numOutputs() const { return mNumOutputs; }
+  int numLines() const { return int(mLines.size()); }
+
+  /// Delay line length in samples
+  int delayLength(int line) const { return mLines[line].length; }
+
+ private:
+  struct Line {
+    std::vector<float> buffer;  // power of two ring buffer
+    int length{0};
+    float feedback{0};  // decay gain for this length
+    float filterState{0};
+    float inputSign{1};
+  };
+
+  void updateMixing();
+  void updateFeedback();
+  void diffuseInput(const float *in, int numFrames);
+  void readLine(int line, int delay, int numFrames, float *dest);
+
+  std::vector<Line> mLines;
+  std::vector<float> mBlock;     // one block per delay line
+  std::vector<float> mTapBlock;   // output taps of later output groups
+  std::vector<float> mOutSigns;  // per output, per line
+  std::vector<int> mTapOffsets;  // per output group, per line
+  std::vector<float> mInput;
+  std::vector<float> mSum;
+  std::vector<float> mDiffusers[2];
+  int mDiffuserPos[2]{0, 0};
+  float mInputState{0};
+  int mNumOutputs{0};
+  int mMask{0};
+  int mWritePos{0};
+  int mBlockSize{0};
+  double mSampleRate{44100};
+  Mixing mMixing{HADAMARD};          // requested
+  Mixing mEffectiveMixing{HADAMARD}; // used for the current line count
+  float mBandwidth{0.9995f};
+  float mDamping{0.4f};
+  float mDecay{0.85f};
+  float mDecayTime{-1};
+  float mDiffusion{0.7f};
+  float mGain{0.6f};
+};
+
+}  // namespace al
+
+#endif  // INCLUDE_AL_FDNREVERB_HPP
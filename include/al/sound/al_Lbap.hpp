@@ -44,8 +44,10 @@
         Andres Cabrera 2018 mantaraya36@gmail.com
 */
 
+#include <cmath>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "al/math/al_Vec.hpp"
 #include "al/sound/al_Speaker.hpp"
@@ -63,18 +65,30 @@ public:
     elevation = 0;
     for (auto speaker : sl) {
       elevation += speaker.elevation;
+      channels.push_back(speaker.deviceChannel);
     }
     elevation /= sl.size(); // store average elevation
+    // assumes circular ring (all elevations and radii equal)
+    edgeElevation = sl[0].elevation;
+    dispersionBaseGain = 1.0 / sqrt(sl.size());
     vbap = std::make_unique<Vbap>(sl);
     vbap->compile();
   }
 
   std::unique_ptr<Vbap> vbap;
   float elevation;
+  float edgeElevation; // elevation of the first speaker, used for dispersion
+  float dispersionBaseGain;         // gain of each speaker in full dispersion
+  std::vector<unsigned int> channels; // device channels of the ring speakers
 };
 
 /// Layer-based amplitude panner
 ///
+/// compile() sorts the rings and stores the sine of each ring's elevation, so
+/// the rings around a source are found by binary search on the source
+/// direction. The gains of all outputs for a source are gathered in one
+/// vector and applied to the buffer once per output.
+///
 /// @ingroup Sound
 class Lbap : public Spatializer {
 public:
@@ -86,12 +100,6 @@ public:
   /// @param[in] sl	A speaker layout
   Lbap(const Speakers &sl) : Spatializer(sl) {}
 
-  virtual ~Lbap() override {
-    if (buffer) {
-      free(buffer);
-    }
-  }
-
   void compile() override;
 
   void prepare(AudioIOData &io) override;
@@ -118,12 +126,34 @@ public:
   void renderBuffer(AudioIOData &io, const Vec3f &reldir, const float *samples,
                     const unsigned int &numFrames) override;
 
+  /// Source ids are passed on to the ring panners, see Vbap
+  void renderBuffers(AudioIOData &io, const Vec3f *positions,
+                     const float *const *samples,
+                     const unsigned int &numSources,
+                     const unsigned int &numFrames,
+                     const uint64_t *sourceIds = nullptr) override;
+
   void print(std::ostream &stream = std::cout) override;
 
 private:
   std::vector<LdapRing> mRings;
-  float *buffer{nullptr}; // Two consecutive buffers (non-interleaved)
-  int bufferSize{0};
+  std::vector<float> mRingSines; // sin(elevation) of each ring, descending
+
+  // Output gains for the current source
+  std::vector<unsigned int> mOutputChannels;
+  std::vector<float> mOutputGains;
+  // Ring panner gains for the current source
+  std::vector<unsigned int> mRingChannels;
+  std::vector<float> mRingGains;
+
+  /// Fill mOutputChannels and mOutputGains for a source direction
+  void computeOutputGains(const Vec3f &reldir, uint64_t id = NO_SOURCE_ID);
+
+  /// Add the output gains of a ring scaled by gain. fraction is the position
+  /// of the source between the ring edge (0) and the pole (1), and sets the
+  /// amount of dispersion to the whole ring
+  void addRingGains(LdapRing &ring, const Vec3f &reldir, float fraction,
+                    float gain, uint64_t id);
 
   float mDispersionOffset = 0.5; // fraction of (zenith - elev) angle at which
                                  // dispersion starts.
@@ -0,0 +1,139 @@
+#ifndef INCLUDE_AL_RESAMPLER_HPP
+#define INCLUDE_AL_RESAMPLER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace al {
+
+/**
+ * @brief Windowed-sinc polyphase sample rate converter
+ *
+ * Converts interleaved multichannel audio between two integer sample rates
+ * with a Kaiser windowed sinc filter. The conversion ratio is kept as an
+ * exact fraction, so the output never drifts against the input. When the
+ * reduced ratio needs few enough filter phases they are all precomputed,
+ * otherwise coefficients are interpolated linearly between neighbouring
+ * phases of a finer table.
+ *
+ * The filter is centered on each output sample, so output frame n
+ * corresponds to input time n * inputRate / outputRate with no delay.
+ * Streaming needs halfTaps() input frames of lookahead.
+ *
+ * convert() processes whole buffers offline on several threads. process()
+ * and pull() convert streams of arbitrary block sizes, e.g. a
+ * SoundFileStreaming or a live input running at a different rate:
+ *
+ * @code
+ * Resampler resampler(file.sampleRate(), 48000, file.numChannels());
+ * resampler.pull(buffer, io.framesPerBuffer(), [&](float *b, uint64_t n) {
+ *   return file.getFrames(n, b);
+ * });
+ * @endcode
+ *
+ * @ingroup Sound
+ */
+class Resampler {
+ public:
+  /// Filter length and stopband attenuation presets
+  enum Quality {
+    FAST = 0,  ///< 24 taps, 60 dB
+    MEDIUM,    ///< 48 taps, 90 dB
+    HIGH,      ///< 96 taps, 110 dB
+    BEST       ///< 192 taps, 130 dB
+  };
+
+  /// Source of input frames for pull(). Writes up to numFrames interleaved
+  /// frames into buffer and returns the number written, 0 at the end.
+  typedef std::function<uint64_t(float *buffer, uint64_t numFrames)> Source;
+
+  Resampler() {}
+  Resampler(unsigned int inputRate, unsigned int outputRate, int channels,
+            Quality quality = HIGH);
+
+  /// Design the filter for a conversion. Resets the stream state
+  /// @return false if the arguments are invalid
+  bool configure(unsigned int inputRate, unsigned int outputRate,
+                 int channels, Quality quality = HIGH);
+
+  unsigned int inputRate() const { return mInputRate; }
+  unsigned int outputRate() const { return mOutputRate; }
+  int channels() const { return mChannels; }
+  Quality quality() const { return mQuality; }
+
+  /// Filter taps on each side of an output sample, in input frames
+  int halfTaps() const { return mTaps / 2; }
+
+  /// Edge of the passband as a fraction of the lower Nyquist frequency
+  double passband() const { return mPassband; }
+
+  /// Number of output frames for inputFrames input frames
+  uint64_t outputFrames(uint64_t inputFrames) const;
+
+  /// Convert a whole interleaved buffer
+  ///
+  /// Input outside the buffer is taken as silence. numThreads 0 uses all
+  /// cores. Does not touch the stream state.
+  void convert(const float *input, uint64_t inputFrames, float *output,
+               uint64_t outputFrames, int numThreads = 0) const;
+
+  /// Clear the stream state
+  void reset();
+
+  /// Append interleaved input frames and write as many output frames as are
+  /// available, up to maxOutputFrames
+  ///
+  /// Input that is not consumed is kept for the next call. Buffers grow to
+  /// the largest block size seen, so pass blocks of similar sizes from the
+  /// audio thread.
+  /// @return number of output frames written
+  uint64_t process(const float *input, uint64_t inputFrames, float *output,
+                   uint64_t maxOutputFrames);
+
+  /// Input frames still missing to produce numOutputFrames output frames
+  uint64_t inputFramesNeeded(uint64_t numOutputFrames) const;
+
+  /// Write numOutputFrames output frames, reading input from source as
+  /// needed
+  ///
+  /// When the source ends the filter tail is flushed and the rest of the
+  /// output is silence until reset().
+  /// @return number of output frames produced, less than numOutputFrames
+  /// once the source has ended
+  uint64_t pull(float *output, uint64_t numOutputFrames,
+                const Source &source);
+
+ private:
+  const float *coefficients(uint64_t phase, float *scratch) const;
+  void append(const float *input, uint64_t inputFrames);
+
+  unsigned int mInputRate{0};
+  unsigned int mOutputRate{0};
+  int mChannels{0};
+  Quality mQuality{HIGH};
+  double mPassband{0};
+
+  // Output frame n is at input time n * mStep / mDenominator
+  uint64_t mStep{1};
+  uint64_t mDenominator{1};
+
+  int mTaps{0};
+  bool mExactPhases{true};
+  uint64_t mNumPhases{1};
+  std::vector<float> mTable;  // mTaps coefficients per phase
+
+  // Stream state. mHistory holds each channel with mTaps / 2 - 1 frames of
+  // past input before the frame at mIndex
+  std::vector<std::vector<float>> mHistory;
+  std::vector<float> mCoefficients;
+  std::vector<float> mPullBuffer;
+  uint64_t mFill{0};
+  uint64_t mIndex{0};
+  uint64_t mPhase{0};
+  bool mFlushed{false};
+};
+
+}  // namespace al
+
+#endif  // INCLUDE_AL_RESAMPLER_HPP
@@ -0,0 +1,133 @@
+#ifndef INCLUDE_AL_STFT_HPP
+#define INCLUDE_AL_STFT_HPP
+
+#include <functional>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/math/al_FFT.hpp"
+#include "al/types/al_TripleBuffer.hpp"
+
+namespace al {
+
+/**
+ * @brief Streaming short-time Fourier transform with overlap-add resynthesis
+ *
+ * Input is collected into overlapping windows that are hopSize samples
+ * apart. For each window the spectrum is computed, passed to the spectrum
+ * callback, where it can be modified, and its magnitudes are published for
+ * other threads. With resynthesis enabled, the spectra are transformed back
+ * and overlap-added, delaying the signal by windowSize samples.
+ *
+ * Resynthesis applies the window a second time and divides by the overlapped
+ * sum of the squared window, so the signal is reconstructed for any hop up
+ * to windowSize as long as every sample falls inside some window. Hops that
+ * divide the window so that the squared window overlap-adds to a constant
+ * (at most windowSize / 4 for Hann) also keep the synthesis window smooth,
+ * which matters when spectra are modified.
+ *
+ * As an AudioCallback it analyzes one channel of io.out(), and replaces it
+ * with the resynthesized signal if resynthesis is on.
+ *
+ * @code
+ * STFT stft(2048, 512);
+ * audioIO().append(stft);
+ * // graphics thread
+ * if (stft.updateMagnitudes()) {
+ *   const std::vector<float> &mags = stft.magnitudes();
+ * }
+ * @endcode
+ *
+ * @ingroup Sound
+ */
+class STFT : public AudioCallback {
+ public:
+  enum WindowType { RECTANGLE, HANN, HAMMING, BLACKMAN };
+
+  /// @param[in] windowSize  samples per analysis window
+  /// @param[in] hopSize     samples between windows
+  /// @param[in] fftSize     transform size, at least windowSize. 0 uses the
+  /// smallest supported size. Larger sizes zero pad the window
+  STFT(unsigned int windowSize = 1024, unsigned int hopSize = 256,
+       WindowType windowType = HANN, unsigned int fftSize = 0);
+
+  /// Reallocates and clears all state
+  void configure(unsigned int windowSize, unsigned int hopSize,
+                 WindowType windowType = HANN, unsigned int fftSize = 0);
+
+  /// Set function called with the spectrum of each window
+  ///
+  /// Called from the processing thread. The spectrum can be modified in
+  /// place before resynthesis.
+  void onSpectrum(
+      std::function<void(float *re, float *im, unsigned int bins)> func) {
+    mSpectrumFunc = func;
+  }
+
+  /// Transform spectra back to audio (default off)
+  void resynthesis(bool on) { mResynthesis = on; }
+  bool resynthesis() const { return mResynthesis; }
+
+  /// Channel processed by onAudioCB()
+  void channel(unsigned int c) { mChannel = c; }
+  unsigned int channel() const { return mChannel; }
+
+  /// Process a block of samples
+  ///
+  /// @param[in] in    numFrames input samples
+  /// @param[out] out  numFrames resynthesized samples, or nullptr
+  /// @return number of spectra computed
+  int process(const float *in, float *out, unsigned int numFrames);
+
+  virtual void onAudioCB(AudioIOData &io);
+
+  /// Clear input and output state
+  void reset();
+
+  unsigned int windowSize() const { return mWindowSize; }
+  unsigned int hopSize() const { return mHopSize; }
+  unsigned int fftSize() const { return mFFT.size(); }
+  unsigned int bins() const { return mFFT.bins(); }
+
+  /// Delay of the resynthesized output in samples
+  unsigned int latency() const { return mWindowSize; }
+
+  /// Spectrum of the last window. Only valid in the processing thread
+  const float *real() const { return mRe.data(); }
+  const float *imag() const { return mIm.data(); }
+
+  /// Fetch the latest published magnitudes. Call from the reading thread
+  ///
+  /// @return true if new magnitudes arrived since the last call
+  bool updateMagnitudes() { return mMagnitudes.update(); }
+
+  /// Magnitudes fetched by updateMagnitudes(), normalized so that a full
+  /// scale sine gives about 1.0 in its bin
+  const std::vector<float> &magnitudes() const {
+    return mMagnitudes.readBuffer();
+  }
+
+ private:
+  void computeFrame();
+
+  RFFT mFFT;
+  unsigned int mWindowSize{0};
+  unsigned int mHopSize{0};
+  unsigned int mPos{0};
+  unsigned int mChannel{0};
+  bool mResynthesis{false};
+  float mMagnitudeScale{1.0f};
+  std::vector<float> mWindow;
+  std::vector<float> mSynthesisWindow;  // mWindow over its overlap sum
+  std::vector<float> mInput;
+  std::vector<float> mOutput;
+  std::vector<float> mFrame;
+  std::vector<float> mRe;
+  std::vector<float> mIm;
+  std::function<void(float *, float *, unsigned int)> mSpectrumFunc;
+  TripleBuffer<std::vector<float>> mMagnitudes;
+};
+
+}  // namespace al
+
+#endif  // INCLUDE_AL_STFT_HPP
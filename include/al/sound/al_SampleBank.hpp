@@ -0,0 +1,248 @@
+#ifndef INCLUDE_AL_SAMPLEBANK_HPP
+#define INCLUDE_AL_SAMPLEBANK_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "al/sound/al_SoundFile.hpp"
+
+namespace al {
+
+class FileList;
+class SampleBank;
+
+/**
+ * @brief Progress of a SampleBank::loadAll() batch
+ * @ingroup Sound
+ *
+ * Files are read by at most ioConcurrency threads at a time and decoded in
+ * parallel by the worker threads. Every sample can be waited on separately,
+ * so audio can start while the rest of the library loads. The batch keeps
+ * its samples in use, so they are not evicted while it exists. Destroying
+ * the batch waits for the remaining files.
+ */
+class BatchLoad {
+public:
+  typedef std::shared_ptr<const SoundFile> Handle;
+
+  /// Outcome of loading one file
+  struct Result {
+    std::string path;
+    Handle sample;      ///< nullptr if the file couldn't be loaded
+    bool cached{false}; ///< already in the bank, nothing was read
+    double readSeconds{0};
+    double decodeSeconds{0};
+    size_t fileBytes{0};
+  };
+
+  /// Called on a worker thread after each file with the number of files
+  /// completed so far. Workers may call it concurrently
+  typedef std::function<void(const Result &result, size_t completed,
+                             size_t total)>
+      Callback;
+
+  struct Options {
+    int numThreads{0};    ///< decoding threads. 0 uses all cores
+    int ioConcurrency{2}; ///< files read from disk at the same time
+    Callback onLoaded;
+  };
+
+  ~BatchLoad();
+
+  size_t size() const { return mPaths.size(); }
+  const std::string &path(size_t index) const { return mPaths[index]; }
+
+  /// Future of the sample at index. get() waits for it
+  std::shared_future<Handle> sample(size_t index) const {
+    return mSamples[index];
+  }
+
+  size_t completed() const { return mCompleted.load(); }
+  size_t failed() const { return mFailed.load(); }
+  float progress() const {
+    return size() ? float(completed()) / size() : 1.0f;
+  }
+  bool done() const { return completed() == size(); }
+
+  /// Wait for every file
+  void wait();
+
+  /// Results of the files completed so far, in completion order
+  std::vector<Result> results();
+
+  /// Wall clock time from the start of the batch to the last file completed
+  double seconds();
+
+private:
+  friend class SampleBank;
+  BatchLoad() {}
+  BatchLoad(const BatchLoad &) = delete;
+  BatchLoad &operator=(const BatchLoad &) = delete;
+
+  std::vector<std::string> mPaths;
+  std::vector<std::shared_future<Handle>> mSamples;
+  // Bank entries this batch loads. Files already cached or loading
+  // elsewhere have no promise
+  std::vector<uint64_t> mIds;
+  std::vector<std::unique_ptr<std::promise<Handle>>> mPromises;
+  Options mOptions;
+
+  std::atomic<size_t> mNext{0};
+  std::atomic<size_t> mCompleted{0};
+  std::atomic<size_t> mFailed{0};
+  std::vector<std::thread> mWorkers;
+
+  std::mutex mLock;
+  std::condition_variable mCondition; // signals I/O slots and completion
+  int mReading{0};
+  std::vector<Result> mResults;
+  std::chrono::steady_clock::time_point mStart;
+  double mSeconds{0};
+};
+
+/**
+ * @brief Shared cache of decoded sound files
+ * @ingroup Sound
+ *
+ * Hands out shared, immutable SoundFile handles keyed by path, so every
+ * voice playing a sample shares one decoded copy and the file is decoded
+ * once. An entry is reloaded when the modification time or size of the
+ * file changes. Existing handles keep the old data.
+ *
+ * The memory budget limits the decoded data kept for samples that are not
+ * in use. When it is exceeded, entries that no handle refers to are evicted
+ * least recently used first. Samples in use are never evicted, so the total
+ * can exceed the budget.
+ *
+ * All functions are thread-safe. get() decodes on the calling thread when
+ * the file is not cached, so preload() samples from the main thread before
+ * voices request them in init():
+ *
+ * @code
+ * SampleBank::instance().preload("kick.wav");
+ * ...
+ * void init() override { sample = SampleBank::instance().get("kick.wav"); }
+ * @endcode
+ *
+ * loadAll() loads a whole library on a pool of threads and reports its
+ * progress:
+ *
+ * @code
+ * auto batch = SampleBank::instance().loadDirectory("samples");
+ * while (!batch->done()) {
+ *   std::cout << int(100 * batch->progress()) << "%" << std::endl;
+ *   std::this_thread::sleep_for(std::chrono::milliseconds(100));
+ * }
+ * @endcode
+ */
+class SampleBank {
+public:
+  typedef std::shared_ptr<const SoundFile> Handle;
+
+  /// @param[in] budgetBytes  memory for unused samples. 0 is unlimited
+  SampleBank(size_t budgetBytes = 0);
+  ~SampleBank();
+
+  /// Process-wide bank
+  static SampleBank &instance();
+
+  /// Get a sample, loading it if needed
+  ///
+  /// Waits if the sample is being preloaded.
+  /// @return nullptr if the file can't be read
+  Handle get(const std::string &path);
+
+  /// Load a sample on the background thread
+  void preload(const std::string &path);
+
+  /// Load many samples in parallel
+  ///
+  /// Returns immediately. Samples that are cached or already loading are
+  /// shared with the batch. The bank must outlive the batch.
+  std::shared_ptr<BatchLoad> loadAll(const std::vector<std::string> &paths,
+                                     const BatchLoad::Options &options);
+  std::shared_ptr<BatchLoad> loadAll(const std::vector<std::string> &paths);
+  std::shared_ptr<BatchLoad> loadAll(FileList &files);
+
+  /// Load the wav and flac files in a directory in parallel
+  std::shared_ptr<BatchLoad> loadDirectory(const std::string &dir,
+                                           bool recursive = false);
+
+  /// True if the sample is cached and loaded
+  bool isLoaded(const std::string &path);
+
+  /// Set the memory budget in bytes. 0 is unlimited
+  void budget(size_t bytes);
+  size_t budget();
+
+  /// Bytes of decoded data held by the bank
+  size_t memoryUsage();
+
+  /// Drop every sample that is not in use
+  void evictUnused();
+
+  uint64_t hits();
+  uint64_t misses();
+  uint64_t evictions();
+  void resetCounters();
+
+private:
+  struct Entry {
+    uint64_t id{0};
+    std::shared_future<Handle> sample;
+    double modified{0};
+    uint64_t fileSize{0};
+    size_t bytes{0};
+    std::list<std::string>::iterator lru;
+  };
+
+  struct PendingLoad {
+    std::string path;
+    uint64_t id;
+    std::promise<Handle> promise;
+  };
+
+  // Find a current entry or insert a pending one. Returns true if the
+  // caller must load the file and fulfil load.promise
+  bool lookup(const std::string &path, std::shared_future<Handle> &sample,
+              PendingLoad &load);
+  void load(PendingLoad &load);
+  // Account for a decoded file and fulfil the load. file is nullptr if it
+  // couldn't be read
+  void finish(const std::string &path, uint64_t id,
+              std::promise<Handle> &promise, std::shared_ptr<SoundFile> file);
+  void loadBatch(BatchLoad &batch);
+  void enforceBudget();
+  void loaderThread();
+
+  std::mutex mLock;
+  std::map<std::string, Entry> mEntries;
+  std::list<std::string> mLru; // most recently used first
+  size_t mBudget{0};
+  size_t mBytes{0};
+  uint64_t mHits{0};
+  uint64_t mMisses{0};
+  uint64_t mEvictions{0};
+  uint64_t mNextId{0};
+
+  std::deque<PendingLoad> mQueue;
+  std::condition_variable mQueueCondition;
+  std::thread mLoader;
+  bool mRunning{true};
+};
+
+} // namespace al
+
+#endif // INCLUDE_AL_SAMPLEBANK_HPP
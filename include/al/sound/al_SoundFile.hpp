@@ -2,6 +2,8 @@
 #define INCLUDE_AL_SOUNDFILE_HPP
 
 #include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace al {
@@ -33,19 +35,113 @@ struct SoundFile {
   //  ~SoundFile() = default;
 
   bool open(const char *path);
+  /// Decode a wav or flac file already read into memory. The format is
+  /// detected from the data
+  bool openMemory(const void *encoded, size_t size);
   float *getFrame(long long int frame); // unsafe, without frameCount check
+  const float *getFrame(long long int frame) const;
 };
 
+/// @brief Convert a sound file to another sample rate
+///
+/// Uses a high quality Resampler on all cores. The result has the same
+/// duration as the original.
+/// @ingroup Sound
 SoundFile getResampledSoundFile(SoundFile *toConvert,
                                 unsigned int newSampleRate);
 
+/**
+ * @brief Memory-mapped view of a wav file
+ * @ingroup Sound
+ *
+ * Maps 16, 24 and 32 bit integer and 32 bit float wav files instead of
+ * decoding them, so opening is immediate and only the parts that are played
+ * are loaded into memory. Float files are served directly from the mapping.
+ * Integer files are converted on demand, either straight into the caller's
+ * buffer by read() or into a small cache of blocks for frame().
+ *
+ * Pages are loaded by the operating system on first access, which can
+ * block. Call preload() ahead of playback for regions that must not stall
+ * the audio thread.
+ *
+ * A view is not thread-safe: read from one thread at a time.
+ */
+class SoundFileView {
+public:
+  SoundFileView() {}
+  SoundFileView(const char *path) { open(path); }
+  ~SoundFileView();
+
+  /// Map a wav file
+  ///
+  /// @param[in] path         wav file
+  /// @param[in] cacheBlocks  number of converted blocks kept for frame()
+  bool open(const char *path, int cacheBlocks = 8);
+  void close();
+  bool isOpen() const { return mData != nullptr; }
+
+  int sampleRate() const { return mSampleRate; }
+  int channels() const { return mChannels; }
+  long long int frameCount() const { return mFrameCount; }
+  /// Bits per sample in the file
+  int bitsPerSample() const { return mBits; }
+  /// True if the samples are served without conversion
+  bool isZeroCopy() const { return mFloat && mAligned; }
+
+  /// Copy interleaved frames starting at frame into buffer
+  /// @return number of frames copied, less than numFrames at the end
+  long long int read(long long int frame, long long int numFrames,
+                     float *buffer);
+
+  /// Pointer to an interleaved frame, nullptr past the end
+  ///
+  /// For converted files the pointer is valid until the next call and for
+  /// the rest of its cache block only.
+  const float *frame(long long int frame);
+
+  /// Ask the operating system to load a range of frames in the background
+  void preload(long long int frame, long long int numFrames);
+
+private:
+  void unmap();
+
+  const unsigned char *mData{nullptr}; // first sample in the mapping
+  void *mMapping{nullptr};
+  size_t mMappingSize{0};
+  void *mFileMapping{nullptr}; // Windows mapping handle
+  int mSampleRate{0};
+  int mChannels{0};
+  long long int mFrameCount{0};
+  int mBits{0};
+  bool mFloat{false};
+  bool mAligned{false};
+
+  // Converted blocks for frame(), direct mapped by block index
+  std::vector<float> mCache;
+  std::vector<long long int> mCacheBlock;
+};
+
 /// @brief Soundfile player class
 /// @ingroup Sound
+///
+/// Plays a SoundFile, or a SoundFileView when soundFileView is set.
+///
+/// At rates other than 1 the file is interpolated a block at a time with the
+/// interpolators of al_Interpolation.hpp. Negative rates play backwards.
+/// With bandLimit set, rates faster than 1 use a windowed sinc filter with
+/// its cutoff lowered to the new Nyquist frequency to avoid aliasing.
 struct SoundFilePlayer {
+  enum Interpolation { LINEAR, CUBIC, HERMITE };
+
   long long int frame = 0;
+  double frameFraction = 0.0; // position between frame and frame + 1
+  double rate = 1.0;          // playback speed, negative plays backwards
+  Interpolation interpolation = CUBIC;
+  bool bandLimit = false;
   bool pause = true;
   bool loop = false;
-  SoundFile *soundFile = nullptr; // non-owning
+  const SoundFile *soundFile = nullptr; // non-owning
+  SoundFileView *soundFileView = nullptr; // non-owning
 
   // In case of adding some constructor other than default constructor,
   //   remember to implement or explicitly specify related functions
@@ -61,12 +157,38 @@ struct SoundFilePlayer {
   //  ~SoundFilePlayer() = default;
 
   void getFrames(uint64_t numFrames, float *buffer, int bufferLength);
+
+private:
+  void getFramesInterpolated(uint64_t numFrames, float *buffer,
+                             int bufferLength);
+  // Copy frames, wrapping when looping and with silence outside the file
+  void readSpan(long long int first, long long int count, float *dest);
+
+  // Scratch for getFramesInterpolated(), grown to the largest block
+  std::vector<float> mSpan;
+  std::vector<int> mIndex;
+  std::vector<float> mFraction;
+  std::vector<float> mWeights;
 };
 
 /**
  * @brief The SoundFileStreaming class provides reading soundifle directly from
  * disk one buffer at a time.
  *
+ * Reads wav and flac files. A shared pool of I/O threads decodes ahead of
+ * the playback position into a lock-free ring buffer for each stream, so
+ * getFrames() only copies and never touches the disk. If the I/O threads
+ * fall behind, getFrames() outputs silence for the missing frames, counts
+ * an underrun and skips the same number of frames once data arrives, which
+ * keeps streams that are played together in sync.
+ *
+ * seek(), loop() and the loop points can be set from any thread. Seeking
+ * discards the read-ahead, so the next buffers are silent until the I/O
+ * thread has refilled it.
+ *
+ * For offline processing call blocking(true) to have getFrames() wait for
+ * the I/O thread instead.
+ *
  * This is a simple reading class with few options, if you need more
  * comprehensive support, use the soundfile module in al_ext
  */
@@ -85,24 +207,53 @@ public:
   uint16_t numChannels();
 
   /// Open file for reading.
-  bool open(const char *path);
+  ///
+  /// @param[in] path          wav or flac file
+  /// @param[in] bufferFrames  frames to read ahead
+  bool open(const char *path, uint64_t bufferFrames = 32768);
   /// Close file and cleanup
   void close();
   /// Read interleaved frames into preallocated buffer;
+  ///
+  /// @return numFrames, or the frames left at the end of the file. The rest
+  /// of the buffer is filled with silence.
   uint64_t getFrames(uint64_t numFrames, float *buffer);
 
+  /// Move the playback position. Can be called from any thread
+  void seek(uint64_t frame);
+
+  /// Loop between the loop points instead of stopping at the end
+  void loop(bool on);
+  bool loop();
+  /// Set loop points. end 0 is the end of the file
+  void loopPoints(uint64_t begin, uint64_t end = 0);
+
+  /// Wait for the I/O thread in getFrames() instead of underrunning
+  void blocking(bool on);
+
+  /// Number of getFrames() calls that could not be served completely
+  uint64_t underruns();
+  /// Number of frames replaced by silence in underruns
+  uint64_t underrunFrames();
+
+  /// Number of threads reading ahead for all streams. Default 2
+  static void numIOThreads(unsigned int n);
+
 private:
-  void *mImpl{nullptr};
+  struct Impl;
+  std::unique_ptr<Impl> mImpl;
 };
 
 /// @brief Soundfile player class with thread-safe access to playback controls
 /// @ingroup Sound
 struct SoundFilePlayerTS {
   SoundFile soundFile;
+  std::shared_ptr<const SoundFile> sharedSoundFile;
   SoundFilePlayer player;
   std::atomic<bool> pauseSignal;
   std::atomic<bool> loopSignal;
   std::atomic<bool> rewindSignal;
+  std::atomic<double> rateSignal{1.0};
   std::atomic<bool> playingState{false};
   // TODO - volume and fading
 
@@ -125,6 +276,10 @@ struct SoundFilePlayerTS {
     return ret;
   }
 
+  /// Play a sample shared through SampleBank::instance() instead of
+  /// decoding a private copy into soundFile
+  bool openShared(const char *path);
+
   void setPlay() { pauseSignal.store(false); }
   void setPause() { pauseSignal.store(true); }
   void togglePause() { pauseSignal.store(!pauseSignal.load()); }
@@ -134,13 +289,17 @@ struct SoundFilePlayerTS {
   void setLoop() { loopSignal.store(true); }
   void setNoLoop() { loopSignal.store(false); }
 
+  void setRate(double rate) { rateSignal.store(rate); }
+
   bool isPlaying() { return playingState.load(); }
 
   void getFrames(int numFrames, float *buffer, int bufferLength) {
     player.pause = pauseSignal.load();
     player.loop = loopSignal.load();
+    player.rate = rateSignal.load();
     if (rewindSignal.exchange(false)) {
       player.frame = 0;
+      player.frameFraction = 0.0;
     }
     player.getFrames(numFrames, buffer, bufferLength);
     playingState.store(player.pause);
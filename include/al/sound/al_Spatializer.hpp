@@ -42,6 +42,7 @@
     Ryan McGee, 2012, ryanmichaelmcgee@gmail.com
 */
 
+#include <cstdint>
 #include <iostream>
 
 #include "al/io/al_AudioIOData.hpp"
@@ -55,6 +56,9 @@ namespace al {
 /// @ingroup Sound
 class Spatializer {
 public:
+  /// Source id for sources that are not tracked across blocks
+  static constexpr uint64_t NO_SOURCE_ID = ~uint64_t(0);
+
   /// @param[in] sl	A speaker layout to use
   Spatializer(const Speakers &sl);
 
@@ -74,6 +78,25 @@ public:
                             const float *samples,
                             const unsigned int &numFrames) = 0;
 
+  /// Render a batch of sources, each with its own position and buffer
+  ///
+  /// @param[in] io         audio data to render into
+  /// @param[in] positions  array of numSources source positions
+  /// @param[in] samples    array of numSources buffers of numFrames samples
+  /// @param[in] numSources number of sources in the batch
+  /// @param[in] numFrames  number of frames in each source buffer
+  /// @param[in] sourceIds  optional array of numSources ids that identify
+  /// each source from block to block, or NO_SOURCE_ID
+  ///
+  /// The default implementation calls renderBuffer() for each source.
+  /// Spatializers override this to share work across sources, and may use
+  /// the ids to keep per source state such as previous gains.
+  virtual void renderBuffers(AudioIOData &io, const Vec3f *positions,
+                             const float *const *samples,
+                             const unsigned int &numSources,
+                             const unsigned int &numFrames,
+                             const uint64_t *sourceIds = nullptr);
+
   /// Render audio sample in position
   virtual void renderSample(AudioIOData &io, const Vec3f &pos,
                             const float &sample,
@@ -95,11 +118,96 @@ public:
   /// Set number of frames
   virtual void numFrames(unsigned int v) { mNumFrames = v; }
 
+  /// Set the largest number of sources expected in one renderBuffers() call
+  ///
+  /// Spatializers size their scratch buffers for this many sources in
+  /// compile(), so call compile() after changing it. Larger batches are still
+  /// rendered, in several passes.
+  void maxBatchSize(unsigned int v) { mMaxBatchSize = v > 0 ? v : 1; }
+  unsigned int maxBatchSize() const { return mMaxBatchSize; }
+
 protected:
   Speakers mSpeakers;
 
   std::vector<float> mBuffer; // temporary frame buffer
   unsigned int mNumFrames{0};
+  unsigned int mMaxBatchSize{64};
+};
+
+/// Collects sources to be rendered in a single Spatializer::renderBuffers()
+/// call.
+///
+/// Sample data is copied into internal storage, so the source buffer can be
+/// reused after add(). Storage is allocated by configure() and add() returns
+/// false when the batch is full, in which case it should be rendered and
+/// cleared before adding more sources.
+///
+/// @ingroup Sound
+class SpatializerBatch {
+public:
+  /// Allocate storage for maxSources sources of numFrames each
+  void configure(unsigned int maxSources, unsigned int numFrames);
+
+  /// Add a source to the batch. Returns false if batch is full.
+  ///
+  /// id identifies the source across blocks, see
+  /// Spatializer::renderBuffers()
+  bool add(const Vec3f &pos, const float *samples,
+           uint64_t id = Spatializer::NO_SOURCE_ID);
+
+  /// Render all sources in batch and clear it
+  void render(Spatializer &spatializer, AudioIOData &io);
+
+  /// Remove all sources from batch
+  void clear() { mNumSources = 0; }
+
+  unsigned int size() const { return mNumSources; }
+  unsigned int capacity() const { return (unsigned int)mPositions.size(); }
+  bool full() const { return mNumSources == mPositions.size(); }
+
+private:
+  std::vector<Vec3f> mPositions;
+  std::vector<const float *> mBuffers;
+  std::vector<uint64_t> mIds;
+  std::vector<float> mSamples;
+  unsigned int mNumFrames{0};
+  unsigned int mNumSources{0};
+};
+
+/// Assigns state slots to source ids for spatializers that keep per source
+/// state from block to block.
+///
+/// find() returns the slot of a source, assigning a free one to sources not
+/// seen before. nextBlock() should be called once per block, from the
+/// spatializer's prepare(): it frees the slots of sources that were not found
+/// since the previous call. Lookups are constant time and never allocate.
+///
+/// @ingroup Sound
+class SpatializerSourceSlots {
+public:
+  /// Allocate maxSources slots and forget all sources
+  void configure(unsigned int maxSources);
+
+  /// Slot of source id, or -1 for NO_SOURCE_ID or when all slots are in use
+  ///
+  /// isNew is set when the slot was just assigned, so it holds no state for
+  /// this source.
+  int find(uint64_t id, bool &isNew);
+
+  /// Start a new block, freeing slots of sources not found in the last one
+  void nextBlock();
+
+  unsigned int size() const { return (unsigned int)mIds.size(); }
+
+private:
+  void rebuildTable();
+
+  uint32_t mBlock{0};
+  std::vector<uint64_t> mIds;
+  std::vector<uint32_t> mBlocks; // Block the source was last found in
+  std::vector<char> mUsed;
+  std::vector<unsigned int> mFree;
+  std::vector<int> mTable; // Open addressing hash table of slots by id
 };
 
 } // namespace al
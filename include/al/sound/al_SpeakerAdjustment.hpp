@@ -1,6 +1,7 @@
 #ifndef AL_SPEAKERADJUSTMENT
 #define AL_SPEAKERADJUSTMENT
 
+#include <cstdint>
 #include <vector>
 
 #include "al/io/al_AudioIOData.hpp"
@@ -53,20 +54,80 @@ class SpeakerDistanceGainAdjustmentProcessor
   using SpeakerDistanceGainAdjustment::processGains;
 };
 
-// FIXME implemement time adjustment for speaker distances
+/**
+ * @brief Delay speakers so that sound from all speakers arrives together
+ *
+ * Each speaker is delayed by the time sound takes to travel the difference
+ * between the farthest speaker distance and its own distance. Delays are
+ * split into an integer and a fractional part. The integer part is read from
+ * a power of two ring buffer per channel with block copies. Channels with a
+ * fractional part are linearly interpolated in a single pass over the block.
+ * An optional gain per speaker is applied in the same pass, so this can also
+ * replace SpeakerDistanceGainAdjustment.
+ *
+ * All memory is allocated in configure(). Buffers larger than the configured
+ * framesPerBuffer are processed in chunks.
+ */
 class SpeakerDistanceTimeAdjustment {
  public:
-  //  void configure(Speakers layout, uint64_t framesPerBuffer);
+  /// @param[in] layout            speaker layout. Radius is in meters
+  /// @param[in] framesPerBuffer   largest expected audio buffer size
+  /// @param[in] framesPerSecond   sampling rate
+  /// @param[in] speedOfSound      speed of sound in meters per second
+  void configure(Speakers layout, uint64_t framesPerBuffer,
+                 double framesPerSecond, double speedOfSound = 343.0);
+
+  /// Set delay in samples for a speaker (index into the layout)
+  ///
+  /// Delay lines are reallocated, and cleared, if the delay is longer than
+  /// they can hold.
+  void delay(size_t index, float samples);
+
+  /// Get delay in samples for a speaker (index into the layout)
+  float delay(size_t index) const { return mDelays[index]; }
+
+  /// Set gains to apply per speaker together with the delays
+  ///
+  /// Use the gains computed by SpeakerDistanceGainAdjustment to do both
+  /// adjustments in one pass. Gains are in layout order.
+  void gains(const std::vector<float>& gains);
+
+  /// Clear delay lines
+  void reset();
 
   void processDelays(AudioIOData& io);
 
  public:
-  //  std::vector<float> mGains;
+  std::vector<float> mDelays;
+  std::vector<float> mGains;
   Speakers mLayout;
+
+ private:
+  void updateSize(float maxDelay);
+  void processChunk(AudioIOData& io, uint64_t offset, uint64_t numFrames);
+
+  std::vector<float> mBuffer;   // ring buffers, mRingSize per speaker
+  std::vector<float> mScratch;  // contiguous read for interpolation
+  std::vector<uint32_t> mIntDelays;
+  std::vector<float> mFracDelays;
+  uint64_t mFramesPerBuffer{0};
+  uint64_t mRingSize{0};
+  uint64_t mWritePos{0};
 };
 
-class SpeakerDistanceTimeAdjustmentProcessor : public AudioCallback,
-                                               SpeakerDistanceTimeAdjustment {
+/**
+ * @brief This class is added for convenience to append it to AudioIO processing
+ *
+ * @code
+ * SpeakerDistanceTimeAdjustmentProcessor timeAdjustment;
+ * timeAdjustment.configure(speakerLayout, audioIO().framesPerBuffer(),
+ *                          audioIO().framesPerSecond());
+ * audioIO().append(timeAdjustment);
+ * @endcode
+ */
+class SpeakerDistanceTimeAdjustmentProcessor
+    : public AudioCallback,
+      public SpeakerDistanceTimeAdjustment {
  public:
   virtual void onAudioCB(AudioIOData& io) { this->processDelays(io); }
 
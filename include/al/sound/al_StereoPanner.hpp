@@ -37,8 +37,16 @@ public:
                             const float *samples,
                             const unsigned int &numFrames) override;
 
+  /// Batch Processing
+  virtual void renderBuffers(AudioIOData &io, const Vec3f *positions,
+                             const float *const *samples,
+                             const unsigned int &numSources,
+                             const unsigned int &numFrames,
+                             const uint64_t *sourceIds = nullptr) override;
+
 private:
   size_t numSpeakers;
+  std::vector<float> mGains; // Left and right gains for renderBuffers()
 
   void equalPowerPan(const Vec3d &relPos, float &gainL, float &gainR);
 };
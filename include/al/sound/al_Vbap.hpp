@@ -83,6 +83,14 @@ struct SpeakerTriple {
 
 /// Vector-based amplitude panner
 ///
+/// compile() builds a cube map of directions, where each cell lists the
+/// triplets that cover it, so finding the triplet for a source is constant
+/// time regardless of the number of triplets. Sources passed to
+/// renderBuffers() with a source id first try the triplet they used in the
+/// previous block. As in Dbap, a source that is not rendered in a block is
+/// forgotten at the next prepare(), so prepare() should be called once per
+/// block.
+///
 /// @ingroup Sound
 class Vbap : public Spatializer {
 public:
@@ -98,6 +106,8 @@ public:
 
   virtual void compile() override;
 
+  virtual void prepare(AudioIOData &io) override;
+
   ///
   /// \brief Make an existing channel a phantom channel
   /// \param channelIndex the channel index of the phantom channel
@@ -123,10 +133,24 @@ public:
   virtual void renderBuffer(AudioIOData &io, const Vec3f &pos,
                             const float *samples,
                             const unsigned int &numFrames) override;
+  virtual void renderBuffers(AudioIOData &io, const Vec3f *positions,
+                             const float *const *samples,
+                             const unsigned int &numSources,
+                             const unsigned int &numFrames,
+                             const uint64_t *sourceIds = nullptr) override;
+
+  /// Compute output gains for a source direction without rendering
+
+  /// id works as in renderBuffers(). channels and gains are cleared and
+  /// filled with one entry per output of the triplet found, and left empty if
+  /// none is found.
+  void outputGains(const Vec3f &pos, std::vector<unsigned int> &channels,
+                   std::vector<float> &gains, uint64_t id = NO_SOURCE_ID);
 
   virtual void print(std::ostream &stream = std::cout) override;
 
   /// Manually add a triple from indeces to speakers
+  /// Call compile() afterwards to include it in the direction lookup table
   void makeTriple(int s1, int s2, int s3 = -1);
 
   // Returns vector of triplets
@@ -137,10 +161,57 @@ private:
   std::map<unsigned int, std::vector<unsigned int>> mPhantomChannels;
   //	Listener* mListener;
   bool mIs3D;
-  VbapOptions mOptions;
+  VbapOptions mOptions{VbapOptions(0)};
+
+  // Output routing for a triplet vertex. Phantom channels are resolved into
+  // one entry per assigned output, with gain (vertexGain * scale)^2
+  struct VertexOutput {
+    int vertex;
+    unsigned int channel;
+    bool phantom;
+    float scale;
+  };
+
+  // Cube map direction lookup. Cells of all faces in a flat array, each cell
+  // holds a range in mCellTriplets
+  int mLookupResolution{16}; // cells per cube face side
+  std::vector<unsigned int> mCellOffsets;
+  std::vector<int> mCellTriplets;
+  bool mLookupValid{false};
+
+  // Per triplet range in mVertexOutputs
+  std::vector<unsigned int> mOutputOffsets;
+  std::vector<VertexOutput> mVertexOutputs;
+
+  // Last triplet used by each source, in slots found by source id
+  unsigned int mMaxCachedSources{256};
+  SpatializerSourceSlots mSlots;
+  std::vector<int> mSlotTriplets;
 
   Vec3d computeGains(const Vec3d &vecA, const SpeakerTriple &speak);
 
+  /// Returns true if direction vec is inside triplet. gains are not normalized
+  bool tripletContains(int tripletIndex, const Vec3d &vec, Vec3d &gains);
+
+  /// Find the triplet that contains direction vec (in audio space), trying
+  /// cachedIndex first. Returns the triplet index or -1 if none found. gains
+  /// are normalized.
+  int findTriplet(const Vec3d &vec, Vec3d &gains, int cachedIndex = -1);
+
+  /// findTriplet() starting from the triplet source id used last, which is
+  /// then updated
+  int findSourceTriplet(const Vec3d &vec, uint64_t id, Vec3d &gains);
+
+  /// Returns lookup table cell for direction
+  int lookupCell(const Vec3d &vec) const;
+
+  void buildLookupTable();
+  void buildVertexOutputs();
+
+  /// Add samples to the triplet's output channels scaled by gains
+  void renderTriplet(AudioIOData &io, int tripletIndex, const Vec3d &gains,
+                     const float *samples, const unsigned int &numFrames);
+
   /// 2D VBAP, Build internal list of speaker pairs
   void findSpeakerPairs(const Speakers &spkrs);
 
@@ -0,0 +1,206 @@
+#ifndef INCLUDE_AL_ATOMICVALUE_HPP
+#define INCLUDE_AL_ATOMICVALUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace al {
+
+/// @brief Trivially copyable representation of a value stored in an
+/// AtomicValue
+///
+/// Trivially copyable types are stored as they are. Specialize with
+/// lockFree = true for value types that are only held back by user declared
+/// copy operations, as done for Pose in al_Parameter.hpp.
+/// @ingroup Types
+template <class T, class Enable = void> struct AtomicValueTraits {
+  static constexpr bool lockFree = false;
+};
+
+template <class T>
+struct AtomicValueTraits<
+    T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type> {
+  static constexpr bool lockFree = true;
+  typedef T Stored;
+  static Stored pack(const T &value) { return value; }
+  static T unpack(const Stored &stored) { return stored; }
+};
+
+namespace detail {
+
+enum AtomicValueKind { ATOMIC_VALUE_ATOMIC, ATOMIC_VALUE_SLOTS,
+                       ATOMIC_VALUE_MUTEX };
+
+template <class T, bool lockFree = AtomicValueTraits<T>::lockFree>
+struct AtomicValueKindOf {
+  static constexpr int value = ATOMIC_VALUE_MUTEX;
+};
+
+template <class T> struct AtomicValueKindOf<T, true> {
+  typedef typename AtomicValueTraits<T>::Stored Stored;
+  static constexpr int value =
+      (sizeof(Stored) == 1 || sizeof(Stored) == 2 || sizeof(Stored) == 4 ||
+       sizeof(Stored) == 8)
+          ? ATOMIC_VALUE_ATOMIC
+          : ATOMIC_VALUE_SLOTS;
+};
+
+} // namespace detail
+
+/**
+ * @brief Value shared between threads without locks where possible
+ * @ingroup Types
+ *
+ * Values of up to 8 bytes, like float, int or bool, are a std::atomic, so
+ * load() and store() are single atomic instructions. Larger trivially
+ * copyable values, like Vec3f or Color, are kept in four slots. store()
+ * writes a slot other than the published one and then publishes it, so
+ * load() never waits for a store in progress, even one whose thread has been
+ * preempted. load() only copies again if another store completed while it
+ * was copying, and never returns a torn value. A store waits for other
+ * stores only when three or more are in progress at once. Other types, like
+ * std::string, are protected by a mutex.
+ */
+template <class T, int Kind = detail::AtomicValueKindOf<T>::value>
+class AtomicValue;
+
+template <class T> class AtomicValue<T, detail::ATOMIC_VALUE_ATOMIC> {
+public:
+  typedef AtomicValueTraits<T> Traits;
+  static constexpr bool isLockFree = true;
+
+  AtomicValue(const T &value = T()) : mValue(Traits::pack(value)) {}
+  AtomicValue(const AtomicValue &) = delete;
+  AtomicValue &operator=(const AtomicValue &) = delete;
+
+  T load() const {
+    return Traits::unpack(mValue.load(std::memory_order_acquire));
+  }
+  void store(const T &value) {
+    mValue.store(Traits::pack(value), std::memory_order_release);
+  }
+
+private:
+  std::atomic<typename Traits::Stored> mValue;
+};
+
+template <class T> class AtomicValue<T, detail::ATOMIC_VALUE_SLOTS> {
+public:
+  typedef AtomicValueTraits<T> Traits;
+  typedef typename Traits::Stored Stored;
+  static constexpr bool isLockFree = true;
+
+  AtomicValue(const T &value = T()) {
+    for (auto &slot : mSlots) {
+      slot.owned.store(false, std::memory_order_relaxed);
+    }
+    store(value);
+  }
+  AtomicValue(const AtomicValue &) = delete;
+  AtomicValue &operator=(const AtomicValue &) = delete;
+
+  T load() const {
+    uint64_t words[kWords];
+    uint64_t published;
+    do {
+      published = mPublished.load(std::memory_order_acquire);
+      const Slot &slot = mSlots[published % kSlots];
+      for (int i = 0; i < kWords; i++) {
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      // A store only writes a slot after seeing it unpublished, so the slot
+      // can only have changed if something was published meanwhile
+    } while (mPublished.load(std::memory_order_relaxed) != published);
+    Stored stored;
+    std::memcpy(&stored, words, sizeof(Stored));
+    return Traits::unpack(stored);
+  }
+
+  void store(const T &value) {
+    uint64_t words[kWords] = {};
+    const Stored stored = Traits::pack(value);
+    std::memcpy(words, &stored, sizeof(Stored));
+    const uint64_t index = claimSlot();
+    Slot &slot = mSlots[index];
+    for (int i = 0; i < kWords; i++) {
+      slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    // Publish before releasing the slot, so no other store can claim it
+    // between the two
+    uint64_t published = mPublished.load(std::memory_order_relaxed);
+    while (!mPublished.compare_exchange_weak(
+        published, (published / kSlots + 1) * kSlots + index,
+        std::memory_order_release, std::memory_order_relaxed)) {
+    }
+    slot.owned.store(false, std::memory_order_release);
+  }
+
+private:
+  static constexpr int kWords = int((sizeof(Stored) + 7) / 8);
+  static constexpr uint64_t kSlots = 4;
+
+  struct Slot {
+    std::atomic<bool> owned; // by a store writing it
+    std::atomic<uint64_t> words[kWords];
+  };
+
+  // Take ownership of a slot that is not published
+  uint64_t claimSlot() {
+    while (true) {
+      const uint64_t published = mPublished.load(std::memory_order_relaxed);
+      for (uint64_t n = 1; n < kSlots; n++) {
+        const uint64_t index = (published + n) % kSlots;
+        Slot &slot = mSlots[index];
+        bool owned = false;
+        if (slot.owned.load(std::memory_order_relaxed) ||
+            !slot.owned.compare_exchange_strong(owned, true,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+          continue; // Another store is writing it
+        }
+        // Only the owner publishes a slot, so it stays unpublished while
+        // owned if it is now
+        if (mPublished.load(std::memory_order_acquire) % kSlots != index) {
+          std::atomic_thread_fence(std::memory_order_release);
+          return index;
+        }
+        slot.owned.store(false, std::memory_order_release);
+      }
+    }
+  }
+
+  Slot mSlots[kSlots];
+  // Publication count times kSlots plus the published slot. The count makes
+  // every publication visible to load(), even of the slot it is reading.
+  std::atomic<uint64_t> mPublished{0};
+};
+
+template <class T> class AtomicValue<T, detail::ATOMIC_VALUE_MUTEX> {
+public:
+  static constexpr bool isLockFree = false;
+
+  AtomicValue(const T &value = T()) : mValue(value) {}
+  AtomicValue(const AtomicValue &) = delete;
+  AtomicValue &operator=(const AtomicValue &) = delete;
+
+  T load() const {
+    std::lock_guard<std::mutex> lk(mMutex);
+    return mValue;
+  }
+  void store(const T &value) {
+    std::lock_guard<std::mutex> lk(mMutex);
+    mValue = value;
+  }
+
+private:
+  mutable std::mutex mMutex;
+  T mValue;
+};
+
+} // namespace al
+
+#endif // INCLUDE_AL_ATOMICVALUE_HPP
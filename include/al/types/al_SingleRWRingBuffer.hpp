@@ -44,6 +44,7 @@
         Graham Wakefield, 2010, grrrwaaa@gmail.com
 */
 
+#include <atomic>
 #include <cstring>
 #include <inttypes.h>
 #include <vector>
@@ -91,13 +92,21 @@ public:
       */
   size_t peek(char *dst, size_t sz);
 
+  /** Advance the read pointer by sz bytes without copying.
+      Returns bytes actually skipped
+      */
+  size_t skip(size_t sz);
+
   /** Clear any data in the ringbuffer
+      Must be called from the reader, or while the reader is idle.
    */
-  void clear() { mRead = mWrite; }
+  void clear() { mRead.store(mWrite.load(std::memory_order_acquire)); }
 
 protected:
   size_t mSize{0}, mWrap{0};
-  size_t mRead{0}, mWrite{0};
+  // Each index is only advanced by its own thread. Release stores publish
+  // the data copied before them to the other thread
+  std::atomic<size_t> mRead{0}, mWrite{0};
   std::vector<char> mData;
 };
 
@@ -120,16 +129,16 @@ inline SingleRWRingBuffer ::SingleRWRingBuffer(size_t sz)
 inline SingleRWRingBuffer ::~SingleRWRingBuffer() {}
 
 inline size_t SingleRWRingBuffer ::writeSpace() const {
-  const size_t r = mRead;
-  const size_t w = mWrite;
+  const size_t r = mRead.load(std::memory_order_acquire);
+  const size_t w = mWrite.load(std::memory_order_relaxed);
   if (r == w)
     return mWrap;
   return ((mSize + (r - w)) & mWrap) - 1;
 }
 
 inline size_t SingleRWRingBuffer ::readSpace() const {
-  const size_t r = mRead;
-  const size_t w = mWrite;
+  const size_t r = mRead.load(std::memory_order_relaxed);
+  const size_t w = mWrite.load(std::memory_order_acquire);
   return (mSize + (w - r)) & mWrap;
 }
 
@@ -139,7 +148,7 @@ inline size_t SingleRWRingBuffer ::write(const char *src, size_t sz) {
   if (sz == 0)
     return 0;
 
-  size_t w = mWrite;
+  size_t w = mWrite.load(std::memory_order_relaxed);
   size_t end = w + sz;
 
   if (end < mSize) {
@@ -151,7 +160,7 @@ inline size_t SingleRWRingBuffer ::write(const char *src, size_t sz) {
     memcpy(mData.data(), src + split, end);
   }
 
-  mWrite = end;
+  mWrite.store(end, std::memory_order_release);
   return sz;
 }
 
@@ -161,7 +170,7 @@ inline size_t SingleRWRingBuffer ::read(char *dst, size_t sz) {
   if (sz == 0)
     return 0;
 
-  size_t r = mRead;
+  size_t r = mRead.load(std::memory_order_relaxed);
   size_t end = r + sz;
 
   if (end < mSize) {
@@ -173,7 +182,7 @@ inline size_t SingleRWRingBuffer ::read(char *dst, size_t sz) {
     memcpy(dst + split, mData.data(), end);
   }
 
-  mRead = end;
+  mRead.store(end, std::memory_order_release);
   return sz;
 }
 
@@ -183,7 +192,7 @@ inline size_t SingleRWRingBuffer ::peek(char *dst, size_t sz) {
   if (sz == 0)
     return 0;
 
-  size_t r = mRead;
+  size_t r = mRead.load(std::memory_order_relaxed);
   size_t end = r + sz;
 
   if (end < mSize) {
@@ -197,6 +206,14 @@ inline size_t SingleRWRingBuffer ::peek(char *dst, size_t sz) {
   return sz;
 }
 
+inline size_t SingleRWRingBuffer ::skip(size_t sz) {
+  size_t space = readSpace();
+  sz = sz > space ? space : sz;
+  size_t r = mRead.load(std::memory_order_relaxed);
+  mRead.store((r + sz) & mWrap, std::memory_order_release);
+  return sz;
+}
+
 } // namespace al
 
 #endif /* include guard */
@@ -0,0 +1,77 @@
+#ifndef INCLUDE_AL_TRIPLE_BUFFER_HPP
+#define INCLUDE_AL_TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+namespace al {
+
+/**
+ * @brief Lock free exchange of the latest value between two threads
+ *
+ * One thread writes whole values, another thread reads the most recent
+ * complete one. The writer never waits for the reader and the reader never
+ * sees a partially written value. Values the reader is too slow to see are
+ * skipped, which is what you want when passing analysis results from the
+ * audio thread to the graphics thread.
+ *
+ * @code
+ * TripleBuffer<std::vector<float>> spectrum;
+ * // audio thread
+ * spectrum.writeBuffer() = magnitudes;
+ * spectrum.publish();
+ * // graphics thread
+ * if (spectrum.update()) {
+ *   draw(spectrum.readBuffer());
+ * }
+ * @endcode
+ *
+ * The buffers are not synchronized when they are resized, so set their size
+ * with forEach() before both threads run.
+ *
+ * @ingroup allocore
+ */
+template <class T> class TripleBuffer {
+public:
+  /// Value to fill in. Only call from the writer thread
+  T &writeBuffer() { return mBuffers[mWrite]; }
+
+  /// Make the value in writeBuffer() available to the reader
+  void publish() {
+    mWrite = mMiddle.exchange(mWrite | kNewFlag) & kIndexMask;
+  }
+
+  /// Get the most recently published value. Only call from the reader
+  /// thread
+  ///
+  /// @return true if readBuffer() changed
+  bool update() {
+    if ((mMiddle.load() & kNewFlag) == 0) {
+      return false;
+    }
+    mRead = mMiddle.exchange(mRead) & kIndexMask;
+    return true;
+  }
+
+  /// Value received in the last update()
+  const T &readBuffer() const { return mBuffers[mRead]; }
+
+  /// Apply a function to the three buffers, e.g. to resize them
+  template <class F> void forEach(F &&f) {
+    for (auto &b : mBuffers) {
+      f(b);
+    }
+  }
+
+private:
+  static const int kIndexMask = 3;
+  static const int kNewFlag = 4;
+
+  T mBuffers[3];
+  int mWrite{0};
+  int mRead{2};
+  std::atomic<int> mMiddle{1};
+};
+
+} // namespace al
+
+#endif // INCLUDE_AL_TRIPLE_BUFFER_HPP
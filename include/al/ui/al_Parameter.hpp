@@ -59,6 +59,7 @@
 #include "al/math/al_Vec.hpp"
 #include "al/protocol/al_OSC.hpp"
 #include "al/spatial/al_Pose.hpp"
+#include "al/types/al_AtomicValue.hpp"
 #include "al/types/al_Color.hpp"
 #include "al/types/al_ValueSource.hpp"
 #include "al/types/al_VariantValue.hpp"
@@ -194,6 +195,14 @@ public:
 
   void set(ParameterMeta *p);
 
+  /**
+   * @brief call change callbacks if value has changed since last call
+   *
+   * Parameters with deferred callbacks deliver their pending change here.
+   * Returns true if a change was delivered.
+   */
+  virtual bool processChange() { return false; }
+
 protected:
   std::string mFullAddress;
   std::string mParameterName;
@@ -203,6 +212,74 @@ protected:
   std::map<std::string, float> mHints; // Provide hints for behavior
 };
 
+/**
+ * @brief Delivers deferred parameter changes in batches
+ * @ingroup UI
+ *
+ * Parameters attached with setChangeDispatcher() don't run their change
+ * callbacks from set(). They queue themselves once, and further changes
+ * before the next process() only replace the value, so a slider drag or an
+ * OSC stream at 1 kHz runs the callbacks at most once per process() with
+ * the latest value. Call process() from the thread that should run the
+ * callbacks, e.g. once per frame from onAnimate() in the graphics domain:
+ *
+ * @code
+ * ParameterDispatcher dispatcher;
+ * Parameter x{"x", "", 0.0f, -1.0f, 1.0f};
+ * x.setChangeDispatcher(&dispatcher);
+ * ...
+ * void onAnimate(double dt) override { dispatcher.process(); }
+ * @endcode
+ *
+ * The dispatcher must outlive the parameters attached to it. Parameters
+ * must not be destroyed while another thread is in process().
+ */
+class ParameterDispatcher {
+public:
+  /// Run the callbacks of every parameter changed since the last call
+  ///
+  /// @return the number of parameters whose callbacks ran
+  size_t process();
+
+  /// Parameters waiting for process()
+  size_t pending();
+
+  /// Changes delivered by process()
+  uint64_t delivered() const { return mDelivered.load(); }
+  /// Changes replaced by a later value before they were delivered
+  uint64_t coalesced() const { return mCoalesced.load(); }
+  void resetCounters() {
+    mDelivered = 0;
+    mCoalesced = 0;
+  }
+
+private:
+  template <class ParameterType> friend class ParameterWrapper;
+
+  void enqueue(ParameterMeta *parameter);
+  void remove(ParameterMeta *parameter);
+
+  std::mutex mLock;
+  std::vector<ParameterMeta *> mPending;
+  std::vector<ParameterMeta *> mProcessing; // only used in process()
+  std::atomic<uint64_t> mDelivered{0};
+  std::atomic<uint64_t> mCoalesced{0};
+};
+
+/// Pose has a user defined copy constructor, so AtomicValue stores its
+/// position and orientation instead
+template <> struct AtomicValueTraits<Pose> {
+  static constexpr bool lockFree = true;
+  struct Stored {
+    Vec3d pos;
+    Quatd quat;
+  };
+  static Stored pack(const Pose &pose) { return {pose.pos(), pose.quat()}; }
+  static Pose unpack(const Stored &stored) {
+    return Pose(stored.pos, stored.quat);
+  }
+};
+
 /**
  * @brief The ParameterWrapper class provides a generic thread safe Parameter
  * class from the ParameterType template parameter
@@ -221,10 +298,11 @@ public:
    * @param min Minimum value for the parameter
    * @param max Maximum value for the parameter
    *
-   * The mechanism used to protect data is locking a mutex within the set()
-   * function and doing try_lock() on the mutex to update a cached value in the
-   * get() function. In the worst case this might incur some jitter when reading
-   * the value.
+   * The value is held in an AtomicValue. For float, int, bool and other
+   * small types get() and set() use a std::atomic. Larger trivially copyable
+   * types like Vec3f, Color and Pose are kept in several slots, so get()
+   * never waits for a set() in progress on another thread. Other types like
+   * std::string keep a mutex.
    */
   ParameterWrapper(std::string parameterName, std::string group = "",
                    ParameterType defaultValue = ParameterType());
@@ -241,13 +319,13 @@ public:
    * @brief set the parameter's value
    *
    * This function is thread-safe and can be called from any number of threads.
-   * It blocks to lock a mutex so its use in critical contexts should be
-   * avoided.
+   * Storing the value only takes a lock for types that are not lock-free, see
+   * AtomicValue, but this function runs the change callbacks.
    */
   virtual void set(ParameterType value, ValueSource *src = nullptr) {
     //        if (value > mMax) value = mMax;
     //        if (value < mMin) value = mMin;
-    mValueCache = get();
+    mValueCache.store(get());
     if (mProcessCallback) {
       value = (*mProcessCallback)(value); //, mProcessUdata);
     }
@@ -265,8 +343,7 @@ public:
    * @brief set the parameter's value without calling callbacks
    *
    * This function is thread-safe and can be called from any number of threads.
-   * It blocks to lock a mutex so its use in critical contexts should be
-   * avoided. The processing callback is called, but the callbacks registered
+   * The processing callback is called, but the callbacks registered
    * with registerChangeCallback() are not called. This is useful to avoid
    * infinite recursion when a widget sets the parameter that then sets the
    * widget.
@@ -278,13 +355,15 @@ public:
   virtual void setNoCalls(ParameterType value, void *blockReceiver = nullptr) {
     //        if (value > mMax) value = mMax;
     //        if (value < mMin) value = mMin;
-    mValueCache = get();
+    mValueCache.store(get());
     if (mProcessCallback) {
       value = (*mProcessCallback)(value); //, mProcessUdata);
     }
     if (blockReceiver) {
-      for (auto cb : mCallbacks) {
-        (*cb)(value);
+      for (const auto &cb : mCallbacks) {
+        if (cb) {
+          (*cb)(value);
+        }
       }
     }
     setLocking(value);
@@ -292,20 +371,18 @@ public:
   }
 
   /**
-   * @brief set the parameter's value forcing a lock
+   * @brief set the parameter's value without processing
    *
    * No callbacks are called.
    */
-  inline void setLocking(ParameterType value) {
-    mMutex->lock();
-    mValue = value;
-    mMutex->unlock();
-  }
+  inline void setLocking(ParameterType value) { mValue.store(value); }
 
   /**
    * @brief get the parameter's value
    *
-   * This function is thread-safe and can be called from any number of threads
+   * This function is thread-safe and can be called from any number of threads.
+   * For lock-free types it never waits for a set() in progress, see
+   * AtomicValue.
    *
    * @return the parameter value
    */
@@ -328,7 +405,7 @@ public:
    */
   void min(ParameterType minValue, ValueSource *src = nullptr) {
     mMin = minValue;
-    for (auto cb : mMetaCallbacksSrc) {
+    for (const auto &cb : mMetaCallbacksSrc) {
       (*cb)(src);
     }
   }
@@ -342,7 +419,7 @@ public:
    */
   void max(ParameterType maxValue, ValueSource *src = nullptr) {
     mMax = maxValue;
-    for (auto cb : mMetaCallbacksSrc) {
+    for (const auto &cb : mMetaCallbacksSrc) {
       (*cb)(src);
     }
   }
@@ -411,43 +488,66 @@ public:
    * and then calling processChange() within the opengl thread will call the
    * callbacks whenever the value has changed, but at the right time, in the
    * right context.
+   *
+   * Changes made before processChange() is called are coalesced: only the
+   * latest value is delivered, and coalescedChanges() counts the others.
    */
   void setSynchronousCallbacks(bool synchronous = true) {
-    if (mCallbacks.size() > 0 && mCallbacks[0] == nullptr) {
-      if (synchronous) {
-        mCallbacks.erase(mCallbacks.begin());
-      }
-    }
-    if (!synchronous) {
+    const bool deferred = mCallbacks.size() > 0 && mCallbacks[0] == nullptr;
+    if (deferred && synchronous) {
+      mCallbacks.erase(mCallbacks.begin());
+    } else if (!deferred && !synchronous) {
       mCallbacks.insert(mCallbacks.begin(), nullptr);
     }
   }
 
+  /**
+   * @brief Defer change callbacks to a ParameterDispatcher
+   *
+   * The callbacks run when dispatcher->process() is called, with the latest
+   * value. nullptr detaches the parameter and makes callbacks synchronous
+   * again.
+   */
+  void setChangeDispatcher(ParameterDispatcher *dispatcher);
+  ParameterDispatcher *changeDispatcher() { return mDispatcher; }
+
   bool hasChange() { return mChanged; }
 
+  /**
+   * @brief Number of deferred changes replaced by a later value before their
+   * callbacks ran
+   */
+  uint64_t coalescedChanges() const { return mCoalescedChanges.load(); }
+
   /**
    * @brief call change callbacks if value has changed since last call
+   *
+   * Callbacks registered with a ValueSource receive a copy of the source of
+   * the latest change, valid until they return.
    */
-  bool processChange() {
-    if (!mChanged) {
+  bool processChange() override {
+    // Clear before reading the value, so a later change queues again
+    mPending = false;
+    if (!mChanged.exchange(false)) {
       return false;
     }
+    ValueSource source;
+    ValueSource *src = nullptr;
+    if (mHasChangeSource.load()) {
+      source = mChangeSource.load();
+      src = &source;
+    }
     ParameterType value = get();
-    mChanged = false;
 
-    auto callbackIt = mCallbacks.begin();
-    while (callbackIt != mCallbacks.end()) {
-      if (*callbackIt) {
-        (*(*callbackIt))(value);
+    for (const auto &cb : mCallbacks) {
+      if (cb) {
+        (*cb)(value);
       }
-      callbackIt++;
     }
-    auto callbackSrcIt = mCallbacksSrc.begin();
-    while (callbackSrcIt != mCallbacksSrc.end()) {
-      if (*callbackSrcIt) {
-        (*(*callbackSrcIt))(value, nullptr);
+    for (const auto &cb : mCallbacksSrc) {
+      if (cb) {
+        (*cb)(value, src);
       }
-      callbackSrcIt++;
     }
     return true;
   }
@@ -478,8 +578,8 @@ protected:
   ParameterType mMin;
   ParameterType mMax;
 
-  ParameterType mValue;
-  ParameterType mValueCache;
+  AtomicValue<ParameterType> mValue;
+  AtomicValue<ParameterType> mValueCache;
 
   ParameterType mDefault;
 
@@ -489,13 +589,17 @@ protected:
   // void * mProcessUdata;
   // std::vector<void *> mCallbackUdata;
 
-  bool mChanged{false};
+  std::atomic<bool> mChanged{false};
 
 private:
-  // pointer to avoid having to explicitly declare copy/move
-  std::unique_ptr<std::mutex> mMutex;
+  // Deferred change state
+  ParameterDispatcher *mDispatcher{nullptr};
+  std::atomic<bool> mPending{false}; // queued for delivery
+  // The setter's source may not outlive set(), so a copy is kept
+  AtomicValue<ValueSource> mChangeSource;
+  std::atomic<bool> mHasChangeSource{false};
+  std::atomic<uint64_t> mCoalescedChanges{0};
 
-private:
   std::vector<std::shared_ptr<ParameterChangeCallback>> mCallbacks;
   std::vector<std::shared_ptr<ParameterChangeCallbackSrc>> mCallbacksSrc;
 
@@ -561,7 +665,7 @@ public:
       std::string prefix, float min = -99999.0, float max = 99999.0);
 
   Parameter(const al::Parameter &param) : ParameterWrapper<float>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -592,7 +696,7 @@ public:
    */
   virtual float get() override;
 
-  virtual float toFloat() override { return mValue; }
+  virtual float toFloat() override { return mValue.load(); }
 
   virtual bool fromFloat(float value) override {
     set(value);
@@ -693,7 +797,7 @@ public:
 
   ParameterInt(const al::ParameterInt &param)
       : ParameterWrapper<int32_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -726,7 +830,7 @@ public:
   //   */
   //  virtual int32_t get() override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(int32_t(value));
@@ -795,7 +899,7 @@ public:
 
   ParameterInt64(const al::ParameterInt64 &param)
       : ParameterWrapper<int64_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -828,7 +932,7 @@ public:
   //   */
   //  virtual int32_t get() override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(int64_t(value));
@@ -894,7 +998,7 @@ public:
 
   ParameterInt16(const al::ParameterInt16 &param)
       : ParameterWrapper<int16_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -917,7 +1021,7 @@ public:
   virtual void setNoCalls(int16_t value,
                           void *blockReceiver = nullptr) override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(int16_t(value));
@@ -982,7 +1086,7 @@ public:
 
   ParameterInt8(const al::ParameterInt8 &param)
       : ParameterWrapper<int8_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1004,7 +1108,7 @@ public:
    */
   virtual void setNoCalls(int8_t value, void *blockReceiver = nullptr) override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(int8_t(value));
@@ -1070,7 +1174,7 @@ public:
 
   ParameterUInt8(const al::ParameterUInt8 &param)
       : ParameterWrapper<uint8_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1093,7 +1197,7 @@ public:
   virtual void setNoCalls(uint8_t value,
                           void *blockReceiver = nullptr) override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(uint8_t(value));
@@ -1159,7 +1263,7 @@ public:
 
   ParameterUInt16(const al::ParameterUInt16 &param)
       : ParameterWrapper<uint16_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1182,7 +1286,7 @@ public:
   virtual void setNoCalls(uint16_t value,
                           void *blockReceiver = nullptr) override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(uint16_t(value));
@@ -1248,7 +1352,7 @@ public:
 
   ParameterUInt32(const al::ParameterUInt32 &param)
       : ParameterWrapper<uint32_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1271,7 +1375,7 @@ public:
   virtual void setNoCalls(uint32_t value,
                           void *blockReceiver = nullptr) override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(uint32_t(value));
@@ -1337,7 +1441,7 @@ public:
 
   ParameterUInt64(const al::ParameterUInt64 &param)
       : ParameterWrapper<uint64_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1360,7 +1464,7 @@ public:
   virtual void setNoCalls(uint64_t value,
                           void *blockReceiver = nullptr) override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(uint64_t(value));
@@ -1426,7 +1530,7 @@ public:
 
   ParameterDouble(const al::ParameterDouble &param)
       : ParameterWrapper<double>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1448,7 +1552,7 @@ public:
    */
   virtual void setNoCalls(double value, void *blockReceiver = nullptr) override;
 
-  virtual float toFloat() override { return float(mValue); }
+  virtual float toFloat() override { return float(mValue.load()); }
 
   virtual bool fromFloat(float value) override {
     set(double(value));
@@ -1521,7 +1625,7 @@ public:
       std::string prefix, float min = 0, float max = 1.0);
 
   ParameterBool(const al::ParameterBool &param) : Parameter(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1573,8 +1677,8 @@ class Trigger : public ParameterWrapper<bool> {
 public:
   Trigger(std::string parameterName, std::string Group = "")
       : ParameterWrapper<bool>(parameterName, Group, false) {
-    mValue = false;
-    mValueCache = false;
+    mValue.store(false);
+    mValueCache.store(false);
   }
 
   virtual float toFloat() override { return get() ? 1.0f : 0.0f; }
@@ -1615,7 +1719,7 @@ public:
 
   ParameterString(const al::ParameterString &param)
       : ParameterWrapper<std::string>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1674,7 +1778,7 @@ public:
 
   ParameterVec3(const al::ParameterVec3 &param)
       : ParameterWrapper<al::Vec3f>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1726,7 +1830,7 @@ public:
 
   ParameterVec4(const al::ParameterVec4 &param)
       : ParameterWrapper<al::Vec4f>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1778,7 +1882,7 @@ public:
 
   ParameterVec5(const al::ParameterVec5 &param)
       : ParameterWrapper<al::Vec5f>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1832,7 +1936,7 @@ public:
 
   ParameterPose(const al::ParameterPose &param)
       : ParameterWrapper<al::Pose>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1877,7 +1981,7 @@ public:
     } else if (fields.size() == 3) {
       Pose vec(Vec3f(fields[0].toDouble(), fields[1].toDouble(),
                      fields[2].toDouble()),
-               mValue.quat());
+               mValue.load().quat());
       set(vec);
     } else {
       std::cout << "Wrong number of parameters for " << getFullAddress()
@@ -1899,7 +2003,7 @@ public:
 
   ParameterMenu(const al::ParameterMenu &param)
       : ParameterWrapper<int32_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -1999,7 +2103,7 @@ public:
 
   ParameterChoice(const al::ParameterChoice &param)
       : ParameterWrapper<uint64_t>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -2112,7 +2216,7 @@ public:
 
   ParameterColor(const al::ParameterColor &param)
       : ParameterWrapper<al::Color>(param) {
-    mValue = param.mValue;
+    mValue.store(param.mValue.load());
     setDefault(param.getDefault());
   }
 
@@ -2184,7 +2288,9 @@ public:
 
 template <class ParameterType>
 ParameterWrapper<ParameterType>::~ParameterWrapper() {
-  //  delete mMutex;
+  if (mDispatcher) {
+    mDispatcher->remove(this);
+  }
 }
 
 template <class ParameterType>
@@ -2192,13 +2298,9 @@ ParameterWrapper<ParameterType>::ParameterWrapper(std::string parameterName,
                                                   std::string group,
                                                   ParameterType defaultValue)
     : ParameterMeta(parameterName, group), mProcessCallback(nullptr) {
-  mValue = defaultValue;
-  mValueCache = defaultValue;
-  mMutex = std::make_unique<std::mutex>();
+  mValue.store(defaultValue);
+  mValueCache.store(defaultValue);
   setDefault(defaultValue);
-  std::shared_ptr<ParameterChangeCallback> mAsyncCallback =
-      std::make_shared<ParameterChangeCallback>(
-          [&](ParameterType value) { mChanged = true; });
 }
 
 template <class ParameterType>
@@ -2211,7 +2313,6 @@ ParameterWrapper<ParameterType>::ParameterWrapper(std::string parameterName,
                                                         defaultValue) {
   mMin = min;
   mMax = max;
-  mMutex = std::make_unique<std::mutex>();
   setDefault(defaultValue);
 }
 
@@ -2224,24 +2325,20 @@ ParameterWrapper<ParameterType>::ParameterWrapper(
   mProcessCallback = param.mProcessCallback;
   // mProcessUdata = param.mProcessUdata;
   mCallbacks = param.mCallbacks;
-  mMutex = std::make_unique<std::mutex>();
+  mValue.store(param.mValue.load());
+  mValueCache.store(param.mValueCache.load());
   setDefault(param.getDefault());
   // mCallbackUdata = param.mCallbackUdata;
 }
 
 template <class ParameterType>
 ParameterType ParameterWrapper<ParameterType>::get() {
-  ParameterType current = mValueCache;
-  if (mMutex->try_lock()) {
-    current = mValue;
-    mMutex->unlock();
-  }
-  return current;
+  return mValue.load();
 }
 
 template <class ParameterType>
 ParameterType ParameterWrapper<ParameterType>::getPrevious() {
-  return mValueCache;
+  return mValueCache.load();
 }
 
 template <class ParameterType>
@@ -2272,19 +2369,48 @@ void ParameterWrapper<ParameterType>::registerMetaChangeCallback(
       std::make_shared<ParameterMetaChangeCallbackSrc>(cb));
 }
 
+template <class ParameterType>
+void ParameterWrapper<ParameterType>::setChangeDispatcher(
+    ParameterDispatcher *dispatcher) {
+  if (mDispatcher) {
+    mDispatcher->remove(this);
+  }
+  mDispatcher = dispatcher;
+  setSynchronousCallbacks(dispatcher == nullptr);
+  if (mDispatcher && mChanged) {
+    mPending = true;
+    mDispatcher->enqueue(this);
+  }
+}
+
 template <class ParameterType>
 void ParameterWrapper<ParameterType>::runChangeCallbacksSynchronous(
     ParameterType &value, ValueSource *src) {
-  for (auto cb : mCallbacks) {
-    if (cb == nullptr) {
-      // If first callback if nullptr, callbacks must be processed async
-      mChanged = true;
-      return;
+  if (mCallbacks.size() > 0 && mCallbacks[0] == nullptr) {
+    // Callbacks are processed async. The value must be stored before the
+    // change is flagged, or processChange() could deliver the old one
+    setLocking(value);
+    if (src) {
+      mChangeSource.store(*src);
+      mHasChangeSource = true;
     } else {
-      (*cb)(value);
+      mHasChangeSource = false;
     }
+    mChanged = true;
+    if (mPending.exchange(true)) {
+      mCoalescedChanges++;
+      if (mDispatcher) {
+        mDispatcher->mCoalesced++;
+      }
+    } else if (mDispatcher) {
+      mDispatcher->enqueue(this);
+    }
+    return;
+  }
+  for (const auto &cb : mCallbacks) {
+    (*cb)(value);
   }
-  for (auto cb : mCallbacksSrc) {
+  for (const auto &cb : mCallbacksSrc) {
     (*cb)(value, src);
   }
 }
@@ -42,6 +42,7 @@
         Andrés Cabrera mantaraya36@gmail.com
 */
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -98,7 +99,10 @@ class ParameterBundle {
    * Note this function is not thread safe, so it must be called in the same
    * conetext where the bundle is processed.
    */
-  void clear() { mParameters.clear(); }
+  void clear() {
+    mParameters.clear();
+    mStructureVersion++;
+  }
 
   std::vector<ParameterMeta *> &parameters() { return mParameters; }
   
@@ -113,8 +117,17 @@ class ParameterBundle {
 
   void addNotifier(OSCNotifier *notifier);
 
+  /**
+   * @brief count of changes to the parameters, sub-bundles or names of all
+   * bundles
+   *
+   * ParameterServer rebuilds its address index when this changes.
+   */
+  static uint64_t structureVersion() { return mStructureVersion.load(); }
+
  private:
   static std::map<std::string, int> mBundleCounter;
+  static std::atomic<uint64_t> mStructureVersion;
   int mBundleIndex = -1;
   std::string mBundleName;
   std::string mParentPrefix;
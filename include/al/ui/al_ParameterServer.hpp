@@ -42,8 +42,14 @@
         Andrés Cabrera mantaraya36@gmail.com
 */
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 
+#include "al/io/al_Socket.hpp"
 #include "al/protocol/al_OSC.hpp"
 #include "al/ui/al_Parameter.hpp"
 #include "al/ui/al_ParameterBundle.hpp"
@@ -79,6 +85,15 @@ private:
   osc::Recv mNetworkListener;
 };
 
+/**
+ * @brief Sends value changes to registered OSC listeners
+ *
+ * By default every notification is sent immediately as its own datagram
+ * from the thread that changed the value. startBatching() queues them
+ * instead and sends them from a background thread, packed into OSC bundles
+ * that fit in one datagram, which takes far fewer packets and system calls
+ * when many values change at once.
+ */
 class OSCNotifier {
 public:
   OSCNotifier();
@@ -94,6 +109,8 @@ public:
     auto newListenerSocket = new osc::Send;
 
     if (newListenerSocket->open(oscPort, IPaddress.c_str())) {
+      // Resolve once so notifications don't look up names
+      std::string ip = Socket::nameToIp(IPaddress);
       mListenerLock.lock();
       for (const auto &sender : mOSCSenders) {
         if (sender->address() == IPaddress && sender->port() == oscPort) {
@@ -104,10 +121,14 @@ public:
                     << oscPort << std::endl;
           mListenerLock.unlock();
           delete newListenerSocket;
+          return;
         }
       }
 
       mOSCSenders.push_back(newListenerSocket);
+      mSenderIps.push_back(ip);
+      mPending.resize(mOSCSenders.size());
+      mCoalesceSize.resize(mOSCSenders.size(), mMaxQueueSize);
       mListenerLock.unlock();
       std::cout << "Registered listener " << IPaddress << ":" << oscPort
                 << std::endl;
@@ -166,9 +187,47 @@ public:
     mHandshakeServer.appendHandler(handler);
   }
 
+  /**
+   * @brief Queue notifications and send them from a background thread
+   * @param intervalSeconds longest time a notification waits to be sent
+   * @param maxPacketSize largest datagram to send. The default fits the
+   * UDP payload of a 1500 byte Ethernet MTU
+   * @param maxQueueSize bytes queued for a listener before older
+   * notifications are dropped
+   *
+   * Notifications to each listener are packed into OSC bundles of up to
+   * maxPacketSize bytes. A bundle is sent as soon as it is full, otherwise
+   * every intervalSeconds or when flush() is called. Messages that do not fit
+   * in a bundle are sent on their own.
+   *
+   * If notifications arrive faster than they can be sent and a listener's
+   * queue grows past maxQueueSize, only the latest queued notification for
+   * each address is kept, so the queue is bounded by the number of addresses.
+   */
+  void startBatching(double intervalSeconds = 0.01,
+                     size_t maxPacketSize = 1472,
+                     size_t maxQueueSize = 65536);
+
+  /// Send the queued notifications and go back to sending immediately
+  void stopBatching();
+
+  bool isBatching();
+
+  /// Wake the sending thread to send the queued notifications now, e.g. once
+  /// per frame. Does not wait for them to be sent
+  void flush();
+
+  /// Datagrams sent while batching
+  uint64_t packetsSent() const { return mPacketsSent.load(); }
+  /// Notifications sent while batching
+  uint64_t messagesSent() const { return mMessagesSent.load(); }
+  /// Queued notifications dropped for a later one to the same address
+  uint64_t messagesCoalesced() const { return mMessagesCoalesced.load(); }
+
 protected:
   std::mutex mListenerLock;
   std::vector<osc::Send *> mOSCSenders;
+  std::vector<std::string> mSenderIps; // resolved addresses of mOSCSenders
   std::vector<std::pair<std::string, int>> mConnectedNodes;
 
   class HandshakeHandler : public osc::PacketHandler {
@@ -184,6 +243,42 @@ protected:
   std::mutex mNodeLock;
 
 private:
+  // True if the change didn't come from the listener at index
+  bool shouldNotify(size_t index, ValueSource *src);
+
+  // Send to the listeners, or queue when batching
+  template <class... Args>
+  void notify(const std::string &OSCaddress, ValueSource *src,
+              const Args &... args);
+
+  void flushThread();
+  void sendBundles(osc::Send &sender, const std::vector<char> &messages,
+                   std::vector<char> &bundle);
+  // Keep only the latest message for each address in a listener's queue
+  void coalesce(size_t index);
+
+  // Batching state, protected by mListenerLock
+  bool mBatching{false};
+  bool mFlushRequested{false};
+  bool mStopFlushing{false};
+  double mBatchInterval{0.01};
+  size_t mMaxPacketSize{1472};
+  size_t mMaxQueueSize{65536};
+  // Queued messages for each listener, each prefixed with its big-endian
+  // size as in a bundle
+  std::vector<std::vector<char>> mPending;
+  // Queue size that triggers coalesce() for each listener. Doubles past
+  // what coalescing leaves, so it runs in amortized constant time
+  std::vector<size_t> mCoalesceSize;
+  // Encoding buffer, grown for messages that don't fit
+  std::unique_ptr<osc::Packet> mScratch;
+  size_t mScratchSize{0};
+  std::condition_variable mFlushCondition;
+  std::thread mFlushThread;
+
+  std::atomic<uint64_t> mPacketsSent{0};
+  std::atomic<uint64_t> mMessagesSent{0};
+  std::atomic<uint64_t> mMessagesCoalesced{0};
 };
 
 /**
@@ -327,6 +422,12 @@ public:
   uint16_t serverPort() { return mServer->port(); }
 
   void verbose(bool verbose = true) { mVerbose = verbose; }
+
+  /// Sets a parameter from a message addressed to it. Returns false if the
+  /// address or type tags don't match
+  typedef bool (*MessageHandler)(ParameterMeta *param, osc::Message &m,
+                                 ValueSource *src);
+
   static bool setParameterValueFromMessage(ParameterMeta *param,
                                            std::string address,
                                            osc::Message &m);
@@ -351,9 +452,10 @@ protected:
 
   void printBundleInfo(ParameterBundle *bundle, std::string id, int depth = 0);
 
-  void setValuesForBundleGroup(osc::Message &m,
-                               std::vector<ParameterBundle *> bundleGroup,
-                               std::string rootAddress);
+  // Index the addresses of a parameter under prefix
+  void indexParameter(ParameterMeta *param, const std::string &prefix);
+  void indexBundle(ParameterBundle *bundle);
+  void buildAddressIndex();
 
   std::vector<std::pair<std::string, uint16_t>>
       mNotifiers; // List of primary nodes
@@ -368,6 +470,16 @@ protected:
   std::map<std::string, int> mCurrentActiveBundle;
   std::mutex mParameterLock;
 
+  struct AddressHandler {
+    ParameterMeta *parameter;
+    MessageHandler handler;
+  };
+  // Handlers by full OSC address, including bundle prefixes. Rebuilt on
+  // the next message after registration or a bundle change
+  std::unordered_map<std::string, std::vector<AddressHandler>> mAddressIndex;
+  bool mAddressIndexValid{false};
+  uint64_t mIndexedBundleVersion{0};
+
   std::string mOscAddress;
   int mOscPort;
 
@@ -0,0 +1,167 @@
+#ifndef INCLUDE_AL_PARAMETERSMOOTHER_HPP
+#define INCLUDE_AL_PARAMETERSMOOTHER_HPP
+
+#include <cstdint>
+
+#include "al/ui/al_Parameter.hpp"
+
+namespace al {
+
+/**
+ * @brief Ramp from the current value to a target at audio rate
+ * @ingroup UI
+ *
+ * LINEAR reaches the target in exactly the smoothing time. ONE_POLE
+ * approaches it exponentially and gets within 60 dB of the jump in the
+ * smoothing time, which sounds smoother for gains and cutoffs.
+ *
+ * The state is advanced once per block by process() or ramp(). next()
+ * advances it by one sample for code that runs per sample.
+ */
+class SmoothedValue {
+public:
+  enum Mode { LINEAR, ONE_POLE };
+
+  /// Linear segment over a block: sample i is start + i * increment
+  struct Ramp {
+    float start;
+    float increment;
+  };
+
+  /// @param[in] value       initial value
+  /// @param[in] seconds     smoothing time
+  /// @param[in] sampleRate  rate process() and next() are called at
+  /// @param[in] mode        ramp shape
+  SmoothedValue(float value = 0.0f, float seconds = 0.02f,
+                double sampleRate = 44100.0, Mode mode = LINEAR);
+
+  void setSampleRate(double sampleRate);
+  double sampleRate() const { return mSampleRate; }
+  void setTime(float seconds);
+  float time() const { return mSeconds; }
+  void setMode(Mode mode);
+  Mode mode() const { return mMode; }
+
+  /// Start ramping towards value. Does nothing if value is the target
+  void setTarget(float value);
+  float target() const { return mTarget; }
+
+  /// Jump to value without ramping
+  void reset(float value);
+
+  float current() const { return mCurrent; }
+  bool isSmoothing() const { return mCurrent != mTarget; }
+
+  /// Next sample
+  float next() {
+    if (mCurrent == mTarget) {
+      return mCurrent;
+    }
+    const float value = mCurrent;
+    if (mMode == LINEAR) {
+      if (--mRemaining <= 0) {
+        mCurrent = mTarget;
+      } else {
+        mCurrent += mIncrement;
+      }
+    } else {
+      mCurrent = mTarget + (mCurrent - mTarget) * mPole;
+      snap();
+    }
+    return value;
+  }
+
+  /// Write the next frames values to out
+  void process(float *out, int frames);
+
+  /// Multiply the next frames samples of buffer by the smoothed value
+  void applyGain(float *buffer, int frames);
+
+  /// Linear segment covering the next frames samples
+  ///
+  /// Exact for LINEAR ramps that don't end inside the block. Otherwise the
+  /// segment joins the values at the block edges. Useful to vectorize
+  /// voices that interpolate a parameter across a block.
+  Ramp ramp(int frames);
+
+private:
+  void computePole();
+  void startRamp();
+  void snap() {
+    const float difference = mCurrent - mTarget;
+    if (difference < kEpsilon && difference > -kEpsilon) {
+      mCurrent = mTarget;
+    }
+  }
+
+  static constexpr float kEpsilon = 1e-6f;
+
+  Mode mMode;
+  double mSampleRate;
+  float mSeconds;
+  float mCurrent;
+  float mTarget;
+  float mIncrement{0};   // LINEAR step per sample
+  int64_t mRemaining{0}; // LINEAR samples left
+  float mPole{0};        // ONE_POLE decay per sample
+};
+
+/**
+ * @brief Smoothed audio-rate view of a Parameter
+ * @ingroup UI
+ *
+ * Reads the parameter once per block and ramps to its value, so voices
+ * don't call get() per sample or each keep their own smoother. Every voice
+ * can hold its own ParameterSmoother on a shared parameter:
+ *
+ * @code
+ * Parameter gain{"gain", "", 0.5f, 0.0f, 1.0f};
+ * ParameterSmoother gainSmoother{gain, 0.02f, audioIO().framesPerSecond()};
+ *
+ * void onProcess(AudioIOData &io) override {
+ *   ... // render into io.outBuffer(0)
+ *   gainSmoother.applyGain(io.outBuffer(0), io.framesPerBuffer());
+ * }
+ * @endcode
+ */
+class ParameterSmoother : public SmoothedValue {
+public:
+  /// Starts at the current parameter value
+  ParameterSmoother(ParameterWrapper<float> &parameter, float seconds = 0.02f,
+                    double sampleRate = 44100.0, Mode mode = LINEAR);
+
+  /// Read the parameter and ramp to its value
+  void update() { setTarget(mParameter->get()); }
+
+  /// Read the parameter, then write the next frames smoothed values
+  void process(float *out, int frames) {
+    update();
+    SmoothedValue::process(out, frames);
+  }
+
+  /// Read the parameter, then multiply buffer by the smoothed value
+  void applyGain(float *buffer, int frames) {
+    update();
+    SmoothedValue::applyGain(buffer, frames);
+  }
+
+  /// Read the parameter, then return the segment for the next frames
+  Ramp ramp(int frames) {
+    update();
+    return SmoothedValue::ramp(frames);
+  }
+
+  using SmoothedValue::reset;
+
+  /// Jump to the current parameter value
+  void reset() { SmoothedValue::reset(mParameter->get()); }
+
+  ParameterWrapper<float> &parameter() { return *mParameter; }
+
+private:
+  ParameterWrapper<float> *mParameter;
+};
+
+} // namespace al
+
+#endif // INCLUDE_AL_PARAMETERSMOOTHER_HPP
@@ -0,0 +1,267 @@
+#include "al/math/al_FFT.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+using namespace al;
+
+// Twiddle tables for one transform size
+struct RFFT::Plan {
+  std::vector<int> factors;
+  // Per stage, twiddles for outputs 1 to radix-1 of each butterfly
+  std::vector<std::vector<float>> stageCos;
+  std::vector<std::vector<float>> stageSin;
+  // Twiddles to split the half size transform into the real spectrum
+  std::vector<float> realCos;
+  std::vector<float> realSin;
+};
+
+static const double kPi = 3.141592653589793;
+
+bool RFFT::isSupportedSize(unsigned int n) {
+  if (n < 2 || n % 2 != 0) {
+    return false;
+  }
+  n /= 2;
+  for (unsigned int f : {2u, 3u, 5u, 7u}) {
+    while (n % f == 0) {
+      n /= f;
+    }
+  }
+  return n == 1;
+}
+
+unsigned int RFFT::nextSupportedSize(unsigned int n) {
+  while (!isSupportedSize(n)) {
+    n++;
+  }
+  return n;
+}
+
+std::shared_ptr<const RFFT::Plan> RFFT::plan(unsigned int size) {
+  static std::mutex cacheLock;
+  static std::map<unsigned int, std::shared_ptr<const Plan>> cache;
+  std::lock_guard<std::mutex> lk(cacheLock);
+  auto cached = cache.find(size);
+  if (cached != cache.end()) {
+    return cached->second;
+  }
+
+  std::shared_ptr<Plan> p = std::make_shared<Plan>();
+  unsigned int n = size / 2;
+  while (n % 4 == 0) {
+    p->factors.push_back(4);
+    n /= 4;
+  }
+  for (int f : {2, 3, 5, 7}) {
+    while (n % f == 0) {
+      p->factors.push_back(f);
+      n /= f;
+    }
+  }
+  // Stage with radix r works on sequences of length len = r * m
+  unsigned int len = size / 2;
+  for (int radix : p->factors) {
+    unsigned int m = len / radix;
+    std::vector<float> c((radix - 1) * m), s((radix - 1) * m);
+    for (int u = 1; u < radix; u++) {
+      for (unsigned int j = 0; j < m; j++) {
+        double phase = -2.0 * kPi * double(j * u) / len;
+        c[(u - 1) * m + j] = float(std::cos(phase));
+        s[(u - 1) * m + j] = float(std::sin(phase));
+      }
+    }
+    p->stageCos.push_back(std::move(c));
+    p->stageSin.push_back(std::move(s));
+    len = m;
+  }
+
+  p->realCos.resize(size / 2 + 1);
+  p->realSin.resize(size / 2 + 1);
+  for (unsigned int k = 0; k <= size / 2; k++) {
+    p->realCos[k] = float(std::cos(2.0 * kPi * k / size));
+    p->realSin[k] = float(-std::sin(2.0 * kPi * k / size));
+  }
+  cache[size] = p;
+  return p;
+}
+
+RFFT::RFFT(unsigned int size) {
+  if (size > 0) {
+    resize(size);
+  }
+}
+
+void RFFT::resize(unsigned int size) {
+  if (!isSupportedSize(size)) {
+    std::cerr << "ERROR: Unsupported RFFT size: " << size << std::endl;
+    return;
+  }
+  if (size == mSize) {
+    return;
+  }
+  mSize = size;
+  mPlan = plan(size);
+  mRe.resize(size / 2);
+  mIm.resize(size / 2);
+  mWorkRe.resize(size / 2);
+  mWorkIm.resize(size / 2);
+}
+
+// Self-sorting (Stockham) decimation in frequency. Each stage reads
+// sequences of length len = radix * m interleaved with stride s and writes
+// radix sequences of length m with stride s * radix. The inner loops run
+// over the interleaved sequences with unit stride.
+void RFFT::complexTransform(float *re, float *im, float *workRe,
+                            float *workIm) {
+  const unsigned int n = mSize / 2;
+  float *xr = re, *xi = im, *yr = workRe, *yi = workIm;
+  unsigned int s = 1;
+  for (size_t stage = 0; stage < mPlan->factors.size(); stage++) {
+    const int radix = mPlan->factors[stage];
+    const unsigned int m = n / (s * radix);
+    const float *wr = mPlan->stageCos[stage].data();
+    const float *wi = mPlan->stageSin[stage].data();
+    if (radix == 4) {
+      for (unsigned int p = 0; p < m; p++) {
+        const float w1r = wr[p], w1i = wi[p];
+        const float w2r = wr[m + p], w2i = wi[m + p];
+        const float w3r = wr[2 * m + p], w3i = wi[2 * m + p];
+        const float *a0r = xr + s * p, *a0i = xi + s * p;
+        const float *a1r = a0r + s * m, *a1i = a0i + s * m;
+        const float *a2r = a1r + s * m, *a2i = a1i + s * m;
+        const float *a3r = a2r + s * m, *a3i = a2i + s * m;
+        float *b0r = yr + s * 4 * p, *b0i = yi + s * 4 * p;
+        float *b1r = b0r + s, *b1i = b0i + s;
+        float *b2r = b1r + s, *b2i = b1i + s;
+        float *b3r = b2r + s, *b3i = b2i + s;
+        for (unsigned int q = 0; q < s; q++) {
+          float t0r = a0r[q] + a2r[q], t0i = a0i[q] + a2i[q];
+          float t1r = a0r[q] - a2r[q], t1i = a0i[q] - a2i[q];
+          float t2r = a1r[q] + a3r[q], t2i = a1i[q] + a3i[q];
+          float t3r = a1r[q] - a3r[q], t3i = a1i[q] - a3i[q];
+          b0r[q] = t0r + t2r;
+          b0i[q] = t0i + t2i;
+          float cr = t1r + t3i, ci = t1i - t3r;
+          b1r[q] = cr * w1r - ci * w1i;
+          b1i[q] = cr * w1i + ci * w1r;
+          cr = t0r - t2r;
+          ci = t0i - t2i;
+          b2r[q] = cr * w2r - ci * w2i;
+          b2i[q] = cr * w2i + ci * w2r;
+          cr = t1r - t3i;
+          ci = t1i + t3r;
+          b3r[q] = cr * w3r - ci * w3i;
+          b3i[q] = cr * w3i + ci * w3r;
+        }
+      }
+    } else if (radix == 2) {
+      for (unsigned int p = 0; p < m; p++) {
+        const float w1r = wr[p], w1i = wi[p];
+        const float *a0r = xr + s * p, *a0i = xi + s * p;
+        const float *a1r = a0r + s * m, *a1i = a0i + s * m;
+        float *b0r = yr + s * 2 * p, *b0i = yi + s * 2 * p;
+        float *b1r = b0r + s, *b1i = b0i + s;
+        for (unsigned int q = 0; q < s; q++) {
+          float cr = a0r[q] - a1r[q], ci = a0i[q] - a1i[q];
+          b0r[q] = a0r[q] + a1r[q];
+          b0i[q] = a0i[q] + a1i[q];
+          b1r[q] = cr * w1r - ci * w1i;
+          b1i[q] = cr * w1i + ci * w1r;
+        }
+      }
+    } else {
+      // Odd radix: direct DFT of each butterfly
+      float rootCos[7], rootSin[7];
+      for (int k = 0; k < radix; k++) {
+        rootCos[k] = float(std::cos(-2.0 * kPi * k / radix));
+        rootSin[k] = float(std::sin(-2.0 * kPi * k / radix));
+      }
+      for (unsigned int p = 0; p < m; p++) {
+        for (unsigned int q = 0; q < s; q++) {
+          float ar[7], ai[7];
+          for (int t = 0; t < radix; t++) {
+            ar[t] = xr[q + s * (p + t * m)];
+            ai[t] = xi[q + s * (p + t * m)];
+          }
+          for (int u = 0; u < radix; u++) {
+            float sr = 0, si = 0;
+            for (int t = 0; t < radix; t++) {
+              int k = (t * u) % radix;
+              sr += ar[t] * rootCos[k] - ai[t] * rootSin[k];
+              si += ar[t] * rootSin[k] + ai[t] * rootCos[k];
+            }
+            if (u > 0) {
+              float tr = wr[(u - 1) * m + p], ti = wi[(u - 1) * m + p];
+              float r = sr * tr - si * ti;
+              si = sr * ti + si * tr;
+              sr = r;
+            }
+            yr[q + s * (radix * p + u)] = sr;
+            yi[q + s * (radix * p + u)] = si;
+          }
+        }
+      }
+    }
+    std::swap(xr, yr);
+    std::swap(xi, yi);
+    s *= radix;
+  }
+  if (xr != re) {
+    std::memcpy(re, xr, n * sizeof(float));
+    std::memcpy(im, xi, n * sizeof(float));
+  }
+}
+
+void RFFT::forward(const float *in, float *re, float *im) {
+  const unsigned int n = mSize / 2;
+  // Pack even samples as real and odd samples as imaginary parts
+  for (unsigned int k = 0; k < n; k++) {
+    mRe[k] = in[2 * k];
+    mIm[k] = in[2 * k + 1];
+  }
+  complexTransform(mRe.data(), mIm.data(), mWorkRe.data(), mWorkIm.data());
+
+  const float *rc = mPlan->realCos.data();
+  const float *rs = mPlan->realSin.data();
+  for (unsigned int k = 0; k <= n; k++) {
+    unsigned int k1 = k == n ? 0 : k;
+    unsigned int k2 = k == 0 ? 0 : n - k;
+    float a = mRe[k1], b = mIm[k1];
+    float c = mRe[k2], d = mIm[k2];
+    // Spectra of the even and odd samples
+    float er = 0.5f * (a + c), ei = 0.5f * (b - d);
+    float orr = 0.5f * (b + d), oi = -0.5f * (a - c);
+    re[k] = er + rc[k] * orr - rs[k] * oi;
+    im[k] = ei + rc[k] * oi + rs[k] * orr;
+  }
+}
+
+void RFFT::inverse(const float *re, const float *im, float *out) {
+  const unsigned int n = mSize / 2;
+  const float *rc = mPlan->realCos.data();
+  const float *rs = mPlan->realSin.data();
+  mRe[0] = 0.5f * (re[0] + re[n]);
+  mIm[0] = 0.5f * (re[0] - re[n]);
+  for (unsigned int k = 1; k < n; k++) {
+    float a = re[k], b = im[k];
+    float c = re[n - k], d = -im[n - k];
+    float er = 0.5f * (a + c), ei = 0.5f * (b + d);
+    float dr = 0.5f * (a - c), di = 0.5f * (b - d);
+    // Odd spectrum: difference times the conjugate twiddle
+    float orr = dr * rc[k] + di * rs[k];
+    float oi = di * rc[k] - dr * rs[k];
+    mRe[k] = er - oi;
+    mIm[k] = ei + orr;
+  }
+  // Inverse through the forward transform with real and imaginary swapped
+  complexTransform(mIm.data(), mRe.data(), mWorkIm.data(), mWorkRe.data());
+  const float scale = 1.0f / n;
+  for (unsigned int k = 0; k < n; k++) {
+    out[2 * k] = mRe[k] * scale;
+    out[2 * k + 1] = mIm[k] * scale;
+  }
+}
@@ -339,6 +339,12 @@ size_t Send::send(const Packet &p) {
   return r;
 }
 
+size_t Send::sendRaw(const char *data, size_t size) {
+  size_t r = 0;
+  OSCTRY("Send::sendRaw", r = socketSender->send(data, size);)
+  return r;
+}
+
 static void *recvThreadFunc(void *user) {
   Recv *r = static_cast<Recv *>(user);
   r->loop();
@@ -8,6 +8,14 @@
 using namespace std;
 using namespace al;
 
+// Identifies a voice output channel to the spatializer across blocks
+static uint64_t spatializerSourceId(SynthVoice *voice, unsigned int channel) {
+  if (voice->id() < 0) {
+    return Spatializer::NO_SOURCE_ID;
+  }
+  return (uint64_t(uint32_t(voice->id())) << 16) | channel;
+}
+
 ThreadPool::ThreadPool(unsigned int n) : busy() {
   for (unsigned int i = 0; i < n; ++i) {
     workers.emplace_back(std::bind(&ThreadPool::thread_proc, this));
@@ -110,6 +118,7 @@ void DynamicScene::prepare(AudioIOData &io) {
                  "is likely to crash."
               << std::endl;
   }
+  mSpatializerBatch.configure(mSpatializerBatchSize, io.framesPerBuffer());
   mThreadedAudioData.resize(mAudioThreads.size());
   for (auto &threadio : mThreadedAudioData) {
     threadio.framesPerBuffer(io.framesPerBuffer());
@@ -117,6 +126,10 @@ void DynamicScene::prepare(AudioIOData &io) {
     threadio.channelsOut(mVoiceMaxOutputChannels);
     threadio.channelsBus(mVoiceBusChannels);
   }
+  mThreadedBatches.resize(mAudioThreads.size());
+  for (auto &batch : mThreadedBatches) {
+    batch.configure(mSpatializerBatchSize, io.framesPerBuffer());
+  }
   m_internalAudioConfigured = true;
 }
 
@@ -256,13 +269,19 @@ void DynamicScene::render(AudioIOData &io) {
               offsetPose.vec() += posOffsets[i];
             }
             Vec3f adjustedPos = offsetPose.vec();
-            mSpatializer->renderBuffer(io, adjustedPos,
-                                       internalAudioIO.outBuffer(i), fpb);
+            uint64_t sourceId = spatializerSourceId(voice, i);
+            if (!mSpatializerBatch.add(
+                    adjustedPos, internalAudioIO.outBuffer(i), sourceId)) {
+              mSpatializerBatch.render(*mSpatializer, io);
+              mSpatializerBatch.add(adjustedPos, internalAudioIO.outBuffer(i),
+                                    sourceId);
+            }
           }
         }
       }
       voice = voice->next;
     }
+    mSpatializerBatch.render(*mSpatializer, io);
   } else { // Process Audio Threaded
     mAudioBusy = 0;
     for (auto &tmap : mThreadMap) {
@@ -388,6 +407,7 @@ void DynamicScene::audioThreadFunc(DynamicScene *scene, int id) {
 
     vector<int> &idsToProcess = scene->mThreadMap[id];
     AudioIOData &internalAudioIO = scene->mThreadedAudioData[id];
+    SpatializerBatch &batch = scene->mThreadedBatches[id];
     AudioIOData &io = *scene->externalAudioIO;
     unsigned int fpb = internalAudioIO.framesPerBuffer();
     SynthVoice *voice = scene->mActiveVoices;
@@ -398,7 +418,7 @@ void DynamicScene::audioThreadFunc(DynamicScene *scene, int id) {
           idsToProcess.end()) { // voice has been assigned to this thread
         unsigned int offset = voice->getStartOffsetFrames(fpb);
         if (offset < fpb) {
-          io.frame(offset);
+          // The shared io is only touched under mSpatializerLock
           unsigned int endOffsetFrames = voice->getEndOffsetFrames(fpb);
           if (endOffsetFrames > 0 && endOffsetFrames <= fpb) {
             voice->triggerOff(endOffsetFrames);
@@ -450,22 +470,30 @@ void DynamicScene::audioThreadFunc(DynamicScene *scene, int id) {
               }
             }
           }
+          scene->mSpatializerLock.unlock();
+          // The batch copies whole buffers, so no frame cursors are needed
           for (unsigned int i = 0; i < voice->numOutChannels(); i++) {
-            io.frame(offset);
-            internalAudioIO.frame(offset);
             Pose offsetPose = scene->mListenerPose;
             if (posOffsets.size() > 0) {
               offsetPose.vec() += posOffsets[i];
             }
             Vec3f adjustedPos = offsetPose.vec();
-            scene->mSpatializer->renderBuffer(
-                io, adjustedPos, internalAudioIO.outBuffer(i), fpb);
+            uint64_t sourceId = spatializerSourceId(voice, i);
+            if (!batch.add(adjustedPos, internalAudioIO.outBuffer(i),
+                           sourceId)) {
+              scene->mSpatializerLock.lock();
+              batch.render(*scene->mSpatializer, io);
+              scene->mSpatializerLock.unlock();
+              batch.add(adjustedPos, internalAudioIO.outBuffer(i), sourceId);
+            }
           }
-          scene->mSpatializerLock.unlock();
         }
       }
       voice = voice->next;
     }
+    scene->mSpatializerLock.lock();
+    batch.render(*scene->mSpatializer, io);
+    scene->mSpatializerLock.unlock();
     scene->mAudioBusy--;
     scene->mAudioThreadDone.notify_one();
   }
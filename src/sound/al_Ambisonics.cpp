@@ -2,6 +2,15 @@
 
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "al/sound/al_Biquad.hpp"
+
 #ifdef USE_GAMMA
 #include "scl.h"
 #define COS gam::scl::cosT8
@@ -39,8 +48,11 @@ static const double c40_11 = 40. / 11.;
 
 // AmbiBase
 
-AmbiBase::AmbiBase(int dim, int order) : mDim(dim), mOrder(0), mWeights(0) {
-  this->order(order);
+AmbiBase::AmbiBase(int dim, int order, Convention convention)
+    : mDim(dim), mOrder(order), mChannels(orderToChannels(dim, order)),
+      mWeights(0), mConvention(convention) {
+  resize(mWeights, channels());
+  updateHarmonics();
 }
 
 AmbiBase::~AmbiBase() { delete[] mWeights; }
@@ -51,6 +63,7 @@ void AmbiBase::dim(int dim) {
     mDim = dim;
     mChannels = orderToChannels(mDim, mOrder);
     resize(mWeights, channels());
+    updateHarmonics();
     onChannelsChange();
   }
 }
@@ -60,10 +73,205 @@ void AmbiBase::order(int o) {
     mOrder = o;
     mChannels = orderToChannels(mDim, mOrder);
     resize(mWeights, channels());
+    updateHarmonics();
+    onChannelsChange();
+  }
+}
+
+void AmbiBase::convention(Convention convention) {
+  if (convention != mConvention) {
+    mConvention = convention;
+    updateHarmonics();
     onChannelsChange();
   }
 }
 
+// Associated Legendre function P_l^m(z) (without Condon-Shortley phase)
+// divided by (1 - z^2)^(m/2)
+static double legendreQ(int l, int m, double z) {
+  double q2 = 1.;
+  for (int k = 1; k <= m; ++k) {
+    q2 *= 2 * k - 1; // (2m - 1)!!
+  }
+  if (l == m) {
+    return q2;
+  }
+  double q1 = (2 * m + 1) * z * q2;
+  for (int k = m + 2; k <= l; ++k) {
+    double q = ((2 * k - 1) * z * q1 - (k + m - 1) * q2) / (k - m);
+    q2 = q1;
+    q1 = q;
+  }
+  return q1;
+}
+
+// Maximum of |P_l^m(z)| over [-1, 1], from a grid refined by a parabola
+// through the largest sample and its neighbours
+static double legendreMax(int l, int m) {
+  const int N = 1024;
+  auto value = [&](int i) {
+    double z = double(i) / N; // |P_l^m| is symmetric about z = 0
+    return std::abs(std::pow(1. - z * z, 0.5 * m) * legendreQ(l, m, z));
+  };
+  int best = 0;
+  double bestValue = value(0);
+  for (int i = 1; i <= N; ++i) {
+    double v = value(i);
+    if (v > bestValue) {
+      best = i;
+      bestValue = v;
+    }
+  }
+  if (best > 0 && best < N) {
+    double a = value(best - 1);
+    double c = value(best + 1);
+    double den = a - 2. * bestValue + c;
+    if (den < 0.) {
+      double t = 0.5 * (a - c) / den;
+      bestValue -= 0.25 * (a - c) * t;
+    }
+  }
+  return bestValue;
+}
+
+void AmbiBase::updateHarmonics() {
+  // FuMa weights of the hand-written encodeWeightsFuMa(), as multiples of
+  // (1 - z^2)^(-m/2) P_l^m(z) cos(m az) (sine part in the second column)
+  static const float fumaScales[4][4][2] = {
+      {{float(c1_sqrt2), 0.f}},
+      {{1.f, 0.f}, {1.f, 1.f}},
+      {{1.f, 0.f}, {2.f / 3.f, 2.f / 3.f}, {1.f / 3.f, 1.f / 3.f}},
+      {{1.f, 0.f},
+       {16.f / 33.f, 16.f / 33.f},
+       {1.f / 30.f, 1.f / 30.f},
+       {1.f / 15.f, -1.f / 15.f}}};
+
+  mHarmonics.clear();
+  mChannelOrders.assign(mChannels, 0);
+  for (int m = 0; m <= mOrder; ++m) {
+    int maxL = (mDim == 2) ? m : mOrder;
+    for (int l = m; l <= maxL; ++l) {
+      Harmonic h;
+      h.l = l;
+      h.m = m;
+      if (mConvention == ACN_SN3D) {
+        if (mDim == 2) {
+          h.cosChannel = 2 * l;
+          h.sinChannel = 2 * l - 1;
+        } else {
+          h.cosChannel = l * l + l + m;
+          h.sinChannel = l * l + l - m;
+        }
+        // sqrt((2 - delta_m) (l - m)! / (l + m)!)
+        double norm = (m == 0) ? 1. : 2.;
+        for (int k = l - m + 1; k <= l + m; ++k) {
+          norm /= k;
+        }
+        h.cosScale = h.sinScale = float(std::sqrt(norm));
+      } else {
+        if (l == 0) {
+          h.cosChannel = 0;
+        } else if (l == m) {
+          h.cosChannel = 2 * l - 1;
+          h.sinChannel = 2 * l;
+        } else {
+          h.cosChannel = orderToChannelsH(mOrder) + (l - 1) * (l - 1) +
+                         2 * (l - 1 - m);
+          h.sinChannel = h.cosChannel + 1;
+        }
+        if (l < 4) {
+          h.cosScale = fumaScales[l][m][0];
+          h.sinScale = fumaScales[l][m][1];
+        } else {
+          h.cosScale = h.sinScale = float(1. / legendreMax(l, m));
+        }
+      }
+      if (m == 0) {
+        h.sinChannel = -1;
+        h.sinScale = 0.f;
+      } else {
+        mChannelOrders[h.sinChannel] = l;
+      }
+      mChannelOrders[h.cosChannel] = l;
+      mHarmonics.push_back(h);
+    }
+  }
+}
+
+void AmbiBase::encodeWeights(float *ws, float x, float y, float z) const {
+  Vec3f dir(x, y, z);
+  encodeWeights(ws, 1, &dir, 1);
+}
+
+void AmbiBase::encodeWeights(float *ws, int stride, const Vec3f *dirs,
+                             int count) const {
+  // Directions are processed in blocks so that every recurrence step is a
+  // short loop over directions the compiler can vectorize
+  const int blockSize = 16;
+  float x[blockSize], y[blockSize], z[blockSize];
+  float cm[blockSize], sm[blockSize]; // Re, Im of (x + iy)^m
+  float q[blockSize], q1[blockSize], q2[blockSize];
+
+  for (int start = 0; start < count; start += blockSize) {
+    const int n = std::min(blockSize, count - start);
+    for (int i = 0; i < n; ++i) {
+      x[i] = dirs[start + i].x;
+      y[i] = dirs[start + i].y;
+      z[i] = dirs[start + i].z;
+      cm[i] = 1.f;
+      sm[i] = 0.f;
+    }
+
+    int m = 0;
+    float qmm = 1.f; // (2m - 1)!!
+    for (const Harmonic &h : mHarmonics) {
+      while (m < h.m) {
+        for (int i = 0; i < n; ++i) {
+          float c = x[i] * cm[i] - y[i] * sm[i];
+          sm[i] = x[i] * sm[i] + y[i] * cm[i];
+          cm[i] = c;
+        }
+        qmm *= 2 * m + 1;
+        ++m;
+      }
+
+      // Q_l^m from Q_(l-1)^m and Q_(l-2)^m
+      const int l = h.l;
+      if (l == m) {
+        for (int i = 0; i < n; ++i) {
+          q[i] = qmm;
+        }
+      } else if (l == m + 1) {
+        const float k = (2 * m + 1) * qmm;
+        for (int i = 0; i < n; ++i) {
+          q[i] = k * z[i];
+        }
+      } else {
+        const float a = float(2 * l - 1) / (l - m);
+        const float b = float(l + m - 1) / (l - m);
+        for (int i = 0; i < n; ++i) {
+          q[i] = a * z[i] * q1[i] - b * q2[i];
+        }
+      }
+      for (int i = 0; i < n; ++i) {
+        q2[i] = q1[i];
+        q1[i] = q[i];
+      }
+
+      float *wc = ws + h.cosChannel * stride + start;
+      for (int i = 0; i < n; ++i) {
+        wc[i] = h.cosScale * q[i] * cm[i];
+      }
+      if (h.sinChannel >= 0) {
+        float *wsin = ws + h.sinChannel * stride + start;
+        for (int i = 0; i < n; ++i) {
+          wsin[i] = h.sinScale * q[i] * sm[i];
+        }
+      }
+    }
+  }
+}
+
 int AmbiBase::channelsToUniformOrder(int channels) {
   // M = floor(sqrt(N) - 1)
   return (int)(sqrt((double)channels) - 1);
@@ -201,64 +409,456 @@ float AmbiDecode::flavorWeights[4][5][5] = {
         {0, 0, 0, 0, 0.246}              // n = 4, M = 0, 1, 2, 3, 4
     }};
 
+// Per-order weights for orders above the flavorWeights table. In-phase uses
+// g_n = M!(M+1)! / ((M+n+1)!(M-n)!), max-rE (also used for the default
+// flavor) uses g_n = P_n(cos(137.9 deg / (M + 1.51))).
+float AmbiDecode::orderWeight(int flavor, int n, int order) {
+  if (order < 5) {
+    return flavorWeights[flavor][n][order];
+  }
+  double g = 1.;
+  if (flavor == 0) {
+    return 1.f;
+  } else if (flavor == 2) {
+    for (int k = 1; k <= n; ++k) {
+      g *= double(order - k + 1) / (order + k + 1);
+    }
+  } else {
+    const double c = std::cos(2.406808 / (order + 1.51));
+    g = legendreQ(n, 0, c);
+  }
+  return float(g);
+}
+
+// Decode matrix and block buffers. Built by the setters and handed to the
+// audio thread whole, so decode() never sees a partial update.
+struct AmbiDecode::DecodePlan {
+  // Effective decode matrix, one row per output device channel with the
+  // channel weights applied. Dual-band decoding adds a column per Ambisonic
+  // channel for its low band.
+  std::vector<float> matrix;
+  std::vector<float> panels; // matrix in panels of 4 rows for decodeRows()
+  std::vector<unsigned int> rowChannels;
+  int numChannels{0}; // Ambisonic input channels
+  int columns{0};
+  int numChunks{1}; // row chunks, one per decoding thread
+
+  bool dualBand{false};
+  BiQuadBank crossover; // low pass for each Ambisonic channel
+  std::vector<float> lowBand;
+  std::vector<float *> lowBandChannels;
+
+  // Current block
+  std::vector<const float *> inputs; // one per matrix column
+  std::vector<float *> outputs;      // one per matrix row
+
+  DecodePlan *nextRetired{nullptr}; // link in DecodeEngine::retired
+};
+
+struct AmbiDecode::DecodeEngine {
+  // Settings, used by the setters
+  bool dualBand{false};
+  float crossoverFrequency{400.f};
+  float sampleRate{44100.f};
+  int framesPerBuffer{0};
+  int numThreads{1};
+  bool holdUpdates{false};
+
+  // The setters publish a new plan in pending and decode() takes it, pushing
+  // the plan it replaces on the retired list for the next setter to delete.
+  // A plan in pending that decode() has not taken is deleted by the setter
+  // that replaces it.
+  std::unique_ptr<DecodePlan> current; // only used by decode()
+  std::atomic<DecodePlan *> pending{nullptr};
+  std::atomic<DecodePlan *> retired{nullptr};
+
+  int numFrames{0};
+
+  // Rows are split in chunks claimed by the decoding thread and the workers.
+  // ticket holds the block number in the high 32 bits, the number of chunks
+  // in the block in the next 16 and the next chunk in the low 16, so workers
+  // never read the chunk count from a plan that may be replaced. threads is
+  // only used by the setters.
+  std::vector<std::thread> threads;
+  std::atomic<uint64_t> ticket{0};
+  std::atomic<int> chunksDone{0};
+  std::atomic<bool> running{true};
+  std::mutex lock; // idle workers sleep on trigger
+  std::condition_variable trigger;
+
+  ~DecodeEngine() {
+    delete pending.load();
+    deleteRetired();
+  }
+
+  void deleteRetired() {
+    DecodePlan *plan = retired.exchange(nullptr, std::memory_order_acquire);
+    while (plan) {
+      DecodePlan *next = plan->nextRetired;
+      delete plan;
+      plan = next;
+    }
+  }
+};
+
 AmbiDecode::AmbiDecode(int dim, int order, int numSpeakers, int flav)
-    : AmbiBase(dim, order), mNumSpeakers(0), mDecodeMatrix(nullptr) {
+    : AmbiBase(dim, order), mNumSpeakers(0), mFlavor(1),
+      mDecodeMatrix(nullptr), mEngine(new DecodeEngine) {
+  mEngine->holdUpdates = true;
+  updateOrderWeights();
   resizeArrays(channels(), numSpeakers);
   flavor(flav);
+  mEngine->holdUpdates = false;
+  updateMatrix();
 }
 
 AmbiDecode::~AmbiDecode() {
+  stopThreads();
   delete[] mDecodeMatrix;
   // delete[] mSpeakers; // listener now owns speakers and will delete them
 }
 
-void AmbiDecode::decode(float *dec, const float *ambi, int numDecFrames) const {
-  // iterate speakers
-  for (int s = 0; s < numSpeakers(); ++s) {
-    // skip zero-amp speakers:
-    if (mSpeakers[s].gain != 0.) {
-      float *out = dec + mSpeakers[s].deviceChannel * numDecFrames;
-
-      // iterate ambi channels
-      for (int c = 0; c < channels(); ++c) {
-        const float *in = ambi + c * numDecFrames;
-        float w = decodeWeight(s, c);
-        for (int i = 0; i < numDecFrames; ++i)
-          out[i] += in[i] * w;
+bool AmbiDecode::takePlan() const {
+  DecodeEngine &e = *mEngine;
+  DecodePlan *plan = e.pending.exchange(nullptr, std::memory_order_acquire);
+  if (plan) {
+    DecodePlan *old = e.current.release();
+    e.current.reset(plan);
+    if (old) {
+      // Only contends with a setter taking the whole list
+      old->nextRetired = e.retired.load(std::memory_order_relaxed);
+      while (!e.retired.compare_exchange_weak(old->nextRetired, old,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
       }
     }
   }
+  return e.current != nullptr;
+}
+
+void AmbiDecode::decode(float *dec, const float *ambi, int numDecFrames) const {
+  if (!takePlan()) {
+    return;
+  }
+  DecodePlan &p = *mEngine->current;
+  for (int c = 0; c < p.numChannels; ++c) {
+    p.inputs[c] = ambi + c * numDecFrames;
+  }
+  for (size_t r = 0; r < p.rowChannels.size(); ++r) {
+    p.outputs[r] = dec + p.rowChannels[r] * numDecFrames;
+  }
+  decodeBlock(numDecFrames);
 }
 
 void AmbiDecode::decode(float **dec, const float **ambi,
                         int numDecFrames) const {
-  // iterate speakers
-  for (int s = 0; s < numSpeakers(); ++s) {
+  if (!takePlan()) {
+    return;
+  }
+  DecodePlan &p = *mEngine->current;
+  for (int c = 0; c < p.numChannels; ++c) {
+    p.inputs[c] = ambi[c];
+  }
+  for (size_t r = 0; r < p.rowChannels.size(); ++r) {
+    p.outputs[r] = dec[p.rowChannels[r]];
+  }
+  decodeBlock(numDecFrames);
+}
+
+void AmbiDecode::prepare(int framesPerBuffer) {
+  mEngine->framesPerBuffer = framesPerBuffer;
+  updateMatrix();
+}
+
+void AmbiDecode::updateMatrix() {
+  DecodeEngine &e = *mEngine;
+  if (e.holdUpdates) {
+    return;
+  }
+  std::unique_ptr<DecodePlan> plan(new DecodePlan);
+  DecodePlan &p = *plan;
+  const int numChannels = channels();
+  std::vector<float> high(numChannels), low(numChannels);
+  for (int c = 0; c < numChannels; ++c) {
+    if (e.dualBand) {
+      high[c] = orderWeight(3, channelOrder(c), mOrder);
+      low[c] = orderWeight(0, channelOrder(c), mOrder);
+    } else {
+      high[c] = mWeights[c];
+    }
+  }
+
+  // Speakers sharing a device channel are merged into one row, so rows can
+  // be processed by different threads without writing the same output
+  p.dualBand = e.dualBand;
+  p.numChannels = numChannels;
+  p.columns = e.dualBand ? 2 * numChannels : numChannels;
+  p.numChunks = e.numThreads;
+  const int numActive = std::min(mNumSpeakers, int(mSpeakers.size()));
+  for (int s = 0; s < numActive; ++s) {
     // skip zero-amp speakers:
-    if (mSpeakers[s].gain != 0.) {
-      float *out = dec[mSpeakers[s].deviceChannel];
-
-      // iterate ambi channels
-      for (int c = 0; c < channels(); ++c) {
-        const float *in = ambi[c];
-        float w = decodeWeight(s, c);
-        for (int i = 0; i < numDecFrames; ++i)
-          out[i] += in[i] * w;
+    if (mSpeakers[s].gain == 0.) {
+      continue;
+    }
+    size_t row = std::find(p.rowChannels.begin(), p.rowChannels.end(),
+                           mSpeakers[s].deviceChannel) -
+                 p.rowChannels.begin();
+    if (row == p.rowChannels.size()) {
+      p.rowChannels.push_back(mSpeakers[s].deviceChannel);
+      p.matrix.resize(p.matrix.size() + p.columns, 0.f);
+    }
+    float *m = p.matrix.data() + row * p.columns;
+    const float *d = mDecodeMatrix + s * numChannels;
+    for (int c = 0; c < numChannels; ++c) {
+      m[c] += high[c] * d[c];
+      if (e.dualBand) {
+        // high band = input - low band
+        m[numChannels + c] += (low[c] - high[c]) * d[c];
       }
     }
   }
+
+  // Panels of four rows, column-major within the panel
+  const int numRows = p.rowChannels.size();
+  p.panels.resize(numRows / 4 * 4 * p.columns);
+  for (int r = 0; r < numRows / 4 * 4; ++r) {
+    for (int c = 0; c < p.columns; ++c) {
+      p.panels[(r / 4 * p.columns + c) * 4 + r % 4] =
+          p.matrix[r * p.columns + c];
+    }
+  }
+
+  p.inputs.resize(p.columns);
+  p.outputs.resize(numRows);
+  if (e.dualBand) {
+    p.crossover.setSampleRate(e.sampleRate);
+    p.crossover.resize(numChannels);
+    p.crossover.set(-1, 0, BIQUAD_LPF, e.crossoverFrequency);
+    p.lowBand.resize(numChannels * e.framesPerBuffer);
+    p.lowBandChannels.resize(numChannels);
+  }
+
+  e.deleteRetired();
+  delete e.pending.exchange(plan.release(), std::memory_order_acq_rel);
+}
+
+void AmbiDecode::decodeBlock(int numFrames) const {
+  DecodeEngine &e = *mEngine;
+  DecodePlan &p = *e.current;
+  e.numFrames = numFrames;
+  if (p.dualBand) {
+    const int numChannels = p.numChannels;
+    if (p.lowBand.size() < size_t(numChannels * numFrames)) {
+      // Only when prepare() was not given the block size
+      p.lowBand.resize(numChannels * numFrames);
+    }
+    for (int c = 0; c < numChannels; ++c) {
+      p.lowBandChannels[c] = p.lowBand.data() + c * numFrames;
+    }
+    p.crossover.process(p.inputs.data(), p.lowBandChannels.data(), numFrames);
+    for (int c = 0; c < numChannels; ++c) {
+      p.inputs[numChannels + c] = p.lowBandChannels[c];
+    }
+  }
+
+  if (p.numChunks <= 1) {
+    decodeRows(0, int(p.rowChannels.size()));
+    return;
+  }
+  // Publish the block, then decode chunks alongside the workers. Nothing
+  // here blocks: chunks not claimed by a worker are decoded by this thread,
+  // so the block completes even while numThreads() is stopping workers, and
+  // the final wait is only for chunks already being decoded.
+  e.chunksDone.store(0, std::memory_order_relaxed);
+  const uint32_t block =
+      uint32_t(e.ticket.load(std::memory_order_relaxed) >> 32) + 1;
+  e.ticket.store((uint64_t(block) << 32) | (uint64_t(p.numChunks) << 16),
+                 std::memory_order_release);
+  e.trigger.notify_all();
+  decodeChunks(block);
+  while (e.chunksDone.load(std::memory_order_acquire) < p.numChunks) {
+    std::this_thread::yield();
+  }
+}
+
+void AmbiDecode::decodeChunks(uint32_t block) const {
+  DecodeEngine &e = *mEngine;
+  uint64_t ticket = e.ticket.load(std::memory_order_acquire);
+  while (uint32_t(ticket >> 32) == block &&
+         int(ticket & 0xffff) < int((ticket >> 16) & 0xffff)) {
+    if (e.ticket.compare_exchange_weak(ticket, ticket + 1,
+                                       std::memory_order_acq_rel)) {
+      int begin, end;
+      rowRange(int(ticket & 0xffff), int((ticket >> 16) & 0xffff), begin,
+               end);
+      decodeRows(begin, end);
+      e.chunksDone.fetch_add(1, std::memory_order_release);
+      ticket = e.ticket.load(std::memory_order_acquire);
+    }
+  }
+}
+
+void AmbiDecode::rowRange(int chunk, int numChunks, int &begin,
+                          int &end) const {
+  // Groups of four rows, as processed by decodeRows()
+  const int numRows = mEngine->current->rowChannels.size();
+  const int numGroups = (numRows + 3) / 4;
+  begin = std::min(numRows, 4 * (numGroups * chunk / numChunks));
+  end = std::min(numRows, 4 * (numGroups * (chunk + 1) / numChunks));
+}
+
+// Accumulate inputs into one output over frames [begin, end)
+static void decodeRow(const float *m, int columns, const float *const *inputs,
+                      float *out, int begin, int end) {
+  for (int c = 0; c < columns; ++c) {
+    const float *in = inputs[c];
+    const float g = m[c];
+    for (int i = begin; i < end; ++i) {
+      out[i] += g * in[i];
+    }
+  }
+}
+
+void AmbiDecode::decodeRows(int begin, int end) const {
+  const DecodePlan &p = *mEngine->current;
+  const int columns = p.columns;
+  const int numFrames = mEngine->numFrames;
+  // Below this many inputs, streaming each output is as fast
+  const int minBlockedColumns = 8;
+
+  int blockedEnd = begin;
+  if (columns >= minBlockedColumns) {
+    blockedEnd = begin + (end - begin) / 4 * 4;
+    // Four outputs by 16 frames are accumulated in registers over all inputs,
+    // so outputs are written once instead of once per input. The 16 frame
+    // strip of the inputs and the matrix panels stay in L1 cache across
+    // panels.
+    const int width = 16;
+    const int blockedFrames = numFrames - numFrames % width;
+    for (int start = 0; start < blockedFrames; start += width) {
+      for (int r = begin; r < blockedEnd; r += 4) {
+        float a0[width] = {0}, a1[width] = {0}, a2[width] = {0},
+              a3[width] = {0};
+        const float *g = p.panels.data() + r * columns;
+        for (int c = 0; c < columns; ++c, g += 4) {
+          const float *in = p.inputs[c] + start;
+          const float g0 = g[0], g1 = g[1], g2 = g[2], g3 = g[3];
+          for (int i = 0; i < width; ++i) {
+            a0[i] += g0 * in[i];
+            a1[i] += g1 * in[i];
+            a2[i] += g2 * in[i];
+            a3[i] += g3 * in[i];
+          }
+        }
+        float *out = p.outputs[r] + start;
+        for (int i = 0; i < width; ++i) {
+          out[i] += a0[i];
+        }
+        out = p.outputs[r + 1] + start;
+        for (int i = 0; i < width; ++i) {
+          out[i] += a1[i];
+        }
+        out = p.outputs[r + 2] + start;
+        for (int i = 0; i < width; ++i) {
+          out[i] += a2[i];
+        }
+        out = p.outputs[r + 3] + start;
+        for (int i = 0; i < width; ++i) {
+          out[i] += a3[i];
+        }
+      }
+    }
+    for (int r = begin; r < blockedEnd; ++r) {
+      decodeRow(p.matrix.data() + r * columns, columns, p.inputs.data(),
+                p.outputs[r], blockedFrames, numFrames);
+    }
+  }
+  for (int r = blockedEnd; r < end; ++r) {
+    decodeRow(p.matrix.data() + r * columns, columns, p.inputs.data(),
+              p.outputs[r], 0, numFrames);
+  }
+}
+
+void AmbiDecode::numThreads(int num) {
+  DecodeEngine &e = *mEngine;
+  num = std::max(1, std::min(num, 0xffff));
+  // A block in progress keeps the chunks it was published with. Chunks no
+  // worker is left to claim are decoded by the calling thread.
+  stopThreads();
+  e.numThreads = num;
+  e.running = true;
+  for (int i = 1; i < num; ++i) {
+    e.threads.push_back(std::thread(AmbiDecode::decodeThreadFunc, this));
+  }
+  updateMatrix();
 }
 
+int AmbiDecode::numThreads() const { return mEngine->numThreads; }
+
+void AmbiDecode::stopThreads() {
+  DecodeEngine &e = *mEngine;
+  {
+    std::unique_lock<std::mutex> lk(e.lock);
+    e.running = false;
+  }
+  e.trigger.notify_all();
+  for (auto &thr : e.threads) {
+    thr.join();
+  }
+  e.threads.clear();
+}
+
+void AmbiDecode::decodeThreadFunc(AmbiDecode *decoder) {
+  DecodeEngine &e = *decoder->mEngine;
+  auto currentBlock = [&e]() {
+    return uint32_t(e.ticket.load(std::memory_order_acquire) >> 32);
+  };
+  uint32_t lastBlock = currentBlock();
+  int idle = 0;
+  while (e.running.load()) {
+    uint32_t block = currentBlock();
+    if (block != lastBlock) {
+      lastBlock = block;
+      decoder->decodeChunks(block);
+      idle = 0;
+    } else if (++idle < 1000) {
+      std::this_thread::yield();
+    } else {
+      // Sleep between blocks. A missed notification only means the decoding
+      // thread takes this worker's chunks.
+      std::unique_lock<std::mutex> lk(e.lock);
+      e.trigger.wait_for(lk, std::chrono::milliseconds(1), [&]() {
+        return !e.running.load() || currentBlock() != lastBlock;
+      });
+    }
+  }
+}
+
+void AmbiDecode::dualBand(bool enable, float crossoverFrequency,
+                          float sampleRate) {
+  mEngine->dualBand = enable;
+  mEngine->crossoverFrequency = crossoverFrequency;
+  mEngine->sampleRate = sampleRate;
+  updateMatrix();
+}
+
+bool AmbiDecode::dualBand() const { return mEngine->dualBand; }
+
 void AmbiDecode::flavor(int type) {
   if (type < 4) {
     mFlavor = type;
-    const int No = sizeof(mWOrder) / sizeof(mWOrder[0]);
-    for (int i = 0; i < No; ++i)
-      mWOrder[i] = flavorWeights[flavor()][i][order()];
+    updateOrderWeights();
     updateChanWeights();
   }
 }
 
+void AmbiDecode::updateOrderWeights() {
+  mWOrder.resize(mOrder + 1);
+  for (int i = 0; i <= mOrder; ++i) {
+    mWOrder[i] = orderWeight(mFlavor, i, mOrder);
+  }
+}
+
 void AmbiDecode::numSpeakers(int num) { resizeArrays(channels(), num); }
 
 // void AmbiDecode::zero(){ memset(mFrame, 0, channels()*sizeof(float)); }
@@ -277,10 +877,13 @@ void AmbiDecode::setSpeakerRadians(int index, int deviceChannel, float az,
   mSpeakers[index].gain = amp;
 
   // update encoding weights
-  encodeWeightsFuMa(mDecodeMatrix + index * channels(), mDim, mOrder, az, el);
+  float cosel = COS(el);
+  encodeWeights(mDecodeMatrix + index * channels(), COS(az) * cosel,
+                SIN(az) * cosel, mDim >= 3 ? SIN(el) : 0.f);
   for (int i = 0; i < channels(); i++) {
     mDecodeMatrix[index * channels() + i] *= amp;
   }
+  updateMatrix();
 }
 
 void AmbiDecode::setSpeaker(int index, int deviceChannel, float az, float el,
@@ -301,51 +904,26 @@ void AmbiDecode::setSpeakers(Speakers *spkrs) {
 
 void AmbiDecode::setSpeakers(Speakers &spkrs) {
   mSpeakers = spkrs;
+  // Build the decode matrix once for all speakers
+  mEngine->holdUpdates = true;
   resizeArrays(channels(), mSpeakers.size());
   // update encoding weights
-  for (int i = 0; i < mSpeakers.size(); i++) {
-    for (int index = 0; index < channels(); index++) {
-      encodeWeightsFuMa(mDecodeMatrix + index * channels(), mDim, mOrder,
-                        mSpeakers[i].azimuth, mSpeakers[i].elevation);
-      for (int i = 0; i < channels(); i++) {
-        mDecodeMatrix[index * channels() + i] *= mSpeakers[i].gain;
-      }
-    }
+  for (int i = 0; i < int(mSpeakers.size()); i++) {
+    setSpeaker(i, mSpeakers[i].deviceChannel, mSpeakers[i].azimuth,
+               mSpeakers[i].elevation, mSpeakers[i].gain);
   }
+  mEngine->holdUpdates = false;
+  updateMatrix();
 }
 
 void AmbiDecode::updateChanWeights() {
-  float *wc = mWeights;
-  *wc++ = mWOrder[0];
-
-  if (mOrder > 0) {
-    *wc++ = mWOrder[1]; // X
-    *wc++ = mWOrder[1]; // Y
-    if (mOrder > 1) {
-      *wc++ = mWOrder[2]; // U
-      *wc++ = mWOrder[2]; // V
-      if (mOrder > 2) {
-        *wc++ = mWOrder[3]; // P
-        *wc++ = mWOrder[3]; // Q
-      }
-    }
-
-    if (3 == mDim) {
-      *wc++ = mWOrder[1]; // Z
-      if (mOrder > 1) {
-        *wc++ = mWOrder[2]; // S
-        *wc++ = mWOrder[2]; // T
-        *wc++ = mWOrder[2]; // R
-        if (mOrder > 2) {
-          *wc++ = mWOrder[3]; // N
-          *wc++ = mWOrder[3]; // O
-          *wc++ = mWOrder[3]; // L
-          *wc++ = mWOrder[3]; // M
-          *wc = mWOrder[3];   // K
-        }
-      }
-    }
+  if (int(mWOrder.size()) != mOrder + 1) {
+    return;
   }
+  for (int c = 0; c < channels(); ++c) {
+    mWeights[c] = mWOrder[mChannelOrders[c]];
+  }
+  updateMatrix();
 }
 
 void AmbiDecode::resizeArrays(int numChannels, int numSpeakers) {
@@ -372,9 +950,17 @@ void AmbiDecode::resizeArrays(int numChannels, int numSpeakers) {
   }
 
   mChannels = numChannels;
+  updateMatrix();
 }
 
-void AmbiDecode::onChannelsChange() { resizeArrays(channels(), mNumSpeakers); }
+void AmbiDecode::onChannelsChange() {
+  mEngine->holdUpdates = true;
+  resizeArrays(channels(), mNumSpeakers);
+  updateOrderWeights();
+  updateChanWeights();
+  mEngine->holdUpdates = false;
+  updateMatrix();
+}
 
 void AmbiDecode::print(std::ostream &stream) const {
   //	AmbiBase::print(stdout, ", ");
@@ -408,6 +994,41 @@ void AmbiEncode::print(std::ostream &stream) {
   stream << std::endl;
 }
 
+void AmbiEncode::encode(float *ambiChans, const Vec3f *dirs,
+                        const float *const *inputs, int numSources,
+                        int numFrames) {
+  const int numChannels = channels();
+  if (mSourceWeights.size() < size_t(numSources * numChannels)) {
+    mSourceWeights.resize(numSources * numChannels);
+  }
+  encodeWeights(mSourceWeights.data(), numSources, dirs, numSources);
+
+  // outer-space, inner-time: each ambi channel is accumulated for all sources
+  // while it is in cache, four sources per pass over the channel
+  for (int c = 0; c < numChannels; ++c) {
+    float *ambi = ambiChans + c * numFrames;
+    const float *w = mSourceWeights.data() + c * numSources;
+    int s = 0;
+    for (; s + 4 <= numSources; s += 4) {
+      const float w0 = w[s], w1 = w[s + 1], w2 = w[s + 2], w3 = w[s + 3];
+      const float *in0 = inputs[s];
+      const float *in1 = inputs[s + 1];
+      const float *in2 = inputs[s + 2];
+      const float *in3 = inputs[s + 3];
+      for (int i = 0; i < numFrames; ++i) {
+        ambi[i] += w0 * in0[i] + w1 * in1[i] + w2 * in2[i] + w3 * in3[i];
+      }
+    }
+    for (; s < numSources; ++s) {
+      const float weight = w[s];
+      const float *in = inputs[s];
+      for (int i = 0; i < numFrames; ++i) {
+        ambi[i] += weight * in[i];
+      }
+    }
+  }
+}
+
 // Ambisonics Spatializer -----------------
 
 AmbisonicsSpatializer::AmbisonicsSpatializer()
@@ -424,28 +1045,27 @@ void AmbisonicsSpatializer::zeroAmbi() {
   memset(ambiChans(), 0, mAmbiDomainChannels.size() * sizeof(ambiChans()[0]));
 }
 
-void AmbisonicsSpatializer::configure(int dim, int order, int flavor) {
+void AmbisonicsSpatializer::configure(int dim, int order, int flavor,
+                                      AmbiBase::Convention convention) {
   mDecoder.dim(dim);
   mDecoder.order(order);
+  mDecoder.convention(convention);
   mDecoder.flavor(flavor);
 
   mEncoder.dim(dim);
   mEncoder.order(order);
-}
-
-void AmbisonicsSpatializer::compile() {
-  mDecoder.setSpeakers(&mSpeakers);
+  mEncoder.convention(convention);
 
-  size_t numSpeakers = mSpeakers.size();
-  for (size_t i = 0; i < numSpeakers; i++) {
-    mDecoder.setSpeakerRadians(i, mSpeakers[i].deviceChannel,
-                               mSpeakers[i].azimuth, mSpeakers[i].elevation,
-                               mSpeakers[i].gain);
+  if (mNumFrames != 0) {
+    numFrames(mNumFrames); // resize Ambisonic domain buffers
   }
 }
 
+void AmbisonicsSpatializer::compile() { mDecoder.setSpeakers(&mSpeakers); }
+
 void AmbisonicsSpatializer::numFrames(unsigned int v) {
   mNumFrames = v;
+  mDecoder.prepare(int(v));
   if (mAmbiDomainChannels.size() != (unsigned long)(mDecoder.channels() * v)) {
     mAmbiDomainChannels.resize(mDecoder.channels() * v);
   }
@@ -502,6 +1122,15 @@ void AmbisonicsSpatializer::renderBuffer(AudioIOData &io, const Vec3f &pos,
   mEncoder.encode(ambiChans(), samples, numFrames);
 }
 
+void AmbisonicsSpatializer::renderBuffers(AudioIOData &io,
+                                          const Vec3f *positions,
+                                          const float *const *samples,
+                                          const unsigned int &numSources,
+                                          const unsigned int &numFrames,
+                                          const uint64_t *sourceIds) {
+  mEncoder.encode(ambiChans(), positions, samples, numSources, numFrames);
+}
+
 void AmbisonicsSpatializer::renderSample(AudioIOData &io, const Vec3f &pos,
                                          const float &sample,
                                          const unsigned int &frameIndex) {
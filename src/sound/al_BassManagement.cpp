@@ -0,0 +1,162 @@
+#include "al/sound/al_BassManagement.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace al;
+
+void BassManagement::configure(const Speakers &mains,
+                               const Speakers &subwoofers,
+                               double crossoverFreq, double sampleRate,
+                               int framesPerBuffer, Routing routing) {
+  mMains = mains;
+  mSubwoofers = subwoofers;
+  mRouting = routing;
+  mFramesPerBuffer = std::max(framesPerBuffer, 1);
+  mWarned = false;
+  mMainFilters.configure(int(mains.size()), crossoverFreq, sampleRate);
+  mSubFilters.configure(int(subwoofers.size()), crossoverFreq, sampleRate);
+
+  mSendGains.assign(mains.size(), 1.0f);
+  mSubGains.assign(subwoofers.size(), 1.0f);
+  updateSends();
+
+  mMix.assign(subwoofers.size() * mFramesPerBuffer, 0.0f);
+  mMixChannels.resize(subwoofers.size());
+  for (size_t s = 0; s < subwoofers.size(); s++) {
+    mMixChannels[s] = mMix.data() + s * mFramesPerBuffer;
+  }
+  mMainChannels.resize(mains.size());
+
+  // Align subwoofers to the farthest of all speakers
+  Speakers all = mains;
+  all.insert(all.end(), subwoofers.begin(), subwoofers.end());
+  const double speedOfSound = 343.0;
+  float maxDistance = 0;
+  for (auto &speaker : all) {
+    maxDistance = std::max(maxDistance, speaker.radius);
+  }
+  mSubAdjustment.configure(subwoofers, mFramesPerBuffer, sampleRate,
+                           speedOfSound);
+  for (size_t s = 0; s < subwoofers.size(); s++) {
+    mSubAdjustment.delay(s, float((maxDistance - subwoofers[s].radius) /
+                                  speedOfSound * sampleRate));
+  }
+}
+
+void BassManagement::crossoverFrequency(double freq) {
+  mMainFilters.freq(freq);
+  mSubFilters.freq(freq);
+}
+
+void BassManagement::sendGain(int main, float gain) {
+  if (main < 0 || main >= int(mSendGains.size())) {
+    std::cerr << "ERROR: Invalid main speaker index " << main << std::endl;
+    return;
+  }
+  mSendGains[main] = gain;
+  updateSends();
+}
+
+void BassManagement::subwooferGain(int sub, float gain) {
+  if (sub < 0 || sub >= int(mSubGains.size())) {
+    std::cerr << "ERROR: Invalid subwoofer index " << sub << std::endl;
+    return;
+  }
+  mSubGains[sub] = gain;
+  mSubAdjustment.gains(mSubGains);
+}
+
+void BassManagement::subwooferDelay(int sub, float samples) {
+  if (sub < 0 || sub >= int(mSubGains.size())) {
+    std::cerr << "ERROR: Invalid subwoofer index " << sub << std::endl;
+    return;
+  }
+  mSubAdjustment.delay(sub, samples);
+}
+
+void BassManagement::reset() {
+  mMainFilters.clear();
+  mSubFilters.clear();
+  mSubAdjustment.reset();
+}
+
+void BassManagement::updateSends() {
+  const size_t numMains = mMains.size();
+  const size_t numSubs = mSubwoofers.size();
+  mSends.assign(numSubs * numMains, 0.0f);
+  if (numSubs == 0) {
+    return;
+  }
+  for (size_t m = 0; m < numMains; m++) {
+    if (mRouting == ALL_SUBWOOFERS) {
+      // Subwoofers add coherently at low frequencies
+      for (size_t s = 0; s < numSubs; s++) {
+        mSends[s * numMains + m] = mSendGains[m] / numSubs;
+      }
+    } else {
+      Vec3d dir = mMains[m].vec().normalized();
+      size_t nearest = 0;
+      double bestDot = -2;
+      for (size_t s = 0; s < numSubs; s++) {
+        double dot = dir.dot(mSubwoofers[s].vec().normalized());
+        if (dot > bestDot) {
+          bestDot = dot;
+          nearest = s;
+        }
+      }
+      mSends[nearest * numMains + m] = mSendGains[m];
+    }
+  }
+}
+
+void BassManagement::onAudioCB(AudioIOData &io) {
+  const unsigned int numChannels = io.channelsOut();
+  for (auto *layout : {&mMains, &mSubwoofers}) {
+    for (auto &speaker : *layout) {
+      if (speaker.deviceChannel >= numChannels) {
+        if (!mWarned) {
+          std::cerr << "ERROR: BassManagement channel "
+                    << speaker.deviceChannel << " not available" << std::endl;
+          mWarned = true;
+        }
+        return;
+      }
+    }
+  }
+  const size_t numMains = mMains.size();
+  const int numFrames = io.framesPerBuffer();
+  for (int offset = 0; offset < numFrames; offset += mFramesPerBuffer) {
+    const int n = std::min(mFramesPerBuffer, numFrames - offset);
+    for (size_t m = 0; m < numMains; m++) {
+      mMainChannels[m] = io.outBuffer(mMains[m].deviceChannel) + offset;
+    }
+    // Mix down full range signals, then split the bands
+    for (size_t s = 0; s < mSubwoofers.size(); s++) {
+      float *mix = mMixChannels[s];
+      std::fill(mix, mix + n, 0.0f);
+      const float *sends = mSends.data() + s * numMains;
+      for (size_t m = 0; m < numMains; m++) {
+        const float gain = sends[m];
+        if (gain == 0.0f) {
+          continue;
+        }
+        const float *in = mMainChannels[m];
+        for (int i = 0; i < n; i++) {
+          mix[i] += gain * in[i];
+        }
+      }
+    }
+    mMainFilters.process(mMainChannels.data(), nullptr, mMainChannels.data(),
+                         n);
+    mSubFilters.process(mMixChannels.data(), mMixChannels.data(), nullptr, n);
+    for (size_t s = 0; s < mSubwoofers.size(); s++) {
+      float *out = io.outBuffer(mSubwoofers[s].deviceChannel) + offset;
+      const float *mix = mMixChannels[s];
+      for (int i = 0; i < n; i++) {
+        out[i] += mix[i];
+      }
+    }
+  }
+  mSubAdjustment.processDelays(io);
+}
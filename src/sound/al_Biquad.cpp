@@ -6,8 +6,11 @@
 //
 //
 #include "al/sound/al_Biquad.hpp"
+#include "al/io/al_AudioIOData.hpp"
 #include "al/math/al_Constants.hpp"
+#include <algorithm>
 #include <cmath>
+#include <iostream>
 #include <stdlib.h>
 
 using namespace al;
@@ -22,25 +25,17 @@ BiQuad::BiQuad(BIQUADTYPE _type, double _sampleRate)
 
 BiQuad::~BiQuad() {}
 
-void BiQuad::set(double freq, double bandwidth, double dbGain) {
-  // TODO all the way to fs/2, range
-  if (freq > 20000)
-    freq = 20000;
-  if (freq <= 20)
-    freq = 20;
-
-  double A, omega, sn, cs, alpha, beta;
+static BiQuadCoefficients designCoefficients(BIQUADTYPE type, double omega,
+                                             double alpha, double dbGain) {
+  double A, sn, cs, beta;
   double a0, a1, a2, b0, b1, b2;
 
-  // setup variables
   A = pow(10, dbGain / 40);
-  omega = 2 * M_PI * freq / (1 * mSampleRate); // 1X or 2X oversampled
   sn = sin(omega);
   cs = cos(omega);
-  alpha = sn * sinh(M_LN2 / 2 * bandwidth * omega / sn);
   beta = sqrt(A + A);
 
-  switch (mType) {
+  switch (type) {
   case BIQUAD_LPF:
     b0 = (1 - cs) / 2;
     b1 = 1 - cs;
@@ -98,14 +93,55 @@ void BiQuad::set(double freq, double bandwidth, double dbGain) {
     a2 = (A + 1) - (A - 1) * cs - beta * sn;
     break;
   default:
-    return;
+    return BiQuadCoefficients();
   }
 
-  mBD.a0 = b0 / a0;
-  mBD.a1 = b1 / a0;
-  mBD.a2 = b2 / a0;
-  mBD.a3 = a1 / a0;
-  mBD.a4 = a2 / a0;
+  BiQuadCoefficients c;
+  c.b0 = b0 / a0;
+  c.b1 = b1 / a0;
+  c.b2 = b2 / a0;
+  c.a1 = a1 / a0;
+  c.a2 = a2 / a0;
+  return c;
+}
+
+BiQuadCoefficients BiQuadCoefficients::design(BIQUADTYPE type, double freq,
+                                              double sampleRate,
+                                              double bandwidth,
+                                              double dbGain) {
+  // TODO all the way to fs/2, range
+  if (freq > 20000)
+    freq = 20000;
+  if (freq <= 20)
+    freq = 20;
+
+  double omega = 2 * M_PI * freq / (1 * sampleRate); // 1X or 2X oversampled
+  double sn = sin(omega);
+  double alpha = sn * sinh(M_LN2 / 2 * bandwidth * omega / sn);
+  return designCoefficients(type, omega, alpha, dbGain);
+}
+
+BiQuadCoefficients BiQuadCoefficients::designQ(BIQUADTYPE type, double freq,
+                                               double sampleRate, double q,
+                                               double dbGain) {
+  if (freq > 0.49 * sampleRate)
+    freq = 0.49 * sampleRate;
+  if (freq < 1)
+    freq = 1;
+
+  double omega = 2 * M_PI * freq / sampleRate;
+  double alpha = sin(omega) / (2 * q);
+  return designCoefficients(type, omega, alpha, dbGain);
+}
+
+void BiQuad::set(double freq, double bandwidth, double dbGain) {
+  BiQuadCoefficients c =
+      BiQuadCoefficients::design(mType, freq, mSampleRate, bandwidth, dbGain);
+  mBD.a0 = c.b0;
+  mBD.a1 = c.b1;
+  mBD.a2 = c.b2;
+  mBD.a3 = c.a1;
+  mBD.a4 = c.a2;
 }
 
 void BiQuad::processBuffer(float *buffer, int count) {
@@ -188,3 +224,125 @@ void BiQuadNX::enable(bool on) {
   for (int i = 0; i < numFilters; i++)
     mFilters[i].enable(on);
 }
+
+////////////////////////////////////////////////////////////////////////////
+
+BiQuadBank::BiQuadBank(int numChannels, int numSections, double sampleRate)
+    : mSampleRate(sampleRate) {
+  mScratch.assign(kBlock * kLanes, 0.0f);
+  resize(numChannels, numSections);
+}
+
+void BiQuadBank::resize(int numChannels, int numSections) {
+  mNumChannels = std::max(numChannels, 0);
+  mNumSections = std::max(numSections, 1);
+  const int numGroups = (mNumChannels + kLanes - 1) / kLanes;
+  // Lanes past the last channel keep zero coefficients and output silence
+  mCoefs.assign(numGroups * mNumSections * 5 * kLanes, 0.0f);
+  mState.assign(numGroups * mNumSections * 2 * kLanes, 0.0f);
+  for (int section = 0; section < mNumSections; section++) {
+    coefficients(-1, section, BiQuadCoefficients());
+  }
+}
+
+void BiQuadBank::set(int channel, int section, BIQUADTYPE type, double freq,
+                     double bandwidth, double dbGain) {
+  coefficients(channel, section,
+               BiQuadCoefficients::design(type, freq, mSampleRate, bandwidth,
+                                          dbGain));
+}
+
+void BiQuadBank::setQ(int channel, int section, BIQUADTYPE type, double freq,
+                      double q, double dbGain) {
+  coefficients(channel, section,
+               BiQuadCoefficients::designQ(type, freq, mSampleRate, q, dbGain));
+}
+
+void BiQuadBank::coefficients(int channel, int section,
+                              const BiQuadCoefficients &c) {
+  if (channel >= mNumChannels || section < 0 || section >= mNumSections) {
+    std::cerr << "ERROR: BiQuadBank channel " << channel << " section "
+              << section << " out of range" << std::endl;
+    return;
+  }
+  int first = channel < 0 ? 0 : channel;
+  int last = channel < 0 ? mNumChannels : channel + 1;
+  for (int ch = first; ch < last; ch++) {
+    float *coefs = sectionCoefs(ch / kLanes, section);
+    int lane = ch % kLanes;
+    coefs[0 * kLanes + lane] = float(c.b0);
+    coefs[1 * kLanes + lane] = float(c.b1);
+    coefs[2 * kLanes + lane] = float(c.b2);
+    coefs[3 * kLanes + lane] = float(c.a1);
+    coefs[4 * kLanes + lane] = float(c.a2);
+  }
+}
+
+void BiQuadBank::clear() { std::fill(mState.begin(), mState.end(), 0.0f); }
+
+void BiQuadBank::process(const float *const *in, float *const *out,
+                         int numFrames) {
+  const int numGroups = (mNumChannels + kLanes - 1) / kLanes;
+  float *scratch = mScratch.data();
+  for (int group = 0; group < numGroups; group++) {
+    const int firstChannel = group * kLanes;
+    const int lanes = std::min(kLanes, mNumChannels - firstChannel);
+    for (int offset = 0; offset < numFrames; offset += kBlock) {
+      const int n = std::min(kBlock, numFrames - offset);
+      // Interleave the channels of this group
+      for (int l = 0; l < lanes; l++) {
+        const float *src = in[firstChannel + l] + offset;
+        for (int i = 0; i < n; i++) {
+          scratch[i * kLanes + l] = src[i];
+        }
+      }
+
+      for (int section = 0; section < mNumSections; section++) {
+        const float *coefs = sectionCoefs(group, section);
+        const float *b0 = coefs, *b1 = coefs + kLanes, *b2 = coefs + 2 * kLanes;
+        const float *a1 = coefs + 3 * kLanes, *a2 = coefs + 4 * kLanes;
+        float *state =
+            mState.data() + (group * mNumSections + section) * 2 * kLanes;
+        float s1[kLanes], s2[kLanes];
+        for (int l = 0; l < kLanes; l++) {
+          s1[l] = state[l];
+          s2[l] = state[kLanes + l];
+        }
+        // Transposed direct form II, one lane per channel
+        for (int i = 0; i < n; i++) {
+          float *x = scratch + i * kLanes;
+          for (int l = 0; l < kLanes; l++) {
+            float y = b0[l] * x[l] + s1[l];
+            s1[l] = b1[l] * x[l] - a1[l] * y + s2[l];
+            s2[l] = b2[l] * x[l] - a2[l] * y;
+            x[l] = y;
+          }
+        }
+        for (int l = 0; l < kLanes; l++) {
+          state[l] = s1[l];
+          state[kLanes + l] = s2[l];
+        }
+      }
+
+      for (int l = 0; l < lanes; l++) {
+        float *dst = out[firstChannel + l] + offset;
+        for (int i = 0; i < n; i++) {
+          dst[i] = scratch[i * kLanes + l];
+        }
+      }
+    }
+  }
+}
+
+void BiQuadBank::process(AudioIOData &io, int firstChannel) {
+  if (firstChannel + mNumChannels > int(io.channelsOut())) {
+    std::cerr << "ERROR: BiQuadBank needs " << firstChannel + mNumChannels
+              << " output channels" << std::endl;
+    return;
+  }
+  mChannels.resize(mNumChannels);
+  for (int c = 0; c < mNumChannels; c++) {
+    mChannels[c] = io.outBuffer(firstChannel + c);
+  }
+  process(mChannels.data(), mChannels.data(), io.framesPerBuffer());
+}
@@ -0,0 +1,462 @@
+#include "al/sound/al_Convolver.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "al/math/al_FFT.hpp"
+#include "al/sound/al_SoundFile.hpp"
+
+using namespace al;
+
+// Uniformly partitioned overlap-save convolution of a range of the impulse
+// responses, with a frequency domain delay line per input
+struct Convolver::Segment {
+  int size{0};
+  int numPartitions{0};
+  int bins{0};
+  RFFT fft;
+  std::vector<int> routeInput;
+  std::vector<int> routeOutput;
+  std::vector<int> routePartitions;  // partitions with nonzero response
+  std::vector<std::vector<float>> filterRe;  // per route, partition spectra
+  std::vector<std::vector<float>> filterIm;
+  std::vector<std::vector<float>> delayRe;  // per input, partition spectra
+  std::vector<std::vector<float>> delayIm;
+  std::vector<std::vector<float>> history;  // per input, last two blocks
+  std::vector<std::vector<float>> accRe;    // per output
+  std::vector<std::vector<float>> accIm;
+  std::vector<float> timeBuffer;
+  int delayPos{0};
+
+  void setup(const std::vector<std::vector<float>> &irs, int start, int end,
+             int partitionSize, const std::vector<int> &inputs,
+             const std::vector<int> &outputs, int numInputs,
+             int numOutputs) {
+    size = partitionSize;
+    numPartitions = (end - start + size - 1) / size;
+    bins = size + 1;
+    fft.resize(2 * size);
+    routeInput = inputs;
+    routeOutput = outputs;
+    timeBuffer.assign(2 * size, 0.0f);
+    routePartitions.assign(irs.size(), 0);
+    filterRe.resize(irs.size());
+    filterIm.resize(irs.size());
+    for (size_t r = 0; r < irs.size(); r++) {
+      filterRe[r].assign(numPartitions * bins, 0.0f);
+      filterIm[r].assign(numPartitions * bins, 0.0f);
+      for (int p = 0; p < numPartitions; p++) {
+        int first = start + p * size;
+        int last = std::min(std::min(first + size, end), int(irs[r].size()));
+        if (last <= first) {
+          break;
+        }
+        std::fill(timeBuffer.begin(), timeBuffer.end(), 0.0f);
+        std::copy(irs[r].begin() + first, irs[r].begin() + last,
+                  timeBuffer.begin());
+        fft.forward(timeBuffer.data(), filterRe[r].data() + p * bins,
+                    filterIm[r].data() + p * bins);
+        routePartitions[r] = p + 1;
+      }
+    }
+    delayRe.assign(numInputs, std::vector<float>(numPartitions * bins));
+    delayIm.assign(numInputs, std::vector<float>(numPartitions * bins));
+    history.assign(numInputs, std::vector<float>(2 * size));
+    accRe.assign(numOutputs, std::vector<float>(bins));
+    accIm.assign(numOutputs, std::vector<float>(bins));
+    reset();
+  }
+
+  void reset() {
+    for (auto &d : delayRe) {
+      std::fill(d.begin(), d.end(), 0.0f);
+    }
+    for (auto &d : delayIm) {
+      std::fill(d.begin(), d.end(), 0.0f);
+    }
+    for (auto &h : history) {
+      std::fill(h.begin(), h.end(), 0.0f);
+    }
+    delayPos = 0;
+  }
+
+  // Consumes size samples of each input and overwrites size samples of each
+  // output
+  void process(const float *const *inputs, float *const *outputs) {
+    delayPos = delayPos + 1 == numPartitions ? 0 : delayPos + 1;
+    for (size_t i = 0; i < history.size(); i++) {
+      float *h = history[i].data();
+      std::memcpy(h, h + size, size * sizeof(float));
+      std::memcpy(h + size, inputs[i], size * sizeof(float));
+      fft.forward(h, delayRe[i].data() + delayPos * bins,
+                  delayIm[i].data() + delayPos * bins);
+    }
+    for (size_t o = 0; o < accRe.size(); o++) {
+      std::fill(accRe[o].begin(), accRe[o].end(), 0.0f);
+      std::fill(accIm[o].begin(), accIm[o].end(), 0.0f);
+    }
+    // Spectra of routes sharing an output are summed before the inverse
+    for (size_t r = 0; r < routeInput.size(); r++) {
+      float *ar = accRe[routeOutput[r]].data();
+      float *ai = accIm[routeOutput[r]].data();
+      for (int p = 0; p < routePartitions[r]; p++) {
+        int slot = delayPos - p < 0 ? delayPos - p + numPartitions
+                                    : delayPos - p;
+        const float *xr = delayRe[routeInput[r]].data() + slot * bins;
+        const float *xi = delayIm[routeInput[r]].data() + slot * bins;
+        const float *hr = filterRe[r].data() + p * bins;
+        const float *hi = filterIm[r].data() + p * bins;
+        for (int k = 0; k < bins; k++) {
+          ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+          ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+        }
+      }
+    }
+    for (size_t o = 0; o < accRe.size(); o++) {
+      fft.inverse(accRe[o].data(), accIm[o].data(), timeBuffer.data());
+      std::memcpy(outputs[o], timeBuffer.data() + size, size * sizeof(float));
+    }
+  }
+};
+
+// One partition size. The head level is processed in the audio callback,
+// tail levels collect a partition of input and convolve it while the
+// previous result is played back
+struct Convolver::Level {
+  Segment segment;
+  bool head{false};
+  int pos{0};
+  std::vector<std::vector<float>> collected;  // per input
+  std::vector<std::vector<float>> playing;    // per output
+  std::vector<std::vector<float>> jobInput;
+  std::vector<std::vector<float>> jobOutput;
+  std::vector<const float *> jobInputPtrs;
+  std::vector<float *> jobOutputPtrs;
+
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool busy{false};
+  bool running{false};
+
+  ~Level() { stopThread(); }
+
+  void allocate() {
+    const int size = segment.size;
+    const size_t numInputs = segment.history.size();
+    const size_t numOutputs = segment.accRe.size();
+    collected.assign(numInputs, std::vector<float>(size));
+    jobInput.assign(numInputs, std::vector<float>(size));
+    playing.assign(numOutputs, std::vector<float>(size));
+    jobOutput.assign(numOutputs, std::vector<float>(size));
+    jobInputPtrs.resize(numInputs);
+    jobOutputPtrs.resize(numOutputs);
+  }
+
+  void reset() {
+    wait();
+    segment.reset();
+    for (auto *buffers : {&collected, &playing, &jobInput, &jobOutput}) {
+      for (auto &b : *buffers) {
+        std::fill(b.begin(), b.end(), 0.0f);
+      }
+    }
+    pos = 0;
+  }
+
+  void runJob() {
+    for (size_t i = 0; i < jobInput.size(); i++) {
+      jobInputPtrs[i] = jobInput[i].data();
+    }
+    for (size_t o = 0; o < jobOutput.size(); o++) {
+      jobOutputPtrs[o] = jobOutput[o].data();
+    }
+    segment.process(jobInputPtrs.data(), jobOutputPtrs.data());
+  }
+
+  void wait() {
+    if (running) {
+      std::unique_lock<std::mutex> lk(mutex);
+      cv.wait(lk, [this]() { return !busy; });
+    }
+  }
+
+  // Called when a full partition has been collected
+  void startJob() {
+    wait();
+    std::swap(playing, jobOutput);
+    std::swap(collected, jobInput);
+    if (running) {
+      {
+        std::lock_guard<std::mutex> lk(mutex);
+        busy = true;
+      }
+      cv.notify_all();
+    } else {
+      runJob();
+    }
+  }
+
+  void startThread() {
+    if (running) {
+      return;
+    }
+    running = true;
+    thread = std::thread([this]() {
+      std::unique_lock<std::mutex> lk(mutex);
+      while (true) {
+        cv.wait(lk, [this]() { return busy || !running; });
+        if (!running) {
+          break;
+        }
+        lk.unlock();
+        runJob();
+        lk.lock();
+        busy = false;
+        cv.notify_all();
+      }
+    });
+  }
+
+  void stopThread() {
+    if (!running) {
+      return;
+    }
+    wait();
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      running = false;
+    }
+    cv.notify_all();
+    thread.join();
+  }
+};
+
+Convolver::Convolver() {}
+
+Convolver::~Convolver() { clearLevels(); }
+
+void Convolver::clearLevels() {
+  for (auto &level : mLevels) {
+    level->stopThread();
+  }
+  mLevels.clear();
+}
+
+bool Convolver::configure(const std::vector<std::vector<float>> &irs,
+                          const std::vector<int> &inputChannels,
+                          const std::vector<int> &outputChannels,
+                          int blockSize, int maxPartitionSize) {
+  if (irs.size() != inputChannels.size() ||
+      irs.size() != outputChannels.size() || irs.size() == 0) {
+    std::cerr << "ERROR: Convolver needs one input and output channel per "
+                 "impulse response"
+              << std::endl;
+    return false;
+  }
+  if (!RFFT::isPowerOfTwo(blockSize)) {
+    std::cerr << "ERROR: Convolver block size must be a power of two: "
+              << blockSize << std::endl;
+    return false;
+  }
+  for (size_t r = 0; r < irs.size(); r++) {
+    if (inputChannels[r] < 0 || outputChannels[r] < 0) {
+      std::cerr << "ERROR: Invalid Convolver channel" << std::endl;
+      return false;
+    }
+  }
+  clearLevels();
+  mInputChannels = inputChannels;
+  mOutputChannels = outputChannels;
+  mBlockSize = blockSize;
+  mSizeWarning = false;
+
+  mInputs.clear();
+  mOutputs.clear();
+  std::vector<int> routeInputs, routeOutputs;
+  for (size_t r = 0; r < irs.size(); r++) {
+    auto in = std::find(mInputs.begin(), mInputs.end(), inputChannels[r]);
+    routeInputs.push_back(int(in - mInputs.begin()));
+    if (in == mInputs.end()) {
+      mInputs.push_back(inputChannels[r]);
+    }
+    auto out = std::find(mOutputs.begin(), mOutputs.end(), outputChannels[r]);
+    routeOutputs.push_back(int(out - mOutputs.begin()));
+    if (out == mOutputs.end()) {
+      mOutputs.push_back(outputChannels[r]);
+    }
+  }
+
+  int length = 1;
+  for (auto &ir : irs) {
+    length = std::max(length, int(ir.size()));
+  }
+  // Each tail level starts at twice its partition size
+  std::vector<int> sizes{blockSize};
+  while (sizes.back() * 4 <= maxPartitionSize &&
+         sizes.back() * 8 < length) {
+    sizes.push_back(sizes.back() * 4);
+  }
+  for (size_t l = 0; l < sizes.size(); l++) {
+    int start = l == 0 ? 0 : 2 * sizes[l];
+    int end = l + 1 < sizes.size() ? 2 * sizes[l + 1] : length;
+    std::unique_ptr<Level> level(new Level);
+    level->head = l == 0;
+    level->segment.setup(irs, start, std::max(end, start + 1), sizes[l],
+                         routeInputs, routeOutputs, int(mInputs.size()),
+                         int(mOutputs.size()));
+    level->allocate();
+    if (!level->head && mBackground) {
+      level->startThread();
+    }
+    mLevels.push_back(std::move(level));
+  }
+
+  mInputCopy.assign(mInputs.size(), std::vector<float>(blockSize));
+  mBlockInputs.resize(mInputs.size());
+  mBlockOutputs.resize(mOutputs.size());
+  return true;
+}
+
+bool Convolver::configure(const std::vector<std::vector<float>> &irs,
+                          int blockSize, int maxPartitionSize) {
+  std::vector<int> channels(irs.size());
+  for (size_t i = 0; i < irs.size(); i++) {
+    channels[i] = int(i);
+  }
+  return configure(irs, channels, channels, blockSize, maxPartitionSize);
+}
+
+bool Convolver::load(const char *path, const std::vector<int> &inputChannels,
+                     const std::vector<int> &outputChannels, int blockSize,
+                     int maxPartitionSize) {
+  SoundFile soundFile;
+  if (!soundFile.open(path)) {
+    std::cerr << "ERROR: Could not load impulse response: " << path
+              << std::endl;
+    return false;
+  }
+  const size_t numRoutes = inputChannels.size();
+  if (soundFile.channels != 1 && size_t(soundFile.channels) < numRoutes) {
+    std::cerr << "ERROR: " << path << " has " << soundFile.channels
+              << " channels for " << numRoutes << " routes" << std::endl;
+    return false;
+  }
+  std::vector<std::vector<float>> irs(numRoutes);
+  for (size_t r = 0; r < numRoutes; r++) {
+    int channel = soundFile.channels == 1 ? 0 : int(r);
+    irs[r].resize(soundFile.frameCount);
+    for (long long i = 0; i < soundFile.frameCount; i++) {
+      irs[r][i] = soundFile.data[i * soundFile.channels + channel];
+    }
+  }
+  return configure(irs, inputChannels, outputChannels, blockSize,
+                   maxPartitionSize);
+}
+
+void Convolver::backgroundThreads(bool on) {
+  mBackground = on;
+  for (auto &level : mLevels) {
+    if (level->head) {
+      continue;
+    }
+    if (on) {
+      level->startThread();
+    } else {
+      level->stopThread();
+    }
+  }
+}
+
+void Convolver::reset() {
+  for (auto &level : mLevels) {
+    level->reset();
+  }
+}
+
+std::vector<int> Convolver::partitionSizes() const {
+  std::vector<int> sizes;
+  for (auto &level : mLevels) {
+    sizes.push_back(level->segment.size);
+  }
+  return sizes;
+}
+
+void Convolver::processBlock(const float *const *inputs,
+                             float *const *outputs) {
+  for (auto &level : mLevels) {
+    if (level->head) {
+      level->segment.process(inputs, outputs);
+      continue;
+    }
+    const int size = level->segment.size;
+    for (size_t i = 0; i < mInputs.size(); i++) {
+      std::memcpy(level->collected[i].data() + level->pos, inputs[i],
+                  mBlockSize * sizeof(float));
+    }
+    for (size_t o = 0; o < mOutputs.size(); o++) {
+      const float *tail = level->playing[o].data() + level->pos;
+      float *out = outputs[o];
+      for (int i = 0; i < mBlockSize; i++) {
+        out[i] += tail[i];
+      }
+    }
+    level->pos += mBlockSize;
+    if (level->pos == size) {
+      level->pos = 0;
+      level->startJob();
+    }
+  }
+}
+
+void Convolver::process(const float *const *inputs, float *const *outputs,
+                        int numFrames) {
+  if (mLevels.size() == 0) {
+    return;
+  }
+  if (numFrames % mBlockSize != 0) {
+    if (!mSizeWarning) {
+      std::cerr << "ERROR: Convolver needs a multiple of " << mBlockSize
+                << " frames, got " << numFrames << std::endl;
+      mSizeWarning = true;
+    }
+    return;
+  }
+  for (int offset = 0; offset < numFrames; offset += mBlockSize) {
+    // Inputs are copied so that outputs can overwrite them
+    for (size_t i = 0; i < mInputs.size(); i++) {
+      std::memcpy(mInputCopy[i].data(), inputs[mInputs[i]] + offset,
+                  mBlockSize * sizeof(float));
+      mBlockInputs[i] = mInputCopy[i].data();
+    }
+    for (size_t o = 0; o < mOutputs.size(); o++) {
+      mBlockOutputs[o] = outputs[mOutputs[o]] + offset;
+    }
+    processBlock(mBlockInputs.data(), mBlockOutputs.data());
+  }
+}
+
+void Convolver::onAudioCB(AudioIOData &io) {
+  const int numChannels = int(io.channelsOut());
+  for (int c : mInputs) {
+    if (c >= numChannels) {
+      return;
+    }
+  }
+  for (int c : mOutputs) {
+    if (c >= numChannels) {
+      return;
+    }
+  }
+  if (int(mChannels.size()) < numChannels) {
+    mChannels.resize(numChannels);
+  }
+  for (int c = 0; c < numChannels; c++) {
+    mChannels[c] = io.outBuffer(c);
+  }
+  process(mChannels.data(), mChannels.data(), int(io.framesPerBuffer()));
+}
@@ -0,0 +1,65 @@
+#include "al/sound/al_Crossover.hpp"
+
+#include <cassert>
+
+using namespace al;
+
+// Whether out is the input buffers, channel for channel
+static bool isInPlace(const float *const *in, float *const *out,
+                      int numChannels) {
+  if (!out || numChannels == 0) {
+    return false;
+  }
+  const bool inPlace = out[0] == in[0];
+#ifndef NDEBUG
+  for (int c = 0; c < numChannels; c++) {
+    for (int k = 0; k < numChannels; k++) {
+      assert((out[c] != in[k] || (inPlace && c == k)) &&
+             "CrossoverBank outputs must alias all inputs or none");
+    }
+  }
+#endif
+  return inPlace;
+}
+
+void CrossoverBank::configure(int numChannels, double freq,
+                              double sampleRate) {
+  mSampleRate = sampleRate;
+  mLow.setSampleRate(sampleRate);
+  mHigh.setSampleRate(sampleRate);
+  mLow.resize(numChannels, 2);
+  mHigh.resize(numChannels, 2);
+  this->freq(freq);
+}
+
+void CrossoverBank::freq(double f) {
+  mFreq = f;
+  if (numChannels() == 0) {
+    return;
+  }
+  const double butterworthQ = 0.7071067811865476;
+  for (int section = 0; section < 2; section++) {
+    mLow.setQ(-1, section, BIQUAD_LPF, f, butterworthQ);
+    mHigh.setQ(-1, section, BIQUAD_HPF, f, butterworthQ);
+  }
+}
+
+void CrossoverBank::process(const float *const *in, float *const *lo,
+                            float *const *hi, int numFrames) {
+  // Filter the band that does not overwrite the input first
+  bool highInPlace = isInPlace(in, hi, numChannels());
+  assert(!(highInPlace && isInPlace(in, lo, numChannels())));
+  if (highInPlace) {
+    if (lo) {
+      mLow.process(in, lo, numFrames);
+    }
+    mHigh.process(in, hi, numFrames);
+  } else {
+    if (hi) {
+      mHigh.process(in, hi, numFrames);
+    }
+    if (lo) {
+      mLow.process(in, lo, numFrames);
+    }
+  }
+}
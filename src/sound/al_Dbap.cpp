@@ -1,69 +1,153 @@
 #include "al/sound/al_Dbap.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+#include "al/math/al_Functions.hpp"
+
 namespace al {
 
-Dbap::Dbap(const Speakers &sl, float focus)
-    : Spatializer(sl), mNumSpeakers(0), mFocus(focus) {
+Dbap::Dbap(const Speakers &sl, float focus) : Spatializer(sl), mFocus(focus) {
+  compile();
+}
+
+void Dbap::compile() {
   mNumSpeakers = mSpeakers.size();
-  std::cout << "DBAP Compiled with " << mNumSpeakers << " speakers"
-            << std::endl;
 
+  mSpeakerX.resize(mNumSpeakers);
+  mSpeakerY.resize(mNumSpeakers);
+  mSpeakerZ.resize(mNumSpeakers);
+  mDeviceChannels.resize(mNumSpeakers);
   for (unsigned int i = 0; i < mNumSpeakers; i++) {
-    mSpeakerVecs[i] = mSpeakers[i].vec();
+    Vec3d vec = mSpeakers[i].vec();
+    mSpeakerX[i] = float(vec.x);
+    mSpeakerY[i] = float(vec.y);
+    mSpeakerZ[i] = float(vec.z);
     mDeviceChannels[i] = mSpeakers[i].deviceChannel;
   }
+
+  mSlots.configure(mMaxCachedSources);
+  mSlotPositions.resize(mMaxCachedSources);
+  mSlotFocus.resize(mMaxCachedSources);
+  mSlotGains.resize(mMaxCachedSources * mNumSpeakers);
+
+  // Scratch for a full batch, so renderBuffers() never allocates
+  mStartGains.resize(mMaxBatchSize * mNumSpeakers);
+  mEndGains.resize(mMaxBatchSize * mNumSpeakers);
+  mRamps.resize(mMaxBatchSize);
 }
 
-void Dbap::renderSample(AudioIOData &io, const Vec3f &pos, const float &sample,
-                        const unsigned int &frameIndex) {
-  //  Vec3d relpos = listeningPose.vec();
+void Dbap::prepare(AudioIOData &io) { mSlots.nextBlock(); }
 
-  //  // Rotate vector according to listener-rotation
-  //  Quatd srcRot = listeningPose.quat();
-  //  relpos = srcRot.rotate(relpos);
-  //  relpos = Vec3d(relpos.x, relpos.z, relpos.y);
+void Dbap::computeGains(const Vec3f &relpos, float *gains) {
+  const float *sx = mSpeakerX.data();
+  const float *sy = mSpeakerY.data();
+  const float *sz = mSpeakerZ.data();
+  const float focus = mFocus;
+  for (size_t k = 0; k < mNumSpeakers; ++k) {
+    float dx = relpos.x - sx[k];
+    float dy = relpos.y - sy[k];
+    float dz = relpos.z - sz[k];
+    float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+    // (1 / (1 + dist))^focus
+    gains[k] = exp2Fast(-focus * log2Fast(1.0f + dist));
+  }
+}
 
-  Vec3d relpos = Vec3d(pos.x, -pos.z, pos.y);
-  for (unsigned int i = 0; i < mNumSpeakers; ++i) {
-    float gain = 1.f;
-    Vec3d vec = relpos - mSpeakerVecs[i];
-    double dist = vec.mag();
-    gain = 1.f / (1.f + float(dist));
-    gain = powf(gain, mFocus);
+bool Dbap::updateSource(const Vec3f &pos, uint64_t id, float *startGains,
+                        float *endGains) {
+  Vec3f relpos(pos.x, -pos.z, pos.y);
+  const size_t gainsSize = mNumSpeakers * sizeof(float);
+  bool isNew;
+  int slot = mSlots.find(id, isNew);
+  if (slot < 0) {
+    computeGains(relpos, endGains);
+    memcpy(startGains, endGains, gainsSize);
+    return false;
+  }
 
-    io.out(mDeviceChannels[i], frameIndex) += gain * sample;
+  float *slotGains = mSlotGains.data() + slot * mNumSpeakers;
+  if (!isNew && mSlotFocus[slot] == mFocus &&
+      (relpos - mSlotPositions[slot]).mag() <= mPositionTolerance) {
+    memcpy(startGains, slotGains, gainsSize);
+    memcpy(endGains, slotGains, gainsSize);
+    return false;
+  }
+
+  computeGains(relpos, endGains);
+  bool ramp = !isNew && mGainRamp;
+  memcpy(startGains, ramp ? slotGains : endGains, gainsSize);
+  memcpy(slotGains, endGains, gainsSize);
+  mSlotPositions[slot] = relpos;
+  mSlotFocus[slot] = mFocus;
+  return ramp;
+}
+
+void Dbap::renderSample(AudioIOData &io, const Vec3f &pos, const float &sample,
+                        const unsigned int &frameIndex) {
+  Vec3f relpos(pos.x, -pos.z, pos.y);
+  float *gains = mEndGains.data();
+  computeGains(relpos, gains);
+  for (unsigned int i = 0; i < mNumSpeakers; ++i) {
+    io.out(mDeviceChannels[i], frameIndex) += gains[i] * sample;
   }
 }
 
 void Dbap::renderBuffer(AudioIOData &io, const Vec3f &pos, const float *samples,
                         const unsigned int &numFrames) {
-  //  Vec3d relpos = listeningPose.vec();
+  renderBuffers(io, &pos, &samples, 1, numFrames);
+}
 
-  //  // Rotate vector according to listener-rotation
-  //  Quatd srcRot = listeningPose.quat();
-  //  relpos = srcRot.rotate(relpos);
+void Dbap::renderBuffers(AudioIOData &io, const Vec3f *positions,
+                         const float *const *samples,
+                         const unsigned int &numSources,
+                         const unsigned int &numFrames,
+                         const uint64_t *sourceIds) {
+  // Render in passes of at most mMaxBatchSize sources, the size of the
+  // scratch buffers
+  for (unsigned int first = 0; first < numSources; first += mMaxBatchSize) {
+    const unsigned int count = std::min(numSources - first, mMaxBatchSize);
+    renderBatch(io, positions + first, samples + first, count, numFrames,
+                sourceIds ? sourceIds + first : nullptr);
+  }
+}
 
-  // FIXME test DBAP
-  Vec3d relpos = Vec3d(pos.x, -pos.z, pos.y);
+void Dbap::renderBatch(AudioIOData &io, const Vec3f *positions,
+                       const float *const *samples, unsigned int numSources,
+                       unsigned int numFrames, const uint64_t *sourceIds) {
+  // Compute all gains first, then accumulate each output buffer once for all
+  // sources so it stays in cache.
+  for (unsigned int s = 0; s < numSources; ++s) {
+    mRamps[s] = updateSource(positions[s],
+                             sourceIds ? sourceIds[s] : NO_SOURCE_ID,
+                             mStartGains.data() + s * mNumSpeakers,
+                             mEndGains.data() + s * mNumSpeakers);
+  }
 
+  const float frameInc = 1.0f / numFrames;
   for (unsigned int k = 0; k < mNumSpeakers; ++k) {
-    float gain = 1.f;
-
-    Vec3d vec = relpos - mSpeakerVecs[k];
-    double dist = vec.mag();
-    gain = 1.0f / (1.0f + float(dist));
-    gain = powf(gain, mFocus);
-
     float *out = io.outBuffer(mDeviceChannels[k]);
-    for (size_t i = 0; i < numFrames; ++i) {
-      out[i] += gain * samples[i];
+    for (unsigned int s = 0; s < numSources; ++s) {
+      const float *in = samples[s];
+      const float gain = mEndGains[s * mNumSpeakers + k];
+      if (mRamps[s]) {
+        const float startGain = mStartGains[s * mNumSpeakers + k];
+        const float gainInc = (gain - startGain) * frameInc;
+        for (unsigned int i = 0; i < numFrames; ++i) {
+          out[i] += (startGain + gainInc * (i + 1)) * in[i];
+        }
+      } else {
+        for (unsigned int i = 0; i < numFrames; ++i) {
+          out[i] += gain * in[i];
+        }
+      }
     }
   }
 }
 
 void Dbap::print(std::ostream &stream) {
-  stream << "Using DBAP Panning- need to add panner info for print function"
+  stream << "DBAP with " << mNumSpeakers << " speakers. Focus: " << mFocus
          << std::endl;
 }
 
-} // namespace al
+}  // namespace al
@@ -0,0 +1,359 @@
+#include "al/sound/al_DiskRecorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "dr_wav.h"
+
+using namespace al;
+
+namespace {
+
+// Largest data chunk a RIFF header can describe
+const uint64_t kMaxWavDataBytes = 0xFFFFFFFFull - 36;
+
+// Largest buffer SingleRWRingBuffer can round up to
+const size_t kMaxRingBytes = size_t(1) << 31;
+
+int bytesPerSample(DiskRecorder::Encoding encoding) {
+  switch (encoding) {
+    case DiskRecorder::INT16:
+      return 2;
+    case DiskRecorder::INT24:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+// take.wav -> take_2.wav
+std::string partPath(const std::string &path, int part) {
+  if (part == 1) {
+    return path;
+  }
+  size_t dot = path.find_last_of('.');
+  size_t slash = path.find_last_of("/\\");
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return path + "_" + std::to_string(part);
+  }
+  return path.substr(0, dot) + "_" + std::to_string(part) + path.substr(dot);
+}
+
+}  // namespace
+
+// Owned by the writer thread while recording
+struct DiskRecorder::Writer {
+  std::string path;
+  Format format;
+  Encoding encoding;
+  unsigned int sampleRate;
+  unsigned int channels;
+  uint64_t maxFileBytes;  // rounded down to whole frames
+
+  int part{0};
+  uint64_t fileBytes{0};
+  drwav wav;
+  bool wavOpen{false};
+  FILE *raw{nullptr};
+
+  std::vector<float> planar;
+  std::vector<char> encoded;
+
+  size_t frameBytes() const {
+    return size_t(channels) * bytesPerSample(encoding);
+  }
+
+  bool open() {
+    part++;
+    fileBytes = 0;
+    const std::string name = partPath(path, part);
+    if (format == RAW) {
+      raw = fopen(name.c_str(), "wb");
+      if (!raw) {
+        std::cerr << "DiskRecorder: can't open " << name << std::endl;
+        return false;
+      }
+      return true;
+    }
+    drwav_data_format wavFormat;
+    wavFormat.container =
+        format == W64 ? drwav_container_w64 : drwav_container_riff;
+    wavFormat.format =
+        encoding == FLOAT32 ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    wavFormat.channels = channels;
+    wavFormat.sampleRate = sampleRate;
+    wavFormat.bitsPerSample = 8 * bytesPerSample(encoding);
+    wavOpen = drwav_init_file_write(&wav, name.c_str(), &wavFormat);
+    if (!wavOpen) {
+      std::cerr << "DiskRecorder: can't open " << name << std::endl;
+    }
+    return wavOpen;
+  }
+
+  void close() {
+    if (wavOpen) {
+      drwav_uninit(&wav);
+      wavOpen = false;
+    }
+    if (raw) {
+      fclose(raw);
+      raw = nullptr;
+    }
+  }
+
+  // Interleave and convert frames of planar, starting at frame offset
+  void encode(uint32_t totalFrames, uint32_t offset, uint32_t frames) {
+    encoded.resize(size_t(frames) * frameBytes());
+    char *dest = encoded.data();
+    for (uint32_t i = offset; i < offset + frames; i++) {
+      for (unsigned int c = 0; c < channels; c++) {
+        float v = planar[size_t(c) * totalFrames + i];
+        if (encoding == FLOAT32) {
+          std::memcpy(dest, &v, 4);
+          dest += 4;
+          continue;
+        }
+        v = std::max(-1.0f, std::min(1.0f, v));
+        if (encoding == INT16) {
+          int16_t s = int16_t(std::lrint(v * 32767.0f));
+          std::memcpy(dest, &s, 2);
+          dest += 2;
+        } else {
+          int32_t s = int32_t(std::lrint(v * 8388607.0f));
+          dest[0] = char(s & 0xFF);
+          dest[1] = char((s >> 8) & 0xFF);
+          dest[2] = char((s >> 16) & 0xFF);
+          dest += 3;
+        }
+      }
+    }
+  }
+
+  bool writeEncoded(uint32_t frames) {
+    const size_t bytes = size_t(frames) * frameBytes();
+    if (raw) {
+      if (fwrite(encoded.data(), 1, bytes, raw) != bytes) {
+        return false;
+      }
+    } else if (drwav_write_pcm_frames(&wav, frames, encoded.data()) !=
+               frames) {
+      return false;
+    }
+    fileBytes += bytes;
+    return true;
+  }
+
+  // Write frames from planar, splitting files at maxFileBytes
+  bool write(uint32_t frames) {
+    uint32_t done = 0;
+    while (done < frames) {
+      if (maxFileBytes > 0 && fileBytes + frameBytes() > maxFileBytes) {
+        close();
+        if (!open()) {
+          return false;
+        }
+      }
+      uint32_t n = frames - done;
+      if (maxFileBytes > 0) {
+        n = uint32_t(std::min<uint64_t>(
+            n, (maxFileBytes - fileBytes) / frameBytes()));
+      }
+      encode(frames, done, n);
+      if (!writeEncoded(n)) {
+        return false;
+      }
+      done += n;
+    }
+    return true;
+  }
+};
+
+DiskRecorder::DiskRecorder() {}
+
+DiskRecorder::~DiskRecorder() { stop(); }
+
+void DiskRecorder::addChannel(Source source, unsigned int index) {
+  if (mRecording.load()) {
+    std::cerr << "DiskRecorder: can't change channels while recording"
+              << std::endl;
+    return;
+  }
+  mChannels.push_back({source, index});
+}
+
+void DiskRecorder::addChannels(Source source, unsigned int first,
+                               unsigned int count) {
+  for (unsigned int i = 0; i < count; i++) {
+    addChannel(source, first + i);
+  }
+}
+
+void DiskRecorder::clearChannels() {
+  if (mRecording.load()) {
+    std::cerr << "DiskRecorder: can't change channels while recording"
+              << std::endl;
+    return;
+  }
+  mChannels.clear();
+}
+
+bool DiskRecorder::start(const std::string &path, double sampleRate,
+                         Format format, Encoding encoding,
+                         double bufferSeconds) {
+  if (mRecording.load()) {
+    std::cerr << "DiskRecorder: already recording" << std::endl;
+    return false;
+  }
+  if (mChannels.empty() || sampleRate <= 0) {
+    std::cerr << "DiskRecorder: no channels to record" << std::endl;
+    return false;
+  }
+  std::unique_ptr<Writer> writer(new Writer);
+  writer->path = path;
+  writer->format = format;
+  writer->encoding = encoding;
+  writer->sampleRate = (unsigned int)(sampleRate);
+  writer->channels = (unsigned int)(mChannels.size());
+  uint64_t maxBytes = mSplitBytes;
+  if (format == WAV && (maxBytes == 0 || maxBytes > kMaxWavDataBytes)) {
+    maxBytes = kMaxWavDataBytes;
+  }
+  const uint64_t frameBytes = writer->frameBytes();
+  writer->maxFileBytes = maxBytes / frameBytes * frameBytes;
+  if (maxBytes > 0 && writer->maxFileBytes == 0) {
+    writer->maxFileBytes = frameBytes;
+  }
+  if (!writer->open()) {
+    return false;
+  }
+  mWriter = std::move(writer);
+
+  // Room for the audio plus a frame count per buffer of at least 32 frames
+  const double ringFrameBytes = mChannels.size() * sizeof(float);
+  double ringBytes = bufferSeconds * sampleRate * ringFrameBytes *
+                     (1.0 + sizeof(uint32_t) / (32 * ringFrameBytes));
+  ringBytes = std::max(ringBytes, 16 * 4096 * ringFrameBytes);
+  mRing.reset(new SingleRWRingBuffer(
+      std::min(kMaxRingBytes, size_t(ringBytes))));
+  mRingCapacity = mRing->writeSpace();
+  mZeros.assign(4096, 0.0f);
+
+  mFramesWritten = 0;
+  mDroppedFrames = 0;
+  mOverflows = 0;
+  mMaxFill = 0.0f;
+  mFiles = 1;
+  mWriteFailed = false;
+  mStopWriter = false;
+  mThread = std::thread([this]() { writerThread(); });
+  mRecording = true;
+  return true;
+}
+
+void DiskRecorder::stop() {
+  if (!mRecording.load()) {
+    return;
+  }
+  mRecording = false;
+  // A callback that saw mRecording set may still be writing a buffer
+  while (mInCallback.load() > 0) {
+    std::this_thread::yield();
+  }
+  mStopWriter = true;
+  mThread.join();
+  mWriter->close();
+  mWriter.reset();
+  mRing.reset();
+}
+
+void DiskRecorder::onAudioCB(AudioIOData &io) {
+  // Announce the callback before checking mRecording so stop() can wait
+  // for it
+  mInCallback++;
+  if (mRecording.load()) {
+    const uint32_t frames = uint32_t(io.framesPerBuffer());
+    const size_t channelBytes = frames * sizeof(float);
+    const size_t bytes = sizeof(frames) + mChannels.size() * channelBytes;
+    const size_t space = mRing->writeSpace();
+    if (space < bytes) {
+      mDroppedFrames += frames;
+      mOverflows++;
+    } else {
+      mRing->write(reinterpret_cast<const char *>(&frames), sizeof(frames));
+      for (const auto &channel : mChannels) {
+        const float *data = nullptr;
+        switch (channel.source) {
+          case OUTPUT:
+            if (channel.index < io.channelsOut()) {
+              data = io.outBuffer(channel.index);
+            }
+            break;
+          case BUS:
+            if (channel.index < io.channelsBus()) {
+              data = io.busBuffer(channel.index);
+            }
+            break;
+          case INPUT:
+            if (channel.index < io.channelsIn()) {
+              data = io.inBuffer(channel.index);
+            }
+            break;
+        }
+        if (data) {
+          mRing->write(reinterpret_cast<const char *>(data), channelBytes);
+        } else {
+          for (uint32_t i = 0; i < frames; i += uint32_t(mZeros.size())) {
+            const size_t n = std::min<size_t>(mZeros.size(), frames - i);
+            mRing->write(reinterpret_cast<const char *>(mZeros.data()),
+                         n * sizeof(float));
+          }
+        }
+      }
+      const float fill = 1.0f - float(space - bytes) / mRingCapacity;
+      if (fill > mMaxFill.load()) {
+        mMaxFill = fill;
+      }
+    }
+  }
+  mInCallback--;
+}
+
+void DiskRecorder::writerThread() {
+  const size_t channels = mChannels.size();
+  Writer &writer = *mWriter;
+  while (true) {
+    // Everything is in the ring once stopping is seen
+    const bool stopping = mStopWriter.load();
+    uint32_t frames;
+    if (mRing->peek(reinterpret_cast<char *>(&frames), sizeof(frames)) ==
+            sizeof(frames) &&
+        mRing->readSpace() >=
+            sizeof(frames) + channels * frames * sizeof(float)) {
+      mRing->skip(sizeof(frames));
+      writer.planar.resize(channels * frames);
+      mRing->read(reinterpret_cast<char *>(writer.planar.data()),
+                  channels * frames * sizeof(float));
+      if (mWriteFailed.load()) {
+        continue;
+      }
+      if (writer.write(frames)) {
+        mFramesWritten += frames;
+      } else {
+        std::cerr << "DiskRecorder: writing " << writer.path << " failed"
+                  << std::endl;
+        mWriteFailed = true;
+      }
+      mFiles = writer.part;
+      continue;
+    }
+    if (stopping) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+}
@@ -1,8 +1,11 @@
 
 #include "al/sound/al_DownMixer.hpp"
 #include "al/io/al_AudioIOData.hpp"
+#include "al/ui/al_Parameter.hpp"
 
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
 
 using namespace al;
 
@@ -31,13 +34,8 @@ void DownMixer::layoutToStereo(const Speakers &sl, AudioIOData &io) {
       mRoutingMap[spkr.deviceChannel].push_back({rightChannel, r});
     }
   }
-  if (mBusStartNumber == -1) {
-
-    mBusStartNumber = io.channelsBus();
-    io.channelsBus(io.channelsBus() + 2);
-  } else {
-    // TODO check if we have enough buses
-  }
+  compile();
+  allocateBuses(io);
 }
 
 void DownMixer::set5_1toStereo(AudioIOData &io) {
@@ -55,11 +53,73 @@ void DownMixer::set5_1toStereo(AudioIOData &io) {
   mRoutingMap[3] = {{leftChannel, sixDbDown}};
   mRoutingMap[4] = {{rightChannel, sixDbDown}};
   mRoutingMap[5] = {{leftChannel, sixDbDown}, {rightChannel, sixDbDown}};
+  compile();
+  allocateBuses(io);
+}
+
+void DownMixer::setRouting(const RoutingMap &routing, AudioIOData &io) {
+  mRoutingMap = routing;
+  compile();
+  allocateBuses(io);
+}
+
+void DownMixer::setIdentity(unsigned numChannels, AudioIOData &io) {
+  mRoutingMap.clear();
+  for (uint32_t i = 0; i < numChannels; i++) {
+    mRoutingMap[i] = {{i, 1.0f}};
+  }
+  compile();
+  allocateBuses(io);
+}
+
+void DownMixer::compile() {
+  // Transpose the per input map into rows of (input, gain) per output.
+  // Inputs are visited in ascending order so every row reads its inputs in
+  // channel order.
+  uint32_t numOutputs = 0;
+  mNumInputs = 0;
+  for (const auto &mapEntry : mRoutingMap) {
+    for (const auto &routing : mapEntry.second) {
+      numOutputs = std::max(numOutputs, routing.first + 1);
+      mNumInputs = std::max(mNumInputs, mapEntry.first + 1);
+    }
+  }
+  std::vector<uint32_t> rowLength(numOutputs, 0);
+  for (const auto &mapEntry : mRoutingMap) {
+    for (const auto &routing : mapEntry.second) {
+      rowLength[routing.first]++;
+    }
+  }
+  mRowStart.assign(numOutputs + 1, 0);
+  for (uint32_t o = 0; o < numOutputs; o++) {
+    mRowStart[o + 1] = mRowStart[o] + rowLength[o];
+  }
+  mInputs.resize(mRowStart[numOutputs]);
+  mGains.resize(mRowStart[numOutputs]);
+  std::vector<uint32_t> next(mRowStart.begin(), mRowStart.end() - 1);
+  for (const auto &mapEntry : mRoutingMap) {
+    for (const auto &routing : mapEntry.second) {
+      uint32_t index = next[routing.first]++;
+      mInputs[index] = mapEntry.first;
+      mGains[index] = routing.second;
+    }
+  }
+  mInputBuffers.resize(mNumInputs);
+  mOutputBuffers.resize(numOutputs);
+}
+
+void DownMixer::allocateBuses(AudioIOData &io) {
+  mNumBuses = int(numOutputs());
   if (mBusStartNumber == -1) {
     mBusStartNumber = io.channelsBus();
-    io.channelsBus(io.channelsBus() + 2);
-  } else {
-    // TODO check if we have enough buses
+    io.channelsBus(io.channelsBus() + mNumBuses);
+  } else if (int(io.channelsBus()) < mBusStartNumber + mNumBuses) {
+    io.channelsBus(mBusStartNumber + mNumBuses);
+  }
+  // Silence for routes from channels the io does not have, allocated here
+  // rather than in the audio callback
+  if (mZeros.size() < io.framesPerBuffer()) {
+    mZeros.assign(io.framesPerBuffer(), 0.0f);
   }
 }
 
@@ -67,26 +127,88 @@ void DownMixer::setStereoOutput() { setOutputs({0, 1}); }
 
 void DownMixer::setOutputs(std::vector<uint32_t> outs) { mOuts = outs; }
 
-void DownMixer::downMixToBus(AudioIOData &io) {
-  // Zero bus buffers
-  for (int i = mBusStartNumber; i < io.channelsBus(); i++) {
-    memset(io.busBuffer(i), 0, io.framesPerBuffer() * sizeof(float));
+void DownMixer::process(const float *const *inputs, float *const *outputs,
+                        int numFrames) {
+  if (mGainParameter) {
+    mTargetGain = mGainParameter->get();
   }
-  io.frame(0);
-  while (io()) {
-    for (const auto &mapEntry : mRoutingMap) {
-      for (const auto &routing : mapEntry.second) {
-        io.bus(routing.first) += io.out(mapEntry.first) * routing.second;
+  // A constant master gain is folded into the matrix gains. A changing one
+  // is applied to each output after mixing.
+  const bool ramping = mCurrentGain != mTargetGain;
+  const float blockGain = ramping ? 1.0f : mCurrentGain;
+  const float rampStart = mCurrentGain;
+  const float rampInc = (mTargetGain - mCurrentGain) / numFrames;
+
+  for (uint32_t o = 0; o < numOutputs(); o++) {
+    float *out = outputs[o];
+    uint32_t k = mRowStart[o];
+    const uint32_t end = mRowStart[o + 1];
+    if (k == end) {
+      memset(out, 0, numFrames * sizeof(float));
+      continue;
+    }
+    // The first term initializes the output, so one-to-one routes are a
+    // plain copy or scale and outputs need no zeroing
+    const float *in = inputs[mInputs[k]];
+    const float g = mGains[k] * blockGain;
+    if (g == 1.0f) {
+      memcpy(out, in, numFrames * sizeof(float));
+    } else {
+      for (int i = 0; i < numFrames; i++) {
+        out[i] = in[i] * g;
+      }
+    }
+    k++;
+    // Accumulate four inputs per pass to cut loads and stores of the output
+    for (; k + 4 <= end; k += 4) {
+      const float *in0 = inputs[mInputs[k]];
+      const float *in1 = inputs[mInputs[k + 1]];
+      const float *in2 = inputs[mInputs[k + 2]];
+      const float *in3 = inputs[mInputs[k + 3]];
+      const float g0 = mGains[k] * blockGain;
+      const float g1 = mGains[k + 1] * blockGain;
+      const float g2 = mGains[k + 2] * blockGain;
+      const float g3 = mGains[k + 3] * blockGain;
+      for (int i = 0; i < numFrames; i++) {
+        out[i] += in0[i] * g0 + in1[i] * g1 + in2[i] * g2 + in3[i] * g3;
+      }
+    }
+    for (; k < end; k++) {
+      const float *in0 = inputs[mInputs[k]];
+      const float g0 = mGains[k] * blockGain;
+      for (int i = 0; i < numFrames; i++) {
+        out[i] += in0[i] * g0;
+      }
+    }
+    if (ramping) {
+      for (int i = 0; i < numFrames; i++) {
+        out[i] *= rampStart + rampInc * (i + 1);
       }
     }
   }
+  mCurrentGain = mTargetGain;
+}
+
+void DownMixer::downMixToBus(AudioIOData &io) {
+  const int numFrames = int(io.framesPerBuffer());
+  // Routes from channels the io does not have read silence. mZeros is
+  // sized when the routing is set and only grows if the buffer size changed
+  if (mNumInputs > io.channelsOut() && mZeros.size() < size_t(numFrames)) {
+    mZeros.resize(numFrames, 0.0f);
+  }
+  for (uint32_t c = 0; c < mNumInputs; c++) {
+    mInputBuffers[c] = c < io.channelsOut() ? io.outBuffer(c) : mZeros.data();
+  }
+  for (uint32_t o = 0; o < numOutputs(); o++) {
+    mOutputBuffers[o] = io.busBuffer(mBusStartNumber + o);
+  }
+  process(mInputBuffers.data(), mOutputBuffers.data(), numFrames);
 }
 
 void DownMixer::copyBusToOuts(AudioIOData &io) {
-  int offset = io.channelsBus() - mOuts.size();
-  for (size_t i = 0; i < mOuts.size(); i++) {
-    if (mOuts[i] != UINT32_MAX) {
-      memcpy(io.outBuffer(mOuts[i]), io.busBuffer(offset + i),
+  for (size_t i = 0; i < mOuts.size() && int(i) < mNumBuses; i++) {
+    if (mOuts[i] != UINT32_MAX && mOuts[i] < io.channelsOut()) {
+      memcpy(io.outBuffer(mOuts[i]), io.busBuffer(mBusStartNumber + i),
              io.framesPerBuffer() * sizeof(float));
     }
   }
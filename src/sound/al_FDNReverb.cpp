@@ -0,0 +1,331 @@
+#include "al/sound/al_FDNReverb.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+using namespace al;
+
+static bool isPrime(int n) {
+  if (n < 2) {
+    return false;
+  }
+  for (int d = 2; d * d <= n; d++) {
+    if (n % d == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+FDNReverb::FDNReverb() { configure(2); }
+
+void FDNReverb::configure(int numOutputs, int numLines, double sampleRate,
+                          float roomSize) {
+  if (numLines < 2) {
+    numLines = 2;
+  }
+  mNumOutputs = numOutputs;
+  mSampleRate = sampleRate;
+
+  // Mutually prime lengths spread exponentially between 25 and 100 ms
+  mLines.resize(numLines);
+  const double minLength = 0.025 * sampleRate * roomSize;
+  int maxLength = 0;
+  for (int i = 0; i < numLines; i++) {
+    int length =
+        int(minLength * std::pow(4.0, double(i) / (numLines - 1))) | 1;
+    length = std::max(length, 17);
+    if (i > 0 && length <= mLines[i - 1].length) {
+      length = mLines[i - 1].length + 1;
+    }
+    while (!isPrime(length)) {
+      length++;
+    }
+    mLines[i].length = length;
+    mLines[i].inputSign = (i % 2 == 0) ? 1.0f : -1.0f;
+    maxLength = std::max(maxLength, length);
+  }
+  mBlockSize = mLines[0].length;
+
+  // Each group of numLines outputs uses Hadamard rows for its signs when
+  // numLines is a power of two, otherwise random signs. Groups after the
+  // first also tap the lines later by a random offset, which decorrelates
+  // them from the other groups
+  const int numGroups = (numOutputs + numLines - 1) / numLines;
+  mOutSigns.resize(numOutputs * numLines);
+  mTapOffsets.assign(numGroups * numLines, 0);
+  const float scale = 1.0f / std::sqrt(float(numLines));
+  const bool powerOfTwo = (numLines & (numLines - 1)) == 0;
+  unsigned int seed = 0x9E3779B9u;
+  auto random = [&seed]() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+  };
+  int maxOffset = 0;
+  for (int g = 1; g < numGroups; g++) {
+    for (int i = 0; i < numLines; i++) {
+      int offset = 1 + int(random() % unsigned(mLines[i].length / 2));
+      mTapOffsets[g * numLines + i] = offset;
+      maxOffset = std::max(maxOffset, offset);
+    }
+  }
+  for (int c = 0; c < numOutputs; c++) {
+    for (int i = 0; i < numLines; i++) {
+      float sign;
+      if (powerOfTwo) {
+        int bits = (c % numLines) & i;
+        int parity = 0;
+        while (bits) {
+          parity ^= bits & 1;
+          bits >>= 1;
+        }
+        sign = parity ? -1.0f : 1.0f;
+      } else {
+        sign = (random() & 1) ? 1.0f : -1.0f;
+      }
+      mOutSigns[c * numLines + i] = sign * scale;
+    }
+  }
+
+  int size = 1;
+  while (size < maxLength + maxOffset + mBlockSize) {
+    size <<= 1;
+  }
+  mMask = size - 1;
+  for (auto &line : mLines) {
+    line.buffer.assign(size, 0.0f);
+  }
+  mBlock.assign(numLines * mBlockSize, 0.0f);
+  if (numGroups > 1) {
+    mTapBlock.assign(numLines * mBlockSize, 0.0f);
+  }
+  mInput.assign(mBlockSize, 0.0f);
+  mSum.assign(mBlockSize, 0.0f);
+
+  // Input diffusers use the lengths from Reverb at its 29761 Hz rate
+  const int diffuserLengths[2] = {142, 379};
+  for (int d = 0; d < 2; d++) {
+    int length = std::max(
+        1, int(diffuserLengths[d] * sampleRate / 29761.0 * roomSize));
+    mDiffusers[d].assign(length, 0.0f);
+    mDiffuserPos[d] = 0;
+  }
+  updateMixing();
+  zero();
+}
+
+FDNReverb &FDNReverb::mixing(Mixing m) {
+  mMixing = m;
+  updateMixing();
+  return *this;
+}
+
+void FDNReverb::updateMixing() {
+  const size_t numLines = mLines.size();
+  mEffectiveMixing = mMixing;
+  if (mMixing == HADAMARD && (numLines & (numLines - 1)) != 0) {
+    std::cerr << "WARNING: Hadamard mixing needs a power of two lines, using "
+                 "Householder mixing for "
+              << numLines << " lines" << std::endl;
+    mEffectiveMixing = HOUSEHOLDER;
+  }
+  updateFeedback();
+}
+
+FDNReverb &FDNReverb::bandwidth(float v) {
+  mBandwidth = v;
+  return *this;
+}
+
+FDNReverb &FDNReverb::damping(float v) {
+  mDamping = v;
+  return *this;
+}
+
+FDNReverb &FDNReverb::decay(float v) {
+  mDecay = v;
+  mDecayTime = -1;
+  updateFeedback();
+  return *this;
+}
+
+FDNReverb &FDNReverb::decayTime(float seconds) {
+  mDecayTime = seconds;
+  updateFeedback();
+  return *this;
+}
+
+FDNReverb &FDNReverb::diffusion(float v) {
+  mDiffusion = v;
+  return *this;
+}
+
+FDNReverb &FDNReverb::gain(float v) {
+  mGain = v;
+  return *this;
+}
+
+void FDNReverb::updateFeedback() {
+  double meanLength = 0;
+  for (auto &line : mLines) {
+    meanLength += line.length;
+  }
+  meanLength /= mLines.size();
+  // The Hadamard transform is orthogonal after scaling by 1/sqrt(N)
+  const float matrixScale =
+      mEffectiveMixing == HADAMARD ? 1.0f / std::sqrt(float(mLines.size())) : 1.0f;
+  for (auto &line : mLines) {
+    double g;
+    if (mDecayTime > 0) {
+      g = std::pow(10.0, -3.0 * line.length / (mDecayTime * mSampleRate));
+    } else {
+      g = std::pow(double(mDecay), line.length / meanLength);
+    }
+    line.feedback = float(g) * matrixScale;
+  }
+}
+
+void FDNReverb::zero() {
+  for (auto &line : mLines) {
+    std::fill(line.buffer.begin(), line.buffer.end(), 0.0f);
+    line.filterState = 0;
+  }
+  for (auto &d : mDiffusers) {
+    std::fill(d.begin(), d.end(), 0.0f);
+  }
+  mInputState = 0;
+  mWritePos = 0;
+}
+
+void FDNReverb::diffuseInput(const float *in, int numFrames) {
+  // Bandwidth one-pole, as Reverb::OnePole with damping 1 - bandwidth
+  const float b1 = 1.0f - mBandwidth;
+  const float a0 = 1.0f - std::abs(b1);
+  float state = mInputState;
+  for (int i = 0; i < numFrames; i++) {
+    state = in[i] * 0.5f * a0 + state * b1;
+    mInput[i] = state;
+  }
+  mInputState = state;
+
+  const float g = mDiffusion;
+  for (int d = 0; d < 2; d++) {
+    float *buffer = mDiffusers[d].data();
+    const int length = int(mDiffusers[d].size());
+    int pos = mDiffuserPos[d];
+    for (int i = 0; i < numFrames; i++) {
+      float delayed = buffer[pos];
+      float v = mInput[i] - g * delayed;
+      buffer[pos] = v;
+      mInput[i] = delayed + g * v;
+      if (++pos == length) {
+        pos = 0;
+      }
+    }
+    mDiffuserPos[d] = pos;
+  }
+}
+
+void FDNReverb::readLine(int line, int delay, int numFrames, float *dest) {
+  const float *buffer = mLines[line].buffer.data();
+  const int readPos = (mWritePos - delay) & mMask;
+  const int first = std::min(numFrames, mMask + 1 - readPos);
+  std::memcpy(dest, buffer + readPos, first * sizeof(float));
+  std::memcpy(dest + first, buffer, (numFrames - first) * sizeof(float));
+}
+
+void FDNReverb::process(const float *in, float *const *outputs,
+                        int numFrames) {
+  const int numLines = int(mLines.size());
+  const int ringSize = mMask + 1;
+  for (int offset = 0; offset < numFrames; offset += mBlockSize) {
+    const int n = std::min(mBlockSize, numFrames - offset);
+    diffuseInput(in + offset, n);
+
+    // Delay line outputs. Every length is at least the block size, so the
+    // whole block was written in earlier blocks
+    for (int i = 0; i < numLines; i++) {
+      readLine(i, mLines[i].length, n, mBlock.data() + i * mBlockSize);
+    }
+
+    for (int c = 0; c < mNumOutputs; c++) {
+      const int group = c / numLines;
+      const float *taps = mBlock.data();
+      if (group > 0) {
+        if (c % numLines == 0) {
+          for (int i = 0; i < numLines; i++) {
+            readLine(i, mLines[i].length + mTapOffsets[group * numLines + i],
+                     n, mTapBlock.data() + i * mBlockSize);
+          }
+        }
+        taps = mTapBlock.data();
+      }
+      float *out = outputs[c] + offset;
+      const float *signs = mOutSigns.data() + c * numLines;
+      std::fill(out, out + n, 0.0f);
+      for (int i = 0; i < numLines; i++) {
+        const float s = signs[i] * mGain;
+        const float *block = taps + i * mBlockSize;
+        for (int j = 0; j < n; j++) {
+          out[j] += s * block[j];
+        }
+      }
+    }
+
+    if (mEffectiveMixing == HADAMARD) {
+      for (int h = 1; h < numLines; h *= 2) {
+        for (int start = 0; start < numLines; start += 2 * h) {
+          for (int i = start; i < start + h; i++) {
+            float *a = mBlock.data() + i * mBlockSize;
+            float *b = mBlock.data() + (i + h) * mBlockSize;
+            for (int j = 0; j < n; j++) {
+              float t = a[j];
+              a[j] = t + b[j];
+              b[j] = t - b[j];
+            }
+          }
+        }
+      }
+    } else {
+      float *sum = mSum.data();
+      std::fill(sum, sum + n, 0.0f);
+      for (int i = 0; i < numLines; i++) {
+        const float *block = mBlock.data() + i * mBlockSize;
+        for (int j = 0; j < n; j++) {
+          sum[j] += block[j];
+        }
+      }
+      const float scale = 2.0f / numLines;
+      for (int i = 0; i < numLines; i++) {
+        float *block = mBlock.data() + i * mBlockSize;
+        for (int j = 0; j < n; j++) {
+          block[j] -= scale * sum[j];
+        }
+      }
+    }
+
+    // Damping, decay and input, written back to the delay lines
+    const float b1 = mDamping;
+    const float a0 = 1.0f - std::abs(b1);
+    for (int i = 0; i < numLines; i++) {
+      Line &line = mLines[i];
+      float *block = mBlock.data() + i * mBlockSize;
+      float state = line.filterState;
+      const float g = line.feedback;
+      const float inputGain = line.inputSign;
+      for (int j = 0; j < n; j++) {
+        state = block[j] * a0 + state * b1;
+        block[j] = state * g + mInput[j] * inputGain;
+      }
+      line.filterState = state;
+      int first = std::min(n, ringSize - mWritePos);
+      std::memcpy(line.buffer.data() + mWritePos, block,
+                  first * sizeof(float));
+      std::memcpy(line.buffer.data(), block + first,
+                  (n - first) * sizeof(float));
+    }
+    mWritePos = (mWritePos + n) & mMask;
+  }
+}
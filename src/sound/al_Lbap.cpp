@@ -17,6 +17,7 @@ void Lbap::compile() {
     }
     speakerRingMap[speaker.group].push_back(speaker);
   }
+  mRings.clear();
   for (auto speakerRing : speakerRingMap) {
     mRings.push_back(LdapRing(speakerRing.second));
   }
@@ -25,130 +26,127 @@ void Lbap::compile() {
             [](const LdapRing &a, const LdapRing &b) -> bool {
               return a.elevation > b.elevation;
             });
+  mRingSines.clear();
+  for (auto &ring : mRings) {
+    mRingSines.push_back(std::sin(ring.elevation / RAD_2_DEG_SCALE));
+  }
 }
 
 void Lbap::prepare(AudioIOData &io) {
-  if (buffer) {
-    free(buffer);
+  for (auto &ring : mRings) {
+    ring.vbap->prepare(io);
   }
-  buffer = (float *)malloc(2 * io.framesPerBuffer() *
-                           sizeof(float)); // Allocate 2 buffers
-  bufferSize = io.framesPerBuffer();
 }
 
 void Lbap::renderSample(AudioIOData &io, const Vec3f &reldir,
                         const float &sample, const unsigned int &frameIndex) {
-
-  assert(0 == 1);
-  // FIXME implement
+  computeOutputGains(reldir);
+  for (size_t i = 0; i < mOutputChannels.size(); i++) {
+    io.out(mOutputChannels[i], frameIndex) += mOutputGains[i] * sample;
+  }
 }
 
 void Lbap::renderBuffer(AudioIOData &io, const Vec3f &reldir,
                         const float *samples, const unsigned int &numFrames) {
-  //  Vec3d vec = reldir;
+  renderBuffers(io, &reldir, &samples, 1, numFrames);
+}
 
-  // Rotate vector according to listener-rotation
-  //  Quatd srcRot = listeningPose.quat();
-  //  vec = srcRot.rotate(vec);
+void Lbap::renderBuffers(AudioIOData &io, const Vec3f *positions,
+                         const float *const *samples,
+                         const unsigned int &numSources,
+                         const unsigned int &numFrames,
+                         const uint64_t *sourceIds) {
+  for (unsigned int s = 0; s < numSources; s++) {
+    computeOutputGains(positions[s], sourceIds ? sourceIds[s] : NO_SOURCE_ID);
+    const float *in = samples[s];
+    for (size_t o = 0; o < mOutputChannels.size(); o++) {
+      float *out = io.outBuffer(mOutputChannels[o]);
+      const float gain = mOutputGains[o];
+      for (unsigned int i = 0; i < numFrames; i++) {
+        out[i] += gain * in[i];
+      }
+    }
+  }
+}
 
-  // Turn to audio space
-  //  vec = Vec3d(vec.x, vec.z, -vec.y);
+void Lbap::computeOutputGains(const Vec3f &reldir, uint64_t id) {
+  mOutputChannels.clear();
+  mOutputGains.clear();
+  if (mRings.empty()) {
+    return;
+  }
 
+  float norm = reldir.mag();
+  float sine = norm > 0 ? reldir.y / norm : 0.0f;
+  // First ring at or below the source
+  size_t ringIndex = std::lower_bound(mRingSines.begin(), mRingSines.end(),
+                                      sine, std::greater<float>()) -
+                     mRingSines.begin();
   float elev =
       RAD_2_DEG_SCALE *
       atan2f(reldir.y, sqrt(reldir.x * reldir.x + reldir.z * reldir.z));
 
-  auto it = mRings.begin();
-  while (it != mRings.end() && it->elevation > elev) {
-    it++;
-  }
-  if (it == mRings.begin()) { // Above Top ring
-    it->vbap->renderBuffer(io, reldir, samples, numFrames);
-    if (mRings.size() > 1) {
-      // assumes circular ring (all elevations and radii equal)
-      float fraction = (elev - it->vbap->speakerLayout()[0].elevation) /
-                       (90 - it->vbap->speakerLayout()[0].elevation);
-      assert(fraction <= 1.0);
-      if (fraction > mDispersionOffset) {
-        // Adjust fraction to effective fraction (discarding offset
-        fraction = (fraction - mDispersionOffset) / (1.0 - mDispersionOffset);
-        // Using linear adjustment. should other adjustment be used?
-        float dispersionBaseGain = 1.0 / sqrt(it->vbap->speakerLayout().size());
-        float disperseFractionGain = sin(fraction * M_PI_2);
-        float focusedFractionGain = cos(fraction * M_PI_2);
-
-        io.frame(0);
-        while (io()) { // Add dispersion
-
-          for (const auto &spkr : it->vbap->speakerLayout()) {
-            if (io.out(spkr.deviceChannel) == 0.0) {
-              io.out(spkr.deviceChannel) += disperseFractionGain *
-                                            dispersionBaseGain *
-                                            samples[io.frame()];
-            } else {
-              io.out(spkr.deviceChannel) *=
-                  dispersionBaseGain +
-                  focusedFractionGain * (1 - dispersionBaseGain);
-            }
-          }
-        }
-      }
-    }
-  } else if (it == mRings.end()) { // Below Bottom ring
-    mRings.back().vbap->renderBuffer(io, reldir, samples, numFrames);
-    if (mRings.size() > 1) {
-      // assumes circular ring (all elevations and radii equal)
-      float fraction =
-          (elev - mRings.back().vbap->speakerLayout()[0].elevation) /
-          (-90 - mRings.back().vbap->speakerLayout()[0].elevation);
-      if (fraction > 1.0) {
-        fraction = 1.0;
-      } else if (fraction < 0.0) {
-        fraction = 0.0;
-      }
-      if (fraction > mDispersionOffset) {
-        // Adjust fraction to effective fraction (discarding offset
-        fraction = (fraction - mDispersionOffset) / (1.0 - mDispersionOffset);
-        // Using linear adjustment. should other adjustment be used?
-        float dispersionBaseGain =
-            1.0 / sqrt(mRings.back().vbap->speakerLayout().size());
-        float disperseFractionGain = cos(fraction * M_PI_2);
-        float focusedFractionGain = sin(fraction * M_PI_2);
-
-        io.frame(0);
-        while (io()) { // Add dispersion
-
-          for (const auto &spkr : mRings.back().vbap->speakerLayout()) {
-            if (io.out(spkr.deviceChannel) == 0.0) {
-              io.out(spkr.deviceChannel) += disperseFractionGain *
-                                            dispersionBaseGain *
-                                            samples[io.frame()];
-            } else {
-              io.out(spkr.deviceChannel) *= focusedFractionGain;
-            }
-          }
-        }
-      }
-    }
-
-  } else {                   // Between inner rings
-    auto topRingIt = it - 1; // top ring is previous ring
-    float fraction = (elev - it->elevation) /
-                     (topRingIt->elevation -
-                      it->elevation); // elevation angle between layers
+  if (ringIndex == 0) { // Above Top ring
+    LdapRing &ring = mRings.front();
+    float fraction = (elev - ring.edgeElevation) / (90 - ring.edgeElevation);
+    addRingGains(ring, reldir, fraction, 1.0f, id);
+  } else if (ringIndex == mRings.size()) { // Below Bottom ring
+    LdapRing &ring = mRings.back();
+    float fraction = (elev - ring.edgeElevation) / (-90 - ring.edgeElevation);
+    addRingGains(ring, reldir, fraction, 1.0f, id);
+  } else { // Between inner rings
+    LdapRing &topRing = mRings[ringIndex - 1];
+    LdapRing &bottomRing = mRings[ringIndex];
+    float fraction = (elev - bottomRing.elevation) /
+                     (topRing.elevation -
+                      bottomRing.elevation); // elevation angle between layers
     float gainTop = sin(M_PI_2 * fraction);
     float gainBottom = cos(M_PI_2 * fraction);
-    for (int i = 0; i < bufferSize; i++) {
-      buffer[i] = samples[i] * gainTop;
-      buffer[i + bufferSize] = samples[i] * gainBottom;
-    }
-
     // TODO we should do dispersion on inner rings too
     if (gainTop != 0) {
-      topRingIt->vbap->renderBuffer(io, reldir, buffer, bufferSize);
+      addRingGains(topRing, reldir, 0.0f, gainTop, id);
     }
     if (gainBottom != 0) {
-      it->vbap->renderBuffer(io, reldir, buffer + bufferSize, bufferSize);
+      addRingGains(bottomRing, reldir, 0.0f, gainBottom, id);
+    }
+  }
+}
+
+void Lbap::addRingGains(LdapRing &ring, const Vec3f &reldir, float fraction,
+                        float gain, uint64_t id) {
+  ring.vbap->outputGains(reldir, mRingChannels, mRingGains, id);
+
+  float focusedGain = 1.0f;
+  float disperseGain = 0.0f;
+  if (mRings.size() > 1) {
+    fraction = std::max(0.0f, std::min(1.0f, fraction));
+    if (fraction > mDispersionOffset) {
+      // Adjust fraction to effective fraction (discarding offset
+      fraction = (fraction - mDispersionOffset) / (1.0 - mDispersionOffset);
+      // Speakers used by the ring panner fade from their panned gain towards
+      // the dispersion base gain, the others fade in at the base gain
+      float base = ring.dispersionBaseGain;
+      focusedGain = base + cos(fraction * M_PI_2) * (1 - base);
+      disperseGain = sin(fraction * M_PI_2) * base;
+    }
+  }
+
+  for (size_t i = 0; i < mRingChannels.size(); i++) {
+    mOutputChannels.push_back(mRingChannels[i]);
+    mOutputGains.push_back(gain * focusedGain * mRingGains[i]);
+  }
+  if (disperseGain != 0) {
+    for (auto channel : ring.channels) {
+      bool panned = false;
+      for (size_t i = 0; i < mRingChannels.size(); i++) {
+        if (mRingChannels[i] == channel && mRingGains[i] != 0) {
+          panned = true;
+        }
+      }
+      if (!panned) {
+        mOutputChannels.push_back(channel);
+        mOutputGains.push_back(gain * disperseGain);
+      }
     }
   }
 }
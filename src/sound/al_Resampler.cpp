@@ -0,0 +1,315 @@
+#include "al/sound/al_Resampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+using namespace al;
+
+namespace {
+
+struct QualityPreset {
+  int halfTaps;        // at the lower of the two rates
+  double attenuation;  // stopband attenuation in dB
+  uint64_t phases;     // table phases when coefficients are interpolated
+};
+
+const QualityPreset kPresets[] = {
+    {12, 60.0, 128}, {24, 90.0, 256}, {48, 110.0, 512}, {96, 130.0, 1024}};
+
+// Precompute every phase when the table stays below this many coefficients
+const uint64_t kMaxExactTableSize = 1 << 18;
+
+double besselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 64; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-17) {
+      break;
+    }
+  }
+  return sum;
+}
+
+uint64_t gcd(uint64_t a, uint64_t b) {
+  while (b != 0) {
+    uint64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Eight partial sums let the compiler vectorize without reassociating.
+// n must be a multiple of 8
+inline float dot(const float *x, const float *h, int n) {
+  float acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  for (int k = 0; k < n; k += 8) {
+    for (int j = 0; j < 8; j++) {
+      acc[j] += x[k + j] * h[k + j];
+    }
+  }
+  return ((acc[0] + acc[4]) + (acc[1] + acc[5])) +
+         ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+}
+
+}  // namespace
+
+Resampler::Resampler(unsigned int inputRate, unsigned int outputRate,
+                     int channels, Quality quality) {
+  configure(inputRate, outputRate, channels, quality);
+}
+
+bool Resampler::configure(unsigned int inputRate, unsigned int outputRate,
+                          int channels, Quality quality) {
+  if (inputRate == 0 || outputRate == 0 || channels < 1 || quality < FAST ||
+      quality > BEST) {
+    std::cerr << "Resampler: invalid configuration " << inputRate << " -> "
+              << outputRate << " Hz, " << channels << " channels" << std::endl;
+    return false;
+  }
+  mInputRate = inputRate;
+  mOutputRate = outputRate;
+  mChannels = channels;
+  mQuality = quality;
+  uint64_t divisor = gcd(inputRate, outputRate);
+  mStep = inputRate / divisor;
+  mDenominator = outputRate / divisor;
+
+  const QualityPreset &preset = kPresets[quality];
+  if (inputRate == outputRate) {
+    // Pass through with a unit impulse
+    mPassband = 1.0;
+    mTaps = 8;
+    mExactPhases = true;
+    mNumPhases = 1;
+    mTable.assign(mTaps, 0.0f);
+    mTable[mTaps / 2 - 1] = 1.0f;
+  } else {
+    // Kaiser design: transition width in radians per sample at the lower
+    // rate, centered on the cutoff so the stopband starts at Nyquist
+    const double width =
+        (preset.attenuation - 8.0) / (2.285 * 2.0 * preset.halfTaps);
+    const double beta = 0.1102 * (preset.attenuation - 8.7);
+    const double ratio = std::min(1.0, double(outputRate) / inputRate);
+    const double cutoff = ratio * (1.0 - width / (2.0 * M_PI));
+    mPassband = 1.0 - width / M_PI;
+
+    // Downsampling stretches the filter over more input samples. Round to
+    // a multiple of 8 taps for dot()
+    int halfTaps = int(std::ceil(preset.halfTaps / ratio));
+    halfTaps = (halfTaps + 3) / 4 * 4;
+    mTaps = 2 * halfTaps;
+
+    mExactPhases = mDenominator * mTaps <= kMaxExactTableSize;
+    // Interpolation reads one phase past the last
+    mNumPhases = mExactPhases ? mDenominator : preset.phases;
+    const uint64_t tablePhases = mExactPhases ? mNumPhases : mNumPhases + 1;
+    mTable.resize(tablePhases * mTaps);
+    const double windowNorm = 1.0 / besselI0(beta);
+    for (uint64_t p = 0; p < tablePhases; p++) {
+      const double frac = double(p) / mNumPhases;
+      float *h = &mTable[p * mTaps];
+      double sum = 0.0;
+      for (int k = 0; k < mTaps; k++) {
+        // Distance of tap k from the output time, in input samples
+        const double u = frac - (k - (halfTaps - 1));
+        const double x = u / halfTaps;
+        double window =
+            x * x < 1.0 ? besselI0(beta * std::sqrt(1.0 - x * x)) * windowNorm
+                        : 0.0;
+        const double arg = M_PI * cutoff * u;
+        double sinc = std::fabs(arg) < 1e-12 ? 1.0 : std::sin(arg) / arg;
+        double c = cutoff * sinc * window;
+        h[k] = float(c);
+        sum += c;
+      }
+      // Unity gain at DC for every phase
+      for (int k = 0; k < mTaps; k++) {
+        h[k] = float(h[k] / sum);
+      }
+    }
+  }
+  mCoefficients.resize(mTaps);
+  mHistory.resize(mChannels);
+  reset();
+  return true;
+}
+
+uint64_t Resampler::outputFrames(uint64_t inputFrames) const {
+  return (inputFrames * mDenominator + mStep - 1) / mStep;
+}
+
+const float *Resampler::coefficients(uint64_t phase, float *scratch) const {
+  if (mExactPhases) {
+    return &mTable[phase * mTaps];
+  }
+  const double position = double(phase) * mNumPhases / mDenominator;
+  const uint64_t p = uint64_t(position);
+  const float a = float(position - p);
+  const float *h0 = &mTable[p * mTaps];
+  const float *h1 = h0 + mTaps;
+  for (int k = 0; k < mTaps; k++) {
+    scratch[k] = h0[k] + a * (h1[k] - h0[k]);
+  }
+  return scratch;
+}
+
+void Resampler::convert(const float *input, uint64_t inputFrames,
+                        float *output, uint64_t outputFrames,
+                        int numThreads) const {
+  if (mTaps == 0 || outputFrames == 0) {
+    return;
+  }
+  // Deinterleave with silence around the input so every output reads a
+  // full window
+  const uint64_t pre = mTaps / 2 - 1;
+  const uint64_t lastIndex = (outputFrames - 1) * mStep / mDenominator;
+  const uint64_t length = std::max(lastIndex, inputFrames) + mTaps + pre;
+  std::vector<std::vector<float>> planar(mChannels,
+                                         std::vector<float>(length, 0.0f));
+  for (uint64_t i = 0; i < inputFrames; i++) {
+    for (int c = 0; c < mChannels; c++) {
+      planar[c][pre + i] = input[i * mChannels + c];
+    }
+  }
+
+  auto convertRange = [&](uint64_t begin, uint64_t end) {
+    std::vector<float> scratch(mTaps);
+    for (uint64_t n = begin; n < end; n++) {
+      const uint64_t position = n * mStep;
+      const uint64_t index = position / mDenominator;
+      const float *h = coefficients(position % mDenominator, scratch.data());
+      float *out = output + n * mChannels;
+      for (int c = 0; c < mChannels; c++) {
+        out[c] = dot(planar[c].data() + index, h, mTaps);
+      }
+    }
+  };
+
+  if (numThreads <= 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // Keep enough work per thread to amortize starting it
+  numThreads = int(std::min<uint64_t>(numThreads, outputFrames / 4096 + 1));
+  std::vector<std::thread> threads;
+  const uint64_t chunk = (outputFrames + numThreads - 1) / numThreads;
+  for (int t = 1; t < numThreads; t++) {
+    uint64_t begin = std::min(outputFrames, t * chunk);
+    uint64_t end = std::min(outputFrames, begin + chunk);
+    threads.push_back(std::thread(convertRange, begin, end));
+  }
+  convertRange(0, std::min(outputFrames, chunk));
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void Resampler::reset() {
+  const uint64_t pre = mTaps / 2 - 1;
+  for (auto &channel : mHistory) {
+    if (channel.size() < pre) {
+      channel.resize(pre);
+    }
+    std::fill(channel.begin(), channel.begin() + pre, 0.0f);
+  }
+  mFill = pre;
+  mIndex = pre;
+  mPhase = 0;
+  mFlushed = false;
+}
+
+void Resampler::append(const float *input, uint64_t inputFrames) {
+  for (int c = 0; c < mChannels; c++) {
+    std::vector<float> &channel = mHistory[c];
+    if (channel.size() < mFill + inputFrames) {
+      channel.resize(mFill + inputFrames);
+    }
+    float *dest = channel.data() + mFill;
+    for (uint64_t i = 0; i < inputFrames; i++) {
+      dest[i] = input[i * mChannels + c];
+    }
+  }
+  mFill += inputFrames;
+}
+
+uint64_t Resampler::process(const float *input, uint64_t inputFrames,
+                            float *output, uint64_t maxOutputFrames) {
+  if (mTaps == 0) {
+    return 0;
+  }
+  if (input && inputFrames > 0) {
+    append(input, inputFrames);
+  }
+  const uint64_t pre = mTaps / 2 - 1;
+  uint64_t written = 0;
+  // The window around mIndex ends at mIndex + mTaps / 2
+  while (written < maxOutputFrames && mIndex + mTaps / 2 < mFill) {
+    const float *h = coefficients(mPhase, mCoefficients.data());
+    float *out = output + written * mChannels;
+    for (int c = 0; c < mChannels; c++) {
+      out[c] = dot(mHistory[c].data() + mIndex - pre, h, mTaps);
+    }
+    written++;
+    mPhase += mStep;
+    mIndex += mPhase / mDenominator;
+    mPhase %= mDenominator;
+  }
+
+  // Drop input that no later output reads
+  const uint64_t drop = std::min(mIndex, mFill) - pre;
+  if (drop > 0) {
+    for (auto &channel : mHistory) {
+      std::memmove(channel.data(), channel.data() + drop,
+                   (mFill - drop) * sizeof(float));
+    }
+    mFill -= drop;
+    mIndex -= drop;
+  }
+  return written;
+}
+
+uint64_t Resampler::inputFramesNeeded(uint64_t numOutputFrames) const {
+  if (numOutputFrames == 0 || mTaps == 0) {
+    return 0;
+  }
+  const uint64_t last =
+      mIndex + (mPhase + (numOutputFrames - 1) * mStep) / mDenominator;
+  const uint64_t needed = last + mTaps / 2 + 1;
+  return needed > mFill ? needed - mFill : 0;
+}
+
+uint64_t Resampler::pull(float *output, uint64_t numOutputFrames,
+                         const Source &source) {
+  uint64_t produced = 0;
+  while (produced < numOutputFrames) {
+    uint64_t needed = inputFramesNeeded(numOutputFrames - produced);
+    if (needed > 0 && !mFlushed) {
+      mPullBuffer.resize(needed * mChannels);
+      uint64_t read = source(mPullBuffer.data(), needed);
+      if (read == 0) {
+        // Feed a window of silence through the filter to get its tail
+        mPullBuffer.assign(std::max<size_t>(mPullBuffer.size(),
+                                            size_t(mTaps) * mChannels),
+                           0.0f);
+        append(mPullBuffer.data(), mTaps);
+        mFlushed = true;
+      } else {
+        append(mPullBuffer.data(), std::min(read, needed));
+      }
+    }
+    uint64_t written = process(nullptr, 0, output + produced * mChannels,
+                               numOutputFrames - produced);
+    produced += written;
+    if (written == 0 && mFlushed) {
+      break;
+    }
+  }
+  std::fill(output + produced * mChannels,
+            output + numOutputFrames * mChannels, 0.0f);
+  return produced;
+}
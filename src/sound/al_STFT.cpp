@@ -0,0 +1,168 @@
+#include "al/sound/al_STFT.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+using namespace al;
+
+STFT::STFT(unsigned int windowSize, unsigned int hopSize,
+           WindowType windowType, unsigned int fftSize) {
+  configure(windowSize, hopSize, windowType, fftSize);
+}
+
+void STFT::configure(unsigned int windowSize, unsigned int hopSize,
+                     WindowType windowType, unsigned int fftSize) {
+  if (windowSize < 2 || hopSize == 0 || hopSize > windowSize) {
+    std::cerr << "ERROR: Invalid STFT window " << windowSize << " and hop "
+              << hopSize << std::endl;
+    return;
+  }
+  if (fftSize < windowSize) {
+    if (fftSize != 0) {
+      std::cerr << "WARNING: STFT fft size smaller than window, using "
+                << windowSize << std::endl;
+    }
+    fftSize = windowSize;
+  }
+  mFFT.resize(RFFT::nextSupportedSize(fftSize));
+  mWindowSize = windowSize;
+  mHopSize = hopSize;
+
+  const double pi = 3.141592653589793;
+  mWindow.resize(windowSize);
+  double sum = 0, sumSquares = 0;
+  for (unsigned int i = 0; i < windowSize; i++) {
+    // Periodic windows, which overlap-add to a constant
+    double phase = 2.0 * pi * i / windowSize;
+    switch (windowType) {
+      case RECTANGLE:
+        mWindow[i] = 1.0f;
+        break;
+      case HANN:
+        mWindow[i] = float(0.5 - 0.5 * std::cos(phase));
+        break;
+      case HAMMING:
+        mWindow[i] = float(0.54 - 0.46 * std::cos(phase));
+        break;
+      case BLACKMAN:
+        mWindow[i] = float(0.42 - 0.5 * std::cos(phase) +
+                           0.08 * std::cos(2.0 * phase));
+        break;
+    }
+    sum += mWindow[i];
+    sumSquares += mWindow[i] * mWindow[i];
+  }
+  mMagnitudeScale = float(2.0 / sum);
+
+  // The window is applied before and after the transform, so overlapping
+  // windows add up to the sum of the squared window at hop intervals. That
+  // sum is only constant for some hops (a Hann window needs a hop of at most
+  // windowSize / 4), so the synthesis window divides by it per sample.
+  std::vector<double> overlapSum(hopSize, 0.0);
+  for (unsigned int i = 0; i < windowSize; i++) {
+    overlapSum[i % hopSize] += mWindow[i] * mWindow[i];
+  }
+  mSynthesisWindow.resize(windowSize);
+  bool gaps = false;
+  for (unsigned int i = 0; i < windowSize; i++) {
+    double s = overlapSum[i % hopSize];
+    if (s > 1e-6 * sumSquares) {
+      mSynthesisWindow[i] = float(mWindow[i] / s);
+    } else {
+      mSynthesisWindow[i] = 0.0f;
+      gaps = true;
+    }
+  }
+  if (gaps) {
+    std::cerr << "WARNING: STFT hop " << hopSize
+              << " leaves samples outside every window. Resynthesis will "
+                 "drop them"
+              << std::endl;
+  }
+
+  mInput.assign(windowSize, 0.0f);
+  mOutput.assign(windowSize, 0.0f);
+  mFrame.assign(mFFT.size(), 0.0f);
+  mRe.assign(mFFT.bins(), 0.0f);
+  mIm.assign(mFFT.bins(), 0.0f);
+  const unsigned int numBins = mFFT.bins();
+  mMagnitudes.forEach(
+      [numBins](std::vector<float> &m) { m.assign(numBins, 0.0f); });
+  mPos = 0;
+}
+
+void STFT::reset() {
+  std::fill(mInput.begin(), mInput.end(), 0.0f);
+  std::fill(mOutput.begin(), mOutput.end(), 0.0f);
+  mPos = 0;
+}
+
+int STFT::process(const float *in, float *out, unsigned int numFrames) {
+  if (mWindowSize == 0) {
+    return 0;
+  }
+  int frames = 0;
+  unsigned int i = 0;
+  const unsigned int start = mWindowSize - mHopSize;
+  while (i < numFrames) {
+    unsigned int n = std::min(numFrames - i, mHopSize - mPos);
+    std::memcpy(mInput.data() + start + mPos, in + i, n * sizeof(float));
+    if (out) {
+      std::memcpy(out + i, mOutput.data() + mPos, n * sizeof(float));
+    }
+    mPos += n;
+    i += n;
+    if (mPos == mHopSize) {
+      computeFrame();
+      mPos = 0;
+      frames++;
+    }
+  }
+  return frames;
+}
+
+void STFT::computeFrame() {
+  const unsigned int windowSize = mWindowSize;
+  const unsigned int hop = mHopSize;
+  float *frame = mFrame.data();
+  for (unsigned int i = 0; i < windowSize; i++) {
+    frame[i] = mInput[i] * mWindow[i];
+  }
+  std::fill(frame + windowSize, frame + mFFT.size(), 0.0f);
+  mFFT.forward(frame, mRe.data(), mIm.data());
+
+  std::vector<float> &mags = mMagnitudes.writeBuffer();
+  const float *re = mRe.data();
+  const float *im = mIm.data();
+  for (size_t k = 0; k < mags.size(); k++) {
+    mags[k] = std::sqrt(re[k] * re[k] + im[k] * im[k]) * mMagnitudeScale;
+  }
+  mMagnitudes.publish();
+
+  if (mSpectrumFunc) {
+    mSpectrumFunc(mRe.data(), mIm.data(), mFFT.bins());
+  }
+  std::memmove(mInput.data(), mInput.data() + hop,
+               (windowSize - hop) * sizeof(float));
+
+  float *output = mOutput.data();
+  std::memmove(output, output + hop, (windowSize - hop) * sizeof(float));
+  std::fill(output + windowSize - hop, output + windowSize, 0.0f);
+  if (mResynthesis) {
+    mFFT.inverse(mRe.data(), mIm.data(), frame);
+    const float *window = mSynthesisWindow.data();
+    for (unsigned int i = 0; i < windowSize; i++) {
+      output[i] += frame[i] * window[i];
+    }
+  }
+}
+
+void STFT::onAudioCB(AudioIOData &io) {
+  if (mChannel >= io.channelsOut()) {
+    return;
+  }
+  float *buffer = io.outBuffer(mChannel);
+  process(buffer, mResynthesis ? buffer : nullptr, io.framesPerBuffer());
+}
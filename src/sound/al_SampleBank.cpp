@@ -0,0 +1,406 @@
+#include "al/sound/al_SampleBank.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "al/io/al_File.hpp"
+
+using namespace al;
+
+namespace {
+
+void fileStatus(const std::string &path, double &modified, uint64_t &size) {
+  struct stat s;
+  if (::stat(path.c_str(), &s) == 0) {
+    modified = double(s.st_mtime);
+    size = uint64_t(s.st_size);
+  } else {
+    modified = 0;
+    size = 0;
+  }
+}
+
+bool readFile(const std::string &path, std::vector<char> &bytes) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return false;
+  }
+  bytes.resize(size_t(file.tellg()));
+  file.seekg(0);
+  return bool(file.read(bytes.data(), bytes.size()));
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+} // namespace
+
+BatchLoad::~BatchLoad() {
+  for (auto &worker : mWorkers) {
+    worker.join();
+  }
+}
+
+void BatchLoad::wait() {
+  std::unique_lock<std::mutex> lk(mLock);
+  mCondition.wait(lk, [this]() { return done(); });
+}
+
+std::vector<BatchLoad::Result> BatchLoad::results() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mResults;
+}
+
+double BatchLoad::seconds() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mSeconds;
+}
+
+SampleBank::SampleBank(size_t budgetBytes) : mBudget(budgetBytes) {}
+
+SampleBank::~SampleBank() {
+  {
+    std::unique_lock<std::mutex> lk(mLock);
+    mRunning = false;
+    mQueueCondition.notify_all();
+  }
+  if (mLoader.joinable()) {
+    mLoader.join();
+  }
+  for (auto &pending : mQueue) {
+    pending.promise.set_value(nullptr);
+  }
+}
+
+SampleBank &SampleBank::instance() {
+  static SampleBank bank;
+  return bank;
+}
+
+bool SampleBank::lookup(const std::string &path,
+                        std::shared_future<Handle> &sample,
+                        PendingLoad &load) {
+  double modified;
+  uint64_t fileSize;
+  fileStatus(path, modified, fileSize);
+  std::unique_lock<std::mutex> lk(mLock);
+  auto it = mEntries.find(path);
+  if (it != mEntries.end()) {
+    Entry &entry = it->second;
+    if (entry.modified == modified && entry.fileSize == fileSize) {
+      mHits++;
+      mLru.splice(mLru.begin(), mLru, entry.lru);
+      sample = entry.sample;
+      return false;
+    }
+    // The file changed. Handles already given out keep the old data
+    mBytes -= entry.bytes;
+    mLru.erase(entry.lru);
+    mEntries.erase(it);
+  }
+  mMisses++;
+  load.path = path;
+  load.id = mNextId++;
+  load.promise = std::promise<Handle>();
+  Entry &entry = mEntries[path];
+  entry.id = load.id;
+  entry.sample = load.promise.get_future().share();
+  entry.modified = modified;
+  entry.fileSize = fileSize;
+  mLru.push_front(path);
+  entry.lru = mLru.begin();
+  sample = entry.sample;
+  return true;
+}
+
+void SampleBank::load(PendingLoad &load) {
+  auto file = std::make_shared<SoundFile>();
+  if (!file->open(load.path.c_str())) {
+    file.reset();
+  }
+  finish(load.path, load.id, load.promise, std::move(file));
+}
+
+void SampleBank::finish(const std::string &path, uint64_t id,
+                        std::promise<Handle> &promise,
+                        std::shared_ptr<SoundFile> file) {
+  // Leave the shared state as the only owner so use counts are exact
+  Handle sample = std::move(file);
+  const size_t bytes = sample ? sample->data.size() * sizeof(float) : 0;
+  {
+    std::unique_lock<std::mutex> lk(mLock);
+    auto it = mEntries.find(path);
+    // The entry may have been replaced while loading
+    if (it != mEntries.end() && it->second.id == id) {
+      if (sample) {
+        it->second.bytes = bytes;
+        mBytes += bytes;
+      } else {
+        // Forget failures so the file can be retried
+        mLru.erase(it->second.lru);
+        mEntries.erase(it);
+      }
+    }
+  }
+  promise.set_value(std::move(sample));
+  enforceBudget();
+}
+
+void SampleBank::enforceBudget() {
+  std::unique_lock<std::mutex> lk(mLock);
+  if (mBudget == 0) {
+    return;
+  }
+  auto it = mLru.end();
+  while (mBytes > mBudget && it != mLru.begin()) {
+    --it;
+    auto entry = mEntries.find(*it);
+    const std::shared_future<Handle> &sample = entry->second.sample;
+    bool loaded = sample.wait_for(std::chrono::seconds(0)) ==
+                  std::future_status::ready;
+    // Only the bank holds unused samples
+    if (loaded && sample.get().use_count() <= 1) {
+      mBytes -= entry->second.bytes;
+      mEvictions++;
+      mEntries.erase(entry);
+      it = mLru.erase(it);
+    }
+  }
+}
+
+SampleBank::Handle SampleBank::get(const std::string &path) {
+  std::shared_future<Handle> sample;
+  PendingLoad pending;
+  if (lookup(path, sample, pending)) {
+    load(pending);
+  }
+  return sample.get();
+}
+
+void SampleBank::preload(const std::string &path) {
+  std::shared_future<Handle> sample;
+  PendingLoad pending;
+  if (!lookup(path, sample, pending)) {
+    return;
+  }
+  std::unique_lock<std::mutex> lk(mLock);
+  mQueue.push_back(std::move(pending));
+  if (!mLoader.joinable()) {
+    mLoader = std::thread([this]() { loaderThread(); });
+  }
+  mQueueCondition.notify_one();
+}
+
+std::shared_ptr<BatchLoad>
+SampleBank::loadAll(const std::vector<std::string> &paths,
+                    const BatchLoad::Options &options) {
+  std::shared_ptr<BatchLoad> batch(new BatchLoad);
+  batch->mPaths = paths;
+  batch->mOptions = options;
+  batch->mOptions.ioConcurrency = std::max(1, options.ioConcurrency);
+  batch->mStart = std::chrono::steady_clock::now();
+  for (const auto &path : paths) {
+    std::shared_future<Handle> sample;
+    PendingLoad pending;
+    if (lookup(path, sample, pending)) {
+      batch->mIds.push_back(pending.id);
+      batch->mPromises.emplace_back(
+          new std::promise<Handle>(std::move(pending.promise)));
+    } else {
+      batch->mIds.push_back(0);
+      batch->mPromises.emplace_back();
+    }
+    batch->mSamples.push_back(sample);
+  }
+
+  int numThreads = options.numThreads;
+  if (numThreads <= 0) {
+    numThreads = std::max(1, int(std::thread::hardware_concurrency()));
+  }
+  numThreads = int(std::min<size_t>(numThreads, paths.size()));
+  BatchLoad *b = batch.get();
+  for (int t = 0; t < numThreads; t++) {
+    batch->mWorkers.emplace_back([this, b]() { loadBatch(*b); });
+  }
+  return batch;
+}
+
+std::shared_ptr<BatchLoad>
+SampleBank::loadAll(const std::vector<std::string> &paths) {
+  return loadAll(paths, BatchLoad::Options());
+}
+
+std::shared_ptr<BatchLoad> SampleBank::loadAll(FileList &files) {
+  std::vector<std::string> paths;
+  for (auto &file : files) {
+    paths.push_back(file.filepath());
+  }
+  return loadAll(paths);
+}
+
+std::shared_ptr<BatchLoad> SampleBank::loadDirectory(const std::string &dir,
+                                                     bool recursive) {
+  FileList files = filterInDir(
+      dir,
+      [](const FilePath &f) {
+        return checkExtension(f, ".wav") || checkExtension(f, ".flac");
+      },
+      recursive);
+  files.sort();
+  return loadAll(files);
+}
+
+void SampleBank::loadBatch(BatchLoad &batch) {
+  size_t i;
+  while ((i = batch.mNext++) < batch.size()) {
+    BatchLoad::Result result;
+    result.path = batch.mPaths[i];
+    if (!batch.mPromises[i]) {
+      result.cached = true;
+    } else {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<char> encoded;
+      {
+        // Bound the reads in flight so decoding overlaps disk access
+        // without seeking between many files
+        std::unique_lock<std::mutex> lk(batch.mLock);
+        batch.mCondition.wait(lk, [&batch]() {
+          return batch.mReading < batch.mOptions.ioConcurrency;
+        });
+        batch.mReading++;
+      }
+      bool read = readFile(result.path, encoded);
+      {
+        std::unique_lock<std::mutex> lk(batch.mLock);
+        batch.mReading--;
+      }
+      batch.mCondition.notify_all();
+      result.readSeconds = secondsSince(start);
+      result.fileBytes = encoded.size();
+
+      start = std::chrono::steady_clock::now();
+      auto file = std::make_shared<SoundFile>();
+      if (!read) {
+        std::cerr << "SampleBank: failed to read " << result.path
+                  << std::endl;
+        file.reset();
+      } else if (!file->openMemory(encoded.data(), encoded.size())) {
+        file.reset();
+      }
+      std::vector<char>().swap(encoded);
+      result.decodeSeconds = secondsSince(start);
+      finish(result.path, batch.mIds[i], *batch.mPromises[i],
+             std::move(file));
+    }
+    result.sample = batch.mSamples[i].get();
+    if (!result.sample) {
+      batch.mFailed++;
+    }
+
+    size_t completed;
+    {
+      std::unique_lock<std::mutex> lk(batch.mLock);
+      batch.mResults.push_back(result);
+      batch.mSeconds = secondsSince(batch.mStart);
+      completed = batch.mResults.size();
+    }
+    if (batch.mOptions.onLoaded) {
+      batch.mOptions.onLoaded(result, completed, batch.size());
+    }
+    // Count the file only now so wait() also waits for the callback
+    {
+      std::unique_lock<std::mutex> lk(batch.mLock);
+      batch.mCompleted++;
+    }
+    batch.mCondition.notify_all();
+  }
+}
+
+void SampleBank::loaderThread() {
+  std::unique_lock<std::mutex> lk(mLock);
+  while (mRunning) {
+    if (mQueue.empty()) {
+      mQueueCondition.wait(lk);
+      continue;
+    }
+    PendingLoad pending = std::move(mQueue.front());
+    mQueue.pop_front();
+    lk.unlock();
+    load(pending);
+    lk.lock();
+  }
+}
+
+bool SampleBank::isLoaded(const std::string &path) {
+  std::unique_lock<std::mutex> lk(mLock);
+  auto it = mEntries.find(path);
+  return it != mEntries.end() &&
+         it->second.sample.wait_for(std::chrono::seconds(0)) ==
+             std::future_status::ready;
+}
+
+void SampleBank::budget(size_t bytes) {
+  {
+    std::unique_lock<std::mutex> lk(mLock);
+    mBudget = bytes;
+  }
+  enforceBudget();
+}
+
+size_t SampleBank::budget() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mBudget;
+}
+
+size_t SampleBank::memoryUsage() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mBytes;
+}
+
+void SampleBank::evictUnused() {
+  std::unique_lock<std::mutex> lk(mLock);
+  auto it = mLru.begin();
+  while (it != mLru.end()) {
+    auto entry = mEntries.find(*it);
+    const std::shared_future<Handle> &sample = entry->second.sample;
+    if (sample.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready &&
+        sample.get().use_count() <= 1) {
+      mBytes -= entry->second.bytes;
+      mEvictions++;
+      mEntries.erase(entry);
+      it = mLru.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+uint64_t SampleBank::hits() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mHits;
+}
+
+uint64_t SampleBank::misses() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mMisses;
+}
+
+uint64_t SampleBank::evictions() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mEvictions;
+}
+
+void SampleBank::resetCounters() {
+  std::unique_lock<std::mutex> lk(mLock);
+  mHits = 0;
+  mMisses = 0;
+  mEvictions = 0;
+}
@@ -3,14 +3,77 @@
 #define DR_WAV_IMPLEMENTATION
 #include "dr_wav.h"
 #define DR_FLAC_IMPLEMENTATION
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 #include "dr_flac.h"
 
+#ifdef AL_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "al/math/al_Interpolation.hpp"
+#include "al/sound/al_Resampler.hpp"
+#include "al/sound/al_SampleBank.hpp"
+#include "al/types/al_SingleRWRingBuffer.hpp"
+
 using namespace al;
 
+namespace {
+
+// Decode straight into data to avoid holding the file twice
+bool decodeWav(drwav& wav, SoundFile& file) {
+  file.channels = (int)wav.channels;
+  file.sampleRate = (int)wav.sampleRate;
+  file.data.resize(size_t(wav.totalPCMFrameCount * wav.channels));
+  file.frameCount = (long long int)drwav_read_pcm_frames_f32(
+      &wav, wav.totalPCMFrameCount, file.data.data());
+  file.data.resize(size_t(file.frameCount * file.channels));
+  drwav_uninit(&wav);
+  return true;
+}
+
+bool decodeFlac(drflac* flac, SoundFile& file) {
+  file.channels = (int)flac->channels;
+  file.sampleRate = (int)flac->sampleRate;
+  file.data.resize(size_t(flac->totalPCMFrameCount * flac->channels));
+  file.frameCount = (long long int)drflac_read_pcm_frames_f32(
+      flac, flac->totalPCMFrameCount, file.data.data());
+  file.data.resize(size_t(file.frameCount * file.channels));
+  drflac_close(flac);
+  return true;
+}
+
+// For streams that don't store their length dr_flac grows the buffer
+bool takeFlacData(float* flacData, unsigned int c, unsigned int s,
+                  drflac_uint64 f, SoundFile& file) {
+  if (!flacData) {
+    return false;
+  }
+  file.channels = (int)c;
+  file.sampleRate = (int)s;
+  file.frameCount = (long long int)f;
+  file.data.assign(flacData, flacData + size_t(c * f));
+  drflac_free(flacData);
+  return true;
+}
+
+}  // namespace
+
 bool SoundFile::open(const char* path) {
   auto len = std::strlen(path);
 
@@ -21,23 +84,12 @@ bool SoundFile::open(const char* path) {
 
   const char* ext3 = path + (len - 4);
   if (std::strcmp(ext3, ".wav") == 0) {
-    unsigned int c, s;
-    uint64_t f;
-    float* file_data =
-        drwav_open_file_and_read_pcm_frames_f32(path, &c, &s, &f);
-    if (file_data) {
-      channels = (int)c;
-      sampleRate = (int)s;
-      frameCount = (long long int)f;
-      size_t n = size_t(c * f);
-      data.resize(n);
-      std::memcpy(data.data(), file_data, sizeof(float) * n);
-      drwav_free(file_data);
-    } else {
+    drwav wav;
+    if (!drwav_init_file(&wav, path)) {
       std::cerr << "failed to open file: " << path << std::endl;
       return false;
     }
-    return true;
+    return decodeWav(wav, *this);
   } else if (std::strcmp(ext3, ".mp3") == 0) {
     std::cerr << "mp3 currently not supported\n";
     return false;
@@ -50,24 +102,59 @@ bool SoundFile::open(const char* path) {
 
   const char* ext4 = path + (len - 5);
   if (std::strcmp(ext4, ".flac") == 0) {
-    unsigned int c, s;
-    drflac_uint64 f;
-    float* file_data =
-        drflac_open_file_and_read_pcm_frames_f32(path, &c, &s, &f);
-    if (file_data) {
-      channels = (int)c;
-      sampleRate = (int)s;
-      frameCount = (long long int)f;
-      size_t n = (size_t)(c * f);
-      data.resize(n);
-      std::memcpy(data.data(), file_data, sizeof(float) * n);
-      drflac_free(file_data);
-    } else {
+    drflac* flac = drflac_open_file(path);
+    if (!flac) {
       std::cerr << "failed to open file: " << path << std::endl;
       return false;
     }
-    return true;
+    if (flac->totalPCMFrameCount == 0) {
+      drflac_close(flac);
+      unsigned int c, s;
+      drflac_uint64 f;
+      float* flacData =
+          drflac_open_file_and_read_pcm_frames_f32(path, &c, &s, &f);
+      if (!takeFlacData(flacData, c, s, f, *this)) {
+        std::cerr << "failed to open file: " << path << std::endl;
+        return false;
+      }
+      return true;
+    }
+    return decodeFlac(flac, *this);
+  }
+  return false;
+}
+
+bool SoundFile::openMemory(const void* encoded, size_t size) {
+  const char* bytes = static_cast<const char*>(encoded);
+  if (size >= 4 && std::memcmp(bytes, "RIFF", 4) == 0) {
+    drwav wav;
+    if (!drwav_init_memory(&wav, encoded, size)) {
+      std::cerr << "failed to decode wav data" << std::endl;
+      return false;
+    }
+    return decodeWav(wav, *this);
+  }
+  if (size >= 4 && std::memcmp(bytes, "fLaC", 4) == 0) {
+    drflac* flac = drflac_open_memory(encoded, size);
+    if (!flac) {
+      std::cerr << "failed to decode flac data" << std::endl;
+      return false;
+    }
+    if (flac->totalPCMFrameCount == 0) {
+      drflac_close(flac);
+      unsigned int c, s;
+      drflac_uint64 f;
+      float* flacData = drflac_open_memory_and_read_pcm_frames_f32(
+          encoded, size, &c, &s, &f);
+      if (!takeFlacData(flacData, c, s, f, *this)) {
+        std::cerr << "failed to decode flac data" << std::endl;
+        return false;
+      }
+      return true;
+    }
+    return decodeFlac(flac, *this);
   }
+  std::cerr << "unsupported sound file data" << std::endl;
   return false;
 }
 
@@ -75,22 +162,59 @@ float* SoundFile::getFrame(long long int frame) {
   return data.data() + frame * channels;
 }
 
+const float* SoundFile::getFrame(long long int frame) const {
+  return data.data() + frame * channels;
+}
+
+bool SoundFilePlayerTS::openShared(const char* path) {
+  sharedSoundFile = SampleBank::instance().get(path);
+  player.soundFile = sharedSoundFile.get();
+  return sharedSoundFile != nullptr;
+}
+
 SoundFile al::getResampledSoundFile(SoundFile* toConvert,
                                     unsigned int newSampleRate) {
-  // TODO!
-  return {};
+  if (!toConvert || toConvert->channels < 1 || toConvert->sampleRate < 1) {
+    std::cerr << "getResampledSoundFile: invalid sound file" << std::endl;
+    return {};
+  }
+  if (unsigned(toConvert->sampleRate) == newSampleRate) {
+    return *toConvert;
+  }
+  Resampler resampler;
+  if (!resampler.configure(toConvert->sampleRate, newSampleRate,
+                           toConvert->channels, Resampler::HIGH)) {
+    return {};
+  }
+  SoundFile converted;
+  converted.sampleRate = int(newSampleRate);
+  converted.channels = toConvert->channels;
+  converted.frameCount = (long long int)resampler.outputFrames(
+      uint64_t(toConvert->frameCount));
+  converted.data.resize(size_t(converted.frameCount) * converted.channels);
+  resampler.convert(toConvert->data.data(), uint64_t(toConvert->frameCount),
+                    converted.data.data(), uint64_t(converted.frameCount));
+  return converted;
 }
 
 void SoundFilePlayer::getFrames(uint64_t numFrames, float* buffer,
                                 int bufferLength) {
-  if (pause || !soundFile) {
+  const bool useView = soundFileView && soundFileView->isOpen();
+  if (pause || !(soundFile || useView)) {
     for (int i = 0; i < bufferLength; i += 1) {
       buffer[i] = 0.0f;
     }
     return;
   }
 
-  if (frame >= soundFile->frameCount) {
+  if (rate != 1.0 || frameFraction != 0.0) {
+    getFramesInterpolated(numFrames, buffer, bufferLength);
+    return;
+  }
+
+  const long long int frameCount =
+      useView ? soundFileView->frameCount() : soundFile->frameCount;
+  if (frame >= frameCount) {
     if (loop) {
       frame = 0;
     } else {
@@ -103,22 +227,716 @@ void SoundFilePlayer::getFrames(uint64_t numFrames, float* buffer,
   }
 
   int n = numFrames;
-  int c = soundFile->channels;
-  if (soundFile->frameCount < frame + n) {
-    n = (int)(soundFile->frameCount - frame);
+  int c = useView ? soundFileView->channels() : soundFile->channels;
+  if (frameCount < frame + n) {
+    n = (int)(frameCount - frame);
   }
-  if (n * c >= bufferLength) {
-    std::memcpy(buffer, soundFile->getFrame(frame),
-                sizeof(float) * bufferLength);
+  int samples = n * c >= bufferLength ? bufferLength : n * c;
+  if (useView) {
+    samples = int(soundFileView->read(frame, samples / c, buffer)) * c;
   } else {
-    std::memcpy(buffer, soundFile->getFrame(frame), sizeof(float) * n * c);
-    for (int i = n * c; i < bufferLength; i += 1) {
-      buffer[i] = 0.0f;
-    }
+    std::memcpy(buffer, soundFile->getFrame(frame), sizeof(float) * samples);
+  }
+  for (int i = samples; i < bufferLength; i += 1) {
+    buffer[i] = 0.0f;
   }
   frame += n;
 }
 
+namespace {
+
+// Kaiser windowed sinc for band-limited playback, tabulated from 0 to
+// kSincZeroCrossings zero crossings
+const int kSincZeroCrossings = 16;
+const int kSincResolution = 512;
+// Cutoff as a fraction of the output Nyquist frequency, low enough for the
+// stopband to start at Nyquist
+const double kSincCutoff = 0.84;
+
+const std::vector<float>& sincTable() {
+  static const std::vector<float> table = []() {
+    // Zeros past the last crossing let taps at the edge of the kernel read
+    // the table without a range check
+    const int size = (kSincZeroCrossings + 3) * kSincResolution;
+    std::vector<float> t(size, 0.0f);
+    const double beta = 8.0;
+    auto besselI0 = [](double x) {
+      double sum = 1.0, term = 1.0;
+      for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+      }
+      return sum;
+    };
+    for (int i = 0; i <= kSincZeroCrossings * kSincResolution; i++) {
+      const double x = double(i) / kSincResolution;
+      const double w = x / kSincZeroCrossings;
+      const double sinc = i == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+      t[i] = float(sinc * besselI0(beta * std::sqrt(1.0 - w * w)) /
+                   besselI0(beta));
+    }
+    return t;
+  }();
+  return table;
+}
+
+// Sum of x[t * stride] * w[t], or of w[t] when stride is 0. Four partial
+// sums hide the latency of the additions
+inline float weightedSum(const float* x, const float* w, int stride, int n) {
+  float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  int t = 0;
+  if (stride == 0) {
+    for (; t + 4 <= n; t += 4) {
+      for (int j = 0; j < 4; j++) {
+        acc[j] += w[t + j];
+      }
+    }
+    for (; t < n; t++) {
+      acc[0] += w[t];
+    }
+  } else {
+    for (; t + 4 <= n; t += 4) {
+      for (int j = 0; j < 4; j++) {
+        acc[j] += x[(t + j) * stride] * w[t + j];
+      }
+    }
+    for (; t < n; t++) {
+      acc[0] += x[t * stride] * w[t];
+    }
+  }
+  return (acc[0] + acc[2]) + (acc[1] + acc[3]);
+}
+
+}  // namespace
+
+void SoundFilePlayer::readSpan(long long int first, long long int count,
+                               float* dest) {
+  const bool useView = soundFileView && soundFileView->isOpen();
+  const long long int frameCount =
+      useView ? soundFileView->frameCount() : soundFile->frameCount;
+  const int c = useView ? soundFileView->channels() : soundFile->channels;
+  while (count > 0) {
+    long long int start = first;
+    if (loop) {
+      start %= frameCount;
+      if (start < 0) {
+        start += frameCount;
+      }
+    }
+    long long int n = count;
+    if (start < 0) {
+      n = std::min(count, -start);
+      std::fill(dest, dest + n * c, 0.0f);
+    } else if (start >= frameCount) {
+      std::fill(dest, dest + n * c, 0.0f);
+    } else {
+      n = std::min(count, frameCount - start);
+      if (useView) {
+        soundFileView->read(start, uint64_t(n), dest);
+      } else {
+        std::memcpy(dest, soundFile->getFrame(start), sizeof(float) * n * c);
+      }
+    }
+    first += n;
+    count -= n;
+    dest += n * c;
+  }
+}
+
+void SoundFilePlayer::getFramesInterpolated(uint64_t numFrames, float* buffer,
+                                            int bufferLength) {
+  const bool useView = soundFileView && soundFileView->isOpen();
+  const long long int frameCount =
+      useView ? soundFileView->frameCount() : soundFile->frameCount;
+  const int c = useView ? soundFileView->channels() : soundFile->channels;
+  const int n = int(std::min<uint64_t>(numFrames, uint64_t(bufferLength / c)));
+  std::fill(buffer, buffer + bufferLength, 0.0f);
+  if (frameCount == 0 || n == 0) {
+    return;
+  }
+  if (!loop && (frame < 0 || frame >= frameCount)) {
+    pause = true;
+    return;
+  }
+
+  const double speed = std::fabs(rate);
+  const bool sinc = bandLimit && speed > 1.0;
+  // Input frames the kernel reads before and after the frame at its
+  // position
+  int before = interpolation == LINEAR ? 0 : 1;
+  int after = interpolation == LINEAR ? 1 : 2;
+  if (sinc) {
+    before = after =
+        int(std::ceil(kSincZeroCrossings * speed / kSincCutoff)) + 1;
+  }
+
+  // Positions relative to frame. Without looping, output stops at the
+  // first position outside the file
+  const double last = frameFraction + (n - 1) * rate;
+  int valid = n;
+  if (!loop) {
+    const double end = rate > 0 ? double(frameCount - frame) : -double(frame);
+    const double steps = (end - frameFraction) / rate;
+    if (rate > 0 ? last >= end : last < end) {
+      const double count = rate > 0 ? std::ceil(steps) : std::floor(steps) + 1;
+      valid = std::max(0, std::min(n, int(count)));
+    }
+  }
+  const long long int low =
+      (long long int)std::floor(std::min(frameFraction, last)) - before;
+  const long long int high =
+      (long long int)std::floor(std::max(frameFraction, last)) + after + 1;
+  mSpan.resize(size_t(high - low) * c);
+  readSpan(frame + low, high - low, mSpan.data());
+
+  mIndex.resize(n);
+  mFraction.resize(n);
+  for (int i = 0; i < valid; i++) {
+    const double p = frameFraction + i * rate - double(low);
+    const int k = int(p);
+    mIndex[i] = k * c;
+    mFraction[i] = float(p - k);
+  }
+
+  const float* span = mSpan.data();
+  const int* index = mIndex.data();
+  const float* fraction = mFraction.data();
+  if (sinc) {
+    // The kernel is stretched by speed to lower the cutoff below the
+    // output Nyquist frequency. Weights are normalized for unity gain
+    const std::vector<float>& table = sincTable();
+    const int taps = 2 * before;
+    mWeights.resize(taps);
+    const float step = float(kSincResolution * kSincCutoff / speed);
+    for (int i = 0; i < valid; i++) {
+      const int k = index[i] / c;
+      // Taps up to and after the position, so distances need no fabs()
+      const float left = (float(before - 1) + fraction[i]) * step;
+      const float right = (1.0f - fraction[i]) * step;
+      float* w = mWeights.data();
+      for (int t = 0; t < before; t++) {
+        const float distance = left - t * step;
+        const int j = int(distance);
+        w[t] = table[j] + (distance - j) * (table[j + 1] - table[j]);
+      }
+      for (int t = 0; t < before; t++) {
+        const float distance = right + t * step;
+        const int j = int(distance);
+        w[before + t] = table[j] + (distance - j) * (table[j + 1] - table[j]);
+      }
+      const float norm = 1.0f / weightedSum(w, w, 0, taps);
+      const float* in = span + (k - before + 1) * c;
+      for (int ch = 0; ch < c; ch++) {
+        buffer[i * c + ch] = weightedSum(in + ch, w, c, taps) * norm;
+      }
+    }
+  } else {
+    for (int ch = 0; ch < c; ch++) {
+      const float* s = span + ch;
+      float* out = buffer + ch;
+      switch (interpolation) {
+        case LINEAR:
+          for (int i = 0; i < valid; i++) {
+            out[i * c] =
+                ipl::linear(fraction[i], s[index[i]], s[index[i] + c]);
+          }
+          break;
+        case CUBIC:
+          for (int i = 0; i < valid; i++) {
+            const float* x = s + index[i];
+            out[i * c] = ipl::cubic(fraction[i], x[-c], x[0], x[c], x[2 * c]);
+          }
+          break;
+        case HERMITE:
+          for (int i = 0; i < valid; i++) {
+            const float* x = s + index[i];
+            out[i * c] = ipl::hermite(fraction[i], x[-c], x[0], x[c],
+                                      x[2 * c], 0.0f, 0.0f);
+          }
+          break;
+      }
+    }
+  }
+
+  if (valid < n) {
+    pause = true;
+    frame = rate > 0 ? frameCount : 0;
+    frameFraction = 0.0;
+    return;
+  }
+  const double next = frameFraction + n * rate;
+  const double whole = std::floor(next);
+  frame += (long long int)whole;
+  frameFraction = next - whole;
+  if (loop) {
+    frame %= frameCount;
+    if (frame < 0) {
+      frame += frameCount;
+    }
+  }
+}
+
+SoundFileView::~SoundFileView() { close(); }
+
+namespace {
+
+uint32_t readLE(const unsigned char* p, int bytes) {
+  uint32_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value |= uint32_t(p[i]) << (8 * i);
+  }
+  return value;
+}
+
+// Convert interleaved samples to float, with the scaling dr_wav uses
+void convertSamples(const unsigned char* in, int bits, bool isFloat,
+                    size_t numSamples, float* out) {
+  if (isFloat) {
+    std::memcpy(out, in, numSamples * sizeof(float));
+  } else if (bits == 16) {
+    for (size_t i = 0; i < numSamples; i++) {
+      int16_t v = int16_t(in[2 * i] | (in[2 * i + 1] << 8));
+      out[i] = v * (1.0f / 32768.0f);
+    }
+  } else if (bits == 24) {
+    for (size_t i = 0; i < numSamples; i++) {
+      const unsigned char* p = in + 3 * i;
+      int32_t v = int32_t(uint32_t(p[0]) << 8 | uint32_t(p[1]) << 16 |
+                          uint32_t(p[2]) << 24) >>
+                  8;
+      out[i] = v * (1.0f / 8388608.0f);
+    }
+  } else {
+    for (size_t i = 0; i < numSamples; i++) {
+      int32_t v = int32_t(readLE(in + 4 * i, 4));
+      out[i] = float(v * (1.0 / 2147483648.0));
+    }
+  }
+}
+
+const long long int kViewBlockFrames = 1024;
+
+}  // namespace
+
+bool SoundFileView::open(const char* path, int cacheBlocks) {
+  close();
+#ifdef AL_WINDOWS
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    std::cerr << "SoundFileView: failed to open file: " << path << std::endl;
+    return false;
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(file, &size);
+  mMappingSize = size_t(size.QuadPart);
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping) {
+    std::cerr << "SoundFileView: failed to map file: " << path << std::endl;
+    return false;
+  }
+  mFileMapping = mapping;
+  mMapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!mMapping) {
+    std::cerr << "SoundFileView: failed to map file: " << path << std::endl;
+    unmap();
+    return false;
+  }
+#else
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "SoundFileView: failed to open file: " << path << std::endl;
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    std::cerr << "SoundFileView: failed to map file: " << path << std::endl;
+    ::close(fd);
+    return false;
+  }
+  mMappingSize = size_t(info.st_size);
+  void* mapping = mmap(nullptr, mMappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    std::cerr << "SoundFileView: failed to map file: " << path << std::endl;
+    return false;
+  }
+  mMapping = mapping;
+#endif
+
+  // Walk the RIFF chunks for the format and the sample data
+  const unsigned char* file = (const unsigned char*)mMapping;
+  if (mMappingSize < 12 || std::memcmp(file, "RIFF", 4) != 0 ||
+      std::memcmp(file + 8, "WAVE", 4) != 0) {
+    std::cerr << "SoundFileView: not a wav file: " << path << std::endl;
+    unmap();
+    return false;
+  }
+  int format = 0;
+  size_t dataOffset = 0;
+  size_t dataSize = 0;
+  size_t offset = 12;
+  while (offset + 8 <= mMappingSize) {
+    const unsigned char* chunk = file + offset;
+    size_t chunkSize = readLE(chunk + 4, 4);
+    if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 &&
+        offset + 8 + chunkSize <= mMappingSize) {
+      format = int(readLE(chunk + 8, 2));
+      mChannels = int(readLE(chunk + 10, 2));
+      mSampleRate = int(readLE(chunk + 12, 4));
+      mBits = int(readLE(chunk + 22, 2));
+      if (format == 0xFFFE && chunkSize >= 40) {
+        // WAVE_FORMAT_EXTENSIBLE: the sub format starts with the format tag
+        format = int(readLE(chunk + 32, 2));
+      }
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      dataOffset = offset + 8;
+      dataSize = std::min(chunkSize, mMappingSize - dataOffset);
+      break;
+    }
+    offset += 8 + chunkSize + (chunkSize & 1);
+  }
+  mFloat = format == 3 && mBits == 32;
+  const bool isInteger =
+      format == 1 && (mBits == 16 || mBits == 24 || mBits == 32);
+  if (dataOffset == 0 || mChannels < 1 || !(mFloat || isInteger)) {
+    std::cerr << "SoundFileView: unsupported wav format in " << path
+              << std::endl;
+    unmap();
+    return false;
+  }
+  mData = file + dataOffset;
+  mFrameCount = (long long int)(dataSize / (mChannels * (mBits / 8)));
+  mAligned = (uintptr_t(mData) % alignof(float)) == 0;
+
+  if (!isZeroCopy()) {
+    cacheBlocks = std::max(cacheBlocks, 1);
+    mCache.assign(size_t(cacheBlocks * kViewBlockFrames * mChannels), 0.0f);
+    mCacheBlock.assign(cacheBlocks, -1);
+  }
+#ifndef AL_WINDOWS
+  madvise(mMapping, mMappingSize, MADV_SEQUENTIAL);
+#endif
+  return true;
+}
+
+void SoundFileView::unmap() {
+#ifdef AL_WINDOWS
+  if (mMapping) {
+    UnmapViewOfFile(mMapping);
+  }
+  if (mFileMapping) {
+    CloseHandle((HANDLE)mFileMapping);
+  }
+  mFileMapping = nullptr;
+#else
+  if (mMapping) {
+    munmap(mMapping, mMappingSize);
+  }
+#endif
+  mMapping = nullptr;
+  mMappingSize = 0;
+  mData = nullptr;
+}
+
+void SoundFileView::close() {
+  unmap();
+  mSampleRate = 0;
+  mChannels = 0;
+  mFrameCount = 0;
+  mBits = 0;
+  mCache.clear();
+  mCacheBlock.clear();
+}
+
+long long int SoundFileView::read(long long int frame, long long int numFrames,
+                                  float* buffer) {
+  if (!mData || frame < 0 || frame >= mFrameCount) {
+    return 0;
+  }
+  numFrames = std::min(numFrames, mFrameCount - frame);
+  const size_t frameBytes = size_t(mChannels * (mBits / 8));
+  convertSamples(mData + frame * frameBytes, mBits, mFloat,
+                 size_t(numFrames * mChannels), buffer);
+  return numFrames;
+}
+
+const float* SoundFileView::frame(long long int frame) {
+  if (!mData || frame < 0 || frame >= mFrameCount) {
+    return nullptr;
+  }
+  if (isZeroCopy()) {
+    return (const float*)mData + frame * mChannels;
+  }
+  const long long int block = frame / kViewBlockFrames;
+  const size_t slot = size_t(block % (long long int)mCacheBlock.size());
+  float* cached = mCache.data() + slot * kViewBlockFrames * mChannels;
+  if (mCacheBlock[slot] != block) {
+    const long long int first = block * kViewBlockFrames;
+    read(first, kViewBlockFrames, cached);
+    mCacheBlock[slot] = block;
+  }
+  return cached + (frame % kViewBlockFrames) * mChannels;
+}
+
+void SoundFileView::preload(long long int frame, long long int numFrames) {
+  if (!mData || frame >= mFrameCount) {
+    return;
+  }
+  frame = std::max(frame, 0ll);
+  numFrames = std::min(numFrames, mFrameCount - frame);
+  const size_t frameBytes = size_t(mChannels * (mBits / 8));
+  const unsigned char* begin = mData + frame * frameBytes;
+  const unsigned char* end = begin + numFrames * frameBytes;
+#ifdef AL_WINDOWS
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = (PVOID)begin;
+  range.NumberOfBytes = size_t(end - begin);
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+  // madvise needs a page aligned start
+  const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+  uintptr_t alignedBegin = uintptr_t(begin) / pageSize * pageSize;
+  madvise((void*)alignedBegin, size_t(uintptr_t(end) - alignedBegin),
+          MADV_WILLNEED);
+#endif
+}
+
+namespace {
+
+// Work item of the shared read-ahead threads
+struct PrefetchTask {
+  virtual ~PrefetchTask() {}
+  // Do a bounded amount of work. Returns false when there is nothing to do
+  virtual bool service() = 0;
+  // Set while a thread services the task
+  std::atomic<bool> busy{false};
+};
+
+// Threads shared by all streams. Each pass services every task once, and
+// threads sleep for a short while when no task had work. Audio threads
+// never signal the pool, they only consume what has been read ahead.
+class PrefetchPool {
+ public:
+  static std::shared_ptr<PrefetchPool> instance() {
+    static std::shared_ptr<PrefetchPool> pool =
+        std::make_shared<PrefetchPool>();
+    return pool;
+  }
+
+  PrefetchPool() { threads(2); }
+  ~PrefetchPool() { threads(0); }
+
+  void add(PrefetchTask* task) {
+    std::unique_lock<std::mutex> lk(mLock);
+    mTasks.push_back(task);
+    mCondition.notify_all();
+  }
+
+  // Returns once no thread is servicing the task
+  void remove(PrefetchTask* task) {
+    {
+      std::unique_lock<std::mutex> lk(mLock);
+      mTasks.erase(std::remove(mTasks.begin(), mTasks.end(), task),
+                   mTasks.end());
+    }
+    while (task->busy.load()) {
+      std::this_thread::yield();
+    }
+  }
+
+  void wake() { mCondition.notify_all(); }
+
+  void threads(unsigned int n) {
+    std::unique_lock<std::mutex> threadsLock(mThreadsLock);
+    {
+      std::unique_lock<std::mutex> lk(mLock);
+      mRunning = false;
+      mCondition.notify_all();
+    }
+    for (auto& thread : mThreads) {
+      thread.join();
+    }
+    mThreads.clear();
+    mRunning = true;
+    for (unsigned int i = 0; i < n; i++) {
+      mThreads.push_back(std::thread([this, i]() { run(i); }));
+    }
+  }
+
+ private:
+  void run(size_t next) {
+    std::unique_lock<std::mutex> lk(mLock);
+    while (mRunning) {
+      bool worked = false;
+      for (size_t i = 0; i < mTasks.size() && mRunning; i++) {
+        PrefetchTask* task = mTasks[(next + i) % mTasks.size()];
+        if (task->busy.exchange(true)) {
+          continue;
+        }
+        lk.unlock();
+        worked |= task->service();
+        task->busy.store(false);
+        lk.lock();
+      }
+      next++;
+      if (!worked && mRunning) {
+        mCondition.wait_for(lk, std::chrono::milliseconds(2));
+      }
+    }
+  }
+
+  std::mutex mLock;
+  std::mutex mThreadsLock;
+  std::condition_variable mCondition;
+  std::vector<PrefetchTask*> mTasks;
+  std::vector<std::thread> mThreads;
+  bool mRunning{false};
+};
+
+}  // namespace
+
+struct SoundFileStreaming::Impl : public PrefetchTask {
+  ~Impl() {
+    if (flac) {
+      drflac_close(flac);
+    } else if (wavOpen) {
+      drwav_uninit(&wav);
+    }
+  }
+
+  bool open(const char* path, uint64_t bufferFrames) {
+    auto len = std::strlen(path);
+    if (len >= 5 && std::strcmp(path + len - 5, ".flac") == 0) {
+      flac = drflac_open_file(path);
+      if (!flac) {
+        return false;
+      }
+      sampleRate = flac->sampleRate;
+      channels = flac->channels;
+      totalFrames = flac->totalPCMFrameCount;
+    } else {
+      if (!drwav_init_file(&wav, path)) {
+        return false;
+      }
+      wavOpen = true;
+      sampleRate = wav.sampleRate;
+      channels = wav.channels;
+      totalFrames = wav.totalPCMFrameCount;
+    }
+    frameBytes = channels * sizeof(float);
+    ring.reset(new SingleRWRingBuffer(bufferFrames * frameBytes + 1));
+    chunkFrames = std::min<uint64_t>(
+        4096, std::max<uint64_t>(1, (ring->writeSpace() / frameBytes) / 2));
+    scratch.resize(chunkFrames * channels);
+    return true;
+  }
+
+  uint64_t decode(uint64_t numFrames, float* buffer) {
+    return flac ? drflac_read_pcm_frames_f32(flac, numFrames, buffer)
+                : drwav_read_pcm_frames_f32(&wav, numFrames, buffer);
+  }
+
+  void seekDecoder(uint64_t frame) {
+    if (flac) {
+      drflac_seek_to_pcm_frame(flac, frame);
+    } else {
+      drwav_seek_to_pcm_frame(&wav, frame);
+    }
+    readPosition = frame;
+  }
+
+  // Runs on the I/O threads
+  bool service() override {
+    const uint32_t request = seekRequest.load(std::memory_order_acquire);
+    if (request != seekDone.load(std::memory_order_relaxed)) {
+      const uint64_t frame = seekFrame.load();
+      seekDecoder(totalFrames > 0 ? std::min(frame, totalFrames) : frame);
+      endOfFile.store(false, std::memory_order_relaxed);
+      // The reader drops everything written before this mark
+      seekMark.store(bytesWritten, std::memory_order_relaxed);
+      seekDone.store(request, std::memory_order_release);
+    }
+    const bool looping = loopOn.load();
+    if (endOfFile.load(std::memory_order_relaxed)) {
+      if (!looping) {
+        return false;
+      }
+      // Looping was switched on after the end
+      endOfFile.store(false, std::memory_order_relaxed);
+    }
+
+    uint64_t begin = 0;
+    uint64_t end = totalFrames > 0 ? totalFrames : UINT64_MAX;
+    if (looping) {
+      uint64_t loopBegin = loopStart.load();
+      uint64_t loopEnd = loopStop.load();
+      if (loopEnd > 0 && loopEnd < end) {
+        end = loopEnd;
+      }
+      begin = loopBegin < end ? loopBegin : 0;
+    }
+    if (readPosition >= end) {
+      if (!looping) {
+        endOfFile.store(true, std::memory_order_release);
+        return false;
+      }
+      seekDecoder(begin);
+    }
+    uint64_t space = ring->writeSpace() / frameBytes;
+    if (space < chunkFrames) {
+      return false;
+    }
+    uint64_t numFrames = std::min<uint64_t>(chunkFrames, end - readPosition);
+    uint64_t read = decode(numFrames, scratch.data());
+    if (read == 0) {
+      // Unknown length or a truncated file: end or loop on the next pass
+      readPosition = end;
+      return false;
+    }
+    ring->write((const char*)scratch.data(), read * frameBytes);
+    bytesWritten += read * frameBytes;
+    readPosition += read;
+    return true;
+  }
+
+  drwav wav;
+  bool wavOpen{false};
+  drflac* flac{nullptr};
+  uint32_t sampleRate{0};
+  uint16_t channels{0};
+  uint64_t totalFrames{0};
+  size_t frameBytes{0};
+  uint64_t chunkFrames{0};
+
+  std::unique_ptr<SingleRWRingBuffer> ring;
+  std::shared_ptr<PrefetchPool> pool;
+
+  // Controls, set from any thread
+  std::atomic<uint64_t> seekFrame{0};
+  std::atomic<uint32_t> seekRequest{0};
+  std::atomic<bool> loopOn{false};
+  std::atomic<uint64_t> loopStart{0};
+  std::atomic<uint64_t> loopStop{0};
+
+  // Written by the I/O thread
+  std::vector<float> scratch;
+  uint64_t readPosition{0};
+  uint64_t bytesWritten{0};
+  std::atomic<uint32_t> seekDone{0};
+  std::atomic<uint64_t> seekMark{0};
+  std::atomic<bool> endOfFile{false};
+
+  // Reader state
+  bool blocking{false};
+  uint32_t readerSeek{0};
+  uint64_t bytesRead{0};
+  uint64_t skipFrames{0};
+  std::atomic<uint64_t> underruns{0};
+  std::atomic<uint64_t> underrunFrames{0};
+};
+
 SoundFileStreaming::SoundFileStreaming(const char* path) {
   if (path) {
     if (!open(path)) {
@@ -130,35 +948,144 @@ SoundFileStreaming::SoundFileStreaming(const char* path) {
 SoundFileStreaming::~SoundFileStreaming() { close(); }
 
 uint32_t SoundFileStreaming::sampleRate() {
-  return static_cast<drwav*>(mImpl)->sampleRate;
+  return mImpl ? mImpl->sampleRate : 0;
 }
 
 uint64_t SoundFileStreaming::totalFrames() {
-  return static_cast<drwav*>(mImpl)->totalPCMFrameCount;
+  return mImpl ? mImpl->totalFrames : 0;
 }
 
 uint16_t SoundFileStreaming::numChannels() {
-  return static_cast<drwav*>(mImpl)->channels;
+  return mImpl ? mImpl->channels : 0;
 }
 
-bool SoundFileStreaming::open(const char* path) {
+bool SoundFileStreaming::open(const char* path, uint64_t bufferFrames) {
   close();
-  mImpl = new drwav;
-  if (!drwav_init_file((drwav*)mImpl, path)) {
+  std::unique_ptr<Impl> impl(new Impl);
+  if (!path || !impl->open(path, std::max<uint64_t>(bufferFrames, 2))) {
     return false;
   }
+  // Fill the buffer before the first getFrames()
+  while (impl->service()) {
+  }
+  impl->pool = PrefetchPool::instance();
+  impl->pool->add(impl.get());
+  mImpl = std::move(impl);
   return true;
 }
 
 void SoundFileStreaming::close() {
   if (mImpl) {
-    drwav_uninit((drwav*)mImpl);
-    delete (drwav*)mImpl;
+    mImpl->pool->remove(mImpl.get());
+    mImpl.reset();
   }
 }
 
 uint64_t SoundFileStreaming::getFrames(uint64_t numFrames, float* buffer) {
-  drwav_uint64 framesRead =
-      drwav_read_pcm_frames_f32((drwav*)mImpl, numFrames, buffer);
-  return framesRead;
+  if (!mImpl) {
+    std::memset(buffer, 0, numFrames * sizeof(float));
+    return 0;
+  }
+  Impl& s = *mImpl;
+  const uint16_t channels = s.channels;
+  const uint32_t request = s.seekRequest.load(std::memory_order_acquire);
+  while (s.blocking &&
+         s.seekDone.load(std::memory_order_acquire) != request) {
+    s.pool->wake();
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  // A seek completing between these loads can hand us a newer mark than
+  // done refers to, and the next call then sees a mark we already read past.
+  const uint32_t done = s.seekDone.load(std::memory_order_acquire);
+  const uint64_t mark = s.seekMark.load(std::memory_order_relaxed);
+  if (done != s.readerSeek) {
+    // Drop what was read ahead before the seek, never past the mark
+    uint64_t stale = mark > s.bytesRead ? mark - s.bytesRead : 0;
+    s.ring->skip(stale);
+    s.bytesRead += stale;
+    s.skipFrames = 0;
+    s.readerSeek = done;
+  }
+  if (done != request) {
+    std::memset(buffer, 0, numFrames * channels * sizeof(float));
+    return numFrames;
+  }
+
+  uint64_t written = 0;
+  while (true) {
+    uint64_t available = s.ring->readSpace() / s.frameBytes;
+    if (s.skipFrames > 0) {
+      // Catch up with the frames missed in an underrun
+      uint64_t skip = std::min(available, s.skipFrames);
+      s.ring->skip(skip * s.frameBytes);
+      s.bytesRead += skip * s.frameBytes;
+      s.skipFrames -= skip;
+      available -= skip;
+    }
+    uint64_t n = std::min(available, numFrames - written);
+    s.ring->read((char*)(buffer + written * channels), n * s.frameBytes);
+    s.bytesRead += n * s.frameBytes;
+    written += n;
+    if (written == numFrames) {
+      return numFrames;
+    }
+    if (s.endOfFile.load(std::memory_order_acquire) &&
+        s.ring->readSpace() == 0) {
+      std::memset(buffer + written * channels, 0,
+                  (numFrames - written) * channels * sizeof(float));
+      return written;
+    }
+    if (!s.blocking) {
+      break;
+    }
+    s.pool->wake();
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  const uint64_t missing = numFrames - written;
+  std::memset(buffer + written * channels, 0,
+              missing * channels * sizeof(float));
+  s.underruns.fetch_add(1, std::memory_order_relaxed);
+  s.underrunFrames.fetch_add(missing, std::memory_order_relaxed);
+  s.skipFrames += missing;
+  return numFrames;
+}
+
+void SoundFileStreaming::seek(uint64_t frame) {
+  if (mImpl) {
+    mImpl->seekFrame.store(frame);
+    mImpl->seekRequest.fetch_add(1, std::memory_order_release);
+  }
+}
+
+void SoundFileStreaming::loop(bool on) {
+  if (mImpl) {
+    mImpl->loopOn.store(on);
+  }
+}
+
+bool SoundFileStreaming::loop() { return mImpl && mImpl->loopOn.load(); }
+
+void SoundFileStreaming::loopPoints(uint64_t begin, uint64_t end) {
+  if (mImpl) {
+    mImpl->loopStart.store(begin);
+    mImpl->loopStop.store(end);
+  }
+}
+
+void SoundFileStreaming::blocking(bool on) {
+  if (mImpl) {
+    mImpl->blocking = on;
+  }
+}
+
+uint64_t SoundFileStreaming::underruns() {
+  return mImpl ? mImpl->underruns.load() : 0;
+}
+
+uint64_t SoundFileStreaming::underrunFrames() {
+  return mImpl ? mImpl->underrunFrames.load() : 0;
+}
+
+void SoundFileStreaming::numIOThreads(unsigned int n) {
+  PrefetchPool::instance()->threads(n);
 }
@@ -1,5 +1,138 @@
 #include "al/sound/al_Spatializer.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace al;
 
+constexpr uint64_t Spatializer::NO_SOURCE_ID;
+
 Spatializer::Spatializer(const Speakers &sl) { mSpeakers = sl; }
+
+void Spatializer::renderBuffers(AudioIOData &io, const Vec3f *positions,
+                                const float *const *samples,
+                                const unsigned int &numSources,
+                                const unsigned int &numFrames,
+                                const uint64_t *sourceIds) {
+  for (unsigned int s = 0; s < numSources; s++) {
+    renderBuffer(io, positions[s], samples[s], numFrames);
+  }
+}
+
+// SpatializerBatch -----------------
+
+void SpatializerBatch::configure(unsigned int maxSources,
+                                 unsigned int numFrames) {
+  mNumFrames = numFrames;
+  mPositions.resize(maxSources);
+  mBuffers.resize(maxSources);
+  mIds.resize(maxSources);
+  mSamples.resize(maxSources * numFrames);
+  for (unsigned int s = 0; s < maxSources; s++) {
+    mBuffers[s] = mSamples.data() + s * numFrames;
+  }
+  mNumSources = 0;
+}
+
+bool SpatializerBatch::add(const Vec3f &pos, const float *samples,
+                           uint64_t id) {
+  if (full()) {
+    return false;
+  }
+  mPositions[mNumSources] = pos;
+  mIds[mNumSources] = id;
+  memcpy(mSamples.data() + mNumSources * mNumFrames, samples,
+         mNumFrames * sizeof(float));
+  mNumSources++;
+  return true;
+}
+
+void SpatializerBatch::render(Spatializer &spatializer, AudioIOData &io) {
+  if (mNumSources > 0) {
+    spatializer.renderBuffers(io, mPositions.data(), mBuffers.data(),
+                              mNumSources, mNumFrames, mIds.data());
+  }
+  mNumSources = 0;
+}
+
+// SpatializerSourceSlots -----------------
+
+void SpatializerSourceSlots::configure(unsigned int maxSources) {
+  mIds.assign(maxSources, Spatializer::NO_SOURCE_ID);
+  mBlocks.assign(maxSources, 0);
+  mUsed.assign(maxSources, 0);
+  mFree.clear();
+  mFree.reserve(maxSources);
+  for (unsigned int slot = maxSources; slot > 0; slot--) {
+    mFree.push_back(slot - 1);
+  }
+  // At most half full, so probing always reaches an empty entry
+  size_t tableSize = 2;
+  while (tableSize < 2 * size_t(maxSources)) {
+    tableSize *= 2;
+  }
+  mTable.assign(tableSize, -1);
+  mBlock = 0;
+}
+
+static inline size_t hashSourceId(uint64_t id) {
+  return size_t((id * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+void SpatializerSourceSlots::rebuildTable() {
+  const size_t mask = mTable.size() - 1;
+  std::fill(mTable.begin(), mTable.end(), -1);
+  for (unsigned int slot = 0; slot < mIds.size(); slot++) {
+    if (mUsed[slot]) {
+      size_t h = hashSourceId(mIds[slot]) & mask;
+      while (mTable[h] >= 0) {
+        h = (h + 1) & mask;
+      }
+      mTable[h] = int(slot);
+    }
+  }
+}
+
+int SpatializerSourceSlots::find(uint64_t id, bool &isNew) {
+  isNew = true;
+  if (id == Spatializer::NO_SOURCE_ID || mTable.empty()) {
+    return -1;
+  }
+  const size_t mask = mTable.size() - 1;
+  size_t h = hashSourceId(id) & mask;
+  while (mTable[h] >= 0) {
+    int slot = mTable[h];
+    if (mIds[slot] == id) {
+      mBlocks[slot] = mBlock;
+      isNew = false;
+      return slot;
+    }
+    h = (h + 1) & mask;
+  }
+  if (mFree.empty()) {
+    return -1;
+  }
+  unsigned int slot = mFree.back();
+  mFree.pop_back();
+  mTable[h] = int(slot);
+  mIds[slot] = id;
+  mBlocks[slot] = mBlock;
+  mUsed[slot] = 1;
+  return int(slot);
+}
+
+void SpatializerSourceSlots::nextBlock() {
+  // Sources not found in the previous block have stopped
+  bool freed = false;
+  for (unsigned int slot = 0; slot < mIds.size(); slot++) {
+    if (mUsed[slot] && mBlocks[slot] != mBlock) {
+      mUsed[slot] = 0;
+      mFree.push_back(slot);
+      freed = true;
+    }
+  }
+  if (freed) {
+    rebuildTable();
+  }
+  mBlock++;
+}
@@ -1,6 +1,9 @@
 #include "al/sound/al_SpeakerAdjustment.hpp"
 
+#include <algorithm>
 #include <cfloat>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
 using namespace al;
@@ -31,16 +34,163 @@ void SpeakerDistanceGainAdjustment::configure(Speakers layout, double expon) {
 }
 
 void SpeakerDistanceGainAdjustment::processGains(AudioIOData& io) {
-  if (io.channelsOut() == 60) {
-    size_t counter = 0;
-    for (auto speaker : mLayout) {
-      float* ioBus = io.outBuffer(speaker.deviceChannel);
-      int samples = io.framesPerBuffer();
-      float gain = mGains[counter++];
-      while (samples-- > 0) {
-        *ioBus = *ioBus * gain;
-        ioBus++;
+  size_t counter = 0;
+  const int numFrames = io.framesPerBuffer();
+  for (auto& speaker : mLayout) {
+    float gain = mGains[counter++];
+    if (speaker.deviceChannel >= io.channelsOut() || gain == 1.0f) {
+      continue;
+    }
+    float* ioBus = io.outBuffer(speaker.deviceChannel);
+    for (int i = 0; i < numFrames; i++) {
+      ioBus[i] *= gain;
+    }
+  }
+}
+
+void SpeakerDistanceTimeAdjustment::configure(Speakers layout,
+                                              uint64_t framesPerBuffer,
+                                              double framesPerSecond,
+                                              double speedOfSound) {
+  mLayout = layout;
+  if (layout.size() == 0) {
+    mDelays.clear();
+    mRingSize = 0;
+    return;
+  }
+  float max_distance = 0.0;
+  for (auto& speaker : layout) {
+    max_distance = std::max(max_distance, speaker.radius);
+  }
+  mDelays.clear();
+  mGains.assign(layout.size(), 1.0f);
+  for (auto& speaker : layout) {
+    mDelays.push_back(float((max_distance - speaker.radius) / speedOfSound *
+                            framesPerSecond));
+  }
+  mFramesPerBuffer = std::max(framesPerBuffer, uint64_t(1));
+  mScratch.resize(mFramesPerBuffer + 1);
+  mIntDelays.resize(layout.size());
+  mFracDelays.resize(layout.size());
+  mRingSize = 0;
+  updateSize(*std::max_element(mDelays.begin(), mDelays.end()));
+  for (size_t i = 0; i < mDelays.size(); i++) {
+    delay(i, mDelays[i]);
+  }
+}
+
+void SpeakerDistanceTimeAdjustment::delay(size_t index, float samples) {
+  if (index >= mDelays.size()) {
+    std::cerr << "ERROR: speaker index out of range: " << index << std::endl;
+    return;
+  }
+  samples = std::max(samples, 0.0f);
+  mDelays[index] = samples;
+  mIntDelays[index] = uint32_t(samples);
+  mFracDelays[index] = samples - mIntDelays[index];
+  // Fractions too small to matter are rounded so the channel is a plain copy
+  if (mFracDelays[index] < 1e-4f) {
+    mFracDelays[index] = 0.0f;
+  } else if (mFracDelays[index] > 1.0f - 1e-4f) {
+    mIntDelays[index]++;
+    mFracDelays[index] = 0.0f;
+  }
+  updateSize(samples);
+}
+
+void SpeakerDistanceTimeAdjustment::gains(const std::vector<float>& gains) {
+  if (gains.size() != mLayout.size()) {
+    std::cerr << "ERROR: expected " << mLayout.size() << " gains, got "
+              << gains.size() << std::endl;
+    return;
+  }
+  mGains = gains;
+}
+
+void SpeakerDistanceTimeAdjustment::reset() {
+  std::fill(mBuffer.begin(), mBuffer.end(), 0.0f);
+}
+
+void SpeakerDistanceTimeAdjustment::updateSize(float maxDelay) {
+  // Holds the longest delay plus one interpolation sample plus one buffer
+  uint64_t needed = uint64_t(maxDelay) + 2 + mFramesPerBuffer;
+  if (needed <= mRingSize && mBuffer.size() == mRingSize * mLayout.size()) {
+    return;
+  }
+  uint64_t size = 1;
+  while (size < needed) {
+    size <<= 1;
+  }
+  mRingSize = std::max(size, mRingSize);
+  mBuffer.assign(mRingSize * mLayout.size(), 0.0f);
+  mWritePos = 0;
+}
+
+void SpeakerDistanceTimeAdjustment::processDelays(AudioIOData& io) {
+  if (mRingSize == 0) {
+    return;
+  }
+  const uint64_t numFrames = io.framesPerBuffer();
+  for (uint64_t offset = 0; offset < numFrames; offset += mFramesPerBuffer) {
+    processChunk(io, offset, std::min(mFramesPerBuffer, numFrames - offset));
+  }
+}
+
+void SpeakerDistanceTimeAdjustment::processChunk(AudioIOData& io,
+                                                 uint64_t offset,
+                                                 uint64_t numFrames) {
+  const uint64_t mask = mRingSize - 1;
+  const uint64_t firstWrite = std::min(numFrames, mRingSize - mWritePos);
+  for (size_t index = 0; index < mLayout.size(); index++) {
+    const int channel = mLayout[index].deviceChannel;
+    if (channel >= int(io.channelsOut())) {
+      continue;
+    }
+    float* out = io.outBuffer(channel) + offset;
+    float* ring = mBuffer.data() + index * mRingSize;
+    const float gain = mGains[index];
+    const uint32_t intDelay = mIntDelays[index];
+    const float frac = mFracDelays[index];
+
+    if (intDelay == 0 && frac == 0.0f) {
+      if (gain != 1.0f) {
+        for (uint64_t i = 0; i < numFrames; i++) {
+          out[i] *= gain;
+        }
+      }
+      continue;
+    }
+
+    // Write the new block, then read it back delayed into the output
+    std::memcpy(ring + mWritePos, out, firstWrite * sizeof(float));
+    std::memcpy(ring, out + firstWrite, (numFrames - firstWrite) * sizeof(float));
+
+    if (frac == 0.0f) {
+      const uint64_t readPos = (mWritePos - intDelay) & mask;
+      const uint64_t firstRead = std::min(numFrames, mRingSize - readPos);
+      std::memcpy(out, ring + readPos, firstRead * sizeof(float));
+      std::memcpy(out + firstRead, ring,
+                  (numFrames - firstRead) * sizeof(float));
+      if (gain != 1.0f) {
+        for (uint64_t i = 0; i < numFrames; i++) {
+          out[i] *= gain;
+        }
+      }
+    } else {
+      // One extra sample at the start for the interpolation
+      const uint64_t readPos = (mWritePos - intDelay - 1) & mask;
+      const uint64_t readLength = numFrames + 1;
+      const uint64_t firstRead = std::min(readLength, mRingSize - readPos);
+      float* scratch = mScratch.data();
+      std::memcpy(scratch, ring + readPos, firstRead * sizeof(float));
+      std::memcpy(scratch + firstRead, ring,
+                  (readLength - firstRead) * sizeof(float));
+      const float a = gain * (1.0f - frac);
+      const float b = gain * frac;
+      for (uint64_t i = 0; i < numFrames; i++) {
+        out[i] = a * scratch[i + 1] + b * scratch[i];
       }
     }
   }
+  mWritePos = (mWritePos + numFrames) & mask;
 }
@@ -40,6 +40,36 @@ void al::StereoPanner::renderBuffer(al::AudioIOData &io, const al::Vec3f &pos,
   }
 }
 
+void al::StereoPanner::renderBuffers(al::AudioIOData &io,
+                                     const al::Vec3f *positions,
+                                     const float *const *samples,
+                                     const unsigned int &numSources,
+                                     const unsigned int &numFrames,
+                                     const uint64_t *sourceIds) {
+  if (numSpeakers < 2) {
+    Spatializer::renderBuffers(io, positions, samples, numSources, numFrames,
+                               sourceIds);
+    return;
+  }
+  if (mGains.size() < 2 * numSources) {
+    mGains.resize(2 * numSources);
+  }
+  for (unsigned int s = 0; s < numSources; s++) {
+    equalPowerPan(positions[s], mGains[2 * s], mGains[2 * s + 1]);
+  }
+  // Accumulate one output channel at a time for all sources
+  for (unsigned int chan = 0; chan < 2; chan++) {
+    float *buf = io.outBuffer(chan);
+    for (unsigned int s = 0; s < numSources; s++) {
+      const float gain = mGains[2 * s + chan];
+      const float *in = samples[s];
+      for (unsigned int i = 0; i < numFrames; i++) {
+        buf[i] += gain * in[i];
+      }
+    }
+  }
+}
+
 void al::StereoPanner::equalPowerPan(const al::Vec3d &relPos, float &gainL,
                                      float &gainR) {
   double panVal = 0.5;
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <list>
 #include <utility> // move
 #include <vector>
@@ -379,173 +381,272 @@ void Vbap::findSpeakerTriplets(const std::vector<Speaker> &spkrs) {
 void Vbap::makePhantomChannel(int channelIndex,
                               std::vector<unsigned int> assignedOutputs) {
   mPhantomChannels[channelIndex] = std::move(assignedOutputs);
-  // mPhantomChannels[channelIndex] = assignedOutputs;
+  buildVertexOutputs();
 }
 
-// void Vbap::compile(Listener& listener){
-//	this->mListener = &listener;
-//}
-
-void Vbap::renderBuffer(AudioIOData &io, const Vec3f &pos, const float *samples,
-                        const unsigned int &numFrames) {
-  // FIMXE AC use cached index
-  //	unsigned currentTripletIndex = src.cachedIndex();
-  unsigned currentTripletIndex = 0;
-  // unsigned currentTripletIndex = mCachedTripletIndex; // Cached source
-  // placement, so it starts searching from there.
-
-  //  Vec3d vec = listeningPose.vec();
-
-  // Rotate vector according to listener-rotation
-  //  Quatd srcRot = listeningPose.quat();
-  //  vec = srcRot.rotate({0, 0, -4});
-  // Transform vector to audio space
-  Vec3d vec = Vec3d(pos.x, -pos.z, pos.y);
-
-  // Silent by default
-  Vec3d gains;
-
-  // Search thru the triplets array in search of a match for the source
-  // position.
-  for (unsigned count = 0; count < mTriplets.size(); ++count) {
-    gains = computeGains(vec, mTriplets[currentTripletIndex]);
-    if ((gains[0] >= 0) && (gains[1] >= 0) && (!mIs3D || (gains[2] >= 0))) {
-      gains.normalize();
-
-      SpeakerTriple triple = mTriplets[currentTripletIndex];
+bool Vbap::tripletContains(int tripletIndex, const Vec3d &vec, Vec3d &gains) {
+  gains = computeGains(vec, mTriplets[tripletIndex]);
+  return (gains[0] >= 0) && (gains[1] >= 0) && (!mIs3D || (gains[2] >= 0));
+}
 
-      float *outBuff1 = io.outBuffer(triple.s1Chan);
-      float *outBuff2 = io.outBuffer(triple.s2Chan);
-      float *outBuff3 = nullptr;
-      if (mIs3D) {
-        outBuff3 = io.outBuffer(triple.s3Chan);
+int Vbap::findTriplet(const Vec3d &vec, Vec3d &gains, int cachedIndex) {
+  int tripletIndex = -1;
+  if (cachedIndex >= 0 && cachedIndex < int(mTriplets.size()) &&
+      tripletContains(cachedIndex, vec, gains)) {
+    tripletIndex = cachedIndex;
+  }
+  if (tripletIndex < 0 && mLookupValid) {
+    int cell = lookupCell(vec);
+    if (cell >= 0) {
+      for (unsigned int i = mCellOffsets[cell]; i < mCellOffsets[cell + 1];
+           i++) {
+        if (tripletContains(mCellTriplets[i], vec, gains)) {
+          tripletIndex = mCellTriplets[i];
+          break;
+        }
+      }
+    }
+  }
+  if (tripletIndex < 0) {
+    // Not in table candidates. Search thru all the triplets
+    for (unsigned int i = 0; i < mTriplets.size(); ++i) {
+      if (tripletContains(i, vec, gains)) {
+        tripletIndex = i;
+        break;
       }
+    }
+  }
+  if (tripletIndex >= 0) {
+    gains.normalize();
+  }
+  return tripletIndex;
+}
 
-      // Check if any of the triplets are phantom channels and
-      // reassign signal
-      auto it1 = mPhantomChannels.find(triple.s1Chan);
-      auto it2 = mPhantomChannels.find(triple.s2Chan);
-      auto it3 = mPhantomChannels.find(triple.s3Chan);
-
-      for (size_t i = 0; i < numFrames; ++i) {
-        float sample = samples[i];
-        if (it1 != mPhantomChannels.end()) { // vertex 1 is phantom
-          float splitGain = gains[0] / mPhantomChannels.size();
-          float splitGainSQ = splitGain * splitGain;
-          for (auto const &element :
-               it1->second) { // iterate across all assigned speakers
-            io.out(element, i) += sample * splitGainSQ;
-          }
-        } else {
-          outBuff1[i] += sample * gains[0];
-        }
-        if (it2 != mPhantomChannels.end()) { // vertex 2 is phantom
-          float splitGain = gains[1] / mPhantomChannels.size();
-          float splitGainSQ = splitGain * splitGain;
-          for (auto const &element : it2->second) {
-            io.out(element, i) += sample * splitGainSQ;
+int Vbap::lookupCell(const Vec3d &vec) const {
+  double x = vec.x;
+  double y = vec.y;
+  double z = mIs3D ? vec.z : 0.0;
+  double ax = std::abs(x);
+  double ay = std::abs(y);
+  double az = std::abs(z);
+  int face;
+  double u, v, major;
+  if (ax >= ay && ax >= az) {
+    face = x >= 0 ? 0 : 1;
+    major = ax;
+    u = y;
+    v = z;
+  } else if (ay >= az) {
+    face = y >= 0 ? 2 : 3;
+    major = ay;
+    u = x;
+    v = z;
+  } else {
+    face = z >= 0 ? 4 : 5;
+    major = az;
+    u = x;
+    v = y;
+  }
+  if (major == 0.0) {
+    return -1;
+  }
+  const int res = mLookupResolution;
+  int iu = int((u / major + 1.0) * 0.5 * res);
+  int iv = int((v / major + 1.0) * 0.5 * res);
+  iu = iu < 0 ? 0 : (iu >= res ? res - 1 : iu);
+  iv = iv < 0 ? 0 : (iv >= res ? res - 1 : iv);
+  return (face * res + iu) * res + iv;
+}
+
+void Vbap::buildLookupTable() {
+  // Sample each cell on a grid that includes its edges and keep every
+  // triplet that contains any sample point. Candidates are sorted by the
+  // number of points they contain. Slivers that fall between sample points
+  // are still found by the full search in findTriplet().
+  const int res = mLookupResolution;
+  const int numCells = 6 * res * res;
+  const int samplesPerSide = 5;
+  const double margin = 1e-6;
+
+  mCellOffsets.resize(numCells + 1);
+  mCellTriplets.clear();
+  std::vector<int> hits(mTriplets.size());
+  std::vector<int> candidates;
+  for (int face = 0; face < 6; face++) {
+    for (int iu = 0; iu < res; iu++) {
+      for (int iv = 0; iv < res; iv++) {
+        int cell = (face * res + iu) * res + iv;
+        std::fill(hits.begin(), hits.end(), 0);
+        for (int su = 0; su < samplesPerSide; su++) {
+          for (int sv = 0; sv < samplesPerSide; sv++) {
+            double u =
+                2.0 * (iu + double(su) / (samplesPerSide - 1)) / res - 1.0;
+            double v =
+                2.0 * (iv + double(sv) / (samplesPerSide - 1)) / res - 1.0;
+            double sign = (face % 2 == 0) ? 1.0 : -1.0;
+            Vec3d dir;
+            switch (face / 2) {
+            case 0:
+              dir.set(sign, u, v);
+              break;
+            case 1:
+              dir.set(u, sign, v);
+              break;
+            default:
+              dir.set(u, v, sign);
+              break;
+            }
+            dir.normalize();
+            for (unsigned int t = 0; t < mTriplets.size(); t++) {
+              Vec3d gains = computeGains(dir, mTriplets[t]);
+              if ((gains[0] >= -margin) && (gains[1] >= -margin) &&
+                  (!mIs3D || (gains[2] >= -margin))) {
+                hits[t]++;
+              }
+            }
           }
-        } else {
-          outBuff2[i] += sample * gains[1];
         }
-        if (mIs3D) {
-          if (it3 != mPhantomChannels.end()) {
-            float splitGain = gains[2] / mPhantomChannels.size();
-            float splitGainSQ = splitGain * splitGain;
-            for (auto const &element : it3->second) {
-              io.out(element, i) += sample * splitGainSQ;
-            }
-          } else {
-            outBuff3[i] += sample * gains[2];
+        candidates.clear();
+        for (unsigned int t = 0; t < mTriplets.size(); t++) {
+          if (hits[t] > 0) {
+            candidates.push_back(t);
           }
         }
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [&hits](int a, int b) { return hits[a] > hits[b]; });
+        mCellOffsets[cell] = mCellTriplets.size();
+        mCellTriplets.insert(mCellTriplets.end(), candidates.begin(),
+                             candidates.end());
       }
-      break;
     }
+  }
+  mCellOffsets[numCells] = mCellTriplets.size();
+  mLookupValid = true;
+}
 
-    ++currentTripletIndex;
-    if (currentTripletIndex >= mTriplets.size()) {
-      currentTripletIndex = 0;
+void Vbap::buildVertexOutputs() {
+  unsigned int dimensions = mIs3D ? 3 : 2;
+  mOutputOffsets.resize(mTriplets.size() + 1);
+  mVertexOutputs.clear();
+  for (unsigned int t = 0; t < mTriplets.size(); t++) {
+    const SpeakerTriple &triple = mTriplets[t];
+    unsigned int vertexChans[3] = {triple.s1Chan, triple.s2Chan,
+                                   triple.s3Chan};
+    mOutputOffsets[t] = mVertexOutputs.size();
+    for (unsigned int vertex = 0; vertex < dimensions; vertex++) {
+      auto it = mPhantomChannels.find(vertexChans[vertex]);
+      if (it != mPhantomChannels.end()) {
+        // Signal for phantom vertex is split among all assigned speakers
+        float scale = 1.0f / mPhantomChannels.size();
+        for (auto const &element : it->second) {
+          mVertexOutputs.push_back({int(vertex), element, true, scale});
+        }
+      } else {
+        mVertexOutputs.push_back(
+            {int(vertex), vertexChans[vertex], false, 1.0f});
+      }
     }
   }
-  // FIXME AC store cached index
-  //	src.cachedIndex(currentTripletIndex);
-  // mCachedTripletIndex = currentTripletIndex; // Store the new index
+  mOutputOffsets[mTriplets.size()] = mVertexOutputs.size();
 }
 
-void Vbap::renderSample(AudioIOData &io, const Vec3f &pos, const float &sample,
-                        const unsigned int &frameIndex) {
-  // FIXME AC use cached index
-  //	unsigned currentTripletIndex = src.cachedIndex();
-  // unsigned currentTripletIndex = mCachedTripletIndex; // Cached source
-  // placement, so it starts searching from there.
-  unsigned currentTripletIndex = 0;
-  //  Vec3d vec = listeningPose.vec();
-
-  //  // Rotate vector according to listener-rotation
-  //  Quatd srcRot = listeningPose.quat();
-  //  vec = srcRot.rotate(vec).normalize();
+void Vbap::prepare(AudioIOData &io) { mSlots.nextBlock(); }
 
-  //  // now transform to audio positions
-  //  vec = Vec3d(vec.x, vec.z, vec.y);
+int Vbap::findSourceTriplet(const Vec3d &vec, uint64_t id, Vec3d &gains) {
+  bool isNew;
+  int slot = mSlots.find(id, isNew);
+  if (slot < 0) {
+    return findTriplet(vec, gains);
+  }
+  int tripletIndex =
+      findTriplet(vec, gains, isNew ? -1 : mSlotTriplets[slot]);
+  mSlotTriplets[slot] = tripletIndex;
+  return tripletIndex;
+}
 
-  Vec3d vec = Vec3d(pos.x, -pos.z, pos.y);
-  // Silent by default
-  Vec3d gains;
-  //	Vec3d gainsTemp;
-
-  // Search thru the triplets array in search of a match for the source
-  // position.
-  for (size_t count = 0; count < mTriplets.size(); ++count) {
-    gains = computeGains(vec, mTriplets[currentTripletIndex]);
-    if ((gains[0] >= 0) && (gains[1] >= 0) && (!mIs3D || (gains[2] >= 0))) {
-      gains.normalize();
-      break;
+void Vbap::renderTriplet(AudioIOData &io, int tripletIndex, const Vec3d &gains,
+                         const float *samples,
+                         const unsigned int &numFrames) {
+  for (unsigned int o = mOutputOffsets[tripletIndex];
+       o < mOutputOffsets[tripletIndex + 1]; o++) {
+    const VertexOutput &output = mVertexOutputs[o];
+    float gain = float(gains[output.vertex]);
+    if (output.phantom) {
+      gain *= output.scale;
+      gain *= gain;
     }
-
-    ++currentTripletIndex;
-    if (currentTripletIndex >= mTriplets.size()) {
-      currentTripletIndex = 0;
+    float *out = io.outBuffer(output.channel);
+    for (unsigned int i = 0; i < numFrames; ++i) {
+      out[i] += gain * samples[i];
     }
   }
+}
 
-  SpeakerTriple triple = mTriplets[currentTripletIndex];
-
-  // mCachedTripletIndex = currentTripletIndex; // Store the new index
-  // FIXME stored cached index
-  //	src.cachedIndex(currentTripletIndex);
+void Vbap::renderBuffer(AudioIOData &io, const Vec3f &pos, const float *samples,
+                        const unsigned int &numFrames) {
+  renderBuffers(io, &pos, &samples, 1, numFrames);
+}
 
-  // Check if any of the triplets are phantom channels and
-  // reassign signal
-  auto it1 = mPhantomChannels.find(triple.s1Chan);
-  auto it2 = mPhantomChannels.find(triple.s2Chan);
-  // auto it3 = mPhantomChannels.find(triple.s3Chan);
+void Vbap::renderBuffers(AudioIOData &io, const Vec3f *positions,
+                         const float *const *samples,
+                         const unsigned int &numSources,
+                         const unsigned int &numFrames,
+                         const uint64_t *sourceIds) {
+  for (unsigned int s = 0; s < numSources; ++s) {
+    // Transform vector to audio space
+    const Vec3f &pos = positions[s];
+    Vec3d vec = Vec3d(pos.x, -pos.z, pos.y);
+
+    // Silent if no triplet found
+    Vec3d gains;
+    int tripletIndex = findSourceTriplet(
+        vec, sourceIds ? sourceIds[s] : NO_SOURCE_ID, gains);
+    if (tripletIndex >= 0) {
+      renderTriplet(io, tripletIndex, gains, samples[s], numFrames);
+    }
+  }
+}
 
-  if (it1 != mPhantomChannels.end()) { // vertex 1 is phantom
-    float splitGain = gains[0] * gains[0] / 2.0;
-    io.out(triple.s1Chan, frameIndex) = 0.0;
-    io.out(triple.s2Chan, frameIndex) += sample * splitGain;
-    io.out(triple.s3Chan, frameIndex) += sample * splitGain;
-  } else {
-    io.out(triple.s1Chan, frameIndex) += sample * gains[0];
+void Vbap::outputGains(const Vec3f &pos, std::vector<unsigned int> &channels,
+                       std::vector<float> &gains, uint64_t id) {
+  channels.clear();
+  gains.clear();
+  Vec3d vec = Vec3d(pos.x, -pos.z, pos.y);
+  Vec3d vertexGains;
+  int tripletIndex = findSourceTriplet(vec, id, vertexGains);
+  if (tripletIndex < 0) {
+    return;
   }
-  if (it2 != mPhantomChannels.end()) { // vertex 2 is phantom
-    float splitGain = gains[1] * gains[1] / 2.0;
-    io.out(triple.s1Chan, frameIndex) += sample * splitGain;
-    io.out(triple.s2Chan, frameIndex) = 0.0;
-    io.out(triple.s3Chan, frameIndex) += sample * splitGain;
-  } else {
-    io.out(triple.s2Chan, frameIndex) += sample * gains[1];
+  for (unsigned int o = mOutputOffsets[tripletIndex];
+       o < mOutputOffsets[tripletIndex + 1]; o++) {
+    const VertexOutput &output = mVertexOutputs[o];
+    float gain = float(vertexGains[output.vertex]);
+    if (output.phantom) {
+      gain *= output.scale;
+      gain *= gain;
+    }
+    channels.push_back(output.channel);
+    gains.push_back(gain);
   }
-  if (mIs3D) {
-    if (it2 != mPhantomChannels.end()) {
-      float splitGain = gains[2] * gains[2] / 2.0;
-      io.out(triple.s1Chan, frameIndex) += sample * splitGain;
-      io.out(triple.s2Chan, frameIndex) += sample * splitGain;
-      io.out(triple.s3Chan, frameIndex) = 0.0;
-    } else {
-      io.out(triple.s3Chan, frameIndex) += sample * gains[2];
+}
+
+void Vbap::renderSample(AudioIOData &io, const Vec3f &pos, const float &sample,
+                        const unsigned int &frameIndex) {
+  Vec3d vec = Vec3d(pos.x, -pos.z, pos.y);
+  Vec3d gains;
+  int tripletIndex = findTriplet(vec, gains);
+  if (tripletIndex < 0) {
+    return;
+  }
+  for (unsigned int o = mOutputOffsets[tripletIndex];
+       o < mOutputOffsets[tripletIndex + 1]; o++) {
+    const VertexOutput &output = mVertexOutputs[o];
+    float gain = float(gains[output.vertex]);
+    if (output.phantom) {
+      gain *= output.scale;
+      gain *= gain;
     }
+    io.out(output.channel, frameIndex) += gain * sample;
   }
 }
 
@@ -569,6 +670,8 @@ void Vbap::makeTriple(int s1, int s2, int s3) {
   triple.s3 = s3;
   triple.loadVectors(mSpeakers);
   addTriple(triple);
+  mLookupValid = false;
+  buildVertexOutputs();
 }
 
 void Vbap::compile() {
@@ -585,6 +688,11 @@ void Vbap::compile() {
     printf("No SpeakerSets found. Check mode setting or speaker layout.\n");
     throw -1;
   }
+
+  buildLookupTable();
+  buildVertexOutputs();
+  mSlots.configure(mMaxCachedSources);
+  mSlotTriplets.assign(mMaxCachedSources, -1);
 }
 
 std::vector<SpeakerTriple> Vbap::triplets() const { return mTriplets; }
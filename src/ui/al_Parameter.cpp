@@ -1,6 +1,7 @@
 
 #include "al/ui/al_Parameter.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <regex>
@@ -10,18 +11,52 @@
 
 using namespace al;
 
+// ParameterDispatcher --------------------------------------------------------
+size_t ParameterDispatcher::process() {
+  {
+    std::unique_lock<std::mutex> lk(mLock);
+    mProcessing.swap(mPending);
+  }
+  // Callbacks may set parameters, which queue them for the next call
+  size_t delivered = 0;
+  for (auto *parameter : mProcessing) {
+    if (parameter->processChange()) {
+      delivered++;
+    }
+  }
+  mProcessing.clear();
+  mDelivered += delivered;
+  return delivered;
+}
+
+size_t ParameterDispatcher::pending() {
+  std::unique_lock<std::mutex> lk(mLock);
+  return mPending.size();
+}
+
+void ParameterDispatcher::enqueue(ParameterMeta *parameter) {
+  std::unique_lock<std::mutex> lk(mLock);
+  mPending.push_back(parameter);
+}
+
+void ParameterDispatcher::remove(ParameterMeta *parameter) {
+  std::unique_lock<std::mutex> lk(mLock);
+  mPending.erase(std::remove(mPending.begin(), mPending.end(), parameter),
+                 mPending.end());
+}
+
 // Parameter ------------------------------------------------------------------
 Parameter::Parameter(std::string parameterName, std::string group,
                      float defaultValue, float min, float max)
     : ParameterWrapper<float>(parameterName, group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
 Parameter::Parameter(std::string parameterName, float defaultValue, float min,
                      float max)
     : ParameterWrapper<float>(parameterName, "", defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -29,11 +64,11 @@ Parameter::Parameter(std::string parameterName, std::string Group,
                      float defaultValue, std::string prefix, float min,
                      float max)
     : ParameterWrapper<float>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
-float Parameter::get() { return mValue; }
+float Parameter::get() { return mValue.load(); }
 
 void Parameter::setNoCalls(float value, void *blockReceiver) {
   if (value > mMax)
@@ -47,7 +82,7 @@ void Parameter::setNoCalls(float value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -61,7 +96,7 @@ void Parameter::set(float value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterInt
@@ -69,7 +104,7 @@ void Parameter::set(float value, ValueSource *src) {
 ParameterInt::ParameterInt(std::string parameterName, std::string Group,
                            int32_t defaultValue, int32_t min, int32_t max)
     : ParameterWrapper<int32_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -77,7 +112,7 @@ ParameterInt::ParameterInt(std::string parameterName, std::string Group,
                            int32_t defaultValue, std::string /*prefix*/,
                            int32_t min, int32_t max)
     : ParameterWrapper<int32_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -95,7 +130,7 @@ void ParameterInt::setNoCalls(int32_t value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -109,7 +144,7 @@ void ParameterInt::set(int32_t value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterInt8
@@ -117,7 +152,7 @@ void ParameterInt::set(int32_t value, ValueSource *src) {
 ParameterInt8::ParameterInt8(std::string parameterName, std::string Group,
                              int8_t defaultValue, int8_t min, int8_t max)
     : ParameterWrapper<int8_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -133,7 +168,7 @@ void ParameterInt8::setNoCalls(int8_t value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -147,7 +182,7 @@ void ParameterInt8::set(int8_t value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterInt16
@@ -155,7 +190,7 @@ void ParameterInt8::set(int8_t value, ValueSource *src) {
 ParameterInt16::ParameterInt16(std::string parameterName, std::string Group,
                                int16_t defaultValue, int16_t min, int16_t max)
     : ParameterWrapper<int16_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -171,7 +206,7 @@ void ParameterInt16::setNoCalls(int16_t value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -185,7 +220,7 @@ void ParameterInt16::set(int16_t value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterInt64
@@ -193,7 +228,7 @@ void ParameterInt16::set(int16_t value, ValueSource *src) {
 ParameterInt64::ParameterInt64(std::string parameterName, std::string Group,
                                int64_t defaultValue, int64_t min, int64_t max)
     : ParameterWrapper<int64_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -209,7 +244,7 @@ void ParameterInt64::setNoCalls(int64_t value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -223,7 +258,7 @@ void ParameterInt64::set(int64_t value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterUInt8
@@ -231,7 +266,7 @@ void ParameterInt64::set(int64_t value, ValueSource *src) {
 ParameterUInt8::ParameterUInt8(std::string parameterName, std::string Group,
                                uint8_t defaultValue, uint8_t min, uint8_t max)
     : ParameterWrapper<uint8_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -247,7 +282,7 @@ void ParameterUInt8::setNoCalls(uint8_t value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -261,7 +296,7 @@ void ParameterUInt8::set(uint8_t value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterUInt16
@@ -270,7 +305,7 @@ ParameterUInt16::ParameterUInt16(std::string parameterName, std::string Group,
                                  uint16_t defaultValue, uint16_t min,
                                  uint16_t max)
     : ParameterWrapper<uint16_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -286,7 +321,7 @@ void ParameterUInt16::setNoCalls(uint16_t value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -300,7 +335,7 @@ void ParameterUInt16::set(uint16_t value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterUInt32
@@ -309,7 +344,7 @@ ParameterUInt32::ParameterUInt32(std::string parameterName, std::string Group,
                                  uint32_t defaultValue, uint32_t min,
                                  uint32_t max)
     : ParameterWrapper<uint32_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -325,7 +360,7 @@ void ParameterUInt32::setNoCalls(uint32_t value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -339,7 +374,7 @@ void ParameterUInt32::set(uint32_t value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterUInt64
@@ -348,7 +383,7 @@ ParameterUInt64::ParameterUInt64(std::string parameterName, std::string Group,
                                  uint64_t defaultValue, uint64_t min,
                                  uint64_t max)
     : ParameterWrapper<uint64_t>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -364,7 +399,7 @@ void ParameterUInt64::setNoCalls(uint64_t value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -378,7 +413,7 @@ void ParameterUInt64::set(uint64_t value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterDouble
@@ -386,7 +421,7 @@ void ParameterUInt64::set(uint64_t value, ValueSource *src) {
 ParameterDouble::ParameterDouble(std::string parameterName, std::string Group,
                                  double defaultValue, double min, double max)
     : ParameterWrapper<double>(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
@@ -402,7 +437,7 @@ void ParameterDouble::setNoCalls(double value, void *blockReceiver) {
     runChangeCallbacksSynchronous(value, nullptr);
   }
 
-  mValue = value;
+  mValue.store(value);
   mChanged = true;
 }
 
@@ -416,7 +451,7 @@ void ParameterDouble::set(double value, ValueSource *src) {
   }
 
   runChangeCallbacksSynchronous(value, src);
-  mValue = value;
+  mValue.store(value);
 }
 
 // ParameterBool
@@ -424,7 +459,7 @@ void ParameterDouble::set(double value, ValueSource *src) {
 ParameterBool::ParameterBool(std::string parameterName, std::string Group,
                              float defaultValue, float min, float max)
     : Parameter(parameterName, Group, defaultValue, min, max) {
-  mValue = defaultValue;
+  mValue.store(defaultValue);
   setDefault(defaultValue);
 }
 
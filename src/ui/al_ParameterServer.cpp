@@ -1,157 +1,336 @@
 
 #include "al/ui/al_ParameterServer.hpp"
-#include "al/io/al_Socket.hpp"
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <cstring>
+#include <unordered_set>
 
 constexpr int handshakeServerPort = 16987;
 constexpr int listenerFirstPort = 14000;
 
 using namespace al;
 
+namespace {
+
+typedef ParameterServer::MessageHandler MessageHandler;
+
+// Sizes of the parts of an encoded OSC message, which are padded to 4 bytes
+size_t oscPadded(size_t size) { return (size + 3) & ~size_t(3); }
+
+template <class T> size_t oscArgSize(const T &) {
+  return sizeof(T) > 4 ? 8 : 4;
+}
+
+size_t oscArgSize(const std::string &v) { return oscPadded(v.size() + 1); }
+
+template <class... Args>
+size_t oscMessageSize(const std::string &address, const Args &... args) {
+  // Address, then ',' and a type tag for each argument
+  size_t size = oscPadded(address.size() + 1) + oscPadded(sizeof...(Args) + 2);
+  const size_t argSizes[] = {size_t(0), oscArgSize(args)...};
+  for (size_t argSize : argSizes) {
+    size += argSize;
+  }
+  return size;
+}
+
+// Message handlers for each parameter type. The parameter is known to be of
+// the type at registration
+template <class ParameterType>
+bool setFloat(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "f") {
+    return false;
+  }
+  float value;
+  m >> value;
+  static_cast<ParameterType *>(param)->set(value, src);
+  return true;
+}
+
+template <class ParameterType>
+bool setInt(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "i") {
+    return false;
+  }
+  int32_t value;
+  m >> value;
+  static_cast<ParameterType *>(param)->set(value, src);
+  return true;
+}
+
+bool setString(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "s") {
+    return false;
+  }
+  std::string value;
+  m >> value;
+  static_cast<ParameterString *>(param)->set(value, src);
+  return true;
+}
+
+bool setPose(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "fffffff") {
+    return false;
+  }
+  float x, y, z, w, qx, qy, qz;
+  m >> x >> y >> z >> w >> qx >> qy >> qz;
+  static_cast<ParameterPose *>(param)->set(
+      Pose(Vec3d(x, y, z), Quatd(w, qx, qy, qz)), src);
+  return true;
+}
+
+bool setPosePos(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "fff") {
+    return false;
+  }
+  float x, y, z;
+  m >> x >> y >> z;
+  ParameterPose *p = static_cast<ParameterPose *>(param);
+  Pose currentPose = p->get();
+  currentPose.pos() = Vec3d(x, y, z);
+  p->set(currentPose, src);
+  return true;
+}
+
+template <int component>
+bool setPoseComponent(ParameterMeta *param, osc::Message &m,
+                      ValueSource *src) {
+  if (m.typeTags() != "f") {
+    return false;
+  }
+  float value;
+  m >> value;
+  ParameterPose *p = static_cast<ParameterPose *>(param);
+  Pose currentPose = p->get();
+  currentPose.pos()[component] = value;
+  p->set(currentPose, src);
+  return true;
+}
+
+bool setVec3(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "fff") {
+    return false;
+  }
+  float x, y, z;
+  m >> x >> y >> z;
+  static_cast<ParameterVec3 *>(param)->set(Vec3f(x, y, z), src);
+  return true;
+}
+
+bool setVec4(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "ffff") {
+    return false;
+  }
+  float a, b, c, d;
+  m >> a >> b >> c >> d;
+  static_cast<ParameterVec4 *>(param)->set(Vec4f(a, b, c, d), src);
+  return true;
+}
+
+bool setVec5(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "fffff") {
+    return false;
+  }
+  float a, b, c, d, e;
+  m >> a >> b >> c >> d >> e;
+  static_cast<ParameterVec5 *>(param)->set(Vec5f(a, b, c, d, e), src);
+  return true;
+}
+
+bool setColor(ParameterMeta *param, osc::Message &m, ValueSource *src) {
+  if (m.typeTags() != "ffff") {
+    return false;
+  }
+  float a, b, c, d;
+  m >> a >> b >> c >> d;
+  static_cast<ParameterColor *>(param)->set(Color(a, b, c, d), src);
+  return true;
+}
+
+bool setTrigger(ParameterMeta *param, osc::Message &m, ValueSource * /*src*/) {
+  Trigger *p = static_cast<Trigger *>(param);
+  if (m.typeTags().size() == 0) {
+    p->trigger();
+    return true;
+  } else if (m.typeTags() == "f") {
+    float value;
+    m >> value;
+    if (value == 1.0) {
+      p->trigger();
+    }
+    return true;
+  }
+  return false;
+}
+
+// Address suffixes a parameter handles, relative to its full address
+struct AddressSuffix {
+  const char *suffix;
+  MessageHandler handler;
+};
+
+const AddressSuffix kBoolHandlers[] = {{"", setFloat<ParameterBool>}};
+const AddressSuffix kFloatHandlers[] = {{"", setFloat<Parameter>}};
+const AddressSuffix kIntHandlers[] = {{"", setInt<ParameterInt>}};
+const AddressSuffix kStringHandlers[] = {{"", setString}};
+const AddressSuffix kPoseHandlers[] = {{"", setPose},
+                                       {"/pos", setPosePos},
+                                       {"/pos/x", setPoseComponent<0>},
+                                       {"/pos/y", setPoseComponent<1>},
+                                       {"/pos/z", setPoseComponent<2>}};
+const AddressSuffix kMenuHandlers[] = {{"", setInt<ParameterMenu>}};
+const AddressSuffix kChoiceHandlers[] = {{"", setInt<ParameterChoice>}};
+const AddressSuffix kVec3Handlers[] = {{"", setVec3}};
+const AddressSuffix kVec4Handlers[] = {{"", setVec4}};
+const AddressSuffix kVec5Handlers[] = {{"", setVec5}};
+const AddressSuffix kColorHandlers[] = {{"", setColor}};
+const AddressSuffix kTriggerHandlers[] = {{"", setTrigger}};
+
+template <size_t N>
+const AddressSuffix *handlers(const AddressSuffix (&table)[N], size_t &count) {
+  count = N;
+  return table;
+}
+
+// Returns nullptr for unsupported types
+const AddressSuffix *messageHandlers(ParameterMeta *param, size_t &count) {
+  const std::type_info &type = typeid(*param);
+  if (type == typeid(ParameterBool)) {
+    return handlers(kBoolHandlers, count);
+  } else if (type == typeid(Parameter)) {
+    return handlers(kFloatHandlers, count);
+  } else if (type == typeid(ParameterInt)) {
+    return handlers(kIntHandlers, count);
+  } else if (type == typeid(ParameterString)) {
+    return handlers(kStringHandlers, count);
+  } else if (type == typeid(ParameterPose)) {
+    return handlers(kPoseHandlers, count);
+  } else if (type == typeid(ParameterMenu)) {
+    return handlers(kMenuHandlers, count);
+  } else if (type == typeid(ParameterChoice)) {
+    return handlers(kChoiceHandlers, count);
+  } else if (type == typeid(ParameterVec3)) {
+    return handlers(kVec3Handlers, count);
+  } else if (type == typeid(ParameterVec4)) {
+    return handlers(kVec4Handlers, count);
+  } else if (type == typeid(ParameterVec5)) {
+    return handlers(kVec5Handlers, count);
+  } else if (type == typeid(ParameterColor)) {
+    return handlers(kColorHandlers, count);
+  } else if (type == typeid(Trigger)) {
+    return handlers(kTriggerHandlers, count);
+  }
+  count = 0;
+  return nullptr;
+}
+
+} // namespace
+
 // OSCNotifier implementation -------------------------------------------------
 
 OSCNotifier::OSCNotifier() { mHandshakeHandler.notifier = this; }
 
 OSCNotifier::~OSCNotifier() {
+  stopBatching();
   for (osc::Send *sender : mOSCSenders) {
     delete sender;
   }
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, float value,
-                                  ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+bool OSCNotifier::shouldNotify(size_t index, ValueSource *src) {
+  const std::string &ip = mSenderIps[index];
+  return !src || (src->port == 0 && src->ipAddr != ip) ||
+         (src->port != mOSCSenders[index]->port() && src->ipAddr != ip);
+}
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value);
+template <class... Args>
+void OSCNotifier::notify(const std::string &OSCaddress, ValueSource *src,
+                         const Args &... args) {
+  std::unique_lock<std::mutex> lk(mListenerLock);
+  if (!mBatching) {
+    for (size_t i = 0; i < mOSCSenders.size(); i++) {
+      if (shouldNotify(i, src)) {
+        mOSCSenders[i]->send(OSCaddress, args...);
+      }
     }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
+    return;
+  }
+  // Encode once and queue a copy for each listener. The encoder needs some
+  // room past the message itself
+  const size_t needed = oscMessageSize(OSCaddress, args...) + 64;
+  if (needed > mScratchSize) {
+    mScratchSize = std::max(needed, size_t(8192));
+    mScratch.reset(new osc::Packet(int(mScratchSize)));
+  }
+  mScratch->clear();
+  mScratch->addMessage(OSCaddress, args...);
+  const uint32_t size = uint32_t(mScratch->size());
+  if (size == 0) {
+    return;
+  }
+  const char sizeBytes[4] = {char(size >> 24), char(size >> 16),
+                             char(size >> 8), char(size)};
+  bool full = false;
+  for (size_t i = 0; i < mOSCSenders.size(); i++) {
+    if (shouldNotify(i, src)) {
+      std::vector<char> &pending = mPending[i];
+      pending.insert(pending.end(), sizeBytes, sizeBytes + 4);
+      pending.insert(pending.end(), mScratch->data(), mScratch->data() + size);
+      full |= pending.size() >= mMaxPacketSize;
+      if (pending.size() > mCoalesceSize[i]) {
+        // The flush thread is falling behind
+        coalesce(i);
+      }
+    }
+  }
+  if (full && !mFlushRequested) {
+    mFlushRequested = true;
+    mFlushCondition.notify_one();
   }
-  mListenerLock.unlock();
 }
 
-void OSCNotifier::notifyListeners(std::string OSCaddress, int value,
+void OSCNotifier::notifyListeners(std::string OSCaddress, float value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
+  notify(OSCaddress, src, value);
+}
 
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value);
-    }
-    //        std::cout << "Notifying " << sender->address() << ":" <<
-    //        sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+void OSCNotifier::notifyListeners(std::string OSCaddress, int value,
+                                  ValueSource *src) {
+  notify(OSCaddress, src, value);
 }
 
 void OSCNotifier::notifyListeners(std::string OSCaddress, std::string value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
-
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value);
-    }
-    //    std::cout << "Notifying " << sender->address() << ":" <<
-    //    sender->port()
-    //              << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+  notify(OSCaddress, src, value);
 }
 
 void OSCNotifier::notifyListeners(std::string OSCaddress, Vec3f value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
-
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value[0], value[1], value[2]);
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+  notify(OSCaddress, src, value[0], value[1], value[2]);
 }
 
 void OSCNotifier::notifyListeners(std::string OSCaddress, Vec4f value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
-
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value[0], value[1], value[2], value[3]);
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+  notify(OSCaddress, src, value[0], value[1], value[2], value[3]);
 }
 
 void OSCNotifier::notifyListeners(std::string OSCaddress, Vec5f value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
-
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, value[0], value[1], value[2], value[3],
-                   value[4]);
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+  notify(OSCaddress, src, value[0], value[1], value[2], value[3], value[4]);
 }
 
 void OSCNotifier::notifyListeners(std::string OSCaddress, Pose value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
-
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, (float)value.pos()[0], (float)value.pos()[1],
-                   (float)value.pos()[2], (float)value.quat().w,
-                   (float)value.quat().x, (float)value.quat().y,
-                   (float)value.quat().z);
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+  notify(OSCaddress, src, (float)value.pos()[0], (float)value.pos()[1],
+         (float)value.pos()[2], (float)value.quat().w, (float)value.quat().x,
+         (float)value.quat().y, (float)value.quat().z);
 }
 
 void OSCNotifier::notifyListeners(std::string OSCaddress, Color value,
                                   ValueSource *src) {
-  mListenerLock.lock();
-  for (osc::Send *sender : mOSCSenders) {
-    auto ip = Socket::nameToIp(sender->address());
-
-    if (!src || (src->port == 0 && src->ipAddr != ip) ||
-        (src->port != sender->port() && src->ipAddr != ip)) {
-      sender->send(OSCaddress, float(value.r), float(value.g), float(value.b));
-    }
-    //		std::cout << "Notifying " << sender->address() << ":" <<
-    // sender->port() << " -- " << OSCaddress << std::endl;
-  }
-  mListenerLock.unlock();
+  notify(OSCaddress, src, float(value.r), float(value.g), float(value.b));
 }
 
 void OSCNotifier::notifyListeners(std::string OSCaddress, ParameterMeta *param,
@@ -197,6 +376,162 @@ void OSCNotifier::notifyListeners(std::string OSCaddress, ParameterMeta *param,
   }
 }
 
+void OSCNotifier::startBatching(double intervalSeconds, size_t maxPacketSize,
+                                size_t maxQueueSize) {
+  stopBatching();
+  std::unique_lock<std::mutex> lk(mListenerLock);
+  mBatchInterval = intervalSeconds;
+  // Room for the bundle header and at least one small message
+  mMaxPacketSize = std::max(maxPacketSize, size_t(64));
+  mMaxQueueSize = std::max(maxQueueSize, mMaxPacketSize);
+  mCoalesceSize.assign(mPending.size(), mMaxQueueSize);
+  mBatching = true;
+  mStopFlushing = false;
+  mFlushRequested = false;
+  mFlushThread = std::thread(&OSCNotifier::flushThread, this);
+}
+
+void OSCNotifier::stopBatching() {
+  {
+    std::unique_lock<std::mutex> lk(mListenerLock);
+    mBatching = false;
+    mStopFlushing = true;
+  }
+  mFlushCondition.notify_one();
+  if (mFlushThread.joinable()) {
+    mFlushThread.join();
+  }
+}
+
+bool OSCNotifier::isBatching() {
+  std::unique_lock<std::mutex> lk(mListenerLock);
+  return mBatching;
+}
+
+void OSCNotifier::flush() {
+  {
+    std::unique_lock<std::mutex> lk(mListenerLock);
+    mFlushRequested = true;
+  }
+  mFlushCondition.notify_one();
+}
+
+void OSCNotifier::flushThread() {
+  std::vector<std::vector<char>> messages;
+  std::vector<osc::Send *> senders;
+  std::vector<char> bundle;
+  std::unique_lock<std::mutex> lk(mListenerLock);
+  bool running = true;
+  while (running) {
+    mFlushCondition.wait_for(
+        lk, std::chrono::duration<double>(mBatchInterval),
+        [this]() { return mFlushRequested || mStopFlushing; });
+    // Last pass sends whatever is queued
+    running = !mStopFlushing;
+    mFlushRequested = false;
+    messages.resize(mPending.size());
+    for (size_t i = 0; i < mPending.size(); i++) {
+      messages[i].clear();
+      messages[i].swap(mPending[i]);
+      mCoalesceSize[i] = mMaxQueueSize;
+    }
+    senders = mOSCSenders;
+    // Send without blocking notifications. Listeners are never removed, so
+    // the senders stay valid
+    lk.unlock();
+    for (size_t i = 0; i < senders.size() && i < messages.size(); i++) {
+      if (messages[i].size() > 0) {
+        sendBundles(*senders[i], messages[i], bundle);
+      }
+    }
+    lk.lock();
+  }
+}
+
+void OSCNotifier::sendBundles(osc::Send &sender,
+                              const std::vector<char> &messages,
+                              std::vector<char> &bundle) {
+  // "#bundle", then the time tag 1 meaning "immediately"
+  static const char header[16] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0,
+                                  0,   0,   0,   0,   0,   0,   0,   1};
+  auto sendBundle = [&]() {
+    if (bundle.size() > sizeof(header)) {
+      sender.sendRaw(bundle.data(), bundle.size());
+      mPacketsSent++;
+    }
+    bundle.assign(header, header + sizeof(header));
+  };
+
+  bundle.assign(header, header + sizeof(header));
+  size_t offset = 0;
+  while (offset + 4 <= messages.size()) {
+    const unsigned char *sizeBytes =
+        reinterpret_cast<const unsigned char *>(&messages[offset]);
+    const size_t size = (size_t(sizeBytes[0]) << 24) |
+                        (size_t(sizeBytes[1]) << 16) |
+                        (size_t(sizeBytes[2]) << 8) | size_t(sizeBytes[3]);
+    const size_t elementSize = 4 + size;
+    if (bundle.size() + elementSize > mMaxPacketSize) {
+      sendBundle();
+      if (sizeof(header) + elementSize > mMaxPacketSize) {
+        // Doesn't fit in a bundle, send the message on its own
+        sender.sendRaw(&messages[offset + 4], size);
+        mPacketsSent++;
+        mMessagesSent++;
+        offset += elementSize;
+        continue;
+      }
+    }
+    bundle.insert(bundle.end(), messages.begin() + offset,
+                  messages.begin() + offset + elementSize);
+    mMessagesSent++;
+    offset += elementSize;
+  }
+  sendBundle();
+}
+
+void OSCNotifier::coalesce(size_t index) {
+  std::vector<char> &pending = mPending[index];
+  struct Entry {
+    size_t offset;
+    size_t size;
+    bool keep;
+  };
+  std::vector<Entry> entries;
+  size_t offset = 0;
+  while (offset + 4 <= pending.size()) {
+    const unsigned char *sizeBytes =
+        reinterpret_cast<const unsigned char *>(&pending[offset]);
+    const size_t size = (size_t(sizeBytes[0]) << 24) |
+                        (size_t(sizeBytes[1]) << 16) |
+                        (size_t(sizeBytes[2]) << 8) | size_t(sizeBytes[3]);
+    entries.push_back({offset, 4 + size, false});
+    offset += 4 + size;
+  }
+  // The newest message for an address replaces the older ones. Messages
+  // always start with their null terminated address
+  std::unordered_set<std::string> addresses;
+  for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+    const char *address = &pending[it->offset + 4];
+    it->keep =
+        addresses.insert(std::string(address, strnlen(address, it->size - 4)))
+            .second;
+  }
+  size_t end = 0;
+  for (const Entry &entry : entries) {
+    if (entry.keep) {
+      std::memmove(&pending[end], &pending[entry.offset], entry.size);
+      end += entry.size;
+    } else {
+      mMessagesCoalesced++;
+    }
+  }
+  pending.resize(end);
+  // Wait for the queue to double before coalescing again if there are many
+  // addresses
+  mCoalesceSize[index] = std::max(mMaxQueueSize, 2 * end);
+}
+
 void OSCNotifier::startHandshakeServer(std::string address) {
   if (mHandshakeServer.open(handshakeServerPort, address.c_str())) {
     mHandshakeServer.handler(mHandshakeHandler);
@@ -275,6 +610,7 @@ bool ParameterServer::listen(int oscPort, std::string address) {
 ParameterServer &ParameterServer::registerParameter(ParameterMeta &param) {
   mParameterLock.lock();
   mParameters.push_back(&param);
+  mAddressIndexValid = false;
   mParameterLock.unlock();
   mListenerLock.lock();
   if (ParameterBool *p =
@@ -352,11 +688,16 @@ ParameterServer &ParameterServer::registerParameter(ParameterMeta &param) {
 
 ParameterServer &
 ParameterServer::registerParameterBundle(ParameterBundle &bundle) {
-  if (mCurrentActiveBundle.find(bundle.name()) == mCurrentActiveBundle.end()) {
-    mParameterBundles[bundle.name()] = std::vector<ParameterBundle *>();
-    mCurrentActiveBundle[bundle.name()] = 0;
+  {
+    std::unique_lock<std::mutex> lk(mParameterLock);
+    if (mCurrentActiveBundle.find(bundle.name()) ==
+        mCurrentActiveBundle.end()) {
+      mParameterBundles[bundle.name()] = std::vector<ParameterBundle *>();
+      mCurrentActiveBundle[bundle.name()] = 0;
+    }
+    mParameterBundles[bundle.name()].push_back(&bundle);
+    mAddressIndexValid = false;
   }
-  mParameterBundles[bundle.name()].push_back(&bundle);
   bundle.addNotifier(this);
 
   return *this;
@@ -364,12 +705,52 @@ ParameterServer::registerParameterBundle(ParameterBundle &bundle) {
 
 void ParameterServer::unregisterParameter(ParameterMeta &param) {
   std::unique_lock<std::mutex> lk(mParameterLock);
-  auto it = mParameters.begin();
-  for (it = mParameters.begin(); it != mParameters.end(); it++) {
-    if (*it == &param) {
-      mParameters.erase(it);
+  mParameters.erase(
+      std::remove(mParameters.begin(), mParameters.end(), &param),
+      mParameters.end());
+  mAddressIndexValid = false;
+}
+
+void ParameterServer::indexParameter(ParameterMeta *param,
+                                     const std::string &prefix) {
+  size_t count;
+  const AddressSuffix *suffixes = messageHandlers(param, count);
+  if (!suffixes) {
+    std::cout << "Unsupported registered Parameter on message "
+              << typeid(*param).name() << std::endl;
+    return;
+  }
+  const std::string address = prefix + param->getFullAddress();
+  for (size_t i = 0; i < count; i++) {
+    mAddressIndex[address + suffixes[i].suffix].push_back(
+        {param, suffixes[i].handler});
+  }
+}
+
+void ParameterServer::indexBundle(ParameterBundle *bundle) {
+  const std::string prefix = bundle->bundlePrefix();
+  for (ParameterMeta *p : bundle->parameters()) {
+    indexParameter(p, prefix);
+  }
+  for (const auto &subBundleGroup : bundle->bundles()) {
+    for (ParameterBundle *subBundle : subBundleGroup.second) {
+      indexBundle(subBundle);
+    }
+  }
+}
+
+void ParameterServer::buildAddressIndex() {
+  mAddressIndex.clear();
+  mIndexedBundleVersion = ParameterBundle::structureVersion();
+  for (ParameterMeta *param : mParameters) {
+    indexParameter(param, "");
+  }
+  for (const auto &bundleGroup : mParameterBundles) {
+    for (ParameterBundle *bundle : bundleGroup.second) {
+      indexBundle(bundle);
     }
   }
+  mAddressIndexValid = true;
 }
 
 void ParameterServer::onMessage(osc::Message &m) {
@@ -378,15 +759,18 @@ void ParameterServer::onMessage(osc::Message &m) {
     m.print();
   }
   mParameterLock.lock();
-  for (ParameterMeta *param : mParameters) {
-    if (setParameterValueFromMessage(param, m.addressPattern(), m)) {
+  if (!mAddressIndexValid ||
+      mIndexedBundleVersion != ParameterBundle::structureVersion()) {
+    buildAddressIndex();
+  }
+  auto handlers = mAddressIndex.find(m.addressPattern());
+  if (handlers != mAddressIndex.end()) {
+    ValueSource s{m.senderAddress(), m.senderPort()};
+    for (const AddressHandler &handler : handlers->second) {
       m.resetStream();
+      handler.handler(handler.parameter, m, &s);
     }
   }
-  for (auto &bundleGroup : mParameterBundles) {
-    auto oscAddress = m.addressPattern();
-    setValuesForBundleGroup(m, bundleGroup.second, oscAddress);
-  }
 
   // FIXME these handlers should not be kept by ParameterServer, but should be
   // set for the Recv object.
@@ -634,171 +1018,23 @@ void ParameterServer::changePoseCallback(Pose value, void *sender,
 bool ParameterServer::setParameterValueFromMessage(ParameterMeta *param,
                                                    std::string address,
                                                    osc::Message &m) {
-
-  ValueSource s{m.senderAddress(), m.senderPort()};
-  if (strcmp(typeid(*param).name(), typeid(ParameterBool).name()) ==
-      0) { // ParameterBool
-    ParameterBool *p = dynamic_cast<ParameterBool *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "f") {
-      float val;
-      m >> val;
-      // Extract the data out of the packet
-      p->set(val, &s);
-      // std::cout << "ParameterServer::onMessage" << val << std::endl;
-      return true;
-    }
-    // notifyListeners(p->getFullAddress(), p->get());
-  } else if (strcmp(typeid(*param).name(), typeid(Parameter).name()) ==
-             0) { // Parameter
-    Parameter *p = dynamic_cast<Parameter *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "f") {
-      float val;
-      m >> val;
-      // Extract the data out of the packet
-      p->set(val, &s);
-      // std::cout << "ParameterServer::onMessage" << val << std::endl;
-      return true;
-    }
-    // notifyListeners(p->getFullAddress(), p->get());
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterInt).name()) ==
-             0) { // ParameterInt
-    ParameterInt *p = dynamic_cast<ParameterInt *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "i") {
-      int32_t val;
-      m >> val;
-      // Extract the data out of the packet
-      p->set(val, &s);
-      // std::cout << "ParameterServer::onMessage" << val << std::endl;
-      return true;
-    }
-    // notifyListeners(p->getFullAddress(), p->get());
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterString).name()) ==
-             0) { // Parameter
-    ParameterString *p = dynamic_cast<ParameterString *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "s") {
-      std::string val;
-      m >> val;
-      // Extract the data out of the packet
-      p->set(val, &s);
-      // std::cout << "ParameterServer::onMessage" << val << std::endl;
-      return true;
-    }
-    // notifyListeners(p->getFullAddress(), p->get());
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterPose).name()) ==
-             0) { // ParameterPose
-    ParameterPose *p = dynamic_cast<ParameterPose *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "fffffff") {
-      float x, y, z, w, qx, qy, qz;
-      m >> x >> y >> z >> w >> qx >> qy >> qz;
-      p->set(Pose(Vec3d(x, y, z), Quatd(w, qx, qy, qz)), &s);
-      return true;
-    } else if (address == p->getFullAddress() + "/pos" &&
-               m.typeTags() == "fff") {
-      float x, y, z;
-      m >> x >> y >> z;
-      Pose currentPose = p->get();
-      currentPose.pos() = Vec3d(x, y, z);
-      p->set(currentPose, &s);
-      return true;
-    } else if (address == p->getFullAddress() + "/pos/x" &&
-               m.typeTags() == "f") {
-      float x;
-      m >> x;
-      Pose currentPose = p->get();
-      currentPose.pos().x = x;
-      p->set(currentPose, &s);
-      return true;
-    } else if (address == p->getFullAddress() + "/pos/y" &&
-               m.typeTags() == "f") {
-      float y;
-      m >> y;
-      Pose currentPose = p->get();
-      currentPose.pos().y = y;
-      p->set(currentPose, &s);
-      return true;
-    } else if (address == p->getFullAddress() + "/pos/z" &&
-               m.typeTags() == "f") {
-      float z;
-      m >> z;
-      Pose currentPose = p->get();
-      currentPose.pos().z = z;
-      p->set(currentPose, &s);
-      return true;
-    }
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterMenu).name()) ==
-             0) { // ParameterMenu
-    ParameterMenu *p = dynamic_cast<ParameterMenu *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "i") {
-      int value;
-      m >> value;
-      p->set(value, &s);
-      return true;
-    }
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterChoice).name()) ==
-             0) { // ParameterChoice
-    ParameterChoice *p = dynamic_cast<ParameterChoice *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "i") {
-      int value;
-      m >> value;
-      p->set(value, &s);
-      return true;
-    }
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterVec3).name()) ==
-             0) { // ParameterVec3
-    ParameterVec3 *p = dynamic_cast<ParameterVec3 *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "fff") {
-      float x, y, z;
-      m >> x >> y >> z;
-      p->set(Vec3f(x, y, z), &s);
-      return true;
-    }
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterVec4).name()) ==
-             0) { // ParameterVec4
-    ParameterVec4 *p = dynamic_cast<ParameterVec4 *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "ffff") {
-      float a, b, c, d;
-      m >> a >> b >> c >> d;
-      p->set(Vec4f(a, b, c, d), &s);
-    }
-    return true;
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterVec5).name()) ==
-             0) { // ParameterVec5
-    ParameterVec5 *p = dynamic_cast<ParameterVec5 *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "fffff") {
-      float a, b, c, d, e;
-      m >> a >> b >> c >> d >> e;
-      p->set(Vec5f(a, b, c, d, e), &s);
-    }
-    return true;
-  } else if (strcmp(typeid(*param).name(), typeid(ParameterColor).name()) ==
-             0) { // ParameterColor
-    ParameterColor *p = dynamic_cast<ParameterColor *>(param);
-    if (address == p->getFullAddress() && m.typeTags() == "ffff") {
-      float a, b, c, d;
-      m >> a >> b >> c >> d;
-      p->set(Color(a, b, c, d), &s);
-      return true;
-    }
-  } else if (strcmp(typeid(*param).name(), typeid(Trigger).name()) ==
-             0) { // Trigger
-    Trigger *p = dynamic_cast<Trigger *>(param);
-    if (address == p->getFullAddress()) {
-      if (m.typeTags().size() == 0) {
-        p->trigger();
-        return true;
-      } else if (m.typeTags() == "f") {
-        float val;
-        m >> val;
-        if (val == 1.0) {
-          p->trigger();
-        }
-        return true;
-      }
-    }
-  } else {
-    // TODO this check should be performed on registration
+  size_t count;
+  const AddressSuffix *suffixes = messageHandlers(param, count);
+  if (!suffixes) {
     std::cout << "Unsupported registered Parameter on message "
               << typeid(*param).name() << std::endl;
+    return false;
+  }
+  const std::string &fullAddress = param->getFullAddress();
+  for (size_t i = 0; i < count; i++) {
+    const size_t suffixLength = strlen(suffixes[i].suffix);
+    if (address.size() == fullAddress.size() + suffixLength &&
+        address.compare(0, fullAddress.size(), fullAddress) == 0 &&
+        address.compare(fullAddress.size(), suffixLength,
+                        suffixes[i].suffix) == 0) {
+      ValueSource s{m.senderAddress(), m.senderPort()};
+      return suffixes[i].handler(param, m, &s);
+    }
   }
   return false;
 }
@@ -890,28 +1126,6 @@ void ParameterServer::printBundleInfo(ParameterBundle *bundle, std::string id,
             << std::endl;
 }
 
-void ParameterServer::setValuesForBundleGroup(
-    osc::Message &m, std::vector<ParameterBundle *> bundleGroup,
-    std::string rootAddress) {
-  for (auto bundle : bundleGroup) {
-    std::string bundlePrefix = bundle->bundlePrefix();
-    if (rootAddress.compare(0, bundlePrefix.size(), bundlePrefix) == 0) {
-      for (ParameterMeta *p : bundle->parameters()) {
-        std::string subAddress = rootAddress.substr(bundlePrefix.size());
-        if (setParameterValueFromMessage(p, subAddress, m)) {
-          m.resetStream();
-          //                            std::cout << " match " <<
-          //                            p->getFullAddress() <<std::endl;
-          continue;
-        }
-      }
-      for (auto subBundleGroups : bundle->bundles()) {
-        setValuesForBundleGroup(m, {subBundleGroups.second}, rootAddress);
-      }
-    }
-  }
-}
-
 void OSCNotifier::HandshakeHandler::onMessage(osc::Message &m) {
   // These are the commands processed by the primary instance
   if (m.addressPattern() == "/handshake" && m.typeTags() == "i") {
@@ -0,0 +1,157 @@
+#include "al/ui/al_ParameterSmoother.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace al;
+
+constexpr float SmoothedValue::kEpsilon;
+
+SmoothedValue::SmoothedValue(float value, float seconds, double sampleRate,
+                             Mode mode)
+    : mMode(mode), mSampleRate(sampleRate), mSeconds(seconds),
+      mCurrent(value), mTarget(value) {
+  computePole();
+}
+
+void SmoothedValue::computePole() {
+  const double samples = mSeconds * mSampleRate;
+  // Decay by 60 dB over the smoothing time
+  mPole = samples >= 1.0 ? float(std::exp(std::log(0.001) / samples)) : 0.0f;
+}
+
+void SmoothedValue::startRamp() {
+  if (mMode != LINEAR) {
+    return;
+  }
+  mRemaining = std::max<int64_t>(1, std::llround(mSeconds * mSampleRate));
+  mIncrement = (mTarget - mCurrent) / float(mRemaining);
+}
+
+void SmoothedValue::setSampleRate(double sampleRate) {
+  mSampleRate = sampleRate;
+  computePole();
+  if (isSmoothing()) {
+    startRamp();
+  }
+}
+
+void SmoothedValue::setTime(float seconds) {
+  mSeconds = seconds;
+  computePole();
+  if (isSmoothing()) {
+    startRamp();
+  }
+}
+
+void SmoothedValue::setMode(Mode mode) {
+  mMode = mode;
+  if (isSmoothing()) {
+    startRamp();
+  }
+}
+
+void SmoothedValue::setTarget(float value) {
+  if (value == mTarget) {
+    return;
+  }
+  mTarget = value;
+  if (mSeconds * mSampleRate < 1.0) {
+    mCurrent = value;
+    return;
+  }
+  startRamp();
+}
+
+void SmoothedValue::reset(float value) {
+  mCurrent = value;
+  mTarget = value;
+  mRemaining = 0;
+}
+
+void SmoothedValue::process(float *out, int frames) {
+  int i = 0;
+  if (mCurrent != mTarget) {
+    if (mMode == LINEAR) {
+      const int n = int(std::min<int64_t>(frames, mRemaining));
+      const float start = mCurrent;
+      for (; i < n; i++) {
+        out[i] = start + float(i) * mIncrement;
+      }
+      mRemaining -= n;
+      mCurrent = mRemaining > 0 ? start + float(n) * mIncrement : mTarget;
+    } else {
+      const float target = mTarget;
+      float difference = mCurrent - target;
+      for (; i < frames; i++) {
+        out[i] = target + difference;
+        difference *= mPole;
+      }
+      mCurrent = target + difference;
+      snap();
+      return;
+    }
+  }
+  std::fill(out + i, out + frames, mCurrent);
+}
+
+void SmoothedValue::applyGain(float *buffer, int frames) {
+  int i = 0;
+  if (mCurrent != mTarget) {
+    if (mMode == LINEAR) {
+      const int n = int(std::min<int64_t>(frames, mRemaining));
+      const float start = mCurrent;
+      for (; i < n; i++) {
+        buffer[i] *= start + float(i) * mIncrement;
+      }
+      mRemaining -= n;
+      mCurrent = mRemaining > 0 ? start + float(n) * mIncrement : mTarget;
+    } else {
+      const float target = mTarget;
+      float difference = mCurrent - target;
+      for (; i < frames; i++) {
+        buffer[i] *= target + difference;
+        difference *= mPole;
+      }
+      mCurrent = target + difference;
+      snap();
+      return;
+    }
+  }
+  const float gain = mCurrent;
+  if (gain == 1.0f) {
+    return;
+  }
+  for (; i < frames; i++) {
+    buffer[i] *= gain;
+  }
+}
+
+SmoothedValue::Ramp SmoothedValue::ramp(int frames) {
+  Ramp segment{mCurrent, 0.0f};
+  if (mCurrent == mTarget || frames <= 0) {
+    return segment;
+  }
+  if (mMode == LINEAR) {
+    if (mRemaining > frames) {
+      mRemaining -= frames;
+      mCurrent += float(frames) * mIncrement;
+      segment.increment = mIncrement;
+      return segment;
+    }
+    mRemaining = 0;
+    mCurrent = mTarget;
+  } else {
+    mCurrent = mTarget + (mCurrent - mTarget) *
+                             float(std::pow(double(mPole), double(frames)));
+    snap();
+  }
+  segment.increment = (mCurrent - segment.start) / float(frames);
+  return segment;
+}
+
+ParameterSmoother::ParameterSmoother(ParameterWrapper<float> &parameter,
+                                     float seconds, double sampleRate,
+                                     Mode mode)
+    : SmoothedValue(parameter.get(), seconds, sampleRate, mode),
+      mParameter(&parameter) {}
@@ -0,0 +1,328 @@
+#include <math.h>
+
+#include <atomic>
+#include <thread>
+
+#include "al/io/al_AudioIO.hpp"
+#include "al/sound/al_Ambisonics.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+static std::vector<Vec3f> testDirections() {
+  std::vector<Vec3f> dirs;
+  for (int i = 0; i < 37; i++) {
+    float az = i * 0.61f;
+    float el = -1.5f + i * 0.083f;
+    dirs.push_back(Vec3f(cos(az) * cos(el), sin(az) * cos(el), sin(el)));
+  }
+  return dirs;
+}
+
+TEST(Ambisonics, ChannelsToOrder) {
+  EXPECT_EQ(AmbiBase::channelsToOrder(3), 1);
+  EXPECT_EQ(AmbiBase::channelsToDimensions(3), 2);
+  EXPECT_EQ(AmbiBase::channelsToOrder(4), 1);
+  EXPECT_EQ(AmbiBase::channelsToDimensions(4), 3);
+  EXPECT_EQ(AmbiBase::channelsToOrder(9), 2);
+  EXPECT_EQ(AmbiBase::channelsToDimensions(9), 3);
+  EXPECT_EQ(AmbiBase::channelsToOrder(16), 3);
+  EXPECT_EQ(AmbiBase::channelsToOrder(64), 7);
+  EXPECT_EQ(AmbiBase::channelsToDimensions(64), 3);
+  EXPECT_EQ(AmbiBase::channelsToOrder(15), 7);
+  EXPECT_EQ(AmbiBase::channelsToDimensions(15), 2);
+  EXPECT_EQ(AmbiBase::channelsToOrder(8), -1);
+  EXPECT_EQ(AmbiBase::channelsToDimensions(8), -1);
+}
+
+TEST(Ambisonics, FuMaMatchesReference) {
+  float ref[16];
+  for (int dim = 2; dim <= 3; dim++) {
+    for (int order = 0; order <= 3; order++) {
+      AmbiEncode enc(dim, order);
+      for (auto &d : testDirections()) {
+        AmbiBase::encodeWeightsFuMa(ref, dim, order, d.x, d.y, d.z);
+        enc.direction(d);
+        for (int c = 0; c < enc.channels(); c++) {
+          EXPECT_NEAR(enc.weights()[c], ref[c], 1e-5);
+        }
+      }
+    }
+  }
+}
+
+TEST(Ambisonics, FuMaHigherOrder) {
+  AmbiEncode enc(3, 5);
+  EXPECT_EQ(enc.channels(), 36);
+  // Horizontal channels first: W X Y U V P Q ...
+  EXPECT_EQ(enc.channelOrder(9), 5);
+  EXPECT_EQ(enc.channelOrder(10), 5);
+  EXPECT_EQ(enc.channelOrder(11), 1); // Z
+  int perOrder[6] = {0};
+  for (int c = 0; c < enc.channels(); c++) {
+    perOrder[enc.channelOrder(c)]++;
+  }
+  for (int l = 0; l <= 5; l++) {
+    EXPECT_EQ(perOrder[l], 2 * l + 1);
+  }
+  float maxWeight = 0;
+  for (int i = 0; i < 2000; i++) {
+    float az = i * 0.0731f;
+    float el = asin(-1.0f + i / 1000.0f);
+    enc.direction(Vec3f(cos(az) * cos(el), sin(az) * cos(el), sin(el)));
+    for (int c = 0; c < enc.channels(); c++) {
+      if (enc.channelOrder(c) > 3) {
+        maxWeight = std::max(maxWeight, std::abs(enc.weights()[c]));
+      }
+    }
+  }
+  // Max-normalized above 3rd order
+  EXPECT_LT(maxWeight, 1.0f + 1e-4f);
+  EXPECT_GT(maxWeight, 0.99f);
+}
+
+TEST(Ambisonics, AcnSn3d) {
+  AmbiEncode enc(3, 7, AmbiBase::ACN_SN3D);
+  EXPECT_EQ(enc.channels(), 64);
+  const float s3 = sqrt(3.0f);
+  for (auto &d : testDirections()) {
+    enc.direction(d);
+    const float *w = enc.weights();
+    EXPECT_NEAR(w[0], 1.0f, 1e-6);
+    EXPECT_NEAR(w[1], d.y, 1e-6);
+    EXPECT_NEAR(w[2], d.z, 1e-6);
+    EXPECT_NEAR(w[3], d.x, 1e-6);
+    EXPECT_NEAR(w[4], s3 * d.x * d.y, 1e-5);
+    EXPECT_NEAR(w[5], s3 * d.y * d.z, 1e-5);
+    EXPECT_NEAR(w[6], 0.5f * (3 * d.z * d.z - 1), 1e-5);
+    EXPECT_NEAR(w[7], s3 * d.x * d.z, 1e-5);
+    EXPECT_NEAR(w[8], 0.5f * s3 * (d.x * d.x - d.y * d.y), 1e-5);
+    // SN3D: the squared harmonics of each order sum to one
+    for (int l = 0; l <= 7; l++) {
+      float sum = 0;
+      for (int c = l * l; c < (l + 1) * (l + 1); c++) {
+        EXPECT_EQ(enc.channelOrder(c), l);
+        sum += w[c] * w[c];
+      }
+      EXPECT_NEAR(sum, 1.0f, 1e-4);
+    }
+  }
+
+  AmbiEncode enc2D(2, 7, AmbiBase::ACN_SN3D);
+  EXPECT_EQ(enc2D.channels(), 15);
+  enc2D.direction(Vec3f(cos(0.3f), sin(0.3f), 0));
+  EXPECT_NEAR(enc2D.weights()[1], sin(0.3f), 1e-6);
+  EXPECT_NEAR(enc2D.weights()[2], cos(0.3f), 1e-6);
+}
+
+TEST(Ambisonics, BatchEncode) {
+  const int numFrames = 16;
+  auto dirs = testDirections();
+  const int numSources = dirs.size();
+  std::vector<float> samples(numSources * numFrames);
+  std::vector<const float *> inputs(numSources);
+  for (int s = 0; s < numSources; s++) {
+    for (int i = 0; i < numFrames; i++) {
+      samples[s * numFrames + i] = sin(0.2f * (s + 1) * i);
+    }
+    inputs[s] = samples.data() + s * numFrames;
+  }
+
+  for (int conv = 0; conv < 2; conv++) {
+    AmbiEncode enc(3, 7, AmbiBase::Convention(conv));
+    std::vector<float> single(enc.channels() * numFrames, 0.0f);
+    std::vector<float> batch(enc.channels() * numFrames, 0.0f);
+    for (int s = 0; s < numSources; s++) {
+      enc.direction(dirs[s]);
+      enc.encode(single.data(), inputs[s], numFrames);
+    }
+    enc.encode(batch.data(), dirs.data(), inputs.data(), numSources,
+               numFrames);
+    for (size_t i = 0; i < single.size(); i++) {
+      EXPECT_NEAR(single[i], batch[i], 1e-3);
+    }
+  }
+}
+
+TEST(Ambisonics, HigherOrderDecode) {
+  Speakers sl;
+  for (int i = 0; i < 16; i++) {
+    sl.push_back(Speaker(i, i * 22.5f, 0));
+  }
+  AmbisonicsSpatializer panner(sl, 2, 7, 3);
+  panner.compile();
+
+  const int fpb = 8;
+  AudioIOData io;
+  io.framesPerBuffer(fpb);
+  io.channelsIn(0);
+  io.channelsOut(16);
+  io.zeroOut();
+
+  float samples[fpb];
+  for (int i = 0; i < fpb; i++) {
+    samples[i] = 1.0f;
+  }
+  panner.prepare(io);
+  // Source in the direction of speaker 4 (90 degrees)
+  panner.renderBuffer(io, Vec3f(0, 1, 0), samples, fpb);
+  panner.finalize(io);
+
+  int loudest = 0;
+  for (int chan = 0; chan < 16; chan++) {
+    EXPECT_TRUE(std::isfinite(io.out(chan, 0)));
+    if (io.out(chan, 0) > io.out(loudest, 0)) {
+      loudest = chan;
+    }
+  }
+  EXPECT_EQ(loudest, 4);
+  EXPECT_GT(io.out(4, 0), 4 * std::abs(io.out(12, 0)));
+}
+
+static Speakers sphereLayout(int numSpeakers) {
+  Speakers sl;
+  for (int i = 0; i < numSpeakers; i++) {
+    // Fibonacci sphere
+    float el = asin(1.0f - 2.0f * (i + 0.5f) / numSpeakers) * 57.29578f;
+    float az = fmod(i * 137.50776f, 360.0f);
+    sl.push_back(Speaker(i, az, el));
+  }
+  return sl;
+}
+
+TEST(Ambisonics, DecodeMatchesReference) {
+  const int numSpeakers = 61;
+  const int numFrames = 100; // not a multiple of the tile size
+  Speakers sl = sphereLayout(numSpeakers);
+  for (int order = 1; order <= 7; order++) {
+    AmbiDecode dec(3, order, numSpeakers, 3);
+    dec.setSpeakers(sl);
+    const int numChannels = dec.channels();
+    std::vector<float> ambi(numChannels * numFrames);
+    for (size_t i = 0; i < ambi.size(); i++) {
+      ambi[i] = sin(0.37f * i);
+    }
+
+    std::vector<float> ref(numSpeakers * numFrames, 0.0f);
+    for (int s = 0; s < numSpeakers; s++) {
+      for (int c = 0; c < numChannels; c++) {
+        for (int i = 0; i < numFrames; i++) {
+          ref[s * numFrames + i] +=
+              dec.decodeWeight(s, c) * ambi[c * numFrames + i];
+        }
+      }
+    }
+
+    for (int threads = 1; threads <= 3; threads += 2) {
+      dec.numThreads(threads);
+      EXPECT_EQ(dec.numThreads(), threads);
+      std::vector<float> out(numSpeakers * numFrames, 0.0f);
+      dec.decode(out.data(), ambi.data(), numFrames);
+      for (size_t i = 0; i < out.size(); i++) {
+        EXPECT_NEAR(out[i], ref[i], 1e-3);
+      }
+    }
+  }
+}
+
+TEST(Ambisonics, DualBandDecode) {
+  const int numSpeakers = 24;
+  const int order = 3;
+  const int numFrames = 64;
+  Speakers sl = sphereLayout(numSpeakers);
+  AmbiDecode basic(3, order, numSpeakers, 0);
+  basic.setSpeakers(sl);
+  AmbiDecode maxRE(3, order, numSpeakers, 3);
+  maxRE.setSpeakers(sl);
+  AmbiDecode dual(3, order, numSpeakers, 1);
+  dual.setSpeakers(sl);
+  dual.dualBand(true, 400, 44100);
+  EXPECT_TRUE(dual.dualBand());
+
+  AmbiEncode enc(3, order);
+  enc.direction(Vec3f(0.6f, 0.0f, 0.8f));
+
+  // Constant input is decoded by the low band, alternating (Nyquist) input
+  // by the high band
+  for (int type = 0; type < 2; type++) {
+    AmbiDecode &expected = type == 0 ? basic : maxRE;
+    std::vector<float> input(numFrames);
+    for (int i = 0; i < numFrames; i++) {
+      input[i] = (type == 0 || i % 2 == 0) ? 1.0f : -1.0f;
+    }
+    std::vector<float> ambi(enc.channels() * numFrames);
+    std::vector<float> out(numSpeakers * numFrames);
+    for (int block = 0; block < 200; block++) {
+      std::fill(ambi.begin(), ambi.end(), 0.0f);
+      std::fill(out.begin(), out.end(), 0.0f);
+      enc.encode(ambi.data(), input.data(), numFrames);
+      dual.decode(out.data(), ambi.data(), numFrames);
+    }
+    std::vector<float> ref(numSpeakers * numFrames, 0.0f);
+    expected.decode(ref.data(), ambi.data(), numFrames);
+    for (size_t i = 0; i < out.size(); i++) {
+      EXPECT_NEAR(out[i], ref[i], 1e-3);
+    }
+  }
+}
+
+// Setters called while another thread decodes take effect at a block
+// boundary, never partially
+TEST(Ambisonics, DecodeWhileUpdating) {
+  const int numSpeakers = 32;
+  const int numFrames = 64;
+  Speakers sl = sphereLayout(numSpeakers);
+  AmbiDecode dec(3, 3, numSpeakers, 0);
+  dec.setSpeakers(sl);
+  dec.prepare(numFrames);
+  dec.numThreads(3);
+  const int numChannels = dec.channels();
+  std::vector<float> ambi(numChannels * numFrames, 0.0f);
+  // Omnidirectional input
+  for (int i = 0; i < numFrames; i++) {
+    ambi[i] = 1.0f;
+  }
+  std::vector<float> expected(numSpeakers);
+  for (int s = 0; s < numSpeakers; s++) {
+    expected[s] = dec.decodeWeight(s, 0);
+  }
+
+  std::atomic<bool> done(false);
+  std::atomic<int> mismatches(0);
+  std::thread audio([&]() {
+    std::vector<float> out(numSpeakers * numFrames);
+    while (!done.load()) {
+      std::fill(out.begin(), out.end(), 0.0f);
+      dec.decode(out.data(), ambi.data(), numFrames);
+      for (int s = 0; s < numSpeakers; s++) {
+        if (std::abs(out[s * numFrames] - expected[s]) > 1e-4f ||
+            out[s * numFrames] != out[s * numFrames + numFrames - 1]) {
+          mismatches++;
+        }
+      }
+    }
+  });
+  // These flavors all weight order 0 by 1
+  const int flavors[3] = {0, 2, 3};
+  for (int i = 0; i < 200; i++) {
+    dec.flavor(flavors[i % 3]);
+    dec.dualBand(i % 3 == 0, 400, 44100);
+    dec.setSpeakers(sl);
+    if (i % 10 == 0) {
+      dec.numThreads(1 + i / 10 % 4);
+    }
+  }
+  done = true;
+  audio.join();
+  EXPECT_EQ(mismatches.load(), 0);
+
+  // The last update is applied even if decode() took the previous one while
+  // it was being published
+  dec.flavor(1);
+  std::vector<float> out(numSpeakers * numFrames, 0.0f);
+  dec.decode(out.data(), ambi.data(), numFrames);
+  for (int s = 0; s < numSpeakers; s++) {
+    EXPECT_NEAR(out[s * numFrames], dec.decodeWeight(s, 0), 1e-4f);
+  }
+}
@@ -0,0 +1,116 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "al/types/al_AtomicValue.hpp"
+#include "al/ui/al_Parameter.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+TEST(AtomicValue, Kinds) {
+  EXPECT_TRUE(AtomicValue<float>::isLockFree);
+  EXPECT_TRUE(AtomicValue<int32_t>::isLockFree);
+  EXPECT_TRUE(AtomicValue<Vec3f>::isLockFree);
+  EXPECT_TRUE(AtomicValue<Vec4f>::isLockFree);
+  EXPECT_TRUE(AtomicValue<Color>::isLockFree);
+  EXPECT_TRUE(AtomicValue<Pose>::isLockFree);
+  EXPECT_FALSE(AtomicValue<std::string>::isLockFree);
+
+  AtomicValue<Pose> pose;
+  pose.store(Pose(Vec3d(1, 2, 3), Quatd(0, 1, 0, 0)));
+  EXPECT_EQ(pose.load().pos(), Vec3d(1, 2, 3));
+  EXPECT_EQ(pose.load().quat().x, 1.0);
+
+  AtomicValue<std::string> text("a");
+  text.store("text");
+  EXPECT_EQ(text.load(), "text");
+}
+
+// Writers store vectors whose components are all equal, so a torn read
+// shows up as differing components
+TEST(AtomicValue, NoTornReads) {
+  ParameterVec4 vec("vec", "", Vec4f(0));
+  ParameterPose pose("pose", "", Pose(Vec3d(-1), Quatd(-1, -1, -1, -1)));
+  std::atomic<bool> running(true);
+  std::vector<std::thread> writers;
+  for (int w = 0; w < 2; w++) {
+    writers.emplace_back([&, w]() {
+      float v = float(w);
+      while (running.load()) {
+        vec.set(Vec4f(v));
+        pose.set(Pose(Vec3d(v), Quatd(v, v, v, v)));
+        v += 2;
+      }
+    });
+  }
+  int torn = 0;
+  for (int i = 0; i < 200000; i++) {
+    Vec4f value = vec.get();
+    if (value[1] != value[0] || value[2] != value[0] || value[3] != value[0]) {
+      torn++;
+    }
+    Pose p = pose.get();
+    if (p.pos()[1] != p.pos()[0] || p.pos()[2] != p.pos()[0] ||
+        p.quat().w != p.pos()[0] || p.quat().z != p.pos()[0]) {
+      torn++;
+    }
+  }
+  running = false;
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  EXPECT_EQ(torn, 0);
+}
+
+// More concurrent stores than free slots, so stores also contend for slots
+TEST(AtomicValue, ManyWriters) {
+  AtomicValue<Vec4d> value(Vec4d(0));
+  std::atomic<bool> running(true);
+  std::vector<std::thread> writers;
+  for (int w = 0; w < 5; w++) {
+    writers.emplace_back([&, w]() {
+      double v = w;
+      while (running.load()) {
+        value.store(Vec4d(v));
+        v += 5;
+      }
+    });
+  }
+  int torn = 0;
+  for (int i = 0; i < 200000; i++) {
+    Vec4d v = value.load();
+    if (v[1] != v[0] || v[2] != v[0] || v[3] != v[0]) {
+      torn++;
+    }
+  }
+  running = false;
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  EXPECT_EQ(torn, 0);
+  value.store(Vec4d(7));
+  EXPECT_EQ(value.load(), Vec4d(7));
+}
+
+TEST(AtomicValue, Parameters) {
+  Parameter p("p", "", 0.5f, 0.0f, 1.0f);
+  p.set(0.25f);
+  EXPECT_FLOAT_EQ(p.get(), 0.25f);
+  p.set(0.75f);
+
+  ParameterString s("s", "", "start");
+  s.set("changed");
+  EXPECT_EQ(s.get(), "changed");
+  s.set("again");
+  EXPECT_EQ(s.getPrevious(), "changed");
+
+  // Copies take the current value
+  Parameter copy(p);
+  EXPECT_FLOAT_EQ(copy.get(), 0.75f);
+
+  ParameterInt i("i", "", 3, 0, 10);
+  i.setNoCalls(7);
+  EXPECT_EQ(i.get(), 7);
+}
@@ -0,0 +1,94 @@
+#include <math.h>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_BassManagement.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+// Linkwitz-Riley 4th order low pass magnitude
+static float lowPassGain(double freq, double crossover) {
+  return float(1.0 / (1.0 + pow(freq / crossover, 4)));
+}
+
+static float runTone(BassManagement &bassManagement, AudioIOData &io,
+                     const std::vector<double> &freqs, int channel) {
+  // Returns peak of channel in the second half of one second
+  const double sampleRate = 48000;
+  const int fpb = io.framesPerBuffer();
+  float peak = 0;
+  for (int block = 0; block < 48000 / fpb; block++) {
+    io.zeroOut();
+    for (size_t c = 0; c < freqs.size(); c++) {
+      for (int i = 0; i < fpb; i++) {
+        if (freqs[c] > 0) {
+          io.out(c, i) = sin(2 * M_PI * freqs[c] * (block * fpb + i) /
+                             sampleRate);
+        }
+      }
+    }
+    bassManagement.onAudioCB(io);
+    if (block > 24000 / fpb) {
+      for (int i = 0; i < fpb; i++) {
+        peak = std::max(peak, std::abs(io.out(channel, i)));
+      }
+    }
+  }
+  return peak;
+}
+
+TEST(BassManagement, SplitsBands) {
+  Speakers mains = SpeakerRingLayout<4>(0, 0, 2.0f);
+  Speakers subs{Speaker(4, 0, -10, 0, 2.0f)};
+  AudioIOData io;
+  io.framesPerBuffer(256);
+  io.channelsIn(0);
+  io.channelsOut(5);
+
+  BassManagement bassManagement;
+  // Configured for smaller buffers than the audio buffers
+  bassManagement.configure(mains, subs, 80, 48000, 128);
+  std::vector<double> freqs{30, 2000, 0, 0};
+  EXPECT_LT(runTone(bassManagement, io, freqs, 0), 0.03f);
+  EXPECT_NEAR(runTone(bassManagement, io, freqs, 1), 1.0f, 0.01f);
+
+  bassManagement.reset();
+  freqs = {30, 0, 0, 0};
+  EXPECT_NEAR(runTone(bassManagement, io, freqs, 4), lowPassGain(30, 80),
+              0.005f);
+  bassManagement.reset();
+  freqs = {0, 2000, 0, 0};
+  EXPECT_LT(runTone(bassManagement, io, freqs, 4), 0.01f);
+
+  // At the crossover frequency both paths are -6 dB
+  bassManagement.reset();
+  freqs = {80, 0, 0, 0};
+  EXPECT_NEAR(runTone(bassManagement, io, freqs, 0), 0.5f, 0.02f);
+  bassManagement.reset();
+  EXPECT_NEAR(runTone(bassManagement, io, freqs, 4), 0.5f, 0.02f);
+
+  bassManagement.subwooferGain(0, 0.5f);
+  bassManagement.reset();
+  freqs = {30, 0, 0, 0};
+  EXPECT_NEAR(runTone(bassManagement, io, freqs, 4),
+              0.5f * lowPassGain(30, 80), 0.005f);
+}
+
+TEST(BassManagement, NearestSubwoofer) {
+  Speakers mains{Speaker(0, 10, 0), Speaker(1, 170, 0)};
+  Speakers subs{Speaker(2, 0, 0, 0, 0.5f), Speaker(3, 180, 0, 0, 1.0f)};
+  AudioIOData io;
+  io.framesPerBuffer(512);
+  io.channelsIn(0);
+  io.channelsOut(4);
+
+  BassManagement bassManagement;
+  bassManagement.configure(mains, subs, 100, 48000, 512,
+                           BassManagement::NEAREST_SUBWOOFER);
+  std::vector<double> freqs{40, 0};
+  EXPECT_NEAR(runTone(bassManagement, io, freqs, 2), lowPassGain(40, 100),
+              0.005f);
+  bassManagement.reset();
+  EXPECT_EQ(runTone(bassManagement, io, freqs, 3), 0.0f);
+}
@@ -0,0 +1,103 @@
+#include <math.h>
+
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_Biquad.hpp"
+#include "al/sound/al_Crossover.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+TEST(BiQuad, BankMatchesBiQuad) {
+  const int numChannels = 11; // one full group and a partial one
+  const int numFrames = 300;  // not a multiple of the block size
+  const BIQUADTYPE types[4] = {BIQUAD_LPF, BIQUAD_HPF, BIQUAD_PEQ,
+                               BIQUAD_HSH};
+  BiQuadBank bank(numChannels, 2, 48000);
+  std::vector<BiQuad> first, second;
+  for (int c = 0; c < numChannels; c++) {
+    BIQUADTYPE type = types[c % 4];
+    double freq = 100 + 300 * c;
+    first.push_back(BiQuad(type, 48000));
+    first.back().set(freq, 1.5, 6);
+    bank.set(c, 0, type, freq, 1.5, 6);
+    second.push_back(BiQuad(BIQUAD_PEQ, 48000));
+    second.back().set(2000, 1.0, -4);
+  }
+  bank.set(-1, 1, BIQUAD_PEQ, 2000, 1.0, -4);
+
+  AudioIOData io;
+  io.framesPerBuffer(numFrames);
+  io.channelsIn(0);
+  io.channelsOut(numChannels + 1);
+  for (int block = 0; block < 3; block++) {
+    std::vector<std::vector<float>> expected(numChannels);
+    for (int c = 0; c < numChannels; c++) {
+      for (int i = 0; i < numFrames; i++) {
+        float x = sin(0.07f * (c + 1) * (block * numFrames + i)) +
+                  ((i * 13 + c) % 7) / 7.0f;
+        io.out(c + 1, i) = x;
+        expected[c].push_back(float(second[c](first[c](x))));
+      }
+    }
+    io.out(0, 0) = 123.0f;
+    bank.process(io, 1);
+    EXPECT_EQ(io.out(0, 0), 123.0f);
+    for (int c = 0; c < numChannels; c++) {
+      for (int i = 0; i < numFrames; i++) {
+        ASSERT_NEAR(io.out(c + 1, i), expected[c][i], 1e-3);
+      }
+    }
+  }
+}
+
+TEST(BiQuad, CrossoverBank) {
+  const double sampleRate = 48000;
+  const int numFrames = 4800;
+  CrossoverBank crossover(3, 200, sampleRate);
+  const double freqs[3] = {50, 200, 2000};
+  std::vector<std::vector<float>> in(3, std::vector<float>(numFrames));
+  std::vector<std::vector<float>> lo(3, std::vector<float>(numFrames));
+  for (int c = 0; c < 3; c++) {
+    for (int i = 0; i < numFrames; i++) {
+      in[c][i] = sin(2 * M_PI * freqs[c] * i / sampleRate);
+    }
+  }
+  std::vector<float> input = in[1];
+  float *inPtrs[3] = {in[0].data(), in[1].data(), in[2].data()};
+  float *loPtrs[3] = {lo[0].data(), lo[1].data(), lo[2].data()};
+  // High band in place
+  crossover.process(inPtrs, loPtrs, inPtrs, numFrames);
+
+  auto peak = [&](const std::vector<float> &x) {
+    float p = 0;
+    for (int i = numFrames / 2; i < numFrames; i++) {
+      p = std::max(p, std::abs(x[i]));
+    }
+    return p;
+  };
+  EXPECT_NEAR(peak(lo[0]), 1.0f, 0.02f);
+  EXPECT_LT(peak(in[0]), 0.05f);
+  EXPECT_LT(peak(lo[2]), 0.01f);
+  EXPECT_NEAR(peak(in[2]), 1.0f, 0.02f);
+  // Linkwitz-Riley: both bands -6 dB at the crossover, summing to unity
+  EXPECT_NEAR(peak(lo[1]), 0.5f, 0.02f);
+  EXPECT_NEAR(peak(in[1]), 0.5f, 0.02f);
+  std::vector<float> sum(numFrames);
+  for (int i = 0; i < numFrames; i++) {
+    sum[i] = lo[1][i] + in[1][i];
+  }
+  EXPECT_NEAR(peak(sum), 1.0f, 0.02f);
+}
+
+TEST(BiQuad, CrossoverBankPartialAlias) {
+  CrossoverBank crossover(2, 200, 48000);
+  std::vector<float> a(64, 1.0f), b(64, 1.0f), lo0(64), lo1(64);
+  float *in[2] = {a.data(), b.data()};
+  float *lo[2] = {lo0.data(), lo1.data()};
+  // Outputs reordered over the inputs
+  float *hi[2] = {b.data(), a.data()};
+  EXPECT_DEBUG_DEATH(crossover.process(in, lo, hi, 64), "alias");
+}
@@ -0,0 +1,83 @@
+#include <math.h>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_Convolver.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+static std::vector<float> testIR(int length, float seed) {
+  std::vector<float> ir(length);
+  for (int i = 0; i < length; i++) {
+    ir[i] = sin(seed * i + 0.3f * i * i) * exp(-3.0f * i / length);
+  }
+  return ir;
+}
+
+static void testConvolver(bool threads) {
+  const int fpb = 64;
+  const int numBlocks = 80;
+  std::vector<std::vector<float>> irs{testIR(3000, 0.7f), testIR(1000, 1.3f),
+                                      testIR(20, 2.1f)};
+  Convolver convolver;
+  convolver.backgroundThreads(threads);
+  // Channel 0 filtered in place, channels 1 and 2 mixed into channel 3
+  ASSERT_TRUE(convolver.configure(irs, {0, 1, 2}, {0, 3, 3}, 32, 512));
+  std::vector<int> sizes{32, 128, 512};
+  EXPECT_EQ(convolver.partitionSizes(), sizes);
+
+  AudioIOData io;
+  io.framesPerBuffer(fpb);
+  io.channelsIn(0);
+  io.channelsOut(4);
+
+  std::vector<std::vector<float>> input(3);
+  for (int c = 0; c < 3; c++) {
+    for (int i = 0; i < fpb * numBlocks; i++) {
+      input[c].push_back(sin(0.05f * (c + 1) * i) + ((i * 7 + c) % 13) / 13.f);
+    }
+  }
+  for (int block = 0; block < numBlocks; block++) {
+    for (int c = 0; c < 3; c++) {
+      for (int i = 0; i < fpb; i++) {
+        io.out(c, i) = input[c][block * fpb + i];
+      }
+    }
+    for (int i = 0; i < fpb; i++) {
+      io.out(3, i) = 100.0f;  // overwritten by the convolver
+    }
+    convolver.onAudioCB(io);
+    for (int i = 0; i < fpb; i++) {
+      int n = block * fpb + i;
+      float expected[4] = {0, input[1][n], input[2][n], 0};
+      for (int r = 0; r < 3; r++) {
+        for (int k = 0; k < int(irs[r].size()) && k <= n; k++) {
+          expected[r == 0 ? 0 : 3] += irs[r][k] * input[r][n - k];
+        }
+      }
+      for (int c = 0; c < 4; c++) {
+        ASSERT_NEAR(io.out(c, i), expected[c], 2e-3) << "frame " << n;
+      }
+    }
+  }
+}
+
+TEST(Convolver, MatchesDirectConvolution) { testConvolver(false); }
+
+TEST(Convolver, BackgroundThreads) { testConvolver(true); }
+
+TEST(Convolver, Uniform) {
+  std::vector<std::vector<float>> irs{{0.5f, 0, 0, 0, 0, 0, 0, 0, 0, 0.25f}};
+  Convolver convolver;
+  ASSERT_TRUE(convolver.configure(irs, 4));
+  EXPECT_EQ(convolver.partitionSizes(), std::vector<int>{4});
+  std::vector<float> signal(16, 0.0f);
+  signal[1] = 1.0f;
+  float *channels[1] = {signal.data()};
+  convolver.process(channels, channels, 16);
+  for (int i = 0; i < 16; i++) {
+    float expected = i == 1 ? 0.5f : (i == 10 ? 0.25f : 0.0f);
+    EXPECT_NEAR(signal[i], expected, 1e-6);
+  }
+}
@@ -0,0 +1,130 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_DiskRecorder.hpp"
+#include "al/sound/al_SoundFile.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+static const int kFramesPerBuffer = 256;
+
+static float signal(int channel, long long frame) {
+  return float((frame * 7 + channel * 13) % 200 - 100) / 128.0f;
+}
+
+// Run blocks through the recorder, filling outputs and buses with signal()
+static void record(DiskRecorder &recorder, AudioIOData &io, int blocks) {
+  for (int b = 0; b < blocks; b++) {
+    for (unsigned int c = 0; c < io.channelsOut(); c++) {
+      for (int i = 0; i < kFramesPerBuffer; i++) {
+        io.out(c, i) = signal(c, b * kFramesPerBuffer + i);
+      }
+    }
+    for (unsigned int c = 0; c < io.channelsBus(); c++) {
+      for (int i = 0; i < kFramesPerBuffer; i++) {
+        io.bus(c, i) = signal(100 + c, b * kFramesPerBuffer + i);
+      }
+    }
+    recorder.onAudioCB(io);
+  }
+}
+
+TEST(DiskRecorder, Wav) {
+  AudioIOData io;
+  io.framesPerBuffer(kFramesPerBuffer);
+  io.channelsIn(0);
+  io.channelsOut(4);
+  io.channelsBus(2);
+
+  DiskRecorder recorder;
+  recorder.addChannel(DiskRecorder::OUTPUT, 2);
+  recorder.addChannel(DiskRecorder::BUS, 1);
+  recorder.addChannel(DiskRecorder::OUTPUT, 9);
+  const char *path = "al_test_recorder.wav";
+  // Not recording yet
+  record(recorder, io, 4);
+  ASSERT_TRUE(recorder.start(path, 44100));
+  EXPECT_TRUE(recorder.isRecording());
+  EXPECT_FALSE(recorder.start(path, 44100));
+  record(recorder, io, 100);
+  recorder.stop();
+  EXPECT_FALSE(recorder.isRecording());
+  record(recorder, io, 4);
+
+  const long long frames = 100 * kFramesPerBuffer;
+  EXPECT_EQ(recorder.framesWritten(), uint64_t(frames));
+  EXPECT_EQ(recorder.droppedFrames(), 0u);
+  EXPECT_EQ(recorder.overflows(), 0u);
+  EXPECT_EQ(recorder.files(), 1);
+  EXPECT_GT(recorder.maxFill(), 0.0f);
+
+  SoundFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(file.sampleRate, 44100);
+  EXPECT_EQ(file.channels, 3);
+  ASSERT_EQ(file.frameCount, frames);
+  for (long long i = 0; i < frames; i += 97) {
+    EXPECT_EQ(file.getFrame(i)[0], signal(2, i));
+    EXPECT_EQ(file.getFrame(i)[1], signal(101, i));
+    // Missing channels are silent
+    EXPECT_EQ(file.getFrame(i)[2], 0.0f);
+  }
+  std::remove(path);
+}
+
+TEST(DiskRecorder, SplitAndEncodings) {
+  AudioIOData io;
+  io.framesPerBuffer(kFramesPerBuffer);
+  io.channelsIn(0);
+  io.channelsOut(70);
+
+  DiskRecorder recorder;
+  recorder.addChannels(DiskRecorder::OUTPUT, 0, 70);
+  // Split 24 bit files every 1000 frames
+  recorder.splitBytes(1000 * 70 * 3);
+  ASSERT_TRUE(recorder.start("al_test_recorder_split.wav", 48000,
+                             DiskRecorder::WAV, DiskRecorder::INT24));
+  record(recorder, io, 10);
+  recorder.stop();
+  EXPECT_EQ(recorder.files(), 3);
+
+  long long frame = 0;
+  for (const char *path :
+       {"al_test_recorder_split.wav", "al_test_recorder_split_2.wav",
+        "al_test_recorder_split_3.wav"}) {
+    SoundFile file;
+    ASSERT_TRUE(file.open(path));
+    EXPECT_EQ(file.channels, 70);
+    EXPECT_LE(file.frameCount, 1000);
+    for (long long i = 0; i < file.frameCount; i++, frame++) {
+      EXPECT_NEAR(file.getFrame(i)[69], signal(69, frame), 1.0f / 8388607);
+    }
+    std::remove(path);
+  }
+  EXPECT_EQ(frame, 10 * kFramesPerBuffer);
+
+  // 16 bit raw
+  recorder.splitBytes(0);
+  recorder.clearChannels();
+  recorder.addChannel(DiskRecorder::OUTPUT, 5);
+  const char *rawPath = "al_test_recorder.raw";
+  ASSERT_TRUE(recorder.start(rawPath, 48000, DiskRecorder::RAW,
+                             DiskRecorder::INT16));
+  record(recorder, io, 3);
+  recorder.stop();
+  std::ifstream raw(rawPath, std::ios::binary);
+  std::vector<int16_t> samples(3 * kFramesPerBuffer + 1);
+  raw.read(reinterpret_cast<char *>(samples.data()),
+           samples.size() * sizeof(int16_t));
+  ASSERT_EQ(raw.gcount(), 3 * kFramesPerBuffer * 2);
+  for (int i = 0; i < 3 * kFramesPerBuffer; i++) {
+    EXPECT_EQ(samples[i], int16_t(std::lrint(signal(5, i) * 32767.0f)));
+  }
+  raw.close();
+  std::remove(rawPath);
+}
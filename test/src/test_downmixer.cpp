@@ -0,0 +1,141 @@
+#include <math.h>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_DownMixer.hpp"
+#include "al/ui/al_Parameter.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+// Walks the routing map frame by frame like the original implementation
+static void referenceMix(const DownMixer::RoutingMap &routing,
+                         const std::vector<std::vector<float>> &in,
+                         std::vector<std::vector<float>> &out, int numFrames) {
+  for (auto &o : out) {
+    std::fill(o.begin(), o.end(), 0.0f);
+  }
+  for (int i = 0; i < numFrames; i++) {
+    for (const auto &mapEntry : routing) {
+      for (const auto &r : mapEntry.second) {
+        out[r.first][i] += in[mapEntry.first][i] * r.second;
+      }
+    }
+  }
+}
+
+TEST(DownMixer, MatchesReference) {
+  const int numInputs = 60;
+  const int numOutputs = 5;
+  const int numFrames = 67;
+  DownMixer::RoutingMap routing;
+  for (uint32_t c = 0; c < numInputs; c++) {
+    // Rows of different lengths, including an unused output (3)
+    for (uint32_t o = 0; o < numOutputs; o++) {
+      if (o != 3 && (c + o) % (o + 1) == 0) {
+        routing[c].push_back({o, 0.1f + 0.01f * c - 0.2f * o});
+      }
+    }
+  }
+  std::vector<std::vector<float>> in(numInputs, std::vector<float>(numFrames));
+  std::vector<const float *> inputs;
+  for (int c = 0; c < numInputs; c++) {
+    for (int i = 0; i < numFrames; i++) {
+      in[c][i] = sin(0.1f * (c + 1) * i);
+    }
+    inputs.push_back(in[c].data());
+  }
+  std::vector<std::vector<float>> ref(numOutputs,
+                                      std::vector<float>(numFrames));
+  std::vector<std::vector<float>> out(numOutputs,
+                                      std::vector<float>(numFrames, 1.0f));
+  std::vector<float *> outputs;
+  for (auto &o : out) {
+    outputs.push_back(o.data());
+  }
+
+  AudioIOData io;
+  DownMixer downMixer;
+  downMixer.setRouting(routing, io);
+  EXPECT_EQ(downMixer.numOutputs(), numOutputs);
+  EXPECT_EQ(io.channelsBus(), numOutputs);
+  downMixer.process(inputs.data(), outputs.data(), numFrames);
+  referenceMix(routing, in, ref, numFrames);
+  for (int o = 0; o < numOutputs; o++) {
+    for (int i = 0; i < numFrames; i++) {
+      EXPECT_NEAR(out[o][i], ref[o][i], 1e-5);
+    }
+  }
+}
+
+TEST(DownMixer, IdentityAndOneToOne) {
+  AudioIOData io;
+  io.framesPerBuffer(16);
+  io.channelsOut(4);
+  for (int c = 0; c < 4; c++) {
+    for (int i = 0; i < 16; i++) {
+      io.outBuffer(c)[i] = c * 100 + i;
+    }
+  }
+  DownMixer downMixer;
+  downMixer.setIdentity(4, io);
+  downMixer.setOutputs({3, 2, 1, 0});
+  downMixer.downMix(io);
+  for (int c = 0; c < 4; c++) {
+    for (int i = 0; i < 16; i++) {
+      EXPECT_EQ(io.outBuffer(3 - c)[i], c * 100 + i);
+    }
+  }
+
+  // Swap back with gain. Routes from missing channels are silent
+  downMixer.setRouting(
+      {{0, {{3, 0.5f}}}, {3, {{0, 0.5f}}}, {7, {{1, 1.0f}}}}, io);
+  EXPECT_EQ(io.channelsBus(), 4);
+  downMixer.setOutputs({0, 1, 2, 3});
+  downMixer.downMix(io);
+  for (int i = 0; i < 16; i++) {
+    EXPECT_EQ(io.outBuffer(0)[i], 0.5f * i);
+    EXPECT_EQ(io.outBuffer(1)[i], 0.0f);
+    EXPECT_EQ(io.outBuffer(2)[i], 0.0f);
+    EXPECT_EQ(io.outBuffer(3)[i], 0.5f * (300 + i));
+  }
+}
+
+TEST(DownMixer, GainRamp) {
+  AudioIOData io;
+  io.framesPerBuffer(8);
+  io.channelsOut(6);
+  DownMixer downMixer;
+  downMixer.set5_1toStereo(io);
+  downMixer.setStereoOutput();
+  Parameter gain{"gain", "", 1.0f, 0.0f, 1.0f};
+  downMixer.gainParameter(&gain);
+
+  auto render = [&]() {
+    for (int c = 0; c < 6; c++) {
+      for (int i = 0; i < 8; i++) {
+        io.outBuffer(c)[i] = c == 0 ? 1.0f : 0.0f;
+      }
+    }
+    downMixer.downMix(io);
+  };
+  render();
+  for (int i = 0; i < 8; i++) {
+    EXPECT_FLOAT_EQ(io.outBuffer(0)[i], 1.0f);
+    EXPECT_FLOAT_EQ(io.outBuffer(1)[i], 0.0f);
+  }
+  // Ramp down over one buffer, then hold
+  gain.set(0.5f);
+  render();
+  for (int i = 0; i < 8; i++) {
+    EXPECT_FLOAT_EQ(io.outBuffer(0)[i], 1.0f - 0.5f * (i + 1) / 8.0f);
+  }
+  render();
+  for (int i = 0; i < 8; i++) {
+    EXPECT_FLOAT_EQ(io.outBuffer(0)[i], 0.5f);
+  }
+  downMixer.gainParameter(nullptr);
+  downMixer.gain(0.25f);
+  render();
+  EXPECT_FLOAT_EQ(io.outBuffer(0)[7], 0.25f);
+}
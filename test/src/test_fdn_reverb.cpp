@@ -0,0 +1,101 @@
+#include <math.h>
+
+#include <vector>
+
+#include "al/sound/al_FDNReverb.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+static std::vector<std::vector<float>> impulseResponse(FDNReverb &reverb,
+                                                       int length,
+                                                       int blockSize) {
+  std::vector<std::vector<float>> out(reverb.numOutputs(),
+                                      std::vector<float>(length));
+  std::vector<float> in(length, 0.0f);
+  in[0] = 1.0f;
+  std::vector<float *> outputs(reverb.numOutputs());
+  for (int offset = 0; offset < length; offset += blockSize) {
+    for (int c = 0; c < reverb.numOutputs(); c++) {
+      outputs[c] = out[c].data() + offset;
+    }
+    reverb.process(in.data() + offset, outputs.data(),
+                   std::min(blockSize, length - offset));
+  }
+  return out;
+}
+
+static double energy(const std::vector<float> &x, int start, int end) {
+  double e = 0;
+  for (int i = start; i < end; i++) {
+    e += x[i] * x[i];
+  }
+  return e;
+}
+
+TEST(FDNReverb, BlockSizeIndependent) {
+  const int length = 20000;
+  for (int mixing = 0; mixing < 2; mixing++) {
+    FDNReverb reverb;
+    reverb.configure(6, mixing == 0 ? 16 : 12, 44100);
+    reverb.mixing(FDNReverb::Mixing(mixing));
+    auto reference = impulseResponse(reverb, length, 1);
+    for (int blockSize : {64, 500, 4096}) {
+      reverb.zero();
+      auto out = impulseResponse(reverb, length, blockSize);
+      for (int c = 0; c < 6; c++) {
+        for (int i = 0; i < length; i++) {
+          ASSERT_FLOAT_EQ(out[c][i], reference[c][i]);
+        }
+      }
+    }
+  }
+}
+
+TEST(FDNReverb, MixingFallback) {
+  FDNReverb reverb;
+  reverb.mixing(FDNReverb::HADAMARD);
+  reverb.configure(2, 12);
+  EXPECT_EQ(reverb.mixing(), FDNReverb::HADAMARD);
+  EXPECT_EQ(reverb.effectiveMixing(), FDNReverb::HOUSEHOLDER);
+  // The requested mixing is used again with a power of two lines
+  reverb.configure(2, 16);
+  EXPECT_EQ(reverb.effectiveMixing(), FDNReverb::HADAMARD);
+  reverb.mixing(FDNReverb::HOUSEHOLDER);
+  EXPECT_EQ(reverb.effectiveMixing(), FDNReverb::HOUSEHOLDER);
+}
+
+TEST(FDNReverb, DecayAndDecorrelation) {
+  const double sampleRate = 44100;
+  const int numOutputs = 24; // more outputs than delay lines
+  FDNReverb reverb;
+  reverb.configure(numOutputs, 16, sampleRate);
+  EXPECT_GE(reverb.delayLength(0), int(0.025 * sampleRate));
+  for (int i = 1; i < reverb.numLines(); i++) {
+    EXPECT_GT(reverb.delayLength(i), reverb.delayLength(i - 1));
+  }
+  reverb.damping(0).decayTime(1.0f);
+  auto out = impulseResponse(reverb, int(sampleRate * 1.5), 512);
+
+  const int window = 4410;
+  for (int c = 0; c < numOutputs; c++) {
+    double early = energy(out[c], 22050, 22050 + window);
+    double late = energy(out[c], 44100, 44100 + window);
+    EXPECT_GT(early, 0);
+    // 0.5 s apart at 60 dB per second
+    double drop = 10 * log10(late / early);
+    EXPECT_NEAR(drop, -30, 4);
+  }
+
+  // Outputs are not copies of each other
+  for (int c = 1; c < numOutputs; c++) {
+    double cross = 0;
+    for (int i = 10000; i < 40000; i++) {
+      cross += out[0][i] * out[c][i];
+    }
+    double norm = sqrt(energy(out[0], 10000, 40000) *
+                       energy(out[c], 10000, 40000));
+    EXPECT_LT(std::abs(cross / norm), 0.3);
+  }
+}
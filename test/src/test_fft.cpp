@@ -0,0 +1,63 @@
+#include <math.h>
+
+#include <vector>
+
+#include "al/math/al_FFT.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+TEST(FFT, RealMatchesDFT) {
+  for (unsigned int n = 2; n <= 1024; n *= 2) {
+    RFFT fft(n);
+    EXPECT_EQ(fft.size(), n);
+    EXPECT_EQ(fft.bins(), n / 2 + 1);
+    std::vector<float> x(n), y(n), re(fft.bins()), im(fft.bins());
+    for (unsigned int i = 0; i < n; i++) {
+      x[i] = sin(0.3 * i * i + 1.0) + 0.1 * i / n;
+    }
+    fft.forward(x.data(), re.data(), im.data());
+    for (unsigned int k = 0; k < fft.bins(); k++) {
+      double dftRe = 0, dftIm = 0;
+      for (unsigned int i = 0; i < n; i++) {
+        dftRe += x[i] * cos(2 * M_PI * k * i / n);
+        dftIm -= x[i] * sin(2 * M_PI * k * i / n);
+      }
+      EXPECT_NEAR(re[k], dftRe, 1e-4 * n);
+      EXPECT_NEAR(im[k], dftIm, 1e-4 * n);
+    }
+    fft.inverse(re.data(), im.data(), y.data());
+    for (unsigned int i = 0; i < n; i++) {
+      EXPECT_NEAR(y[i], x[i], 1e-5);
+    }
+  }
+}
+
+TEST(FFT, MixedRadix) {
+  for (unsigned int n : {6u, 10u, 14u, 18u, 30u, 42u, 60u, 96u, 210u, 1000u}) {
+    EXPECT_TRUE(RFFT::isSupportedSize(n));
+    RFFT fft(n);
+    std::vector<float> x(n), y(n), re(fft.bins()), im(fft.bins());
+    for (unsigned int i = 0; i < n; i++) {
+      x[i] = cos(0.17 * i * i) - 0.2;
+    }
+    fft.forward(x.data(), re.data(), im.data());
+    for (unsigned int k = 0; k < fft.bins(); k++) {
+      double dftRe = 0, dftIm = 0;
+      for (unsigned int i = 0; i < n; i++) {
+        dftRe += x[i] * cos(2 * M_PI * k * i / n);
+        dftIm -= x[i] * sin(2 * M_PI * k * i / n);
+      }
+      EXPECT_NEAR(re[k], dftRe, 1e-4 * n);
+      EXPECT_NEAR(im[k], dftIm, 1e-4 * n);
+    }
+    fft.inverse(re.data(), im.data(), y.data());
+    for (unsigned int i = 0; i < n; i++) {
+      EXPECT_NEAR(y[i], x[i], 1e-5);
+    }
+  }
+  EXPECT_FALSE(RFFT::isSupportedSize(22));
+  EXPECT_FALSE(RFFT::isSupportedSize(15));
+  EXPECT_EQ(RFFT::nextSupportedSize(22), 24u);
+}
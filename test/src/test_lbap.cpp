@@ -574,3 +574,81 @@ TEST(LBAP, LBAPAllosphereDispersion) {
     }
   }
 }
+
+TEST(LBAP, LBAPAllosphereMultipleSources) {
+  const int fpb = 16;
+  Speakers sl = AlloSphereSpeakerLayout();
+  Lbap lbapPanner(sl);
+  lbapPanner.compile();
+  lbapPanner.setDispersionThreshold(0.5);
+
+  AudioIOData audioData;
+  audioData.framesPerBuffer(fpb);
+  audioData.framesPerSecond(44100);
+  audioData.channelsIn(0);
+  audioData.channelsOut(60);
+
+  float samples[fpb];
+  for (int i = 0; i < fpb; i++) {
+    samples[i] = i + 0.5f;
+  }
+  Vec3f middle(1, 0.1, -1);
+  Vec3f above(0.1, 5, -0.2);
+
+  // Dispersion only affects the dispersed source
+  AudioIOData single;
+  single.framesPerBuffer(fpb);
+  single.channelsIn(0);
+  single.channelsOut(60);
+  single.zeroOut();
+  lbapPanner.prepare(single);
+  lbapPanner.renderBuffer(single, middle, samples, fpb);
+  std::vector<float> expected(single.outBuffer(0),
+                              single.outBuffer(0) + 60 * fpb);
+  single.zeroOut();
+  lbapPanner.prepare(single);
+  lbapPanner.renderBuffer(single, above, samples, fpb);
+  for (int i = 0; i < 60 * fpb; i++) {
+    expected[i] += single.outBuffer(0)[i];
+  }
+
+  audioData.zeroOut();
+  lbapPanner.prepare(audioData);
+  lbapPanner.renderBuffer(audioData, middle, samples, fpb);
+  lbapPanner.renderBuffer(audioData, above, samples, fpb);
+  for (int i = 0; i < 60 * fpb; i++) {
+    EXPECT_NEAR(audioData.outBuffer(0)[i], expected[i], 1e-5);
+  }
+
+  // Full dispersion on the bottom ring from below
+  audioData.zeroOut();
+  lbapPanner.prepare(audioData);
+  lbapPanner.renderBuffer(audioData, Vec3f(0, -5, 0), samples, fpb);
+  int bottomChannel = -1;
+  for (auto &spkr : sl) {
+    if (spkr.elevation < -30) {
+      if (bottomChannel < 0) {
+        bottomChannel = spkr.deviceChannel;
+      }
+      EXPECT_GT(audioData.out(spkr.deviceChannel, 1), 1e-6);
+      EXPECT_FLOAT_EQ(audioData.out(spkr.deviceChannel, 1),
+                      audioData.out(bottomChannel, 1));
+    }
+  }
+  ASSERT_GE(bottomChannel, 0);
+
+  // renderSample matches renderBuffer
+  audioData.zeroOut();
+  lbapPanner.prepare(audioData);
+  lbapPanner.renderBuffer(audioData, above, samples, fpb);
+  std::vector<float> block(audioData.outBuffer(0),
+                           audioData.outBuffer(0) + 60 * fpb);
+  audioData.zeroOut();
+  for (int i = 0; i < fpb; i++) {
+    lbapPanner.prepare(audioData);
+    lbapPanner.renderSample(audioData, above, samples[i], i);
+  }
+  for (int i = 0; i < 60 * fpb; i++) {
+    EXPECT_NEAR(audioData.outBuffer(0)[i], block[i], 1e-5);
+  }
+}
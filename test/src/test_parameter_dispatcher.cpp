@@ -0,0 +1,112 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "al/ui/al_Parameter.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+TEST(ParameterDispatcher, Coalesce) {
+  ParameterDispatcher dispatcher;
+  Parameter x("x", "", 0.0f, -1000.0f, 1000.0f);
+  std::vector<float> values;
+  x.registerChangeCallback([&](float value) { values.push_back(value); });
+  x.setChangeDispatcher(&dispatcher);
+
+  for (int i = 1; i <= 100; i++) {
+    x.set(float(i));
+  }
+  EXPECT_TRUE(values.empty());
+  EXPECT_EQ(x.get(), 100.0f);
+  EXPECT_EQ(dispatcher.pending(), 1u);
+
+  EXPECT_EQ(dispatcher.process(), 1u);
+  ASSERT_EQ(values.size(), 1u);
+  EXPECT_EQ(values[0], 100.0f);
+  EXPECT_EQ(x.coalescedChanges(), 99u);
+  EXPECT_EQ(dispatcher.coalesced(), 99u);
+  EXPECT_EQ(dispatcher.delivered(), 1u);
+
+  // Nothing changed
+  EXPECT_EQ(dispatcher.process(), 0u);
+  EXPECT_EQ(values.size(), 1u);
+
+  x.set(5.0f);
+  dispatcher.process();
+  ASSERT_EQ(values.size(), 2u);
+  EXPECT_EQ(values[1], 5.0f);
+
+  // Detached parameters call back synchronously again
+  x.setChangeDispatcher(nullptr);
+  x.set(6.0f);
+  ASSERT_EQ(values.size(), 3u);
+  EXPECT_EQ(values[2], 6.0f);
+}
+
+TEST(ParameterDispatcher, Source) {
+  ParameterDispatcher dispatcher;
+  ParameterInt i("i", "", 0, 0, 10);
+  ValueSource received{"", 0};
+  bool hasSource = false;
+  i.registerChangeCallback([&](int32_t, ValueSource *src) {
+    hasSource = src != nullptr;
+    if (src) {
+      received = *src;
+    }
+  });
+  i.setChangeDispatcher(&dispatcher);
+  {
+    // As in ParameterServer, the source is gone before the callbacks run
+    ValueSource source{"192.168.1.5", 9011};
+    i.set(3, &source);
+    source.ipAddr = "overwritten";
+    source.port = 1;
+  }
+  dispatcher.process();
+  EXPECT_TRUE(hasSource);
+  EXPECT_EQ(received.ipAddr, "192.168.1.5");
+  EXPECT_EQ(received.port, 9011);
+
+  // A later change without a source replaces it
+  i.set(4, &received);
+  i.set(5);
+  dispatcher.process();
+  EXPECT_FALSE(hasSource);
+}
+
+TEST(ParameterDispatcher, Destroyed) {
+  ParameterDispatcher dispatcher;
+  {
+    Parameter x("x", "", 0.0f, 0.0f, 1.0f);
+    x.setChangeDispatcher(&dispatcher);
+    x.set(0.5f);
+    EXPECT_EQ(dispatcher.pending(), 1u);
+  }
+  EXPECT_EQ(dispatcher.pending(), 0u);
+  EXPECT_EQ(dispatcher.process(), 0u);
+}
+
+// The last value set is always delivered
+TEST(ParameterDispatcher, Threads) {
+  ParameterDispatcher dispatcher;
+  ParameterVec3 position("position");
+  Vec3f last(-1);
+  position.registerChangeCallback([&](Vec3f value) { last = value; });
+  position.setChangeDispatcher(&dispatcher);
+
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+    for (int i = 0; i <= 20000; i++) {
+      position.set(Vec3f(float(i)));
+    }
+    done = true;
+  });
+  while (!done.load()) {
+    dispatcher.process();
+  }
+  writer.join();
+  dispatcher.process();
+  EXPECT_EQ(last, Vec3f(20000.0f));
+  EXPECT_EQ(dispatcher.delivered() + dispatcher.coalesced(), 20001u);
+}
@@ -3,7 +3,10 @@
 
 #include "al/ui/al_ParameterServer.hpp"
 
+#include <algorithm>
 #include <fstream>
+#include <mutex>
+#include <vector>
 
 TEST(ParameterSever, Handshake) {
   al::ParameterServer s;
@@ -30,3 +33,175 @@ TEST(ParameterSever, Handshake) {
   c.stopServer();
   s.stopServer();
 }
+
+namespace {
+void sendTo(al::ParameterServer &server, al::osc::Packet &packet) {
+  al::osc::Message m(packet.data(), int(packet.size()), 1, "127.0.0.1", 0);
+  server.onMessage(m);
+}
+} // namespace
+
+TEST(ParameterSever, AddressIndex) {
+  al::ParameterServer server("", 9012, false);
+  al::Parameter p{"freq", "synth", 440.0f, 20.0f, 20000.0f};
+  al::ParameterInt i{"voices", "synth", 4, 1, 16};
+  al::ParameterPose pose{"pose"};
+  al::ParameterBundle bundle("voice");
+  al::Parameter gain{"gain", "", 0.5f, 0.0f, 1.0f};
+  bundle << gain;
+  server << p << i << pose << bundle;
+
+  al::osc::Packet packet;
+  packet.addMessage(p.getFullAddress(), 880.0f);
+  sendTo(server, packet);
+  EXPECT_FLOAT_EQ(p.get(), 880.0f);
+
+  // Wrong type tags are ignored
+  packet.clear();
+  packet.addMessage(i.getFullAddress(), 2.0f);
+  sendTo(server, packet);
+  EXPECT_EQ(i.get(), 4);
+  packet.clear();
+  packet.addMessage(i.getFullAddress(), 8);
+  sendTo(server, packet);
+  EXPECT_EQ(i.get(), 8);
+
+  packet.clear();
+  packet.addMessage(pose.getFullAddress() + "/pos/y", 3.0f);
+  sendTo(server, packet);
+  EXPECT_EQ(pose.get().pos().y, 3.0);
+
+  packet.clear();
+  packet.addMessage(bundle.bundlePrefix() + gain.getFullAddress(), 0.25f);
+  sendTo(server, packet);
+  EXPECT_FLOAT_EQ(gain.get(), 0.25f);
+
+  // Parameters added to a registered bundle are found
+  al::Parameter pan{"pan", "", 0.0f, -1.0f, 1.0f};
+  bundle << pan;
+  packet.clear();
+  packet.addMessage(bundle.bundlePrefix() + pan.getFullAddress(), -0.5f);
+  sendTo(server, packet);
+  EXPECT_FLOAT_EQ(pan.get(), -0.5f);
+
+  server.unregisterParameter(p);
+  packet.clear();
+  packet.addMessage(p.getFullAddress(), 100.0f);
+  sendTo(server, packet);
+  EXPECT_FLOAT_EQ(p.get(), 880.0f);
+}
+
+namespace {
+class NotificationCounter : public al::osc::PacketHandler {
+public:
+  void onMessage(al::osc::Message &m) override {
+    std::unique_lock<std::mutex> lk(mutex);
+    if (m.addressPattern() == "/value") {
+      float v;
+      m >> v;
+      values.push_back(v);
+    } else if (m.addressPattern() == "/long") {
+      std::string s;
+      m >> s;
+      longSize = s.size();
+    }
+  }
+
+  std::mutex mutex;
+  std::vector<float> values;
+  size_t longSize{0};
+};
+} // namespace
+
+TEST(ParameterSever, BatchedNotifications) {
+  NotificationCounter counter;
+  al::osc::Recv recv;
+  ASSERT_TRUE(recv.open(10830, "localhost", 0.0));
+  recv.handler(counter);
+  recv.start();
+
+  al::OSCNotifier notifier;
+  notifier.addListener("localhost", 10830);
+  // Registering twice is ignored
+  notifier.addListener("localhost", 10830);
+  // A long interval, so only full bundles and flush() send
+  notifier.startBatching(10.0, 256);
+  EXPECT_TRUE(notifier.isBatching());
+  for (int i = 0; i < 100; i++) {
+    notifier.notifyListeners("/value", float(i), nullptr);
+  }
+  // Larger than a bundle, sent on its own
+  notifier.notifyListeners("/long", std::string(400, 'a'), nullptr);
+  notifier.flush();
+  notifier.stopBatching();
+  EXPECT_FALSE(notifier.isBatching());
+  EXPECT_EQ(notifier.messagesSent(), 101u);
+  // 12 messages of 20 bytes fit in a 256 byte bundle
+  EXPECT_GE(notifier.packetsSent(), 10u);
+  EXPECT_LT(notifier.packetsSent(), 30u);
+
+  al::al_sleep(0.2);
+  {
+    std::unique_lock<std::mutex> lk(counter.mutex);
+    ASSERT_EQ(counter.values.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+      EXPECT_EQ(counter.values[i], float(i));
+    }
+    EXPECT_EQ(counter.longSize, 400u);
+    counter.values.clear();
+  }
+
+  // Sent immediately when not batching
+  notifier.notifyListeners("/value", 1.0f, nullptr);
+  al::al_sleep(0.1);
+  std::unique_lock<std::mutex> lk(counter.mutex);
+  EXPECT_EQ(counter.values.size(), 1u);
+  recv.stop();
+}
+
+TEST(ParameterSever, BatchedQueueBound) {
+  NotificationCounter counter;
+  al::osc::Recv recv;
+  ASSERT_TRUE(recv.open(10831, "localhost", 0.0));
+  recv.handler(counter);
+  recv.start();
+
+  al::OSCNotifier notifier;
+  notifier.addListener("localhost", 10831);
+  notifier.startBatching(10.0, 256, 1024);
+  for (int i = 0; i < 5000; i++) {
+    notifier.notifyListeners("/value", float(i), nullptr);
+  }
+  notifier.flush();
+  notifier.stopBatching();
+  // Every notification is either sent or replaced by a later one
+  EXPECT_EQ(notifier.messagesSent() + notifier.messagesCoalesced(), 5000u);
+
+  al::al_sleep(0.2);
+  std::unique_lock<std::mutex> lk(counter.mutex);
+  ASSERT_GT(counter.values.size(), 0u);
+  EXPECT_EQ(counter.values.back(), 4999.0f);
+  EXPECT_TRUE(std::is_sorted(counter.values.begin(), counter.values.end()));
+  recv.stop();
+}
+
+TEST(ParameterSever, BatchedLongMessage) {
+  // Read the raw datagram, it is larger than osc::Recv accepts
+  al::SocketServer socket(10832, "127.0.0.1", 1.0);
+  ASSERT_TRUE(socket.opened());
+
+  al::OSCNotifier notifier;
+  notifier.addListener("127.0.0.1", 10832);
+  notifier.startBatching(10.0, 256);
+  // Larger than the default encoding buffer, sent on its own
+  notifier.notifyListeners("/long", std::string(10000, 'a'), nullptr);
+  notifier.flush();
+  notifier.stopBatching();
+  EXPECT_EQ(notifier.messagesSent(), 1u);
+
+  std::vector<char> buffer(16384);
+  const size_t size = socket.recv(buffer.data(), buffer.size());
+  // Address, type tags and the padded string
+  EXPECT_EQ(size, 8u + 4u + 10004u);
+  EXPECT_EQ(std::string(buffer.data()), "/long");
+}
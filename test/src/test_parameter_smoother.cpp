@@ -0,0 +1,97 @@
+#include <cmath>
+#include <vector>
+
+#include "al/ui/al_ParameterSmoother.hpp"
+#include "gtest/gtest.h"
+
+using namespace al;
+
+TEST(ParameterSmoother, Linear) {
+  // 100 samples of smoothing
+  SmoothedValue value(0.0f, 0.01f, 10000.0);
+  value.setTarget(1.0f);
+  std::vector<float> out(64);
+  value.process(out.data(), 64);
+  for (int i = 0; i < 64; i++) {
+    EXPECT_NEAR(out[i], i * 0.01f, 1e-5f);
+  }
+  value.process(out.data(), 64);
+  EXPECT_NEAR(out[0], 0.64f, 1e-5f);
+  EXPECT_NEAR(out[35], 0.99f, 1e-5f);
+  EXPECT_EQ(out[36], 1.0f);
+  EXPECT_EQ(out[63], 1.0f);
+  EXPECT_FALSE(value.isSmoothing());
+
+  // Blocks and single samples agree
+  SmoothedValue blocks(0.0f, 0.01f, 10000.0);
+  SmoothedValue samples(0.0f, 0.01f, 10000.0);
+  blocks.setTarget(-2.0f);
+  samples.setTarget(-2.0f);
+  for (int block = 0; block < 4; block++) {
+    blocks.process(out.data(), 37);
+    for (int i = 0; i < 37; i++) {
+      EXPECT_NEAR(out[i], samples.next(), 1e-5f);
+    }
+  }
+  EXPECT_EQ(blocks.current(), -2.0f);
+  EXPECT_EQ(samples.current(), -2.0f);
+}
+
+TEST(ParameterSmoother, OnePole) {
+  SmoothedValue value(0.0f, 0.01f, 10000.0, SmoothedValue::ONE_POLE);
+  value.setTarget(1.0f);
+  std::vector<float> out(100);
+  value.process(out.data(), 100);
+  EXPECT_EQ(out[0], 0.0f);
+  for (int i = 1; i < 100; i++) {
+    EXPECT_GT(out[i], out[i - 1]);
+  }
+  // Within 60 dB after the smoothing time
+  EXPECT_NEAR(value.current(), 0.999f, 1e-4f);
+
+  value.process(out.data(), 100);
+  value.process(out.data(), 100);
+  EXPECT_FALSE(value.isSmoothing());
+  EXPECT_EQ(value.current(), 1.0f);
+}
+
+TEST(ParameterSmoother, Ramp) {
+  SmoothedValue linear(0.0f, 0.01f, 10000.0);
+  linear.setTarget(1.0f);
+  SmoothedValue::Ramp ramp = linear.ramp(64);
+  EXPECT_EQ(ramp.start, 0.0f);
+  EXPECT_NEAR(ramp.increment, 0.01f, 1e-7f);
+  // The ramp ends inside the block, so the segment joins its edges
+  ramp = linear.ramp(64);
+  EXPECT_NEAR(ramp.start, 0.64f, 1e-5f);
+  EXPECT_NEAR(ramp.start + 64 * ramp.increment, 1.0f, 1e-5f);
+  ramp = linear.ramp(64);
+  EXPECT_EQ(ramp.start, 1.0f);
+  EXPECT_EQ(ramp.increment, 0.0f);
+
+  SmoothedValue onePole(0.0f, 0.01f, 10000.0, SmoothedValue::ONE_POLE);
+  onePole.setTarget(1.0f);
+  ramp = onePole.ramp(100);
+  EXPECT_NEAR(ramp.start + 100 * ramp.increment, 0.999f, 1e-4f);
+}
+
+TEST(ParameterSmoother, Parameter) {
+  Parameter gain("gain", "", 0.5f, 0.0f, 1.0f);
+  ParameterSmoother smoother(gain, 0.01f, 10000.0);
+  std::vector<float> buffer(200, 2.0f);
+  smoother.applyGain(buffer.data(), 200);
+  EXPECT_EQ(buffer[0], 1.0f);
+  EXPECT_EQ(buffer[199], 1.0f);
+
+  gain.set(1.0f);
+  buffer.assign(200, 2.0f);
+  smoother.applyGain(buffer.data(), 200);
+  EXPECT_EQ(buffer[0], 1.0f);
+  EXPECT_NEAR(buffer[50], 1.5f, 1e-5f);
+  EXPECT_EQ(buffer[199], 2.0f);
+
+  gain.set(0.0f);
+  smoother.reset();
+  EXPECT_EQ(smoother.current(), 0.0f);
+  EXPECT_FALSE(smoother.isSmoothing());
+}
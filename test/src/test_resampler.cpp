@@ -0,0 +1,168 @@
+#include <math.h>
+
+#include "al/sound/al_Resampler.hpp"
+#include "al/sound/al_SoundFile.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+// THD+N in dB of a sine converted offline, against the ideal sine at the
+// output rate. The edges of the buffer are skipped
+static double thdn(unsigned int inRate, unsigned int outRate,
+                   Resampler::Quality quality, double freq) {
+  Resampler resampler(inRate, outRate, 1, quality);
+  std::vector<float> in(inRate / 2);
+  for (size_t i = 0; i < in.size(); i++) {
+    in[i] = 0.5 * sin(2 * M_PI * freq * i / inRate);
+  }
+  uint64_t numOut = resampler.outputFrames(in.size());
+  std::vector<float> out(numOut);
+  resampler.convert(in.data(), in.size(), out.data(), numOut);
+  double error = 0, signal = 0;
+  for (uint64_t i = 1000; i < numOut - 1000; i++) {
+    double ref = 0.5 * sin(2 * M_PI * freq * i / outRate);
+    error += (out[i] - ref) * (out[i] - ref);
+    signal += ref * ref;
+  }
+  return 10 * log10(error / signal);
+}
+
+TEST(Resampler, THDN) {
+  const double limits[] = {-60, -90, -115, -130};
+  for (int q = Resampler::FAST; q <= Resampler::BEST; q++) {
+    auto quality = Resampler::Quality(q);
+    // Exact phases up and down, interpolated phases for 44101
+    EXPECT_LT(thdn(44100, 48000, quality, 997), limits[q]) << q;
+    EXPECT_LT(thdn(48000, 44100, quality, 997), limits[q]) << q;
+    EXPECT_LT(thdn(44100, 44101, quality, 997), limits[q]) << q;
+    EXPECT_LT(thdn(96000, 44100, quality, 997), limits[q]) << q;
+  }
+  // Near the passband edge
+  EXPECT_LT(thdn(44100, 48000, Resampler::HIGH, 15000), -110);
+}
+
+TEST(Resampler, Antialiasing) {
+  // A tone above the output Nyquist frequency is removed
+  Resampler resampler(96000, 44100, 1, Resampler::HIGH);
+  std::vector<float> in(48000);
+  for (size_t i = 0; i < in.size(); i++) {
+    in[i] = sin(2 * M_PI * 30000.0 * i / 96000);
+  }
+  std::vector<float> out(resampler.outputFrames(in.size()));
+  resampler.convert(in.data(), in.size(), out.data(), out.size());
+  float peak = 0;
+  for (size_t i = 1000; i < out.size() - 1000; i++) {
+    peak = std::max(peak, std::abs(out[i]));
+  }
+  EXPECT_LT(20 * log10(peak), -100);
+}
+
+TEST(Resampler, StreamingMatchesOffline) {
+  const int channels = 3;
+  const int numIn = 5000;
+  std::vector<float> in(numIn * channels);
+  for (size_t i = 0; i < in.size(); i++) {
+    in[i] = sin(0.013 * i) + 0.3f * cos(0.31 * i);
+  }
+  unsigned int rates[][2] = {{44100, 48000}, {48000, 44100}, {22050, 44101},
+                             {96000, 44100}, {48000, 48000}};
+  for (auto &rate : rates) {
+    Resampler resampler(rate[0], rate[1], channels, Resampler::MEDIUM);
+    uint64_t numOut = resampler.outputFrames(numIn);
+    std::vector<float> offline(numOut * channels);
+    resampler.convert(in.data(), numIn, offline.data(), numOut, 1);
+    std::vector<float> threaded(numOut * channels);
+    resampler.convert(in.data(), numIn, threaded.data(), numOut, 3);
+    EXPECT_EQ(offline, threaded);
+
+    // Push blocks of varying size
+    std::vector<float> streamed(numOut * channels + 64 * channels);
+    uint64_t written = 0;
+    uint64_t read = 0;
+    int block = 1;
+    while (read < numIn) {
+      uint64_t n = std::min<uint64_t>(block, numIn - read);
+      written += resampler.process(in.data() + read * channels, n,
+                                   streamed.data() + written * channels,
+                                   numOut - written);
+      read += n;
+      block = block * 3 % 257 + 1;
+    }
+    // Lookahead frames are still held back
+    EXPECT_LE(written, numOut);
+    EXPECT_GE(written + resampler.halfTaps() * rate[1] / rate[0] + 2, numOut);
+    for (uint64_t i = 0; i < written * channels; i++) {
+      EXPECT_FLOAT_EQ(streamed[i], offline[i]) << rate[0] << " " << rate[1];
+    }
+
+    // Pull from a source in blocks
+    resampler.reset();
+    uint64_t sourcePosition = 0;
+    auto source = [&](float *buffer, uint64_t numFrames) {
+      uint64_t n = std::min<uint64_t>(numFrames, numIn - sourcePosition);
+      std::copy(in.begin() + sourcePosition * channels,
+                in.begin() + (sourcePosition + n) * channels, buffer);
+      sourcePosition += n;
+      return n;
+    };
+    std::vector<float> pulled(numOut * channels);
+    uint64_t produced = 0;
+    while (produced < numOut) {
+      uint64_t n = std::min<uint64_t>(128, numOut - produced);
+      EXPECT_EQ(resampler.pull(pulled.data() + produced * channels, n, source),
+                n);
+      produced += n;
+    }
+    for (uint64_t i = 0; i < pulled.size(); i++) {
+      EXPECT_FLOAT_EQ(pulled[i], offline[i]) << rate[0] << " " << rate[1];
+    }
+  }
+}
+
+TEST(Resampler, PullEndsWithTail) {
+  Resampler resampler(44100, 48000, 1, Resampler::FAST);
+  bool done = false;
+  auto source = [&](float *buffer, uint64_t numFrames) -> uint64_t {
+    if (done) {
+      return 0;
+    }
+    done = true;
+    buffer[0] = 1.0f;
+    return 1;
+  };
+  std::vector<float> out(256, 1.0f);
+  uint64_t produced = resampler.pull(out.data(), out.size(), source);
+  EXPECT_GT(produced, 1u);
+  EXPECT_LT(produced, out.size());
+  for (size_t i = produced; i < out.size(); i++) {
+    EXPECT_EQ(out[i], 0.0f);
+  }
+  EXPECT_EQ(resampler.pull(out.data(), out.size(), source), 0u);
+}
+
+TEST(Resampler, ResampledSoundFile) {
+  SoundFile file;
+  file.sampleRate = 32000;
+  file.channels = 2;
+  file.frameCount = 32000;
+  file.data.resize(file.frameCount * file.channels);
+  for (long long int i = 0; i < file.frameCount; i++) {
+    file.data[2 * i] = sin(2 * M_PI * 440.0 * i / 32000);
+    file.data[2 * i + 1] = 0.5f;
+  }
+  SoundFile converted = getResampledSoundFile(&file, 48000);
+  EXPECT_EQ(converted.sampleRate, 48000);
+  EXPECT_EQ(converted.channels, 2);
+  EXPECT_EQ(converted.frameCount, 48000);
+  ASSERT_EQ(converted.data.size(), 96000u);
+  for (long long int i = 1000; i < converted.frameCount - 1000; i++) {
+    EXPECT_NEAR(converted.getFrame(i)[0], sin(2 * M_PI * 440.0 * i / 48000),
+                1e-4);
+    EXPECT_NEAR(converted.getFrame(i)[1], 0.5f, 1e-4);
+  }
+
+  SoundFile same = getResampledSoundFile(&file, 32000);
+  EXPECT_EQ(same.data, file.data);
+  EXPECT_TRUE(getResampledSoundFile(nullptr, 48000).data.empty());
+}
@@ -0,0 +1,574 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "al/sound/al_SampleBank.hpp"
+#include "al/sound/al_SoundFile.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+static const int kChannels = 2;
+static const int kFrames = 20000;
+
+static int16_t testSample(int frame, int channel) {
+  return int16_t((frame * 7 + channel * 1000) % 60000 - 30000);
+}
+
+static float testValue(int frame, int channel) {
+  return testSample(frame, channel) / 32768.0f;
+}
+
+static void writeLE(std::ofstream &f, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    f.put(char((value >> (8 * i)) & 0xFF));
+  }
+}
+
+// format 1 is integer PCM, 3 is float
+static void writeWav(const char *path, int format = 1, int bits = 16) {
+  std::ofstream f(path, std::ios::binary);
+  const int bytes = bits / 8;
+  uint32_t dataBytes = kFrames * kChannels * bytes;
+  f.write("RIFF", 4);
+  writeLE(f, 36 + dataBytes, 4);
+  f.write("WAVEfmt ", 8);
+  writeLE(f, 16, 4);
+  writeLE(f, format, 2);
+  writeLE(f, kChannels, 2);
+  writeLE(f, 44100, 4);
+  writeLE(f, 44100 * kChannels * bytes, 4);
+  writeLE(f, kChannels * bytes, 2);
+  writeLE(f, bits, 2);
+  f.write("data", 4);
+  writeLE(f, dataBytes, 4);
+  for (int i = 0; i < kFrames; i++) {
+    for (int c = 0; c < kChannels; c++) {
+      if (format == 3) {
+        float value = testValue(i, c);
+        uint32_t word;
+        std::memcpy(&word, &value, 4);
+        writeLE(f, word, 4);
+      } else {
+        // Same values at every bit depth
+        writeLE(f, uint32_t(int32_t(testSample(i, c)) << (bits - 16)), bytes);
+      }
+    }
+  }
+}
+
+// Minimal FLAC encoder writing verbatim subframes
+struct BitWriter {
+  std::vector<uint8_t> bytes;
+  int bitCount = 0;
+  void put(uint64_t value, int bits) {
+    for (int b = bits - 1; b >= 0; b--) {
+      if (bitCount % 8 == 0) {
+        bytes.push_back(0);
+      }
+      bytes.back() |= ((value >> b) & 1) << (7 - bitCount % 8);
+      bitCount++;
+    }
+  }
+};
+
+static uint8_t crc8(const uint8_t *data, size_t n) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x80) ? uint8_t((crc << 1) ^ 0x07) : uint8_t(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static uint16_t crc16(const uint8_t *data, size_t n) {
+  uint16_t crc = 0;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= uint16_t(data[i]) << 8;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? uint16_t((crc << 1) ^ 0x8005) : uint16_t(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static void writeFlac(const char *path) {
+  const int blockSize = 1024;
+  BitWriter w;
+  w.put(0x664C6143, 32);  // fLaC
+  w.put(1, 1);            // last metadata block
+  w.put(0, 7);            // STREAMINFO
+  w.put(34, 24);
+  w.put(blockSize, 16);
+  w.put(blockSize, 16);
+  w.put(0, 24);
+  w.put(0, 24);
+  w.put(44100, 20);
+  w.put(kChannels - 1, 3);
+  w.put(15, 5);  // 16 bits
+  w.put(kFrames, 36);
+  w.put(0, 64);  // MD5 not computed
+  w.put(0, 64);
+  for (int frame = 0; frame * blockSize < kFrames; frame++) {
+    const int n = std::min(blockSize, kFrames - frame * blockSize);
+    const size_t start = w.bytes.size();
+    w.put(0x3FFE, 14);  // sync
+    w.put(0, 2);
+    w.put(7, 4);  // block size in 16 bits at the end of the header
+    w.put(0, 4);  // sample rate from STREAMINFO
+    w.put(kChannels - 1, 4);
+    w.put(4, 3);  // 16 bits per sample
+    w.put(0, 1);
+    w.put(frame, 8);  // UTF-8 coded frame number below 128
+    w.put(n - 1, 16);
+    w.put(crc8(w.bytes.data() + start, w.bytes.size() - start), 8);
+    for (int c = 0; c < kChannels; c++) {
+      w.put(0, 1);
+      w.put(1, 6);  // verbatim
+      w.put(0, 1);
+      for (int i = 0; i < n; i++) {
+        w.put(uint16_t(testSample(frame * blockSize + i, c)), 16);
+      }
+    }
+    w.put(crc16(w.bytes.data() + start, w.bytes.size() - start), 16);
+  }
+  std::ofstream f(path, std::ios::binary);
+  f.write((const char *)w.bytes.data(), w.bytes.size());
+}
+
+static void checkFrames(const std::vector<float> &buffer, int firstFrame,
+                        int numFrames) {
+  for (int i = 0; i < numFrames; i++) {
+    for (int c = 0; c < kChannels; c++) {
+      ASSERT_EQ(buffer[i * kChannels + c], testValue(firstFrame + i, c))
+          << "frame " << firstFrame + i;
+    }
+  }
+}
+
+static void readWholeFile(const char *path) {
+  SoundFileStreaming stream;
+  ASSERT_TRUE(stream.open(path, 4096));
+  EXPECT_EQ(stream.sampleRate(), 44100u);
+  EXPECT_EQ(stream.numChannels(), kChannels);
+  EXPECT_EQ(stream.totalFrames(), uint64_t(kFrames));
+  stream.blocking(true);
+
+  const int block = 333;
+  std::vector<float> buffer(block * kChannels);
+  int position = 0;
+  while (position < kFrames) {
+    uint64_t n = stream.getFrames(block, buffer.data());
+    EXPECT_EQ(n, uint64_t(std::min(block, kFrames - position)));
+    checkFrames(buffer, position, int(n));
+    position += int(n);
+  }
+  EXPECT_EQ(stream.getFrames(block, buffer.data()), 0u);
+  EXPECT_EQ(buffer[0], 0.0f);
+
+  stream.seek(12345);
+  EXPECT_EQ(stream.getFrames(block, buffer.data()), uint64_t(block));
+  checkFrames(buffer, 12345, block);
+
+  // Loop through 500 frames
+  stream.loopPoints(1000, 1500);
+  stream.loop(true);
+  EXPECT_TRUE(stream.loop());
+  stream.seek(1200);
+  std::vector<float> looped(1600 * kChannels);
+  EXPECT_EQ(stream.getFrames(1600, looped.data()), 1600u);
+  for (int i = 0; i < 1600; i++) {
+    ASSERT_EQ(looped[i * kChannels], testValue(1000 + (200 + i) % 500, 0))
+        << i;
+  }
+  EXPECT_EQ(stream.underruns(), 0u);
+}
+
+TEST(SoundFileStreaming, Wav) {
+  const char *path = "al_test_streaming.wav";
+  writeWav(path);
+  SoundFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(file.frameCount, kFrames);
+  EXPECT_EQ(file.getFrame(777)[1], testValue(777, 1));
+  readWholeFile(path);
+  std::remove(path);
+}
+
+TEST(SoundFileStreaming, Flac) {
+  const char *path = "al_test_streaming.flac";
+  writeFlac(path);
+  SoundFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(file.frameCount, kFrames);
+  EXPECT_EQ(file.getFrame(1025)[0], testValue(1025, 0));
+  readWholeFile(path);
+  std::remove(path);
+}
+
+TEST(SoundFileStreaming, Underrun) {
+  const char *path = "al_test_underrun.wav";
+  writeWav(path);
+  // Without I/O threads only the buffer filled by open() is available
+  SoundFileStreaming::numIOThreads(0);
+  SoundFileStreaming stream;
+  ASSERT_TRUE(stream.open(path, 1000));
+  std::vector<float> buffer(3000 * kChannels);
+  uint64_t n = stream.getFrames(3000, buffer.data());
+  EXPECT_EQ(n, 3000u);
+  EXPECT_EQ(stream.underruns(), 1u);
+  uint64_t missing = stream.underrunFrames();
+  EXPECT_GT(missing, 0u);
+  EXPECT_LT(missing, 3000u);
+  const int available = int(3000 - missing);
+  checkFrames(buffer, 0, available);
+  EXPECT_EQ(buffer[available * kChannels], 0.0f);
+
+  // Reading resumes in time, skipping the frames that were missed
+  SoundFileStreaming::numIOThreads(2);
+  stream.blocking(true);
+  EXPECT_EQ(stream.getFrames(100, buffer.data()), 100u);
+  checkFrames(buffer, 3000, 100);
+  EXPECT_EQ(stream.underruns(), 1u);
+
+  stream.close();
+  EXPECT_FALSE(stream.isOpen());
+  EXPECT_FALSE(stream.open("al_test_does_not_exist.wav"));
+  std::remove(path);
+}
+
+TEST(SoundFileView, Formats) {
+  const char *path = "al_test_view.wav";
+  int formats[][2] = {{1, 16}, {1, 24}, {1, 32}, {3, 32}};
+  for (auto &format : formats) {
+    writeWav(path, format[0], format[1]);
+    SoundFileView view;
+    ASSERT_TRUE(view.open(path, 2));
+    EXPECT_EQ(view.sampleRate(), 44100);
+    EXPECT_EQ(view.channels(), kChannels);
+    EXPECT_EQ(view.frameCount(), kFrames);
+    EXPECT_EQ(view.bitsPerSample(), format[1]);
+    EXPECT_EQ(view.isZeroCopy(), format[0] == 3);
+
+    std::vector<float> buffer(5000 * kChannels);
+    for (int first : {0, 4321, kFrames - 5000}) {
+      EXPECT_EQ(view.read(first, 5000, buffer.data()), 5000);
+      checkFrames(buffer, first, 5000);
+    }
+    EXPECT_EQ(view.read(kFrames - 10, 5000, buffer.data()), 10);
+    EXPECT_EQ(view.read(kFrames, 5000, buffer.data()), 0);
+
+    // Random access through the block cache
+    for (int i : {0, 5, 19999, 1023, 1024, 7000, 3, 12000, 2047}) {
+      const float *frame = view.frame(i);
+      ASSERT_NE(frame, nullptr);
+      EXPECT_EQ(frame[0], testValue(i, 0)) << format[1] << " " << i;
+      EXPECT_EQ(frame[1], testValue(i, 1)) << format[1] << " " << i;
+    }
+    EXPECT_EQ(view.frame(kFrames), nullptr);
+    view.preload(0, kFrames);
+  }
+  std::remove(path);
+
+  SoundFileView view;
+  EXPECT_FALSE(view.open("al_test_does_not_exist.wav"));
+  EXPECT_FALSE(view.isOpen());
+}
+
+TEST(SoundFileView, Player) {
+  const char *path = "al_test_view_player.wav";
+  writeWav(path, 1, 24);
+  SoundFileView view(path);
+  ASSERT_TRUE(view.isOpen());
+  SoundFilePlayer player;
+  player.soundFileView = &view;
+  player.pause = false;
+  player.loop = true;
+  player.frame = kFrames - 700;
+
+  std::vector<float> buffer(512 * kChannels);
+  player.getFrames(512, buffer.data(), int(buffer.size()));
+  checkFrames(buffer, kFrames - 700, 512);
+  player.getFrames(512, buffer.data(), int(buffer.size()));
+  checkFrames(buffer, kFrames - 188, 188);
+  EXPECT_EQ(buffer[188 * kChannels], 0.0f);
+  // Wraps to the start on the next buffer
+  player.getFrames(512, buffer.data(), int(buffer.size()));
+  player.getFrames(512, buffer.data(), int(buffer.size()));
+  checkFrames(buffer, 0, 512);
+  std::remove(path);
+}
+
+TEST(SampleBank, SharedHandles) {
+  const char *pathA = "al_test_bank_a.wav";
+  const char *pathB = "al_test_bank_b.wav";
+  writeWav(pathA);
+  writeWav(pathB, 3, 32);
+  const size_t fileBytes = kFrames * kChannels * sizeof(float);
+
+  SampleBank bank;
+  auto a = bank.get(pathA);
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a->frameCount, kFrames);
+  EXPECT_EQ(a->getFrame(10)[1], testValue(10, 1));
+  auto a2 = bank.get(pathA);
+  EXPECT_EQ(a.get(), a2.get());
+  EXPECT_EQ(bank.hits(), 1u);
+  EXPECT_EQ(bank.misses(), 1u);
+  EXPECT_EQ(bank.memoryUsage(), fileBytes);
+
+  bank.preload(pathB);
+  auto b = bank.get(pathB);
+  ASSERT_NE(b, nullptr);
+  EXPECT_TRUE(bank.isLoaded(pathB));
+  EXPECT_EQ(bank.misses(), 2u);
+  EXPECT_EQ(bank.memoryUsage(), 2 * fileBytes);
+
+  // Samples in use are kept even when over budget
+  bank.budget(fileBytes);
+  EXPECT_EQ(bank.evictions(), 0u);
+  EXPECT_EQ(bank.memoryUsage(), 2 * fileBytes);
+  // Releasing b leaves a over the budget alone, a is more recent
+  a.reset();
+  b.reset();
+  bank.get(pathA);
+  bank.budget(fileBytes);
+  EXPECT_EQ(bank.evictions(), 1u);
+  EXPECT_TRUE(bank.isLoaded(pathA));
+  EXPECT_FALSE(bank.isLoaded(pathB));
+  // a2 still holds a
+  bank.evictUnused();
+  EXPECT_TRUE(bank.isLoaded(pathA));
+  a2.reset();
+  bank.evictUnused();
+  EXPECT_FALSE(bank.isLoaded(pathA));
+  EXPECT_EQ(bank.memoryUsage(), 0u);
+
+  // A changed file is reloaded, old handles keep their data
+  auto before = bank.get(pathA);
+  {
+    std::ofstream f(pathA, std::ios::binary | std::ios::app);
+    f.put(0);
+  }
+  auto after = bank.get(pathA);
+  EXPECT_NE(before.get(), after.get());
+  EXPECT_EQ(before->frameCount, kFrames);
+
+  EXPECT_EQ(bank.get("al_test_does_not_exist.wav"), nullptr);
+  EXPECT_FALSE(bank.isLoaded("al_test_does_not_exist.wav"));
+  std::remove(pathA);
+  std::remove(pathB);
+}
+
+TEST(SampleBank, SharedPlayers) {
+  const char *path = "al_test_bank_players.wav";
+  writeWav(path);
+  SampleBank::instance().resetCounters();
+  std::vector<SoundFilePlayerTS> voices(8);
+  for (auto &voice : voices) {
+    EXPECT_TRUE(voice.openShared(path));
+    EXPECT_EQ(voice.player.soundFile, voices[0].player.soundFile);
+  }
+  EXPECT_EQ(SampleBank::instance().misses(), 1u);
+  EXPECT_EQ(SampleBank::instance().hits(), 7u);
+  voices[3].setPlay();
+  std::vector<float> buffer(64 * kChannels);
+  voices[3].getFrames(64, buffer.data(), int(buffer.size()));
+  checkFrames(buffer, 0, 64);
+  std::remove(path);
+}
+
+TEST(SampleBank, BatchLoad) {
+  std::vector<std::string> paths;
+  for (int i = 0; i < 6; i++) {
+    paths.push_back("al_test_batch_" + std::to_string(i) +
+                    (i % 2 ? ".flac" : ".wav"));
+    if (i % 2) {
+      writeFlac(paths.back().c_str());
+    } else {
+      writeWav(paths.back().c_str());
+    }
+  }
+  paths.push_back("al_test_does_not_exist.wav");
+
+  SampleBank bank;
+  auto cached = bank.get(paths[0]);
+  std::atomic<size_t> callbacks{0};
+  BatchLoad::Options options;
+  options.numThreads = 3;
+  options.ioConcurrency = 1;
+  options.onLoaded = [&](const BatchLoad::Result &result, size_t completed,
+                         size_t total) {
+    EXPECT_LE(completed, total);
+    callbacks++;
+  };
+  auto batch = bank.loadAll(paths, options);
+  ASSERT_EQ(batch->size(), paths.size());
+  // Samples can be used before the batch is done
+  auto first = batch->sample(1).get();
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first->getFrame(100)[0], testValue(100, 0));
+  batch->wait();
+
+  EXPECT_TRUE(batch->done());
+  EXPECT_FLOAT_EQ(batch->progress(), 1.0f);
+  EXPECT_EQ(callbacks.load(), paths.size());
+  EXPECT_EQ(batch->failed(), 1u);
+  auto results = batch->results();
+  ASSERT_EQ(results.size(), paths.size());
+  for (const auto &result : results) {
+    if (result.path == paths.back()) {
+      EXPECT_EQ(result.sample, nullptr);
+      continue;
+    }
+    ASSERT_NE(result.sample, nullptr);
+    EXPECT_EQ(result.sample->frameCount, kFrames);
+    EXPECT_EQ(result.sample->getFrame(kFrames - 1)[1],
+              testValue(kFrames - 1, 1));
+    EXPECT_EQ(result.cached, result.path == paths[0]);
+    if (!result.cached) {
+      EXPECT_GT(result.fileBytes, 0u);
+    }
+  }
+  EXPECT_GT(batch->seconds(), 0.0);
+  // The bank shares the batch's samples
+  EXPECT_EQ(bank.get(paths[0]).get(), cached.get());
+  EXPECT_EQ(bank.get(paths[3]).get(), batch->sample(3).get().get());
+  EXPECT_EQ(bank.memoryUsage(),
+            (paths.size() - 1) * kFrames * kChannels * sizeof(float));
+  batch.reset();
+
+  for (const auto &path : paths) {
+    std::remove(path.c_str());
+  }
+}
+
+static SoundFile makeSoundFile(int channels, long long frames,
+                               float (*value)(long long frame, int channel)) {
+  SoundFile file;
+  file.channels = channels;
+  file.sampleRate = 48000;
+  file.frameCount = frames;
+  file.data.resize(size_t(frames * channels));
+  for (long long i = 0; i < frames; i++) {
+    for (int c = 0; c < channels; c++) {
+      file.data[size_t(i * channels + c)] = value(i, c);
+    }
+  }
+  return file;
+}
+
+static float ramp(long long frame, int channel) {
+  return float(frame) * (channel ? -1.0f : 1.0f) / 1024.0f;
+}
+
+TEST(SoundFilePlayer, Rates) {
+  SoundFile file = makeSoundFile(2, 1000, ramp);
+  SoundFilePlayer player;
+  player.soundFile = &file;
+  player.pause = false;
+  std::vector<float> buffer(2 * 64);
+
+  // Half speed interpolates a ramp exactly
+  player.rate = 0.5;
+  player.interpolation = SoundFilePlayer::LINEAR;
+  player.frame = 100;
+  player.getFrames(64, buffer.data(), int(buffer.size()));
+  for (int i = 0; i < 64; i++) {
+    EXPECT_NEAR(buffer[2 * i], ramp(100, 0) + i * 0.5f / 1024.0f, 1e-6f);
+    EXPECT_NEAR(buffer[2 * i + 1], ramp(100, 1) - i * 0.5f / 1024.0f, 1e-6f);
+  }
+  EXPECT_EQ(player.frame, 132);
+  EXPECT_EQ(player.frameFraction, 0.0);
+
+  // Backwards, every interpolator passes through the samples
+  for (auto interpolation : {SoundFilePlayer::LINEAR, SoundFilePlayer::CUBIC,
+                             SoundFilePlayer::HERMITE}) {
+    player.interpolation = interpolation;
+    player.rate = -1.0;
+    player.frameFraction = 0.0;
+    player.frame = 500;
+    player.getFrames(64, buffer.data(), int(buffer.size()));
+    for (int i = 0; i < 64; i++) {
+      EXPECT_NEAR(buffer[2 * i], ramp(500 - i, 0), 1e-6f);
+    }
+    EXPECT_EQ(player.frame, 436);
+  }
+
+  // Stops at the start when playing backwards without looping
+  player.rate = -3.0;
+  player.frame = 30;
+  player.getFrames(64, buffer.data(), int(buffer.size()));
+  EXPECT_TRUE(player.pause);
+  EXPECT_NEAR(buffer[2 * 10], ramp(0, 0), 1e-6f);
+  EXPECT_EQ(buffer[2 * 11], 0.0f);
+  EXPECT_EQ(buffer[2 * 63], 0.0f);
+
+  // Stops at the end
+  player.pause = false;
+  player.rate = 0.75;
+  player.frame = 980;
+  player.getFrames(64, buffer.data(), int(buffer.size()));
+  EXPECT_TRUE(player.pause);
+  // 980 + 26 * 0.75 = 999.5 is the last position in the file
+  EXPECT_NE(buffer[2 * 26], 0.0f);
+  EXPECT_EQ(buffer[2 * 27], 0.0f);
+
+  // Looping wraps around the end
+  player.pause = false;
+  player.loop = true;
+  player.interpolation = SoundFilePlayer::CUBIC;
+  player.rate = 1.5;
+  player.frame = 990;
+  player.getFrames(64, buffer.data(), int(buffer.size()));
+  EXPECT_FALSE(player.pause);
+  EXPECT_NEAR(buffer[2 * 8], ramp(2, 0), 1e-6f);
+  EXPECT_EQ(player.frame, 86);
+}
+
+static float tone(double cyclesPerSample, long long frame) {
+  return float(std::sin(2.0 * M_PI * cyclesPerSample * frame));
+}
+
+static float highTone(long long frame, int) { return tone(0.3, frame); }
+static float lowTone(long long frame, int) { return tone(0.02, frame); }
+
+static float peakAtRate(const SoundFile &file, double rate, bool bandLimit) {
+  SoundFilePlayer player;
+  player.soundFile = &file;
+  player.pause = false;
+  player.rate = rate;
+  player.bandLimit = bandLimit;
+  player.frame = 10000;
+  std::vector<float> buffer(256);
+  float peak = 0.0f;
+  for (int block = 0; block < 8; block++) {
+    player.getFrames(256, buffer.data(), int(buffer.size()));
+    for (float v : buffer) {
+      peak = std::max(peak, std::fabs(v));
+    }
+  }
+  return peak;
+}
+
+TEST(SoundFilePlayer, BandLimited) {
+  SoundFile high = makeSoundFile(1, 20000, highTone);
+  SoundFile low = makeSoundFile(1, 20000, lowTone);
+  // 0.3 cycles per sample at double speed is above the Nyquist frequency
+  // and aliases without band limiting
+  EXPECT_GT(peakAtRate(high, 2.0, false), 0.9f);
+  EXPECT_LT(peakAtRate(high, 2.0, true), 0.01f);
+  EXPECT_LT(peakAtRate(high, -2.5, true), 0.01f);
+  EXPECT_NEAR(peakAtRate(low, 2.0, true), 1.0f, 0.01f);
+  EXPECT_NEAR(peakAtRate(low, 3.7, true), 1.0f, 0.01f);
+}
@@ -0,0 +1,272 @@
+#include <math.h>
+
+#include "al/io/al_AudioIO.hpp"
+#include "al/sound/al_Ambisonics.hpp"
+#include "al/sound/al_Dbap.hpp"
+#include "al/sound/al_StereoPanner.hpp"
+#include "al/sphere/al_AlloSphereSpeakerLayout.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+// Render the same sources one by one and as a batch and compare outputs
+static void compareBatch(Spatializer &spatializer, unsigned int numChannels) {
+  const unsigned int fpb = 32;
+  const unsigned int numSources = 5;
+
+  AudioIOData single;
+  single.framesPerBuffer(fpb);
+  single.framesPerSecond(44100);
+  single.channelsIn(0);
+  single.channelsOut(numChannels);
+  AudioIOData batch;
+  batch.framesPerBuffer(fpb);
+  batch.framesPerSecond(44100);
+  batch.channelsIn(0);
+  batch.channelsOut(numChannels);
+
+  std::vector<float> samples(numSources * fpb);
+  std::vector<const float *> buffers(numSources);
+  std::vector<Vec3f> positions(numSources);
+  for (unsigned int s = 0; s < numSources; s++) {
+    for (unsigned int i = 0; i < fpb; i++) {
+      samples[s * fpb + i] = sin(0.1 * (s + 1) * i);
+    }
+    buffers[s] = samples.data() + s * fpb;
+    float angle = s * 1.3f;
+    positions[s] = Vec3f(2 * cos(angle), 0.5f * s - 1.0f, 2 * sin(angle));
+  }
+
+  single.zeroOut();
+  spatializer.prepare(single);
+  for (unsigned int s = 0; s < numSources; s++) {
+    spatializer.renderBuffer(single, positions[s], buffers[s], fpb);
+  }
+  spatializer.finalize(single);
+
+  batch.zeroOut();
+  spatializer.prepare(batch);
+  spatializer.renderBuffers(batch, positions.data(), buffers.data(),
+                            numSources, fpb);
+  spatializer.finalize(batch);
+
+  for (unsigned int chan = 0; chan < numChannels; chan++) {
+    for (unsigned int i = 0; i < fpb; i++) {
+      EXPECT_NEAR(single.out(chan, i), batch.out(chan, i), 1e-5);
+    }
+  }
+}
+
+TEST(Spatializer, BatchStereo) {
+  Speakers sl = StereoSpeakerLayout();
+  StereoPanner panner(sl);
+  panner.compile();
+  compareBatch(panner, 2);
+}
+
+TEST(Spatializer, BatchDbap) {
+  Speakers sl = AlloSphereSpeakerLayoutCompensated();
+  unsigned int numChannels = 0;
+  for (auto &s : sl) {
+    numChannels = std::max(numChannels, s.deviceChannel + 1);
+  }
+  Dbap panner(sl);
+  panner.compile();
+  compareBatch(panner, numChannels);
+}
+
+TEST(Spatializer, BatchAmbisonics) {
+  Speakers sl = OctalSpeakerLayout();
+  AmbisonicsSpatializer panner(sl, 3, 1);
+  panner.compile();
+  compareBatch(panner, 8);
+}
+
+TEST(Spatializer, Batch) {
+  Speakers sl = StereoSpeakerLayout();
+  StereoPanner panner(sl);
+  panner.compile();
+
+  const unsigned int fpb = 8;
+  AudioIOData io;
+  io.framesPerBuffer(fpb);
+  io.channelsIn(0);
+  io.channelsOut(2);
+  io.zeroOut();
+
+  SpatializerBatch batch;
+  batch.configure(2, fpb);
+  EXPECT_EQ(batch.capacity(), 2);
+
+  float samples[fpb];
+  for (unsigned int i = 0; i < fpb; i++) {
+    samples[i] = 1.0f;
+  }
+  EXPECT_TRUE(batch.add(Vec3f(-1, 0, 0), samples));
+  // Source buffer is copied on add
+  samples[0] = 0.0f;
+  EXPECT_TRUE(batch.add(Vec3f(1, 0, 0), samples));
+  EXPECT_TRUE(batch.full());
+  EXPECT_FALSE(batch.add(Vec3f(1, 0, 0), samples));
+
+  batch.render(panner, io);
+  EXPECT_EQ(batch.size(), 0);
+  EXPECT_NEAR(io.out(0, 0), 1.0f, 1e-6);
+  EXPECT_NEAR(io.out(1, 1), 1.0f, 1e-6);
+}
+
+TEST(Spatializer, DbapLargeLayout) {
+  // More speakers than the previous fixed limit of 192
+  const unsigned int numSpeakers = 320;
+  Speakers sl;
+  for (unsigned int i = 0; i < numSpeakers; i++) {
+    sl.push_back(Speaker(i, 360.0f * i / numSpeakers, (i % 4) * 10.0f, 0,
+                         4.0f));
+  }
+  Dbap panner(sl, 1.5f);
+  panner.compile();
+
+  const unsigned int fpb = 16;
+  AudioIOData io;
+  io.framesPerBuffer(fpb);
+  io.channelsIn(0);
+  io.channelsOut(numSpeakers);
+
+  float samples[fpb];
+  for (unsigned int i = 0; i < fpb; i++) {
+    samples[i] = 1.0f;
+  }
+  Vec3f pos(1.0f, 0.5f, -2.0f);
+  const float *buffer = samples;
+  const uint64_t id = 7;
+  io.zeroOut();
+  panner.prepare(io);
+  panner.renderBuffers(io, &pos, &buffer, 1, fpb, &id);
+
+  Vec3d relpos(pos.x, -pos.z, pos.y);
+  for (unsigned int k = 0; k < numSpeakers; k++) {
+    double dist = (relpos - sl[k].vec()).mag();
+    float expected = powf(1.0f / (1.0f + float(dist)), 1.5f);
+    EXPECT_NEAR(io.out(k, 0), expected, expected * 1e-4);
+    EXPECT_NEAR(io.out(k, fpb - 1), expected, expected * 1e-4);
+  }
+
+  // Move the source. Gains ramp from previous to new values
+  Vec3f newPos(-1.0f, 0.0f, 2.0f);
+  Vec3d newRelpos(newPos.x, -newPos.z, newPos.y);
+  io.zeroOut();
+  panner.prepare(io);
+  panner.renderBuffers(io, &newPos, &buffer, 1, fpb, &id);
+  for (unsigned int k = 0; k < numSpeakers; k++) {
+    float startGain =
+        powf(1.0f / (1.0f + float((relpos - sl[k].vec()).mag())), 1.5f);
+    float endGain =
+        powf(1.0f / (1.0f + float((newRelpos - sl[k].vec()).mag())), 1.5f);
+    EXPECT_NEAR(io.out(k, 0), startGain + (endGain - startGain) / fpb, 1e-4);
+    EXPECT_NEAR(io.out(k, fpb - 1), endGain, endGain * 1e-4);
+  }
+}
+
+TEST(Spatializer, DbapSourceRemoved) {
+  Speakers sl = OctalSpeakerLayout();
+  const unsigned int fpb = 16;
+  AudioIOData io;
+  io.framesPerBuffer(fpb);
+  io.channelsIn(0);
+  io.channelsOut(8);
+
+  float samples[fpb];
+  for (unsigned int i = 0; i < fpb; i++) {
+    samples[i] = 1.0f;
+  }
+  const float *buffers[2] = {samples, samples};
+  Vec3f positions[2] = {Vec3f(2.0f, 0.0f, 0.0f), Vec3f(-2.0f, 0.0f, 1.0f)};
+  const uint64_t ids[2] = {1, 2};
+
+  // Source 1 stops after the first block while source 2 keeps moving. Its
+  // gains must ramp from its own previous gains, as when rendered alone.
+  Dbap panner(sl);
+  Dbap reference(sl);
+  io.zeroOut();
+  panner.prepare(io);
+  panner.renderBuffers(io, positions, buffers, 2, fpb, ids);
+  reference.prepare(io);
+  reference.renderBuffers(io, positions + 1, buffers + 1, 1, fpb, ids + 1);
+
+  positions[1] = Vec3f(-1.0f, 0.5f, 2.0f);
+  AudioIOData expected;
+  expected.framesPerBuffer(fpb);
+  expected.channelsIn(0);
+  expected.channelsOut(8);
+  expected.zeroOut();
+  reference.prepare(expected);
+  reference.renderBuffers(expected, positions + 1, buffers + 1, 1, fpb,
+                          ids + 1);
+  io.zeroOut();
+  panner.prepare(io);
+  panner.renderBuffers(io, positions + 1, buffers + 1, 1, fpb, ids + 1);
+  for (unsigned int chan = 0; chan < 8; chan++) {
+    for (unsigned int i = 0; i < fpb; i++) {
+      EXPECT_NEAR(io.out(chan, i), expected.out(chan, i), 1e-6);
+    }
+  }
+
+  // A new source takes the stopped source's place without ramping from its
+  // gains
+  const uint64_t newId = 3;
+  Vec3f newPos(0.0f, 0.0f, -2.0f);
+  io.zeroOut();
+  panner.prepare(io);
+  panner.renderBuffers(io, &newPos, buffers, 1, fpb, &newId);
+  for (unsigned int chan = 0; chan < 8; chan++) {
+    EXPECT_NEAR(io.out(chan, 0), io.out(chan, fpb - 1), 1e-6);
+  }
+}
+
+TEST(Spatializer, DbapBatchPasses) {
+  Speakers sl = OctalSpeakerLayout();
+  const unsigned int fpb = 16;
+  const unsigned int numSources = 5;
+  AudioIOData io;
+  io.framesPerBuffer(fpb);
+  io.channelsIn(0);
+  io.channelsOut(8);
+  AudioIOData expected;
+  expected.framesPerBuffer(fpb);
+  expected.channelsIn(0);
+  expected.channelsOut(8);
+
+  float samples[numSources][fpb];
+  const float *buffers[numSources];
+  Vec3f positions[numSources];
+  uint64_t ids[numSources];
+  for (unsigned int s = 0; s < numSources; s++) {
+    for (unsigned int i = 0; i < fpb; i++) {
+      samples[s][i] = float(s + 1) / float(i + 1);
+    }
+    buffers[s] = samples[s];
+    positions[s] = Vec3f(float(s) - 2.0f, 0.5f, float(s % 2));
+    ids[s] = s;
+  }
+
+  // Batches larger than the scratch buffers are rendered in passes
+  Dbap panner(sl);
+  panner.maxBatchSize(2);
+  panner.compile();
+  Dbap reference(sl);
+  io.zeroOut();
+  panner.prepare(io);
+  panner.renderBuffers(io, positions, buffers, numSources, fpb, ids);
+  expected.zeroOut();
+  reference.prepare(expected);
+  for (unsigned int s = 0; s < numSources; s++) {
+    reference.renderBuffers(expected, positions + s, buffers + s, 1, fpb,
+                            ids + s);
+  }
+  for (unsigned int chan = 0; chan < 8; chan++) {
+    for (unsigned int i = 0; i < fpb; i++) {
+      EXPECT_NEAR(io.out(chan, i), expected.out(chan, i), 1e-6);
+    }
+  }
+}
@@ -0,0 +1,74 @@
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_SpeakerAdjustment.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+static void fillRamp(AudioIOData &io, int block) {
+  for (unsigned int chan = 0; chan < io.channelsOut(); chan++) {
+    for (unsigned int i = 0; i < io.framesPerBuffer(); i++) {
+      io.out(chan, i) = float(block * io.framesPerBuffer() + i + 1);
+    }
+  }
+}
+
+TEST(SpeakerAdjustment, TimeAdjustment) {
+  const int fpb = 32;
+  Speakers sl;
+  sl.push_back(Speaker(0, 0, 0, 0, 5.0f));
+  sl.push_back(Speaker(1, 90, 0, 0, 4.0f));
+  sl.push_back(Speaker(2, 180, 0, 0, 3.0f));
+  sl.push_back(Speaker(3, 270, 0, 0, 3.5f));
+
+  AudioIOData io;
+  io.framesPerBuffer(fpb);
+  io.channelsIn(0);
+  io.channelsOut(4);
+
+  SpeakerDistanceTimeAdjustmentProcessor adjustment;
+  // One meter per 10 samples
+  adjustment.configure(sl, 16, 3430, 343.0);
+  EXPECT_FLOAT_EQ(adjustment.delay(0), 0.0f);
+  EXPECT_FLOAT_EQ(adjustment.delay(1), 10.0f);
+  EXPECT_FLOAT_EQ(adjustment.delay(2), 20.0f);
+  adjustment.delay(3, 7.25f);
+  adjustment.gains({1.0f, 0.5f, 1.0f, 2.0f});
+
+  // Buffers larger than configured and longer than the ring buffer
+  for (int block = 0; block < 40; block++) {
+    fillRamp(io, block);
+    adjustment.onAudioCB(io);
+    for (int i = 0; i < fpb; i++) {
+      float t = float(block * fpb + i + 1);
+      EXPECT_FLOAT_EQ(io.out(0, i), t);
+      EXPECT_FLOAT_EQ(io.out(1, i), 0.5f * std::max(t - 10.0f, 0.0f));
+      EXPECT_FLOAT_EQ(io.out(2, i), std::max(t - 20.0f, 0.0f));
+      // Linear interpolation between the input 7 and 8 samples ago
+      int n = block * fpb + i;
+      float expected = 0.75f * std::max(n - 6, 0) + 0.25f * std::max(n - 7, 0);
+      EXPECT_NEAR(io.out(3, i), 2.0f * expected, 1e-2);
+    }
+  }
+}
+
+TEST(SpeakerAdjustment, GainAdjustment) {
+  Speakers sl;
+  sl.push_back(Speaker(0, 0, 0, 0, 1.0f));
+  sl.push_back(Speaker(1, 90, 0, 0, 2.0f));
+  sl.push_back(Speaker(5, 180, 0, 0, 2.0f)); // beyond channelsOut
+
+  AudioIOData io;
+  io.framesPerBuffer(8);
+  io.channelsIn(0);
+  io.channelsOut(2);
+  fillRamp(io, 0);
+
+  SpeakerDistanceGainAdjustmentProcessor adjustment;
+  adjustment.configure(sl, 1.0);
+  adjustment.onAudioCB(io);
+  for (int i = 0; i < 8; i++) {
+    EXPECT_FLOAT_EQ(io.out(0, i), i + 1.0f);
+    EXPECT_FLOAT_EQ(io.out(1, i), 2.0f * (i + 1.0f));
+  }
+}
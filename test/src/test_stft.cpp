@@ -0,0 +1,123 @@
+#include <math.h>
+
+#include <thread>
+
+#include "al/io/al_AudioIOData.hpp"
+#include "al/sound/al_STFT.hpp"
+#include "al/types/al_TripleBuffer.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace al;
+
+TEST(STFT, Resynthesis) {
+  const int fpb = 100; // not a multiple of the hop size
+  STFT stft(512, 128);
+  stft.resynthesis(true);
+  int spectra = 0;
+  stft.onSpectrum([&](float *re, float *im, unsigned int bins) {
+    EXPECT_EQ(bins, 257u);
+    spectra++;
+  });
+
+  AudioIOData io;
+  io.framesPerBuffer(fpb);
+  io.channelsIn(0);
+  io.channelsOut(2);
+  std::vector<float> input;
+  for (int block = 0; block < 30; block++) {
+    for (int i = 0; i < fpb; i++) {
+      float x = sin(0.05f * input.size()) + 0.3f * sin(0.61f * input.size());
+      input.push_back(x);
+      io.out(0, i) = x;
+      io.out(1, i) = x;
+    }
+    stft.onAudioCB(io);
+    for (int i = 0; i < fpb; i++) {
+      int n = block * fpb + i - int(stft.latency());
+      // Full overlap after the first window
+      if (n >= int(stft.windowSize())) {
+        ASSERT_NEAR(io.out(0, i), input[n], 1e-4);
+      }
+      EXPECT_EQ(io.out(1, i), input[block * fpb + i]);
+    }
+  }
+  EXPECT_EQ(spectra, 30 * fpb / 128);
+}
+
+// Hops where the squared window does not overlap-add to a constant
+TEST(STFT, ResynthesisHops) {
+  struct Config {
+    unsigned int window, hop;
+    STFT::WindowType type;
+  };
+  const Config configs[] = {{512, 256, STFT::HANN},
+                            {512, 384, STFT::HANN},
+                            {500, 150, STFT::HAMMING},
+                            {256, 256, STFT::RECTANGLE}};
+  for (const Config &config : configs) {
+    STFT stft(config.window, config.hop, config.type);
+    stft.resynthesis(true);
+    std::vector<float> input(8 * config.window), output(input.size());
+    for (size_t i = 0; i < input.size(); i++) {
+      input[i] = sin(0.05f * i) + 0.3f * sin(0.61f * i);
+    }
+    stft.process(input.data(), output.data(), input.size());
+    for (size_t n = 2 * config.window; n < input.size(); n++) {
+      ASSERT_NEAR(output[n], input[n - stft.latency()], 1e-4)
+          << config.window << " " << config.hop;
+    }
+  }
+}
+
+TEST(STFT, Magnitudes) {
+  STFT stft(1000, 250, STFT::HANN);
+  EXPECT_EQ(stft.fftSize(), 1000u);
+  std::vector<float> input(2000);
+  for (size_t i = 0; i < input.size(); i++) {
+    // Bin 100
+    input[i] = 0.5f * cos(2 * M_PI * 100 * i / 1000.0);
+  }
+  EXPECT_FALSE(stft.updateMagnitudes());
+  EXPECT_EQ(stft.process(input.data(), nullptr, 2000), 8);
+  EXPECT_TRUE(stft.updateMagnitudes());
+  EXPECT_FALSE(stft.updateMagnitudes());
+  const std::vector<float> &mags = stft.magnitudes();
+  ASSERT_EQ(mags.size(), 501u);
+  EXPECT_NEAR(mags[100], 0.5f, 1e-3);
+  EXPECT_NEAR(mags[98], 0.0f, 1e-3);
+}
+
+TEST(TripleBuffer, LatestValue) {
+  TripleBuffer<int> buffer;
+  EXPECT_FALSE(buffer.update());
+  buffer.writeBuffer() = 1;
+  buffer.publish();
+  buffer.writeBuffer() = 2;
+  buffer.publish();
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.readBuffer(), 2);
+  EXPECT_FALSE(buffer.update());
+
+  // Reader never sees a partially written value
+  TripleBuffer<std::vector<int>> vectors;
+  vectors.forEach([](std::vector<int> &v) { v.assign(64, 0); });
+  std::thread writer([&]() {
+    for (int i = 1; i <= 20000; i++) {
+      std::fill(vectors.writeBuffer().begin(), vectors.writeBuffer().end(), i);
+      vectors.publish();
+    }
+  });
+  int last = 0;
+  while (last < 20000) {
+    if (vectors.update()) {
+      const std::vector<int> &v = vectors.readBuffer();
+      ASSERT_GE(v[0], last);
+      for (int x : v) {
+        ASSERT_EQ(x, v[0]);
+      }
+      last = v[0];
+    }
+  }
+  writer.join();
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <math.h>
 
 #include "al/io/al_AudioIO.hpp"
@@ -187,3 +188,152 @@ TEST(VBAP, Allosphere3D) {
 
   //    }
 }
+
+TEST(VBAP, Allosphere3DLookup) {
+  const int fpb = 4;
+
+  Speakers sl = AlloSphereSpeakerLayoutCompensated();
+  unsigned int numChannels = 0;
+  for (auto &s : sl) {
+    numChannels = std::max(numChannels, s.deviceChannel + 1);
+  }
+  Vbap vbapPanner(sl, true);
+  vbapPanner.compile();
+
+  AudioIOData audioData;
+  audioData.framesPerBuffer(fpb);
+  audioData.framesPerSecond(44100);
+  audioData.channelsIn(0);
+  audioData.channelsOut(numChannels);
+
+  float samples[fpb];
+  for (unsigned int i = 0; i < fpb; i++) {
+    samples[i] = 1.0;
+  }
+
+  std::vector<SpeakerTriple> triplets = vbapPanner.triplets();
+
+  // Every direction covered by a triplet must produce normalized,
+  // non-negative gains. Render each direction twice so the second time uses
+  // the cached triplet.
+  const uint64_t sourceId = 1;
+  for (int block = 0; block < 2; block++) {
+    for (int el = -60; el <= 60; el += 5) {
+      for (int az = 0; az < 360; az += 7) {
+        float elr = el * M_PI / 180.0;
+        float azr = az * M_PI / 180.0;
+        Vec3f pos(sin(azr) * cos(elr), sin(elr), -cos(azr) * cos(elr));
+        Vec3d vec(pos.x, -pos.z, pos.y);
+        bool covered = false;
+        for (auto &triplet : triplets) {
+          Vec3d gains;
+          for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+              gains[i] += vec[j] * triplet.mat(j, i);
+            }
+          }
+          if (gains[0] >= 0 && gains[1] >= 0 && gains[2] >= 0) {
+            covered = true;
+            break;
+          }
+        }
+        audioData.zeroOut();
+        vbapPanner.prepare(audioData);
+        const float *buffer = samples;
+        vbapPanner.renderBuffers(audioData, &pos, &buffer, 1, fpb, &sourceId);
+        float sumSquares = 0;
+        for (unsigned int chan = 0; chan < numChannels; chan++) {
+          EXPECT_GE(audioData.out(chan, 0), -1e-6);
+          sumSquares += audioData.out(chan, 0) * audioData.out(chan, 0);
+        }
+        EXPECT_NEAR(sumSquares, covered ? 1.0 : 0.0, 1e-4);
+      }
+    }
+  }
+}
+
+TEST(VBAP, PhantomChannel) {
+  const int fpb = 4;
+
+  Speakers sl = OctalSpeakerLayout();
+  Vbap vbapPanner(sl);
+  vbapPanner.compile();
+  // Signal for channel 0 is split between channels 1 and 7
+  vbapPanner.makePhantomChannel(0, {1, 7});
+
+  AudioIOData audioData;
+  audioData.framesPerBuffer(fpb);
+  audioData.framesPerSecond(44100);
+  audioData.channelsIn(0);
+  audioData.channelsOut(sl.size());
+
+  float samples[fpb];
+  for (unsigned int i = 0; i < fpb; i++) {
+    samples[i] = 1.0;
+  }
+
+  Vec3f pos(0, 0, -4); // Center
+  audioData.zeroOut();
+  vbapPanner.renderBuffer(audioData, pos, samples, fpb);
+  for (unsigned int i = 0; i < fpb; i++) {
+    EXPECT_NEAR(audioData.out(0, i), 0.0f, 1e-6);
+    EXPECT_NEAR(audioData.out(1, i), 1.0f, 1e-6);
+    EXPECT_NEAR(audioData.out(7, i), 1.0f, 1e-6);
+  }
+}
+
+TEST(VBAP, SourceIdsReordered) {
+  const unsigned int fpb = 4;
+  const unsigned int numSources = 4;
+
+  Speakers sl = AlloSphereSpeakerLayoutCompensated();
+  unsigned int numChannels = 0;
+  for (auto &s : sl) {
+    numChannels = std::max(numChannels, s.deviceChannel + 1);
+  }
+  Vbap vbapPanner(sl, true);
+  vbapPanner.compile();
+  Vbap reference(sl, true);
+  reference.compile();
+
+  AudioIOData audioData;
+  audioData.framesPerBuffer(fpb);
+  audioData.channelsIn(0);
+  audioData.channelsOut(numChannels);
+  AudioIOData expected;
+  expected.framesPerBuffer(fpb);
+  expected.channelsIn(0);
+  expected.channelsOut(numChannels);
+
+  float samples[fpb];
+  for (unsigned int i = 0; i < fpb; i++) {
+    samples[i] = 1.0f;
+  }
+  const float *buffers[numSources] = {samples, samples, samples, samples};
+  Vec3f positions[numSources] = {Vec3f(1.0f, 0.2f, -0.3f),
+                                 Vec3f(-0.4f, 0.5f, 1.0f),
+                                 Vec3f(0.1f, -0.3f, -1.0f),
+                                 Vec3f(-1.0f, 0.1f, -0.2f)};
+  uint64_t ids[numSources] = {10, 11, 12, 13};
+
+  // Sources change order and one stops between blocks, as voices do in
+  // DynamicScene. Each source must keep its own triplet.
+  for (int block = 0; block < 3; block++) {
+    unsigned int count = block == 0 ? numSources : numSources - 1;
+    audioData.zeroOut();
+    expected.zeroOut();
+    vbapPanner.prepare(audioData);
+    vbapPanner.renderBuffers(audioData, positions, buffers, count, fpb, ids);
+    for (unsigned int s = 0; s < count; s++) {
+      reference.renderBuffer(expected, positions[s], samples, fpb);
+    }
+    for (unsigned int chan = 0; chan < numChannels; chan++) {
+      EXPECT_NEAR(audioData.out(chan, 0), expected.out(chan, 0), 1e-5);
+    }
+    std::reverse(positions, positions + count);
+    std::reverse(ids, ids + count);
+    for (unsigned int s = 0; s < count; s++) {
+      positions[s].x += 0.05f;
+    }
+  }
+}